@@ -0,0 +1,69 @@
+#include "inference_backend.h"
+
+#include <stdexcept>
+
+#ifdef WATER_OCR_WITH_ORT
+#include "ort_backend.h"
+#endif
+#ifdef WATER_OCR_WITH_PADDLE_LITE
+#include "paddle_lite_backend.h"
+#endif
+
+namespace ocr {
+
+namespace {
+
+bool endsWith(const std::string& text, const std::string& suffix) {
+    return text.size() >= suffix.size() && text.compare(text.size() - suffix.size(), suffix.size(), suffix) == 0;
+}
+
+std::vector<std::pair<std::string, SessionFactory>>& registeredBackends() {
+    static std::vector<std::pair<std::string, SessionFactory>> backends;
+    return backends;
+}
+
+} // namespace
+
+std::vector<std::string> availableBackends() {
+    std::vector<std::string> names;
+#ifdef WATER_OCR_WITH_ORT
+    names.push_back("onnxruntime");
+#endif
+#ifdef WATER_OCR_WITH_PADDLE_LITE
+    names.push_back("paddle_lite");
+#endif
+    for (const auto& backend : registeredBackends()) names.push_back(backend.first);
+    return names;
+}
+
+std::string backendForModel(const std::string& path) {
+    return endsWith(path, ".nb") ? "paddle_lite" : "onnxruntime";
+}
+
+void registerBackend(const std::string& name, SessionFactory factory) {
+    for (auto& backend : registeredBackends()) {
+        if (backend.first == name) {
+            backend.second = std::move(factory);
+            return;
+        }
+    }
+    registeredBackends().emplace_back(name, std::move(factory));
+}
+
+std::unique_ptr<InferenceSession> openSession(const std::string& backend, const std::string& path,
+                                              const SessionOptions& options) {
+    const std::string name = backend == "auto" ? backendForModel(path) : backend;
+    for (const auto& registered : registeredBackends()) {
+        if (registered.first == name) return registered.second(path, options);
+    }
+#ifdef WATER_OCR_WITH_ORT
+    if (name == "onnxruntime") return openOrtSession(path, options);
+#endif
+#ifdef WATER_OCR_WITH_PADDLE_LITE
+    if (name == "paddle_lite") return openPaddleLiteSession(path, options);
+#endif
+    throw std::runtime_error("Inference backend '" + name + "' is not available for " + options.label +
+                             " model " + path);
+}
+
+} // namespace ocr
@@ -0,0 +1,294 @@
+#include "batch_runner.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <exception>
+#include <map>
+#include <mutex>
+#include <utility>
+
+#include "image_io.h"
+#include "image_ops.h"
+#include "ocr_engine.h"
+#include "ocr_trace.h"
+#include "task_scheduler.h"
+
+namespace ocr {
+
+namespace {
+
+int alignUp(int value, int alignment) {
+    return (value + alignment - 1) / alignment * alignment;
+}
+
+// Shared det canvas for an image: landscape, portrait or square, so photos
+// from the same camera land in the same batch.
+std::pair<int, int> detCanvas(int width, int height, int maxSide) {
+    const int longSide = alignUp(maxSide, 32);
+    const int shortSide = alignUp(maxSide * 3 / 4, 32);
+    const float ratio = static_cast<float>(width) / height;
+    if (ratio >= 1.15f) return {longSide, shortSide};
+    if (ratio <= 1.0f / 1.15f) return {shortSide, longSide};
+    return {longSide, longSide};
+}
+
+struct ImageState {
+    RgbaImage image;
+    RgbaImage canvas;
+    float scale = 1.0f;
+    // With decodeScaled: the encoded file, kept for the full-resolution ROI
+    // decode, and the factor `image` was decoded at
+    std::vector<uint8_t> encoded;
+    int decodeScale = 1;
+    // EXIF orientation and full-resolution size of the stored pixels; det
+    // and crops work on the upright image, turned while resizing
+    Orientation orientation = Orientation::Normal;
+    int storedWidth = 0;
+    int storedHeight = 0;
+    std::vector<RgbaImage> crops;
+};
+
+void appendJsonString(std::string& out, const std::string& text) {
+    out += '"';
+    for (unsigned char c : text) {
+        switch (c) {
+        case '"': out += "\\\""; break;
+        case '\\': out += "\\\\"; break;
+        case '\n': out += "\\n"; break;
+        case '\r': out += "\\r"; break;
+        case '\t': out += "\\t"; break;
+        default:
+            if (c < 0x20) {
+                char buffer[8];
+                std::snprintf(buffer, sizeof(buffer), "\\u%04x", c);
+                out += buffer;
+            } else {
+                out += static_cast<char>(c);
+            }
+        }
+    }
+    out += '"';
+}
+
+void appendNumber(std::string& out, float value) {
+    char buffer[32];
+    std::snprintf(buffer, sizeof(buffer), "%.4g", value);
+    out += buffer;
+}
+
+} // namespace
+
+BatchRunner::BatchRunner(Engine& engine) : engine_(engine), scheduler_(engine.scheduler()) {}
+
+BatchRunner::~BatchRunner() = default;
+
+int BatchRunner::workers() const {
+    return scheduler_.concurrency();
+}
+
+std::vector<BatchResult> BatchRunner::run(const std::vector<BatchInput>& inputs) {
+    OCR_TRACE_SCOPE("BatchRunner::run", "batch");
+    const EngineConfig& config = engine_.config();
+    const int count = static_cast<int>(inputs.size());
+    std::vector<BatchResult> results(count);
+    std::vector<ImageState> states(count);
+
+    // Stage 1: decode and letterbox
+    scheduler_.parallelFor(count, [&](int i) {
+        OCR_TRACE_SCOPE("batch.decode", "batch");
+        const BatchInput& input = inputs[i];
+        BatchResult& result = results[i];
+        ImageState& state = states[i];
+        result.name = input.name.empty() ? input.path : input.name;
+        DecodeOptions options;
+        options.grayscale = config.decodeGray;
+        DecodeInfo info;
+        bool ok;
+        if (config.decodeScaled) {
+            // Decode straight to about the det size; crops come from a second,
+            // full-resolution decode of just the text in stage 3
+            if (input.encoded.empty() && !readFileBytes(input.path, state.encoded, result.error)) return;
+            const std::vector<uint8_t>& bytes = input.encoded.empty() ? state.encoded : input.encoded;
+            options.minLongSide = config.detMaxSide;
+            ok = decodeImage(bytes.data(), bytes.size(), options, state.image, &info, result.error);
+        } else {
+            ok = input.encoded.empty()
+                ? decodeImageFile(input.path, options, state.image, &info, result.error)
+                : decodeImage(input.encoded.data(), input.encoded.size(), options, state.image, &info,
+                              result.error);
+        }
+        if (!ok) return;
+        state.decodeScale = info.scale;
+        state.orientation = info.orientation;
+        state.storedWidth = info.width;
+        state.storedHeight = info.height;
+        // Sizes and regions are reported upright
+        const bool swap = swapsAxes(info.orientation);
+        result.width = swap ? info.height : info.width;
+        result.height = swap ? info.width : info.height;
+        std::pair<int, int> canvas = detCanvas(result.width, result.height, config.detMaxSide);
+        state.scale = letterbox(state.image, state.orientation, canvas.first, canvas.second, state.canvas);
+    });
+
+    // Stage 2: det, batched per canvas shape
+    std::map<std::pair<int, int>, std::vector<int>> byShape;
+    for (int i = 0; i < count; ++i) {
+        if (results[i].error.empty()) byShape[{states[i].canvas.width, states[i].canvas.height}].push_back(i);
+    }
+    std::vector<std::vector<int>> detBatches;
+    for (const auto& entry : byShape) {
+        const std::vector<int>& members = entry.second;
+        for (size_t start = 0; start < members.size(); start += config.detBatch) {
+            size_t end = std::min(members.size(), start + config.detBatch);
+            detBatches.emplace_back(members.begin() + start, members.begin() + end);
+        }
+    }
+    scheduler_.parallelFor(static_cast<int>(detBatches.size()), [&](int b) {
+        const std::vector<int>& members = detBatches[b];
+        std::vector<const uint32_t*> images;
+        for (int i : members) images.push_back(states[i].canvas.pixels.data());
+        const RgbaImage& first = states[members[0]].canvas;
+        try {
+            ContextLease lease = engine_.acquireContext();
+            std::vector<QuadSet> boxes = engine_.detectBatch(*lease, images, first.width, first.height);
+            for (size_t k = 0; k < members.size(); ++k) {
+                BatchResult& result = results[members[k]];
+                const float inverse = states[members[k]].decodeScale / states[members[k]].scale;
+                boxes[k].scale(inverse, inverse);
+                for (size_t q = 0; q < boxes[k].size(); ++q) {
+                    RegionResult region;
+                    boxes[k].corners(q, region.quad.data());
+                    region.score = boxes[k].score(q);
+                    result.regions.push_back(region);
+                }
+            }
+        } catch (const std::exception& e) {
+            for (int i : members) results[i].error = std::string("det failed: ") + e.what();
+        }
+    });
+
+    // Stage 3: crop every region from the full-resolution image
+    scheduler_.parallelFor(count, [&](int i) {
+        OCR_TRACE_SCOPE("batch.crop", "batch");
+        BatchResult& result = results[i];
+        ImageState& state = states[i];
+        state.canvas = RgbaImage();
+        state.crops.resize(result.regions.size());
+        std::vector<Rect> boxes(result.regions.size());
+        Rect bounds{0, 0, 0, 0};
+        for (size_t r = 0; r < result.regions.size(); ++r) {
+            const std::array<float, 8>& q = result.regions[r].quad;
+            Rect& box = boxes[r];
+            box.left = static_cast<int>(std::floor(std::min({q[0], q[2], q[4], q[6]})));
+            box.right = static_cast<int>(std::ceil(std::max({q[0], q[2], q[4], q[6]})));
+            box.top = static_cast<int>(std::floor(std::min({q[1], q[3], q[5], q[7]})));
+            box.bottom = static_cast<int>(std::ceil(std::max({q[1], q[3], q[5], q[7]})));
+            bounds = r == 0 ? box
+                            : Rect{std::min(bounds.left, box.left), std::min(bounds.top, box.top),
+                                   std::max(bounds.right, box.right), std::max(bounds.bottom, box.bottom)};
+        }
+        // A scaled decode is too coarse for rec: decode the regions' bounding
+        // box again at full resolution and crop from that
+        int originX = 0;
+        int originY = 0;
+        if (state.decodeScale > 1 && !boxes.empty()) {
+            const BatchInput& input = inputs[i];
+            const std::vector<uint8_t>& bytes = input.encoded.empty() ? state.encoded : input.encoded;
+            DecodeOptions options;
+            options.grayscale = config.decodeGray;
+            options.roi = storedRect(bounds, state.orientation, state.storedWidth, state.storedHeight);
+            DecodeInfo info;
+            if (!decodeImage(bytes.data(), bytes.size(), options, state.image, &info, result.error)) {
+                state.crops.clear();
+                return;
+            }
+            const Rect decoded = uprightRect(info.roi, state.orientation, state.storedWidth, state.storedHeight);
+            originX = decoded.left;
+            originY = decoded.top;
+        }
+        state.encoded = std::vector<uint8_t>();
+        for (size_t r = 0; r < boxes.size(); ++r) {
+            const Rect& box = boxes[r];
+            cropToHeight(state.image, state.orientation, box.left - originX, box.top - originY, box.right - originX,
+                         box.bottom - originY, config.recHeight, config.recMaxWidth, state.crops[r]);
+        }
+        state.image = RgbaImage();
+        if (config.useCls && !state.crops.empty()) {
+            try {
+                ContextLease lease = engine_.acquireContext();
+                for (RgbaImage& crop : state.crops) {
+                    if (!crop.empty()) engine_.orientCrop(*lease, crop);
+                }
+            } catch (const std::exception& e) {
+                result.error = std::string("cls failed: ") + e.what();
+                state.crops.clear();
+            }
+        }
+    });
+
+    // Stage 4: rec over crops pooled from all images, sorted by width so each
+    // batch pads as little as possible
+    std::vector<std::pair<int, int>> crops;
+    for (int i = 0; i < count; ++i) {
+        for (size_t r = 0; r < states[i].crops.size(); ++r) {
+            if (!states[i].crops[r].empty()) crops.emplace_back(i, static_cast<int>(r));
+        }
+    }
+    std::sort(crops.begin(), crops.end(), [&](const std::pair<int, int>& a, const std::pair<int, int>& b) {
+        return states[a.first].crops[a.second].width < states[b.first].crops[b.second].width;
+    });
+    const int recBatches = (static_cast<int>(crops.size()) + config.recBatch - 1) / config.recBatch;
+    // An image's crops may span batches that fail together
+    std::mutex errorMutex;
+    scheduler_.parallelFor(recBatches, [&](int b) {
+        size_t start = static_cast<size_t>(b) * config.recBatch;
+        size_t end = std::min(crops.size(), start + config.recBatch);
+        std::vector<const RgbaImage*> batch;
+        for (size_t k = start; k < end; ++k) batch.push_back(&states[crops[k].first].crops[crops[k].second]);
+        try {
+            ContextLease lease = engine_.acquireContext();
+            std::vector<Recognition> texts = engine_.recognizeBatch(*lease, batch);
+            for (size_t k = start; k < end; ++k) {
+                results[crops[k].first].regions[crops[k].second].recognition = std::move(texts[k - start]);
+            }
+        } catch (const std::exception& e) {
+            std::lock_guard<std::mutex> lock(errorMutex);
+            for (size_t k = start; k < end; ++k) results[crops[k].first].error = std::string("rec failed: ") + e.what();
+        }
+    });
+    return results;
+}
+
+std::string toJsonLine(const BatchResult& result) {
+    std::string out = "{\"file\":";
+    appendJsonString(out, result.name);
+    if (!result.error.empty()) {
+        out += ",\"error\":";
+        appendJsonString(out, result.error);
+        out += "}";
+        return out;
+    }
+    out += ",\"width\":" + std::to_string(result.width) + ",\"height\":" + std::to_string(result.height);
+    out += ",\"regions\":[";
+    for (size_t r = 0; r < result.regions.size(); ++r) {
+        const RegionResult& region = result.regions[r];
+        if (r) out += ',';
+        out += "{\"quad\":[";
+        for (int j = 0; j < 8; ++j) {
+            if (j) out += ',';
+            appendNumber(out, region.quad[j]);
+        }
+        out += "],\"score\":";
+        appendNumber(out, region.score);
+        out += ",\"text\":";
+        appendJsonString(out, region.recognition.text);
+        out += ",\"confidence\":";
+        appendNumber(out, region.recognition.confidence);
+        out += '}';
+    }
+    out += "]}";
+    return out;
+}
+
+} // namespace ocr
@@ -0,0 +1,65 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "ctc_decoder.h"
+
+namespace ocr {
+
+class Engine;
+class TaskScheduler;
+
+// One image to process: either a file path or an encoded JPEG/PNG buffer.
+struct BatchInput {
+    std::string name;
+    std::string path;
+    std::vector<uint8_t> encoded;
+};
+
+struct RegionResult {
+    // Quad corners in source image pixels: x1, y1, ... x4, y4.
+    std::array<float, 8> quad{};
+    float score = 0.0f;
+    Recognition recognition;
+};
+
+struct BatchResult {
+    std::string name;
+    int width = 0;
+    int height = 0;
+    std::vector<RegionResult> regions;
+    // Non-empty when the image could not be processed.
+    std::string error;
+};
+
+// Offline throughput path for reprocessing archives. run() decodes all inputs
+// in parallel, letterboxes them into a few shared det shapes so det runs with
+// batch > 1, then pools the crops of every image into width-sorted rec
+// batches. Crops go through cls before rec, as in Engine::readMeter. Each
+// stage is spread over the engine's scheduler (EngineConfig::workers), so a
+// runner and other engine calls share one pool instead of oversubscribing
+// the cores; every task uses its own engine run context.
+class BatchRunner {
+public:
+    explicit BatchRunner(Engine& engine);
+    ~BatchRunner();
+
+    // Threads each stage runs on, the calling thread included.
+    int workers() const;
+
+    // Results are in input order. Per-image failures are reported in
+    // BatchResult::error rather than thrown.
+    std::vector<BatchResult> run(const std::vector<BatchInput>& inputs);
+
+private:
+    Engine& engine_;
+    TaskScheduler& scheduler_;
+};
+
+// Single-line JSON object for one result (JSON Lines output).
+std::string toJsonLine(const BatchResult& result);
+
+} // namespace ocr
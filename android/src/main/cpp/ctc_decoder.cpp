@@ -0,0 +1,78 @@
+#include "ctc_decoder.h"
+
+#include <fstream>
+
+#include "ocr_log.h"
+
+namespace ocr {
+
+namespace {
+const std::string kEmpty;
+}
+
+CharDict::CharDict() {
+    for (char c = '0'; c <= '9'; ++c) labels_.emplace_back(1, c);
+}
+
+bool CharDict::load(const std::string& path, bool appendSpace) {
+    std::ifstream in(path);
+    if (!in) {
+        LOGE("Cannot open character dictionary %s", path.c_str());
+        return false;
+    }
+    std::vector<std::string> labels;
+    std::string line;
+    while (std::getline(in, line)) {
+        if (!line.empty() && line.back() == '\r') line.pop_back();
+        labels.push_back(line);
+    }
+    if (appendSpace) labels.emplace_back(" ");
+    labels_.swap(labels);
+    LOGI("Loaded %zu dictionary labels from %s", labels_.size(), path.c_str());
+    return true;
+}
+
+const std::string& CharDict::label(int classIndex) const {
+    if (classIndex <= 0 || classIndex > static_cast<int>(labels_.size())) return kEmpty;
+    return labels_[classIndex - 1];
+}
+
+Recognition ctcGreedyDecode(const float* probs, int timeSteps, int numClasses, const CharDict& dict) {
+    Recognition result;
+    ctcGreedyDecode(probs, timeSteps, numClasses, dict, result);
+    return result;
+}
+
+void ctcGreedyDecode(const float* probs, int timeSteps, int numClasses, const CharDict& dict, Recognition& result) {
+    result.text.clear();
+    result.charConfidences.clear();
+    result.confidence = 0.0f;
+    result.fractionDigits = 0;
+    int previous = 0;
+    float scoreSum = 0.0f;
+    for (int t = 0; t < timeSteps; ++t) {
+        const float* step = probs + static_cast<size_t>(t) * numClasses;
+        int best = 0;
+        float bestProb = step[0];
+        for (int c = 1; c < numClasses; ++c) {
+            if (step[c] > bestProb) {
+                bestProb = step[c];
+                best = c;
+            }
+        }
+        if (best != 0 && best != previous) {
+            const std::string& label = dict.label(best);
+            if (!label.empty()) {
+                result.text += label;
+                result.charConfidences.push_back(bestProb);
+                scoreSum += bestProb;
+            }
+        }
+        previous = best;
+    }
+    if (!result.charConfidences.empty()) {
+        result.confidence = scoreSum / result.charConfidences.size();
+    }
+}
+
+} // namespace ocr
@@ -0,0 +1,44 @@
+#pragma once
+
+#include <string>
+#include <vector>
+
+namespace ocr {
+
+// Decoded text of one recognition crop.
+struct Recognition {
+    std::string text;
+    // Mean probability of the emitted characters, 0 for empty text.
+    float confidence = 0.0f;
+    std::vector<float> charConfidences;
+    // Trailing digits of text that are decimals; set by ReadingDecoder.
+    int fractionDigits = 0;
+};
+
+// Maps rec model class indices to UTF-8 labels. Class 0 is the CTC blank and
+// class i is line i of the PaddleOCR dictionary file, optionally followed by a
+// space class. Without a file the labels are the ten ASCII digits.
+class CharDict {
+public:
+    CharDict();
+
+    bool load(const std::string& path, bool appendSpace = true);
+
+    // Label of `classIndex`, empty for the blank and out-of-range indices.
+    const std::string& label(int classIndex) const;
+
+    // Number of model classes covered, blank included.
+    int classCount() const { return static_cast<int>(labels_.size()) + 1; }
+
+private:
+    std::vector<std::string> labels_;
+};
+
+// Best-path CTC decoding of softmax output laid out as [timeSteps, numClasses]:
+// take the arg-max class per step, merge repeats and drop blanks.
+Recognition ctcGreedyDecode(const float* probs, int timeSteps, int numClasses, const CharDict& dict);
+
+// Same, overwriting `result` and reusing its string and vector capacity.
+void ctcGreedyDecode(const float* probs, int timeSteps, int numClasses, const CharDict& dict, Recognition& result);
+
+} // namespace ocr
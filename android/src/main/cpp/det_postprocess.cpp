@@ -0,0 +1,79 @@
+#include "det_postprocess.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+#include "frame_arena.h"
+
+namespace ocr {
+
+void dbBoxes(const float* prob, int width, int height, const DbParams& params,
+             float scaleX, float scaleY, QuadSet& boxes, FrameArena* arena) {
+    if (width <= 0 || height <= 0) return;
+    const size_t size = static_cast<size_t>(width) * height;
+    // Every pixel is pushed at most once, so a map-sized stack never overflows
+    std::vector<uint8_t> heapVisited;
+    std::vector<int> heapStack;
+    uint8_t* visited;
+    int* stack;
+    if (arena) {
+        visited = arena->allocate<uint8_t>(size);
+        stack = arena->allocate<int>(size);
+    } else {
+        heapVisited.resize(size);
+        heapStack.resize(size);
+        visited = heapVisited.data();
+        stack = heapStack.data();
+    }
+    std::memset(visited, 0, size);
+
+    for (size_t start = 0; start < size; ++start) {
+        if (visited[start] || prob[start] <= params.binThreshold) continue;
+
+        // Flood fill one component, tracking its bounds and score
+        int left = width, top = height, right = -1, bottom = -1;
+        double sum = 0.0;
+        int count = 0;
+        visited[start] = 1;
+        size_t depth = 0;
+        stack[depth++] = static_cast<int>(start);
+        while (depth > 0) {
+            int index = stack[--depth];
+            int x = index % width;
+            int y = index / width;
+            left = std::min(left, x);
+            right = std::max(right, x);
+            top = std::min(top, y);
+            bottom = std::max(bottom, y);
+            sum += prob[index];
+            ++count;
+
+            const int neighbours[4] = {x > 0 ? index - 1 : -1, x + 1 < width ? index + 1 : -1,
+                                       y > 0 ? index - width : -1, y + 1 < height ? index + width : -1};
+            for (int n : neighbours) {
+                if (n >= 0 && !visited[n] && prob[n] > params.binThreshold) {
+                    visited[n] = 1;
+                    stack[depth++] = n;
+                }
+            }
+        }
+
+        float boxWidth = static_cast<float>(right - left + 1);
+        float boxHeight = static_cast<float>(bottom - top + 1);
+        if (std::min(boxWidth, boxHeight) < params.minSize) continue;
+        float score = static_cast<float>(sum / count);
+        if (score < params.boxThreshold) continue;
+
+        // Unclip: DB predicts a shrunk kernel, grow it back by a margin
+        float margin = boxWidth * boxHeight * params.unclipRatio / (2.0f * (boxWidth + boxHeight));
+        float x0 = std::max(0.0f, left - margin) * scaleX;
+        float y0 = std::max(0.0f, top - margin) * scaleY;
+        float x1 = std::min(static_cast<float>(width), right + 1 + margin) * scaleX;
+        float y1 = std::min(static_cast<float>(height), bottom + 1 + margin) * scaleY;
+        boxes.pushRect(x0, y0, x1, y1, score);
+    }
+}
+
+} // namespace ocr
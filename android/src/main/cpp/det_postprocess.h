@@ -0,0 +1,29 @@
+#pragma once
+
+#include "quad_set.h"
+
+namespace ocr {
+
+class FrameArena;
+
+// DB (differentiable binarization) postprocess for det models that output a
+// text probability map rather than a box list.
+struct DbParams {
+    // Pixels above binThreshold are text.
+    float binThreshold = 0.3f;
+    // Minimum mean probability of a region to be reported.
+    float boxThreshold = 0.5f;
+    // The shrunk text kernel is grown by area * unclipRatio / perimeter.
+    float unclipRatio = 1.5f;
+    // Regions whose shorter side is below this many map pixels are dropped.
+    int minSize = 3;
+};
+
+// Finds the 4-connected text regions of a width x height probability map and
+// appends one axis-aligned box per region to `boxes`, in map pixels
+// multiplied by scaleX/scaleY. The flood-fill scratch comes from `arena` when
+// one is given.
+void dbBoxes(const float* prob, int width, int height, const DbParams& params,
+             float scaleX, float scaleY, QuadSet& boxes, FrameArena* arena = nullptr);
+
+} // namespace ocr
@@ -0,0 +1,57 @@
+#include "frame_arena.h"
+
+#include <algorithm>
+#include <cstdint>
+
+namespace ocr {
+
+FrameArena::FrameArena(size_t blockSize) : blockSize_(std::max<size_t>(blockSize, 1024)) {}
+
+void* FrameArena::allocate(size_t bytes, size_t alignment) {
+    bytes = std::max<size_t>(bytes, 1);
+    for (;;) {
+        if (current_ < blocks_.size()) {
+            Block& block = blocks_[current_];
+            uintptr_t base = reinterpret_cast<uintptr_t>(block.data.get());
+            size_t aligned = ((base + offset_ + alignment - 1) & ~(uintptr_t(alignment) - 1)) - base;
+            if (aligned + bytes <= block.size) {
+                used_ += aligned + bytes - offset_;
+                offset_ = aligned + bytes;
+                return block.data.get() + aligned;
+            }
+            // The tail of this block stays unused until the next reset
+            used_ += block.size - offset_;
+            ++current_;
+            offset_ = 0;
+            continue;
+        }
+        addBlock(bytes + alignment);
+    }
+}
+
+void FrameArena::reset() {
+    if (blocks_.size() > 1) {
+        // Next frame fits in one block without growing
+        size_t total = capacity();
+        blocks_.clear();
+        addBlock(total);
+    }
+    current_ = 0;
+    offset_ = 0;
+    used_ = 0;
+}
+
+size_t FrameArena::capacity() const {
+    size_t total = 0;
+    for (const Block& block : blocks_) total += block.size;
+    return total;
+}
+
+void FrameArena::addBlock(size_t minBytes) {
+    // Doubling keeps the number of blocks per frame logarithmic
+    size_t size = std::max(minBytes, std::max(blockSize_, capacity()));
+    blocks_.push_back({std::unique_ptr<unsigned char[]>(new unsigned char[size]), size});
+    ++heapAllocations_;
+}
+
+} // namespace ocr
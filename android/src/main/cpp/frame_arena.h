@@ -0,0 +1,97 @@
+#pragma once
+
+#include <cstddef>
+#include <memory>
+#include <vector>
+
+namespace ocr {
+
+// Bump allocator for the temporaries of one frame: tap tables, flood-fill
+// stacks, tile lists and similar buffers that die when the frame is done.
+//
+// allocate() hands out aligned slices of a block and never frees them one
+// by one; reset() releases everything at once. When a frame outgrew the
+// first block, reset() replaces the blocks with a single one large enough
+// for that frame, so once the arena has seen the largest frame it no longer
+// touches the heap.
+//
+// Not thread-safe: each run context owns its own arena.
+class FrameArena {
+public:
+    explicit FrameArena(size_t blockSize = 64 * 1024);
+
+    FrameArena(const FrameArena&) = delete;
+    FrameArena& operator=(const FrameArena&) = delete;
+
+    // Uninitialized storage, valid until the next reset().
+    void* allocate(size_t bytes, size_t alignment = alignof(std::max_align_t));
+
+    template <typename T>
+    T* allocate(size_t count) {
+        return static_cast<T*>(allocate(count * sizeof(T), alignof(T)));
+    }
+
+    // Invalidates every allocation made since the previous reset.
+    void reset();
+
+    // Bytes handed out since the last reset, alignment padding included.
+    size_t used() const { return used_; }
+    // Bytes held in blocks.
+    size_t capacity() const;
+    // Blocks allocated from the heap over the arena's lifetime.
+    size_t heapAllocations() const { return heapAllocations_; }
+
+private:
+    struct Block {
+        std::unique_ptr<unsigned char[]> data;
+        size_t size;
+    };
+
+    void addBlock(size_t minBytes);
+
+    size_t blockSize_;
+    std::vector<Block> blocks_;
+    size_t current_ = 0;
+    size_t offset_ = 0;
+    size_t used_ = 0;
+    size_t heapAllocations_ = 0;
+};
+
+// Standard allocator over a FrameArena, for containers that live within one
+// frame. deallocate() is a no-op; storage is reclaimed by FrameArena::reset().
+template <typename T>
+class ArenaAllocator {
+public:
+    using value_type = T;
+
+    explicit ArenaAllocator(FrameArena& arena) : arena_(&arena) {}
+    template <typename U>
+    ArenaAllocator(const ArenaAllocator<U>& other) : arena_(other.arena()) {}
+
+    T* allocate(size_t count) { return arena_->allocate<T>(count); }
+    void deallocate(T*, size_t) {}
+
+    FrameArena* arena() const { return arena_; }
+
+    template <typename U>
+    bool operator==(const ArenaAllocator<U>& other) const { return arena_ == other.arena(); }
+    template <typename U>
+    bool operator!=(const ArenaAllocator<U>& other) const { return arena_ != other.arena(); }
+
+private:
+    FrameArena* arena_;
+};
+
+template <typename T>
+using ArenaVector = std::vector<T, ArenaAllocator<T>>;
+
+// `count` uninitialized elements from `arena`, or from `heap` without one,
+// for kernels that take an optional arena.
+template <typename T>
+T* scratch(FrameArena* arena, std::vector<T>& heap, size_t count) {
+    if (arena) return arena->allocate<T>(count);
+    heap.resize(count);
+    return heap.data();
+}
+
+} // namespace ocr
@@ -0,0 +1,182 @@
+#include "frame_quality.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <vector>
+
+#include "frame_arena.h"
+#include "ocr_trace.h"
+#include "pixel_convert.h"
+
+#if defined(__ARM_NEON)
+#include <arm_neon.h>
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+namespace ocr {
+
+namespace {
+
+// Keeps a row's squared Laplacians within int32 lanes
+constexpr int kMaxThumbnailSide = 1024;
+
+#if defined(__ARM_NEON)
+// vaddvq_s32 is AArch64 only
+int64_t addLanes(int32x4_t v) {
+    return static_cast<int64_t>(vgetq_lane_s32(v, 0)) + vgetq_lane_s32(v, 1) + vgetq_lane_s32(v, 2) +
+           vgetq_lane_s32(v, 3);
+}
+#endif
+
+// Sum and sum of squares of the Laplacian 4c - l - r - u - d over columns
+// [1, width - 1) of row `c`, between rows `u` and `d`. Values fit int16
+// (|L| <= 1020), and each lane's share of a row's squares fits int32 up to
+// kMaxThumbnailSide.
+void laplacianRow(const uint8_t* u, const uint8_t* c, const uint8_t* d, int width, int64_t& sum,
+                  int64_t& squares) {
+    int x = 1;
+    int32_t rowSum = 0;
+    int64_t rowSquares = 0;
+#if defined(__ARM_NEON)
+    int32x4_t sums = vdupq_n_s32(0);
+    int32x4_t squareSums = vdupq_n_s32(0);
+    for (; x + 8 <= width - 1; x += 8) {
+        const int16x8_t centre = vreinterpretq_s16_u16(vshll_n_u8(vld1_u8(c + x), 2));
+        const uint16x8_t sides = vaddq_u16(vaddl_u8(vld1_u8(c + x - 1), vld1_u8(c + x + 1)),
+                                           vaddl_u8(vld1_u8(u + x), vld1_u8(d + x)));
+        const int16x8_t lap = vsubq_s16(centre, vreinterpretq_s16_u16(sides));
+        sums = vpadalq_s16(sums, lap);
+        squareSums = vmlal_s16(squareSums, vget_low_s16(lap), vget_low_s16(lap));
+        squareSums = vmlal_s16(squareSums, vget_high_s16(lap), vget_high_s16(lap));
+    }
+    rowSum += static_cast<int32_t>(addLanes(sums));
+    rowSquares += addLanes(squareSums);
+#elif defined(__SSE2__)
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i ones = _mm_set1_epi16(1);
+    __m128i sums = zero;
+    __m128i squareSums = zero;
+    auto load = [&](const uint8_t* p) {
+        return _mm_unpacklo_epi8(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(p)), zero);
+    };
+    for (; x + 8 <= width - 1; x += 8) {
+        const __m128i centre = _mm_slli_epi16(load(c + x), 2);
+        const __m128i sides = _mm_add_epi16(_mm_add_epi16(load(c + x - 1), load(c + x + 1)),
+                                            _mm_add_epi16(load(u + x), load(d + x)));
+        const __m128i lap = _mm_sub_epi16(centre, sides);
+        sums = _mm_add_epi32(sums, _mm_madd_epi16(lap, ones));
+        squareSums = _mm_add_epi32(squareSums, _mm_madd_epi16(lap, lap));
+    }
+    int32_t lanes[4];
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(lanes), sums);
+    rowSum += lanes[0] + lanes[1] + lanes[2] + lanes[3];
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(lanes), squareSums);
+    rowSquares += static_cast<int64_t>(lanes[0]) + lanes[1] + lanes[2] + lanes[3];
+#endif
+    for (; x < width - 1; ++x) {
+        const int lap = 4 * c[x] - c[x - 1] - c[x + 1] - u[x] - d[x];
+        rowSum += lap;
+        rowSquares += lap * lap;
+    }
+    sum += rowSum;
+    squares += rowSquares;
+}
+
+} // namespace
+
+int lumaPercentile(const uint32_t* histogram, uint32_t total, float fraction) {
+    const uint32_t target = static_cast<uint32_t>(fraction * total);
+    uint32_t seen = 0;
+    for (int level = 0; level < 256; ++level) {
+        seen += histogram[level];
+        if (seen > target) return level;
+    }
+    return 255;
+}
+
+FrameQuality assessQuality(const ImageView& src, const QualityParams& params, FrameArena* arena) {
+    OCR_TRACE_SCOPE("assessQuality", "preprocess");
+    FrameQuality quality;
+    if (src.empty()) {
+        quality.issue = QualityIssue::LowContrast;
+        return quality;
+    }
+    // Never upscale: small frames are measured as they are
+    const int longSide = std::max(src.roi.width(), src.roi.height());
+    const int side = std::max(3, std::min({params.thumbnailSide, longSide, kMaxThumbnailSide}));
+    const int width = std::max(1, static_cast<int>(static_cast<int64_t>(src.roi.width()) * side / longSide));
+    const int height = std::max(1, static_cast<int>(static_cast<int64_t>(src.roi.height()) * side / longSide));
+    const size_t count = static_cast<size_t>(width) * height;
+    std::vector<uint8_t> heapThumbnail;
+    uint8_t* thumbnail;
+    if (arena) {
+        thumbnail = arena->allocate<uint8_t>(count);
+    } else {
+        heapThumbnail.resize(count);
+        thumbnail = heapThumbnail.data();
+    }
+    lumaThumbnail(src, width, height, thumbnail);
+
+    // Exposure from the histogram
+    uint32_t histogram[256] = {};
+    for (size_t i = 0; i < count; ++i) ++histogram[thumbnail[i]];
+    uint64_t total = 0;
+    uint32_t clipped = 0;
+    for (int level = 0; level < 256; ++level) {
+        total += static_cast<uint64_t>(level) * histogram[level];
+        if (level >= params.clipLevel) clipped += histogram[level];
+    }
+    quality.mean = static_cast<float>(total) / count;
+    quality.clipped = static_cast<float>(clipped) / count;
+    const uint32_t pixels = static_cast<uint32_t>(count);
+    quality.spread =
+        static_cast<float>(lumaPercentile(histogram, pixels, 0.95f) - lumaPercentile(histogram, pixels, 0.05f));
+
+    // Focus from the variance of the Laplacian over the interior
+    if (width >= 3 && height >= 3) {
+        int64_t sum = 0;
+        int64_t squares = 0;
+        for (int y = 1; y + 1 < height; ++y) {
+            const uint8_t* row = thumbnail + static_cast<size_t>(y) * width;
+            laplacianRow(row - width, row, row + width, width, sum, squares);
+        }
+        const double n = static_cast<double>(width - 2) * (height - 2);
+        const double mean = sum / n;
+        quality.sharpness = static_cast<float>(squares / n - mean * mean);
+    }
+
+    if (quality.clipped > params.maxClipped) {
+        quality.issue = QualityIssue::Glare;
+    } else if (quality.mean < params.minMean) {
+        quality.issue = QualityIssue::Dark;
+    } else if (quality.spread < params.minSpread) {
+        quality.issue = QualityIssue::LowContrast;
+    } else if (quality.sharpness < params.minSharpness) {
+        quality.issue = QualityIssue::Blur;
+    }
+    return quality;
+}
+
+void rankFrames(const FrameQuality* frames, size_t count, int topK, std::vector<uint32_t>& out) {
+    out.resize(count);
+    for (size_t i = 0; i < count; ++i) out[i] = static_cast<uint32_t>(i);
+    std::stable_sort(out.begin(), out.end(), [frames](uint32_t a, uint32_t b) {
+        if (frames[a].usable() != frames[b].usable()) return frames[a].usable();
+        return frames[a].sharpness > frames[b].sharpness;
+    });
+    if (topK > 0 && out.size() > static_cast<size_t>(topK)) out.resize(topK);
+}
+
+const char* qualityIssueName(QualityIssue issue) {
+    switch (issue) {
+    case QualityIssue::None: return "none";
+    case QualityIssue::Blur: return "blur";
+    case QualityIssue::Glare: return "glare";
+    case QualityIssue::Dark: return "dark";
+    case QualityIssue::LowContrast: return "low_contrast";
+    }
+    return "unknown";
+}
+
+} // namespace ocr
@@ -0,0 +1,69 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "image_view.h"
+
+namespace ocr {
+
+class FrameArena;
+
+// Why a frame is not worth running the models on. The values cross the C
+// ABI and JNI, so they only ever gain members.
+enum class QualityIssue {
+    None = 0,
+    Blur = 1,         // too little edge energy: motion or focus blur
+    Glare = 2,        // too many clipped highlights, e.g. flash on the glass
+    Dark = 3,         // underexposed
+    LowContrast = 4,  // narrow histogram: fogged, washed out or featureless
+};
+
+// Rejection thresholds, measured on a luma thumbnail of thumbnailSide
+// pixels on its longer side. Tune them per camera; the defaults only turn
+// down frames that are plainly unreadable.
+struct QualityParams {
+    int thumbnailSide = 256;
+    // Variance of the 4-neighbour Laplacian
+    float minSharpness = 40.0f;
+    // Fraction of pixels at or above clipLevel
+    float maxClipped = 0.1f;
+    int clipLevel = 250;
+    // Mean luma, and the distance between the 5th and 95th percentiles
+    float minMean = 35.0f;
+    float minSpread = 32.0f;
+};
+
+struct FrameQuality {
+    float sharpness = 0.0f;
+    float clipped = 0.0f;
+    float mean = 0.0f;
+    float spread = 0.0f;
+    // The first threshold the frame misses, checked as listed in
+    // QualityIssue from Glare on, then Blur: edges mean little in a frame
+    // that is blown out or black.
+    QualityIssue issue = QualityIssue::None;
+
+    bool usable() const { return issue == QualityIssue::None; }
+};
+
+// Measures the ROI of `src` in any pixel format. Reads a few taps per
+// thumbnail pixel, so it costs a fraction of a millisecond whatever the frame
+// size; the thumbnail comes from `arena` when one is given.
+FrameQuality assessQuality(const ImageView& src, const QualityParams& params = QualityParams(),
+                           FrameArena* arena = nullptr);
+
+// Indices of the frames of a burst in the order they are worth reading:
+// usable frames before rejected ones, each by sharpness, which rises with
+// contrast as well as focus. At most topK of them; 0 keeps all.
+void rankFrames(const FrameQuality* frames, size_t count, int topK, std::vector<uint32_t>& out);
+
+// Luma level below which `fraction` of the `total` pixels counted in a
+// 256-bin histogram lie.
+int lumaPercentile(const uint32_t* histogram, uint32_t total, float fraction);
+
+// Lower-case name of an issue, for logs and results ("blur", "glare", ...).
+const char* qualityIssueName(QualityIssue issue);
+
+} // namespace ocr
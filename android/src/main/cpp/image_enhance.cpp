@@ -0,0 +1,424 @@
+#include "image_enhance.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <vector>
+
+#include "frame_arena.h"
+#include "frame_quality.h"
+#include "ocr_trace.h"
+
+#if defined(__aarch64__)
+#include <arm_neon.h>
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+namespace ocr {
+
+namespace {
+
+// Window sums of squared centred pixels, at most 128^2 times 255^2 pixels,
+// must fit an int32 for the wrap-around integral arithmetic below
+constexpr int kMaxSauvolaRadius = 127;
+
+// Crops whose 1st..99th luma percentiles are closer than this are stretched
+// to it at most, so a flat crop does not turn into amplified noise
+constexpr int kMinStretchRange = 32;
+
+// Moves the band of the column sums down a row: adds the centred pixels of
+// `entering` and their squares, drops those of `leaving`. A row of 128s
+// stands in for rows beyond the image. Sums are modular: only differences
+// taken across a window need to be exact.
+void slideColumns(const uint8_t* entering, const uint8_t* leaving, int width, uint32_t* sums, uint32_t* squares) {
+    int x = 0;
+#if defined(__aarch64__)
+    const uint8x8_t centre = vdup_n_u8(128);
+    for (; x + 8 <= width; x += 8) {
+        const int16x8_t in = vreinterpretq_s16_u16(vsubl_u8(vld1_u8(entering + x), centre));
+        const int16x8_t out = vreinterpretq_s16_u16(vsubl_u8(vld1_u8(leaving + x), centre));
+        const int16x8_t change = vsubq_s16(in, out);
+        int32_t* s = reinterpret_cast<int32_t*>(sums + x);
+        int32_t* q = reinterpret_cast<int32_t*>(squares + x);
+        vst1q_s32(s, vaddw_s16(vld1q_s32(s), vget_low_s16(change)));
+        vst1q_s32(s + 4, vaddw_s16(vld1q_s32(s + 4), vget_high_s16(change)));
+        int32x4_t low = vmlal_s16(vld1q_s32(q), vget_low_s16(in), vget_low_s16(in));
+        int32x4_t high = vmlal_s16(vld1q_s32(q + 4), vget_high_s16(in), vget_high_s16(in));
+        vst1q_s32(q, vmlsl_s16(low, vget_low_s16(out), vget_low_s16(out)));
+        vst1q_s32(q + 4, vmlsl_s16(high, vget_high_s16(out), vget_high_s16(out)));
+    }
+#elif defined(__SSE2__)
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i centre = _mm_set1_epi16(128);
+    auto load = [&](const uint8_t* p) {
+        return _mm_sub_epi16(_mm_unpacklo_epi8(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(p)), zero), centre);
+    };
+    auto add = [](uint32_t* p, __m128i value) {
+        __m128i* at = reinterpret_cast<__m128i*>(p);
+        _mm_storeu_si128(at, _mm_add_epi32(_mm_loadu_si128(at), value));
+    };
+    for (; x + 8 <= width; x += 8) {
+        const __m128i in = load(entering + x);
+        const __m128i out = load(leaving + x);
+        const __m128i change = _mm_sub_epi16(in, out);
+        // Sign-extended halves of the change
+        add(sums + x, _mm_srai_epi32(_mm_unpacklo_epi16(change, change), 16));
+        add(sums + x + 4, _mm_srai_epi32(_mm_unpackhi_epi16(change, change), 16));
+        // in * in - out * out from interleaved pairs
+        const __m128i negated = _mm_sub_epi16(zero, out);
+        add(squares + x, _mm_madd_epi16(_mm_unpacklo_epi16(in, out), _mm_unpacklo_epi16(in, negated)));
+        add(squares + x + 4, _mm_madd_epi16(_mm_unpackhi_epi16(in, out), _mm_unpackhi_epi16(in, negated)));
+    }
+#endif
+    for (; x < width; ++x) {
+        const int32_t in = static_cast<int32_t>(entering[x]) - 128;
+        const int32_t out = static_cast<int32_t>(leaving[x]) - 128;
+        sums[x] += static_cast<uint32_t>(in - out);
+        squares[x] += static_cast<uint32_t>(in * in - out * out);
+    }
+}
+
+// The Sauvola test for one pixel from the window's sums of centred values
+uint8_t sauvolaPixel(uint8_t value, int32_t sum, int32_t squares, float inverseCount, float k, float inverseRange) {
+    const float centredMean = static_cast<float>(sum) * inverseCount;
+    const float variance = static_cast<float>(squares) * inverseCount - centredMean * centredMean;
+    const float deviation = std::sqrt(std::max(variance, 0.0f));
+    const float threshold = (centredMean + 128.0f) * (1.0f + k * (deviation * inverseRange - 1.0f));
+    return static_cast<float>(value) > threshold ? 255 : 0;
+}
+
+// One output row. `prefix` and `prefixSquares` integrate the column sums of
+// `rows` rows over x; windows are clipped to the image at its edges.
+void sauvolaRow(const uint8_t* src, int width, int radius, int rows, const uint32_t* prefix,
+                const uint32_t* prefixSquares, float k, float inverseRange, uint8_t* dst) {
+    auto clipped = [&](int x) {
+        const int x0 = std::max(0, x - radius);
+        const int x1 = std::min(width, x + radius + 1);
+        dst[x] = sauvolaPixel(src[x], static_cast<int32_t>(prefix[x1] - prefix[x0]),
+                              static_cast<int32_t>(prefixSquares[x1] - prefixSquares[x0]),
+                              1.0f / static_cast<float>(rows * (x1 - x0)), k, inverseRange);
+    };
+    const int interiorBegin = std::min(radius, width);
+    const int interiorEnd = std::max(interiorBegin, width - radius);
+    for (int x = 0; x < interiorBegin; ++x) clipped(x);
+
+    // Full windows all hold the same number of pixels
+    const int span = 2 * radius + 1;
+    const float inverseCount = 1.0f / static_cast<float>(rows * span);
+    int x = interiorBegin;
+#if defined(__aarch64__)
+    const float32x4_t invCount = vdupq_n_f32(inverseCount);
+    const float32x4_t one = vdupq_n_f32(1.0f);
+    const float32x4_t offset = vdupq_n_f32(128.0f);
+    const float32x4_t kVec = vdupq_n_f32(k);
+    const float32x4_t invRange = vdupq_n_f32(inverseRange);
+    for (; x + 4 <= interiorEnd; x += 4) {
+        const uint32x4_t sum = vsubq_u32(vld1q_u32(prefix + x + radius + 1), vld1q_u32(prefix + x - radius));
+        const uint32x4_t squares =
+            vsubq_u32(vld1q_u32(prefixSquares + x + radius + 1), vld1q_u32(prefixSquares + x - radius));
+        const float32x4_t mean = vmulq_f32(vcvtq_f32_s32(vreinterpretq_s32_u32(sum)), invCount);
+        const float32x4_t variance =
+            vsubq_f32(vmulq_f32(vcvtq_f32_s32(vreinterpretq_s32_u32(squares)), invCount), vmulq_f32(mean, mean));
+        const float32x4_t deviation = vsqrtq_f32(vmaxq_f32(variance, vdupq_n_f32(0.0f)));
+        const float32x4_t factor =
+            vaddq_f32(one, vmulq_f32(kVec, vsubq_f32(vmulq_f32(deviation, invRange), one)));
+        const float32x4_t threshold = vmulq_f32(vaddq_f32(mean, offset), factor);
+        uint32_t values;
+        std::memcpy(&values, src + x, 4);
+        const uint16x8_t widened = vmovl_u8(vreinterpret_u8_u32(vdup_n_u32(values)));
+        const uint32x4_t above = vcgtq_f32(vcvtq_f32_u32(vmovl_u16(vget_low_u16(widened))), threshold);
+        // All-ones lanes narrow to 0xff bytes, zero lanes to 0
+        const uint16x4_t half = vmovn_u32(above);
+        const uint32_t packed = vget_lane_u32(vreinterpret_u32_u8(vmovn_u16(vcombine_u16(half, half))), 0);
+        std::memcpy(dst + x, &packed, 4);
+    }
+#elif defined(__SSE2__)
+    const __m128 invCount = _mm_set1_ps(inverseCount);
+    const __m128 one = _mm_set1_ps(1.0f);
+    const __m128 offset = _mm_set1_ps(128.0f);
+    const __m128 kVec = _mm_set1_ps(k);
+    const __m128 invRange = _mm_set1_ps(inverseRange);
+    const __m128i zero = _mm_setzero_si128();
+    auto load = [](const uint32_t* p) { return _mm_loadu_si128(reinterpret_cast<const __m128i*>(p)); };
+    for (; x + 4 <= interiorEnd; x += 4) {
+        const __m128i sum = _mm_sub_epi32(load(prefix + x + radius + 1), load(prefix + x - radius));
+        const __m128i squares = _mm_sub_epi32(load(prefixSquares + x + radius + 1), load(prefixSquares + x - radius));
+        const __m128 mean = _mm_mul_ps(_mm_cvtepi32_ps(sum), invCount);
+        const __m128 variance = _mm_sub_ps(_mm_mul_ps(_mm_cvtepi32_ps(squares), invCount), _mm_mul_ps(mean, mean));
+        const __m128 deviation = _mm_sqrt_ps(_mm_max_ps(variance, _mm_setzero_ps()));
+        const __m128 factor = _mm_add_ps(one, _mm_mul_ps(kVec, _mm_sub_ps(_mm_mul_ps(deviation, invRange), one)));
+        const __m128 threshold = _mm_mul_ps(_mm_add_ps(mean, offset), factor);
+        int32_t values;
+        std::memcpy(&values, src + x, 4);
+        const __m128i widened = _mm_unpacklo_epi16(_mm_unpacklo_epi8(_mm_cvtsi32_si128(values), zero), zero);
+        // All-ones lanes narrow to 0xff bytes, zero lanes to 0
+        const __m128i above = _mm_castps_si128(_mm_cmpgt_ps(_mm_cvtepi32_ps(widened), threshold));
+        const __m128i bytes = _mm_packs_epi16(_mm_packs_epi32(above, above), zero);
+        const int32_t packed = _mm_cvtsi128_si32(bytes);
+        std::memcpy(dst + x, &packed, 4);
+    }
+#endif
+    for (; x < interiorEnd; ++x) {
+        dst[x] = sauvolaPixel(src[x], static_cast<int32_t>(prefix[x + radius + 1] - prefix[x - radius]),
+                              static_cast<int32_t>(prefixSquares[x + radius + 1] - prefixSquares[x - radius]),
+                              inverseCount, k, inverseRange);
+    }
+    for (x = interiorEnd; x < width; ++x) clipped(x);
+}
+
+// Caps the histogram at `limit` per bin and spreads the excess evenly
+void clipHistogram(uint32_t* histogram, uint32_t limit) {
+    uint32_t excess = 0;
+    for (int i = 0; i < 256; ++i) {
+        if (histogram[i] > limit) {
+            excess += histogram[i] - limit;
+            histogram[i] = limit;
+        }
+    }
+    const uint32_t share = excess / 256;
+    const uint32_t remainder = excess % 256;
+    for (int i = 0; i < 256; ++i) histogram[i] += share;
+    // The rest goes to bins spaced evenly across the range
+    for (uint32_t i = 0; i < remainder; ++i) ++histogram[i * 256 / remainder];
+}
+
+// Where pixel `i` of `size` lies between the centres of `tiles` equal tiles:
+// the tiles before and after it and the weight of the latter, in 1/256ths
+void blendTaps(int i, int size, int tiles, int& before, int& after, int& weight) {
+    const float position = (static_cast<float>(i) + 0.5f) * tiles / size - 0.5f;
+    if (position <= 0.0f) {
+        before = after = 0;
+        weight = 0;
+    } else if (position >= tiles - 1) {
+        before = after = tiles - 1;
+        weight = 0;
+    } else {
+        before = static_cast<int>(position);
+        after = before + 1;
+        weight = static_cast<int>((position - before) * 256.0f + 0.5f);
+    }
+}
+
+// upper * (256 - weight) + lower * weight for every curve entry; at most
+// 255 * 256, so it stays within 16 bits
+void blendCurves(const uint8_t* upper, const uint8_t* lower, size_t count, int weight, uint16_t* dst) {
+    size_t i = 0;
+#if defined(__aarch64__)
+    const uint8x8_t zero = vdup_n_u8(0);
+    const uint16x8_t up = vdupq_n_u16(static_cast<uint16_t>(256 - weight));
+    const uint16x8_t down = vdupq_n_u16(static_cast<uint16_t>(weight));
+    for (; i + 8 <= count; i += 8) {
+        const uint16x8_t a = vaddl_u8(vld1_u8(upper + i), zero);
+        const uint16x8_t b = vaddl_u8(vld1_u8(lower + i), zero);
+        vst1q_u16(dst + i, vmlaq_u16(vmulq_u16(a, up), b, down));
+    }
+#elif defined(__SSE2__)
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i up = _mm_set1_epi16(static_cast<short>(256 - weight));
+    const __m128i down = _mm_set1_epi16(static_cast<short>(weight));
+    for (; i + 16 <= count; i += 16) {
+        const __m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i*>(upper + i));
+        const __m128i b = _mm_loadu_si128(reinterpret_cast<const __m128i*>(lower + i));
+        const __m128i low = _mm_add_epi16(_mm_mullo_epi16(_mm_unpacklo_epi8(a, zero), up),
+                                          _mm_mullo_epi16(_mm_unpacklo_epi8(b, zero), down));
+        const __m128i high = _mm_add_epi16(_mm_mullo_epi16(_mm_unpackhi_epi8(a, zero), up),
+                                           _mm_mullo_epi16(_mm_unpackhi_epi8(b, zero), down));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i), low);
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i + 8), high);
+    }
+#endif
+    for (; i < count; ++i) dst[i] = static_cast<uint16_t>(upper[i] * (256 - weight) + lower[i] * weight);
+}
+
+// Threshold maximizing the between-class variance of `histogram`: grey
+// levels up to it are dark
+int otsuThreshold(const uint32_t* histogram) {
+    double total = 0.0;
+    double weighted = 0.0;
+    for (int i = 0; i < 256; ++i) {
+        total += histogram[i];
+        weighted += static_cast<double>(i) * histogram[i];
+    }
+    double dark = 0.0;
+    double darkWeighted = 0.0;
+    double bestVariance = -1.0;
+    int best = 127;
+    for (int i = 0; i < 255; ++i) {
+        dark += histogram[i];
+        darkWeighted += static_cast<double>(i) * histogram[i];
+        const double light = total - dark;
+        if (dark == 0.0 || light == 0.0) continue;
+        const double meanGap = darkWeighted / dark - (weighted - darkWeighted) / light;
+        const double variance = dark * light * meanGap * meanGap;
+        if (variance > bestVariance) {
+            bestVariance = variance;
+            best = i;
+        }
+    }
+    return best;
+}
+
+} // namespace
+
+void sauvolaThreshold(const uint8_t* src, int width, int height, int srcStride, uint8_t* dst, int dstStride,
+                      const SauvolaParams& params, FrameArena* arena) {
+    if (width <= 0 || height <= 0) return;
+    OCR_TRACE_SCOPE("sauvolaThreshold", "preprocess");
+    const int radius = std::max(1, std::min(params.radius, kMaxSauvolaRadius));
+    const float inverseRange = 1.0f / std::max(params.range, 1.0f);
+
+    std::vector<uint32_t> heap;
+    uint32_t* sums = scratch(arena, heap, static_cast<size_t>(4) * width + 2);
+    uint32_t* squares = sums + width;
+    uint32_t* prefix = squares + width;
+    uint32_t* prefixSquares = prefix + width + 1;
+    std::fill(sums, sums + 2 * width, 0u);
+    prefix[0] = 0;
+    prefixSquares[0] = 0;
+    std::vector<uint8_t> heapBlank;
+    uint8_t* blank = scratch(arena, heapBlank, width);
+    std::fill(blank, blank + width, 128);
+
+    auto row = [&](int y) { return y >= 0 && y < height ? src + static_cast<size_t>(y) * srcStride : blank; };
+    // Output row y sees rows [y - radius, y + radius]; the band starts one
+    // row short of row 0's window
+    for (int y = 0; y < radius; ++y) slideColumns(row(y), blank, width, sums, squares);
+    for (int y = 0; y < height; ++y) {
+        slideColumns(row(y + radius), row(y - radius - 1), width, sums, squares);
+        uint32_t sum = 0;
+        uint32_t squareSum = 0;
+        for (int x = 0; x < width; ++x) {
+            sum += sums[x];
+            squareSum += squares[x];
+            prefix[x + 1] = sum;
+            prefixSquares[x + 1] = squareSum;
+        }
+        const int rows = std::min(height, y + radius + 1) - std::max(0, y - radius);
+        sauvolaRow(src + static_cast<size_t>(y) * srcStride, width, radius, rows, prefix, prefixSquares, params.k,
+                   inverseRange, dst + static_cast<size_t>(y) * dstStride);
+    }
+}
+
+void equalizeClahe(const uint8_t* src, int width, int height, int srcStride, uint8_t* dst, int dstStride,
+                   const ClaheParams& params, FrameArena* arena) {
+    if (width <= 0 || height <= 0) return;
+    OCR_TRACE_SCOPE("equalizeClahe", "preprocess");
+    const int tilesX = std::max(1, std::min(params.tilesX, width));
+    const int tilesY = std::max(1, std::min(params.tilesY, height));
+
+    // One equalization curve per tile
+    std::vector<uint8_t> heapCurves;
+    uint8_t* curves = scratch(arena, heapCurves, static_cast<size_t>(tilesX) * tilesY * 256);
+    for (int ty = 0; ty < tilesY; ++ty) {
+        const int y0 = ty * height / tilesY;
+        const int y1 = (ty + 1) * height / tilesY;
+        for (int tx = 0; tx < tilesX; ++tx) {
+            const int x0 = tx * width / tilesX;
+            const int x1 = (tx + 1) * width / tilesX;
+            uint32_t histogram[256] = {};
+            for (int y = y0; y < y1; ++y) {
+                const uint8_t* row = src + static_cast<size_t>(y) * srcStride;
+                for (int x = x0; x < x1; ++x) ++histogram[row[x]];
+            }
+            const uint32_t area = static_cast<uint32_t>((y1 - y0) * (x1 - x0));
+            if (params.clipLimit > 0.0f) {
+                clipHistogram(histogram, std::max(1u, static_cast<uint32_t>(params.clipLimit * area / 256.0f)));
+            }
+            uint8_t* curve = curves + (static_cast<size_t>(ty) * tilesX + tx) * 256;
+            const float scale = 255.0f / static_cast<float>(std::max(area, 1u));
+            uint32_t cumulative = 0;
+            for (int i = 0; i < 256; ++i) {
+                cumulative += histogram[i];
+                curve[i] = static_cast<uint8_t>(std::min(255.0f, cumulative * scale + 0.5f));
+            }
+        }
+    }
+
+    // Column weights are the same for every row. Columns that blend the same
+    // two tiles form a span; at the edges the weight is 0 and only the
+    // nearest tile counts
+    std::vector<int> heapTaps;
+    int* weights = scratch(arena, heapTaps, static_cast<size_t>(width) + 2 * tilesX);
+    int* spans = weights + width;
+    int spanCount = 0;
+    int lastBefore = -1;
+    for (int x = 0; x < width; ++x) {
+        int before, after;
+        blendTaps(x, width, tilesX, before, after, weights[x]);
+        (void)after;
+        if (before != lastBefore) {
+            spans[2 * spanCount] = x;
+            spans[2 * spanCount + 1] = before;
+            ++spanCount;
+            lastBefore = before;
+        }
+    }
+    std::vector<uint16_t> heapRow;
+    uint16_t* rowCurves = scratch(arena, heapRow, static_cast<size_t>(tilesX) * 256);
+    const size_t curveCount = static_cast<size_t>(tilesX) * 256;
+    for (int y = 0; y < height; ++y) {
+        int before, after, weightY;
+        blendTaps(y, height, tilesY, before, after, weightY);
+        // Blending the curves of the two tile rows once per image row leaves
+        // two lookups per pixel instead of four
+        blendCurves(curves + before * curveCount, curves + after * curveCount, curveCount, weightY, rowCurves);
+        const uint8_t* in = src + static_cast<size_t>(y) * srcStride;
+        uint8_t* out = dst + static_cast<size_t>(y) * dstStride;
+        for (int span = 0; span < spanCount; ++span) {
+            const int end = span + 1 < spanCount ? spans[2 * span + 2] : width;
+            const uint16_t* left = rowCurves + spans[2 * span + 1] * 256;
+            const uint16_t* right = spans[2 * span + 1] + 1 < tilesX ? left + 256 : left;
+            for (int x = spans[2 * span]; x < end; ++x) {
+                const uint32_t weightX = weights[x];
+                const uint32_t blended = left[in[x]] * (256 - weightX) + right[in[x]] * weightX;
+                out[x] = static_cast<uint8_t>((blended + 32768) >> 16);
+            }
+        }
+    }
+}
+
+void cropVariants(const RgbaImage& crop, const CropVariant* variants, size_t count, RgbaImage* out) {
+    if (count == 0) return;
+    OCR_TRACE_SCOPE("cropVariants", "preprocess");
+    auto luma = [](uint32_t pixel) {
+        const uint32_t sum = 77 * (pixel & 0xFF) + 150 * ((pixel >> 8) & 0xFF) + 29 * ((pixel >> 16) & 0xFF);
+        return static_cast<int>((sum + 128) >> 8);
+    };
+    uint32_t histogram[256] = {};
+    for (uint32_t pixel : crop.pixels) ++histogram[luma(pixel)];
+
+    const uint32_t total = static_cast<uint32_t>(crop.pixels.size());
+    int low = lumaPercentile(histogram, total, 0.01f);
+    int high = lumaPercentile(histogram, total, 0.99f);
+    if (high - low < kMinStretchRange) {
+        low = std::max(0, std::min((low + high - kMinStretchRange) / 2, 255 - kMinStretchRange));
+        high = low + kMinStretchRange;
+    }
+    uint8_t stretch[256];
+    for (int i = 0; i < 256; ++i) {
+        const int level = ((i - low) * 255 + (high - low) / 2) / (high - low);
+        stretch[i] = static_cast<uint8_t>(std::min(255, std::max(0, level)));
+    }
+    const int threshold = otsuThreshold(histogram);
+
+    for (size_t v = 0; v < count; ++v) out[v].resize(crop.width, crop.height);
+    for (size_t i = 0; i < crop.pixels.size(); ++i) {
+        const uint32_t pixel = crop.pixels[i];
+        for (size_t v = 0; v < count; ++v) {
+            uint32_t value;
+            if (variants[v] == CropVariant::Stretch) {
+                // Per channel, so coloured digits keep their colour
+                const uint32_t r = stretch[pixel & 0xFF];
+                const uint32_t g = stretch[(pixel >> 8) & 0xFF];
+                const uint32_t b = stretch[(pixel >> 16) & 0xFF];
+                value = (pixel & 0xFF000000u) | b << 16 | g << 8 | r;
+            } else {
+                value = luma(pixel) > threshold ? 0xFFFFFFFFu : 0xFF000000u;
+            }
+            out[v].pixels[i] = value;
+        }
+    }
+}
+
+} // namespace ocr
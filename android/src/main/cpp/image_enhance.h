@@ -0,0 +1,61 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+#include "image_ops.h"
+
+namespace ocr {
+
+class FrameArena;
+
+// Local thresholding after Sauvola: a pixel is foreground (0) when it is at
+// most m * (1 + k * (s / range - 1)), with m and s the mean and standard
+// deviation of the (2 * radius + 1)^2 window around it, and background (255)
+// otherwise. Made for dark digits on a light face; shadows and gradients
+// across the dial do not move the cut-off the way a global one moves.
+struct SauvolaParams {
+    int radius = 15;  // at most 127
+    float k = 0.2f;
+    float range = 128.0f;
+};
+
+// Binarizes the grey width x height image `src` into `dst`, which must not
+// overlap it. Window sums come from an integral image of column sums over a
+// band of 2 * radius + 1 rows, so each pixel costs the same whatever the
+// radius; the band update and the threshold run on NEON (AArch64) and SSE2.
+// Row sums and tables come from `arena` when one is given.
+void sauvolaThreshold(const uint8_t* src, int width, int height, int srcStride, uint8_t* dst, int dstStride,
+                      const SauvolaParams& params = SauvolaParams(), FrameArena* arena = nullptr);
+
+// Contrast limited adaptive histogram equalization: each of tilesX x tilesY
+// tiles gets its own equalization curve, with histogram bins capped at
+// clipLimit times their mean (0 for none) and the excess spread over all
+// bins, so flat areas are not blown up into noise. Pixels blend the curves
+// of the four nearest tile centres.
+struct ClaheParams {
+    int tilesX = 8;
+    int tilesY = 8;
+    float clipLimit = 2.0f;
+};
+
+// Equalizes the grey width x height image `src` into `dst`, which may be
+// `src` itself. Curves and column blend tables come from `arena` when one
+// is given.
+void equalizeClahe(const uint8_t* src, int width, int height, int srcStride, uint8_t* dst, int dstStride,
+                   const ClaheParams& params = ClaheParams(), FrameArena* arena = nullptr);
+
+// Photometric variants of a rec crop for test-time augmentation. They keep
+// the crop's geometry, so rec sees the characters at the same time steps in
+// every variant.
+enum class CropVariant {
+    Stretch,  // levels stretched from the 1st..99th luma percentile to 0..255
+    Binary,   // black and white at Otsu's threshold of the luma
+};
+
+// Writes `crop` as each of the `count` `variants` into `out[0..count)`. The
+// crop is read twice, once for its luma histogram and once to write every
+// variant.
+void cropVariants(const RgbaImage& crop, const CropVariant* variants, size_t count, RgbaImage* out);
+
+} // namespace ocr
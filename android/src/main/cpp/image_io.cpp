@@ -0,0 +1,375 @@
+#include "image_io.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <csetjmp>
+#include <fstream>
+#include <iterator>
+#include <vector>
+
+#ifdef WATER_OCR_HAVE_JPEG
+#include <jpeglib.h>
+#endif
+#ifdef WATER_OCR_HAVE_PNG
+#include <png.h>
+#endif
+
+namespace ocr {
+
+namespace {
+
+bool isJpeg(const uint8_t* data, size_t size) {
+    return size >= 3 && data[0] == 0xFF && data[1] == 0xD8 && data[2] == 0xFF;
+}
+
+bool isPng(const uint8_t* data, size_t size) {
+    static const uint8_t kSignature[8] = {0x89, 'P', 'N', 'G', 0x0D, 0x0A, 0x1A, 0x0A};
+    return size >= 8 && std::memcmp(data, kSignature, 8) == 0;
+}
+
+uint32_t readBigEndian(const uint8_t* p, int bytes) {
+    uint32_t value = 0;
+    for (int i = 0; i < bytes; ++i) value = value << 8 | p[i];
+    return value;
+}
+
+// Orientation tag (0x0112) of IFD0 in a TIFF block, as EXIF data is stored
+Orientation tiffOrientation(const uint8_t* tiff, size_t size) {
+    if (size < 8) return Orientation::Normal;
+    const bool little = tiff[0] == 'I' && tiff[1] == 'I';
+    if (!little && !(tiff[0] == 'M' && tiff[1] == 'M')) return Orientation::Normal;
+    auto read = [&](size_t offset, int bytes) -> uint32_t {
+        if (!little) return readBigEndian(tiff + offset, bytes);
+        uint32_t value = 0;
+        for (int i = bytes - 1; i >= 0; --i) value = value << 8 | tiff[offset + i];
+        return value;
+    };
+    const size_t ifd = read(4, 4);
+    if (ifd > size - 2) return Orientation::Normal;
+    const size_t entries = read(ifd, 2);
+    for (size_t i = 0; i < entries; ++i) {
+        const size_t entry = ifd + 2 + i * 12;
+        if (entry > size - 12) break;
+        if (read(entry, 2) != 0x0112) continue;
+        // SHORT, stored in the first two bytes of the value field
+        const uint32_t value = read(entry + 8, 2);
+        return value >= 1 && value <= 8 ? static_cast<Orientation>(value) : Orientation::Normal;
+    }
+    return Orientation::Normal;
+}
+
+// The ROI clamped to the image, the whole image when it is empty
+Rect clampRoi(const Rect& roi, int width, int height) {
+    if (roi.width() <= 0 || roi.height() <= 0) return {0, 0, width, height};
+    Rect r;
+    r.left = std::max(0, std::min(roi.left, width));
+    r.top = std::max(0, std::min(roi.top, height));
+    r.right = std::max(r.left, std::min(roi.right, width));
+    r.bottom = std::max(r.top, std::min(roi.bottom, height));
+    return r;
+}
+
+int ceilDiv(int value, int divisor) {
+    return (value + divisor - 1) / divisor;
+}
+
+// Largest power-of-two divisor up to 8 whose output still meets the options
+int chooseScale(const Rect& roi, const DecodeOptions& options) {
+    if (options.minLongSide <= 0 && options.minShortSide <= 0) return 1;
+    const int longSide = std::max(roi.width(), roi.height());
+    const int shortSide = std::min(roi.width(), roi.height());
+    for (int scale = 8; scale > 1; scale /= 2) {
+        if (ceilDiv(longSide, scale) >= options.minLongSide && ceilDiv(shortSide, scale) >= options.minShortSide) {
+            return scale;
+        }
+    }
+    return 1;
+}
+
+// The ROI in output pixels, and the full-resolution region those cover
+Rect scaledRoi(const Rect& roi, int scale, int outputWidth, int outputHeight) {
+    return {roi.left / scale, roi.top / scale, std::min(outputWidth, ceilDiv(roi.right, scale)),
+            std::min(outputHeight, ceilDiv(roi.bottom, scale))};
+}
+
+void fillInfo(DecodeInfo* info, int width, int height, int scale, const Rect& scaled) {
+    if (!info) return;
+    info->width = width;
+    info->height = height;
+    info->scale = scale;
+    info->roi = {scaled.left * scale, scaled.top * scale, std::min(width, scaled.right * scale),
+                 std::min(height, scaled.bottom * scale)};
+}
+
+// One decoded row of 1 (grey), 3 (RGB) or 4 (RGBA) components into RGBA
+void storeRow(const uint8_t* src, int components, int width, uint8_t* dst) {
+    switch (components) {
+    case 4:
+        std::memcpy(dst, src, static_cast<size_t>(width) * 4);
+        break;
+    case 3:
+        for (int x = 0; x < width; ++x) {
+            dst[4 * x + 0] = src[3 * x + 0];
+            dst[4 * x + 1] = src[3 * x + 1];
+            dst[4 * x + 2] = src[3 * x + 2];
+            dst[4 * x + 3] = 0xFF;
+        }
+        break;
+    default:
+        for (int x = 0; x < width; ++x) {
+            dst[4 * x + 0] = dst[4 * x + 1] = dst[4 * x + 2] = src[x];
+            dst[4 * x + 3] = 0xFF;
+        }
+        break;
+    }
+}
+
+#ifdef WATER_OCR_HAVE_JPEG
+// libjpeg-turbo 1.5 added cropped and skipped scanlines
+#if defined(LIBJPEG_TURBO_VERSION_NUMBER) && LIBJPEG_TURBO_VERSION_NUMBER >= 1005000
+#define WATER_OCR_JPEG_CROP 1
+#endif
+
+struct JpegErrorManager {
+    jpeg_error_mgr base;
+    jmp_buf jump;
+    char message[JMSG_LENGTH_MAX];
+};
+
+void jpegErrorExit(j_common_ptr cinfo) {
+    auto* err = reinterpret_cast<JpegErrorManager*>(cinfo->err);
+    (*cinfo->err->format_message)(cinfo, err->message);
+    std::longjmp(err->jump, 1);
+}
+
+bool decodeJpeg(const uint8_t* data, size_t size, const DecodeOptions& options, RgbaImage& out, DecodeInfo* info,
+                std::string& error) {
+    jpeg_decompress_struct cinfo;
+    JpegErrorManager jerr;
+    // Every C++ object lives outside the setjmp/longjmp span
+    std::vector<uint8_t> row;
+    cinfo.err = jpeg_std_error(&jerr.base);
+    jerr.base.error_exit = jpegErrorExit;
+    if (setjmp(jerr.jump)) {
+        error = std::string("JPEG decode failed: ") + jerr.message;
+        jpeg_destroy_decompress(&cinfo);
+        return false;
+    }
+    jpeg_create_decompress(&cinfo);
+    jpeg_mem_src(&cinfo, data, static_cast<unsigned long>(size));
+    jpeg_read_header(&cinfo, TRUE);
+
+    const int width = static_cast<int>(cinfo.image_width);
+    const int height = static_cast<int>(cinfo.image_height);
+    const Rect roi = clampRoi(options.roi, width, height);
+    const int scale = chooseScale(roi, options);
+    cinfo.scale_num = 1;
+    cinfo.scale_denom = scale;
+    if (options.grayscale) {
+        cinfo.out_color_space = JCS_GRAYSCALE;
+    } else {
+#ifdef JCS_EXTENSIONS
+        cinfo.out_color_space = JCS_EXT_RGBA;
+#else
+        cinfo.out_color_space = JCS_RGB;
+#endif
+    }
+    jpeg_start_decompress(&cinfo);
+
+    const Rect scaled = scaledRoi(roi, scale, cinfo.output_width, cinfo.output_height);
+    fillInfo(info, width, height, scale, scaled);
+    out.resize(scaled.width(), scaled.height());
+    if (out.pixels.empty()) {
+        jpeg_destroy_decompress(&cinfo);
+        error = "ROI outside the image";
+        return false;
+    }
+
+    // Columns: libjpeg-turbo decodes from the iMCU column holding the ROI's
+    // left edge, possibly a little wider; otherwise whole rows are decoded
+    JDIMENSION xOffset = 0;
+    JDIMENSION decodedWidth = cinfo.output_width;
+#ifdef WATER_OCR_JPEG_CROP
+    if (scaled.width() < static_cast<int>(cinfo.output_width)) {
+        xOffset = scaled.left;
+        decodedWidth = scaled.width();
+        jpeg_crop_scanline(&cinfo, &xOffset, &decodedWidth);
+    }
+#endif
+    const int skipColumns = scaled.left - static_cast<int>(xOffset);
+    row.resize(static_cast<size_t>(decodedWidth) * cinfo.output_components);
+    JSAMPROW rows[1] = {row.data()};
+
+    // Rows above the ROI are skipped, those below never reached
+#ifdef WATER_OCR_JPEG_CROP
+    if (scaled.top > 0) jpeg_skip_scanlines(&cinfo, scaled.top);
+#endif
+    while (static_cast<int>(cinfo.output_scanline) < scaled.top) jpeg_read_scanlines(&cinfo, rows, 1);
+    for (int y = 0; y < scaled.height(); ++y) {
+        jpeg_read_scanlines(&cinfo, rows, 1);
+        uint8_t* dst = reinterpret_cast<uint8_t*>(out.pixels.data() + static_cast<size_t>(y) * out.width);
+        storeRow(row.data() + static_cast<size_t>(skipColumns) * cinfo.output_components, cinfo.output_components,
+                 out.width, dst);
+    }
+    if (cinfo.output_scanline < cinfo.output_height) {
+        jpeg_abort_decompress(&cinfo);
+    } else {
+        jpeg_finish_decompress(&cinfo);
+    }
+    jpeg_destroy_decompress(&cinfo);
+    return true;
+}
+#endif
+
+#ifdef WATER_OCR_HAVE_PNG
+// Averages `scale` x `scale` blocks of the region of `src` into `out`
+void shrink(const RgbaImage& src, const Rect& scaled, int scale, bool grayscale, RgbaImage& out) {
+    out.resize(scaled.width(), scaled.height());
+    const uint8_t* pixels = reinterpret_cast<const uint8_t*>(src.pixels.data());
+    for (int y = 0; y < out.height; ++y) {
+        const int y0 = (scaled.top + y) * scale;
+        const int y1 = std::min(src.height, y0 + scale);
+        uint8_t* dst = reinterpret_cast<uint8_t*>(out.pixels.data() + static_cast<size_t>(y) * out.width);
+        for (int x = 0; x < out.width; ++x) {
+            const int x0 = (scaled.left + x) * scale;
+            const int x1 = std::min(src.width, x0 + scale);
+            int sum[4] = {0, 0, 0, 0};
+            for (int sy = y0; sy < y1; ++sy) {
+                const uint8_t* p = pixels + (static_cast<size_t>(sy) * src.width + x0) * 4;
+                for (int sx = x0; sx < x1; ++sx, p += 4) {
+                    for (int c = 0; c < 4; ++c) sum[c] += p[c];
+                }
+            }
+            const int count = (y1 - y0) * (x1 - x0);
+            for (int c = 0; c < 4; ++c) dst[4 * x + c] = static_cast<uint8_t>((sum[c] + count / 2) / count);
+            if (grayscale) {
+                const int luma = (77 * dst[4 * x] + 150 * dst[4 * x + 1] + 29 * dst[4 * x + 2] + 128) >> 8;
+                dst[4 * x] = dst[4 * x + 1] = dst[4 * x + 2] = static_cast<uint8_t>(luma);
+            }
+        }
+    }
+}
+
+bool decodePng(const uint8_t* data, size_t size, const DecodeOptions& options, RgbaImage& out, DecodeInfo* info,
+               std::string& error) {
+    png_image image;
+    std::memset(&image, 0, sizeof(image));
+    image.version = PNG_IMAGE_VERSION;
+    if (!png_image_begin_read_from_memory(&image, data, size)) {
+        error = std::string("PNG decode failed: ") + image.message;
+        return false;
+    }
+    const int width = static_cast<int>(image.width);
+    const int height = static_cast<int>(image.height);
+    const Rect roi = clampRoi(options.roi, width, height);
+    const int scale = chooseScale(roi, options);
+    const Rect scaled = scaledRoi(roi, scale, ceilDiv(width, scale), ceilDiv(height, scale));
+    fillInfo(info, width, height, scale, scaled);
+    if (scaled.width() <= 0 || scaled.height() <= 0) {
+        png_image_free(&image);
+        error = "ROI outside the image";
+        return false;
+    }
+
+    // PNG has no reduced decode: read it all, then cut and shrink
+    image.format = PNG_FORMAT_RGBA;
+    const bool whole = scale == 1 && !options.grayscale && scaled.width() == width && scaled.height() == height;
+    RgbaImage full;
+    RgbaImage& target = whole ? out : full;
+    target.resize(width, height);
+    if (!png_image_finish_read(&image, nullptr, target.pixels.data(), 0, nullptr)) {
+        error = std::string("PNG decode failed: ") + image.message;
+        png_image_free(&image);
+        return false;
+    }
+    if (!whole) shrink(full, scaled, scale, options.grayscale, out);
+    return true;
+}
+#endif
+
+} // namespace
+
+bool decodeImage(const uint8_t* data, size_t size, const DecodeOptions& options, RgbaImage& out, DecodeInfo* info,
+                 std::string& error) {
+    if (info) info->orientation = exifOrientation(data, size);
+    if (isJpeg(data, size)) {
+#ifdef WATER_OCR_HAVE_JPEG
+        return decodeJpeg(data, size, options, out, info, error);
+#else
+        error = "JPEG support not built";
+        return false;
+#endif
+    }
+    if (isPng(data, size)) {
+#ifdef WATER_OCR_HAVE_PNG
+        return decodePng(data, size, options, out, info, error);
+#else
+        error = "PNG support not built";
+        return false;
+#endif
+    }
+    error = "Unsupported image format";
+    return false;
+}
+
+bool decodeImage(const uint8_t* data, size_t size, RgbaImage& out, std::string& error) {
+    return decodeImage(data, size, DecodeOptions(), out, nullptr, error);
+}
+
+Orientation exifOrientation(const uint8_t* data, size_t size) {
+    if (isJpeg(data, size)) {
+        // Marker segments up to the scan; EXIF is an APP1 starting "Exif\0\0"
+        size_t pos = 2;
+        while (pos + 4 <= size && data[pos] == 0xFF) {
+            const uint8_t marker = data[pos + 1];
+            if (marker == 0xFF) {
+                ++pos;
+                continue;
+            }
+            if (marker == 0xDA || marker == 0xD9) break;
+            const size_t length = readBigEndian(data + pos + 2, 2);
+            if (length < 2 || pos + 2 + length > size) break;
+            const uint8_t* segment = data + pos + 4;
+            if (marker == 0xE1 && length >= 8 && std::memcmp(segment, "Exif\0\0", 6) == 0) {
+                return tiffOrientation(segment + 6, length - 8);
+            }
+            pos += 2 + length;
+        }
+    } else if (isPng(data, size)) {
+        // Chunks up to the image data; eXIf holds a bare TIFF block
+        size_t pos = 8;
+        while (pos + 8 <= size) {
+            const size_t length = readBigEndian(data + pos, 4);
+            const uint8_t* type = data + pos + 4;
+            if (length > size - pos - 8) break;
+            if (std::memcmp(type, "eXIf", 4) == 0) return tiffOrientation(data + pos + 8, length);
+            if (std::memcmp(type, "IDAT", 4) == 0) break;
+            pos += 12 + length;
+        }
+    }
+    return Orientation::Normal;
+}
+
+bool readFileBytes(const std::string& path, std::vector<uint8_t>& bytes, std::string& error) {
+    std::ifstream in(path, std::ios::binary);
+    if (!in) {
+        error = "Cannot open " + path;
+        return false;
+    }
+    bytes.assign(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+    return true;
+}
+
+bool decodeImageFile(const std::string& path, const DecodeOptions& options, RgbaImage& out, DecodeInfo* info,
+                     std::string& error) {
+    std::vector<uint8_t> bytes;
+    if (!readFileBytes(path, bytes, error)) return false;
+    return decodeImage(bytes.data(), bytes.size(), options, out, info, error);
+}
+
+bool decodeImageFile(const std::string& path, RgbaImage& out, std::string& error) {
+    return decodeImageFile(path, DecodeOptions(), out, nullptr, error);
+}
+
+} // namespace ocr
@@ -0,0 +1,67 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "image_ops.h"
+
+namespace ocr {
+
+// How decodeImage() may shrink its output. Sizes and the ROI are in pixels of
+// the full-resolution image.
+struct DecodeOptions {
+    // Smallest output the caller can work with. The image (or ROI) is decoded
+    // at the smallest of 1/2, 1/4 or 1/8 scale whose longer and shorter sides
+    // still reach these, so a 12 MP photo lands near the det resolution
+    // without a full-size decode. JPEG scales inside the IDCT; PNG decodes
+    // in full and averages blocks. 0 for both keeps the full size.
+    int minLongSide = 0;
+    int minShortSide = 0;
+    // Luma only: JPEG skips chroma decoding and colour conversion. Output
+    // pixels are still RGBA, with R = G = B.
+    bool grayscale = false;
+    // Region to decode in stored pixels (before any EXIF orientation),
+    // clamped to the image; empty for all of it. JPEG rows
+    // below it are not decoded, and with libjpeg-turbo neither are the
+    // columns outside it.
+    Rect roi;
+};
+
+// What decodeImage() produced. Output pixel (x, y) covers `scale` x `scale`
+// full-resolution pixels starting at (roi.left + x * scale, roi.top + y * scale).
+struct DecodeInfo {
+    // Size of the full-resolution image.
+    int width = 0;
+    int height = 0;
+    int scale = 1;
+    // The decoded region in full-resolution pixels: the requested ROI widened
+    // to whole output pixels.
+    Rect roi;
+    // From the file's EXIF data. Pixels come out as stored; consumers turn
+    // them upright while resizing (see resizeBilinear), not in a pass of
+    // their own.
+    Orientation orientation = Orientation::Normal;
+};
+
+// JPEG (libjpeg-turbo) and PNG (libpng) decoding into RgbaImage, as stored. Formats whose
+// library was not found at build time report an error. Errors are returned as
+// false with a message in `error`; nothing here throws.
+bool decodeImage(const uint8_t* data, size_t size, RgbaImage& out, std::string& error);
+bool decodeImageFile(const std::string& path, RgbaImage& out, std::string& error);
+
+// Same with scaling, grayscale and ROI options; `info` may be null.
+bool decodeImage(const uint8_t* data, size_t size, const DecodeOptions& options, RgbaImage& out, DecodeInfo* info,
+                 std::string& error);
+bool decodeImageFile(const std::string& path, const DecodeOptions& options, RgbaImage& out, DecodeInfo* info,
+                     std::string& error);
+
+// EXIF orientation of an encoded JPEG (APP1) or PNG (eXIf), Normal when it
+// has none.
+Orientation exifOrientation(const uint8_t* data, size_t size);
+
+// Reads a whole file, e.g. to decode it more than once.
+bool readFileBytes(const std::string& path, std::vector<uint8_t>& bytes, std::string& error);
+
+} // namespace ocr
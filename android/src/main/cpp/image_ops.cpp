@@ -0,0 +1,200 @@
+#include "image_ops.h"
+
+#include <algorithm>
+#include <cmath>
+
+#include "frame_arena.h"
+
+namespace ocr {
+
+namespace {
+
+inline uint32_t lerpPixel(uint32_t a, uint32_t b, int weight) {
+    // weight in [0, 256], channels interpolated independently
+    uint32_t result = 0;
+    for (int shift = 0; shift < 32; shift += 8) {
+        int ca = (a >> shift) & 0xFF;
+        int cb = (b >> shift) & 0xFF;
+        int c = ca + (((cb - ca) * weight) >> 8);
+        result |= static_cast<uint32_t>(c) << shift;
+    }
+    return result;
+}
+
+// Axis flips and swap behind each orientation, for the stored image: upright
+// (x, y) reads stored (y, x) when swapped, then mirrors stored x and/or y
+struct OrientationAxes {
+    bool swap;
+    bool mirrorX;
+    bool mirrorY;
+};
+
+OrientationAxes axesOf(Orientation orientation) {
+    switch (orientation) {
+    case Orientation::FlipHorizontal: return {false, true, false};
+    case Orientation::Rotate180: return {false, true, true};
+    case Orientation::FlipVertical: return {false, false, true};
+    case Orientation::Transpose: return {true, false, false};
+    case Orientation::Rotate90: return {true, false, true};
+    case Orientation::Transverse: return {true, true, true};
+    case Orientation::Rotate270: return {true, true, false};
+    default: return {false, false, false};
+    }
+}
+
+// Bilinear taps for output pixel `i` along an axis scaled by `scale` from
+// `srcLength` source pixels `step` elements apart, read backwards when
+// mirrored: element offsets of both taps and the weight of the second.
+inline void axisTap(int i, float scale, int srcLength, bool mirror, int step, int& offset0, int& offset1,
+                    int& weight) {
+    float s = std::max(0.0f, (i + 0.5f) * scale - 0.5f);
+    int i0 = std::min(static_cast<int>(s), srcLength - 1);
+    weight = i0 + 1 < srcLength ? static_cast<int>((s - i0) * 256.0f) : 0;
+    int i1 = weight ? i0 + 1 : i0;
+    if (mirror) {
+        i0 = srcLength - 1 - i0;
+        i1 = srcLength - 1 - i1;
+    }
+    offset0 = i0 * step;
+    offset1 = i1 * step;
+}
+
+} // namespace
+
+Rect storedRect(const Rect& r, Orientation orientation, int width, int height) {
+    const OrientationAxes axes = axesOf(orientation);
+    Rect stored = axes.swap ? Rect{r.top, r.left, r.bottom, r.right} : r;
+    if (axes.mirrorX) stored = {width - stored.right, stored.top, width - stored.left, stored.bottom};
+    if (axes.mirrorY) stored = {stored.left, height - stored.bottom, stored.right, height - stored.top};
+    return stored;
+}
+
+Rect uprightRect(const Rect& r, Orientation orientation, int width, int height) {
+    // Every orientation undoes itself except the two quarter turns
+    Orientation inverse = orientation;
+    if (orientation == Orientation::Rotate90) inverse = Orientation::Rotate270;
+    if (orientation == Orientation::Rotate270) inverse = Orientation::Rotate90;
+    return swapsAxes(orientation) ? storedRect(r, inverse, height, width) : storedRect(r, inverse, width, height);
+}
+
+void resizeBilinear(const uint32_t* src, int width, int height, int stride,
+                    uint32_t* dst, int dstWidth, int dstHeight, int dstStride, FrameArena* arena) {
+    resizeBilinear(src, width, height, stride, Orientation::Normal, dst, dstWidth, dstHeight, dstStride, arena);
+}
+
+void resizeBilinear(const uint32_t* src, int width, int height, int stride, Orientation orientation,
+                    uint32_t* dst, int dstWidth, int dstHeight, int dstStride, FrameArena* arena) {
+    if (width <= 0 || height <= 0 || dstWidth <= 0 || dstHeight <= 0) return;
+    // Output columns walk stored columns, or stored rows when the axes swap;
+    // either way a tap is an element offset, so one loop serves all eight
+    const OrientationAxes axes = axesOf(orientation);
+    const int columns = axes.swap ? height : width;
+    const int rows = axes.swap ? width : height;
+    const int columnStep = axes.swap ? stride : 1;
+    const int rowStep = axes.swap ? 1 : stride;
+    const bool mirrorColumns = axes.swap ? axes.mirrorY : axes.mirrorX;
+    const bool mirrorRows = axes.swap ? axes.mirrorX : axes.mirrorY;
+
+    // Horizontal source taps are the same for every row
+    std::vector<int> heapTaps;
+    int* x0;
+    if (arena) {
+        x0 = arena->allocate<int>(static_cast<size_t>(3) * dstWidth);
+    } else {
+        heapTaps.resize(static_cast<size_t>(3) * dstWidth);
+        x0 = heapTaps.data();
+    }
+    int* x1 = x0 + dstWidth;
+    int* weightX = x1 + dstWidth;
+    const float scaleX = static_cast<float>(columns) / dstWidth;
+    for (int x = 0; x < dstWidth; ++x) {
+        axisTap(x, scaleX, columns, mirrorColumns, columnStep, x0[x], x1[x], weightX[x]);
+    }
+
+    const float scaleY = static_cast<float>(rows) / dstHeight;
+    for (int y = 0; y < dstHeight; ++y) {
+        int y0;
+        int y1;
+        int weightY;
+        axisTap(y, scaleY, rows, mirrorRows, rowStep, y0, y1, weightY);
+        const uint32_t* row0 = src + y0;
+        const uint32_t* row1 = src + y1;
+        uint32_t* out = dst + static_cast<size_t>(y) * dstStride;
+        for (int x = 0; x < dstWidth; ++x) {
+            uint32_t top = lerpPixel(row0[x0[x]], row0[x1[x]], weightX[x]);
+            uint32_t bottom = lerpPixel(row1[x0[x]], row1[x1[x]], weightX[x]);
+            out[x] = lerpPixel(top, bottom, weightY);
+        }
+    }
+}
+
+float letterbox(const RgbaImage& src, int canvasWidth, int canvasHeight, RgbaImage& dst, FrameArena* arena) {
+    return letterbox(src, Orientation::Normal, canvasWidth, canvasHeight, dst, arena);
+}
+
+float letterbox(const RgbaImage& src, Orientation orientation, int canvasWidth, int canvasHeight, RgbaImage& dst,
+                FrameArena* arena) {
+    dst.resize(canvasWidth, canvasHeight);
+    if (src.empty()) return 1.0f;
+    const int uprightWidth = swapsAxes(orientation) ? src.height : src.width;
+    const int uprightHeight = swapsAxes(orientation) ? src.width : src.height;
+    float scale = std::min(static_cast<float>(canvasWidth) / uprightWidth,
+                           static_cast<float>(canvasHeight) / uprightHeight);
+    int width = std::max(1, std::min(canvasWidth, static_cast<int>(std::lround(uprightWidth * scale))));
+    int height = std::max(1, std::min(canvasHeight, static_cast<int>(std::lround(uprightHeight * scale))));
+    resizeBilinear(src.pixels.data(), src.width, src.height, src.width, orientation,
+                   dst.pixels.data(), width, height, canvasWidth, arena);
+    return scale;
+}
+
+bool cropToHeight(const RgbaImage& src, int left, int top, int right, int bottom,
+                  int targetHeight, int maxWidth, RgbaImage& dst, FrameArena* arena) {
+    return cropToHeight(src.pixels.data(), src.width, src.height, src.width, left, top, right, bottom,
+                        targetHeight, maxWidth, dst, arena);
+}
+
+bool cropToHeight(const uint32_t* pixels, int srcWidth, int srcHeight, int stride, int left, int top, int right,
+                  int bottom, int targetHeight, int maxWidth, RgbaImage& dst, FrameArena* arena) {
+    left = std::max(0, left);
+    top = std::max(0, top);
+    right = std::min(srcWidth, right);
+    bottom = std::min(srcHeight, bottom);
+    if (right <= left || bottom <= top || targetHeight <= 0) return false;
+
+    int cropWidth = right - left;
+    int cropHeight = bottom - top;
+    int width = static_cast<int>(std::ceil(static_cast<float>(cropWidth) * targetHeight / cropHeight));
+    width = std::max(1, std::min(width, maxWidth));
+    dst.resize(width, targetHeight);
+    resizeBilinear(pixels + static_cast<size_t>(top) * stride + left, cropWidth, cropHeight, stride,
+                   dst.pixels.data(), width, targetHeight, width, arena);
+    return true;
+}
+
+bool cropToHeight(const RgbaImage& src, Orientation orientation, int left, int top, int right, int bottom,
+                  int targetHeight, int maxWidth, RgbaImage& dst, FrameArena* arena) {
+    const int uprightWidth = swapsAxes(orientation) ? src.height : src.width;
+    const int uprightHeight = swapsAxes(orientation) ? src.width : src.height;
+    left = std::max(0, left);
+    top = std::max(0, top);
+    right = std::min(uprightWidth, right);
+    bottom = std::min(uprightHeight, bottom);
+    if (right <= left || bottom <= top || targetHeight <= 0) return false;
+
+    int cropWidth = right - left;
+    int cropHeight = bottom - top;
+    int width = static_cast<int>(std::ceil(static_cast<float>(cropWidth) * targetHeight / cropHeight));
+    width = std::max(1, std::min(width, maxWidth));
+    dst.resize(width, targetHeight);
+    // The same pixels in stored order, turned upright by the resize
+    const Rect stored = storedRect({left, top, right, bottom}, orientation, src.width, src.height);
+    resizeBilinear(src.pixels.data() + static_cast<size_t>(stored.top) * src.width + stored.left, stored.width(),
+                   stored.height(), src.width, orientation, dst.pixels.data(), width, targetHeight, width, arena);
+    return true;
+}
+
+void rotate180(RgbaImage& image) {
+    std::reverse(image.pixels.begin(), image.pixels.end());
+}
+
+} // namespace ocr
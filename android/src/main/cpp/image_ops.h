@@ -0,0 +1,102 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace ocr {
+
+class FrameArena;
+
+// Owned 32-bit pixel buffer, tightly packed, in the same memory order as an
+// Android ARGB_8888 bitmap (R, G, B, A bytes).
+struct RgbaImage {
+    int width = 0;
+    int height = 0;
+    std::vector<uint32_t> pixels;
+
+    void resize(int w, int h) {
+        width = w;
+        height = h;
+        pixels.assign(static_cast<size_t>(w) * h, 0);
+    }
+    bool empty() const { return width <= 0 || height <= 0; }
+};
+
+// Integer pixel rectangle, [left, right) x [top, bottom).
+struct Rect {
+    int left = 0;
+    int top = 0;
+    int right = 0;
+    int bottom = 0;
+
+    int width() const { return right - left; }
+    int height() const { return bottom - top; }
+};
+
+// How stored pixels relate to the upright image, by EXIF orientation tag
+// value: what a viewer does to the stored image to show it upright.
+enum class Orientation {
+    Normal = 1,
+    FlipHorizontal = 2,
+    Rotate180 = 3,
+    FlipVertical = 4,
+    Transpose = 5,   // mirror along the top-left to bottom-right diagonal
+    Rotate90 = 6,    // clockwise
+    Transverse = 7,  // mirror along the top-right to bottom-left diagonal
+    Rotate270 = 8,
+};
+
+// Orientations whose upright width is the stored height.
+inline bool swapsAxes(Orientation orientation) {
+    return static_cast<int>(orientation) >= static_cast<int>(Orientation::Transpose);
+}
+
+// Rectangle `r` of the upright image, in the pixels of the stored
+// width x height image, and back.
+Rect storedRect(const Rect& r, Orientation orientation, int width, int height);
+Rect uprightRect(const Rect& r, Orientation orientation, int width, int height);
+
+// Bilinear resize of `src` (width x height, row stride in pixels) into the
+// top-left dstWidth x dstHeight corner of `dst`, whose row stride is
+// dstStride pixels. The tap tables come from `arena` when one is given.
+void resizeBilinear(const uint32_t* src, int width, int height, int stride,
+                    uint32_t* dst, int dstWidth, int dstHeight, int dstStride, FrameArena* arena = nullptr);
+
+// Same, turning the stored `src` upright on the way: dst is the upright image
+// resized to dstWidth x dstHeight. The rotation and flips live in the tap
+// tables, so the pass costs the same as a plain resize.
+void resizeBilinear(const uint32_t* src, int width, int height, int stride, Orientation orientation,
+                    uint32_t* dst, int dstWidth, int dstHeight, int dstStride, FrameArena* arena = nullptr);
+
+// Scales `src` to fit inside a canvasWidth x canvasHeight canvas keeping the
+// aspect ratio and pads the right/bottom edge with zeros. Returns the scale
+// factor, so canvas coordinates divide by it to map back to `src`.
+float letterbox(const RgbaImage& src, int canvasWidth, int canvasHeight, RgbaImage& dst,
+                FrameArena* arena = nullptr);
+
+// Same with `src` stored in `orientation`: the canvas holds it upright, and
+// the scale maps canvas coordinates to upright ones.
+float letterbox(const RgbaImage& src, Orientation orientation, int canvasWidth, int canvasHeight, RgbaImage& dst,
+                FrameArena* arena = nullptr);
+
+// Crops the [left, right) x [top, bottom) rectangle of `src` (clamped to the
+// image) and resizes it to `targetHeight`, keeping the aspect ratio with the
+// width limited to maxWidth. Returns false for an empty intersection.
+bool cropToHeight(const RgbaImage& src, int left, int top, int right, int bottom,
+                  int targetHeight, int maxWidth, RgbaImage& dst, FrameArena* arena = nullptr);
+
+// Same, reading from a caller-owned width x height buffer with a row stride
+// of `stride` pixels, so crops need no copy of the source.
+bool cropToHeight(const uint32_t* pixels, int width, int height, int stride, int left, int top, int right,
+                  int bottom, int targetHeight, int maxWidth, RgbaImage& dst, FrameArena* arena = nullptr);
+
+// Same with `src` stored in `orientation` and the rectangle in upright
+// coordinates; the crop comes out upright.
+bool cropToHeight(const RgbaImage& src, Orientation orientation, int left, int top, int right, int bottom,
+                  int targetHeight, int maxWidth, RgbaImage& dst, FrameArena* arena = nullptr);
+
+// Rotates the image by 180 degrees in place.
+void rotate180(RgbaImage& image);
+
+} // namespace ocr
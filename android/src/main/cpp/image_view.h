@@ -0,0 +1,157 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+
+#include "image_ops.h"
+
+namespace ocr {
+
+// Memory layouts a frame can arrive in: the Android bitmap configs and the
+// camera YUV formats.
+enum class PixelFormat {
+    Rgba8888,  // R, G, B, A bytes
+    Rgb565,    // 16-bit native-endian words, R in the top five bits
+    A8,        // one byte per pixel, read as grey
+    RgbaF16,   // four half floats per pixel in [0, 1]
+    Nv21,      // Y plane, then interleaved V/U at half resolution
+    I420,      // Y, U and V planes, chroma at half resolution
+    Nv12,      // Y plane, then interleaved U/V at half resolution
+};
+
+// Bytes per pixel of plane 0.
+inline int bytesPerPixel(PixelFormat format) {
+    switch (format) {
+    case PixelFormat::Rgba8888: return 4;
+    case PixelFormat::Rgb565: return 2;
+    case PixelFormat::RgbaF16: return 8;
+    default: return 1;
+    }
+}
+
+// Planes a frame of `format` is made of.
+inline int planeCount(PixelFormat format) {
+    switch (format) {
+    case PixelFormat::Nv21:
+    case PixelFormat::Nv12: return 2;
+    case PixelFormat::I420: return 3;
+    default: return 1;
+    }
+}
+
+// Non-owning view of caller pixels: format, up to three planes with their row
+// strides in bytes, and the region of interest that consumers read. Nothing
+// is copied, so the pixels must outlive the view.
+struct ImageView {
+    PixelFormat format = PixelFormat::Rgba8888;
+    int width = 0;
+    int height = 0;
+    const uint8_t* planes[3] = {nullptr, nullptr, nullptr};
+    int strides[3] = {0, 0, 0};
+    // Always within the image; the whole image unless cropped().
+    Rect roi;
+
+    // Single-plane formats; stride 0 means tightly packed.
+    static ImageView packed(PixelFormat format, const void* pixels, int width, int height, int stride = 0) {
+        ImageView view;
+        view.format = format;
+        view.width = width;
+        view.height = height;
+        view.planes[0] = static_cast<const uint8_t*>(pixels);
+        view.strides[0] = stride > 0 ? stride : width * bytesPerPixel(format);
+        view.roi = {0, 0, width, height};
+        return view;
+    }
+
+    static ImageView rgba(const uint32_t* pixels, int width, int height, int stridePixels = 0) {
+        return packed(PixelFormat::Rgba8888, pixels, width, height, stridePixels * 4);
+    }
+
+    static ImageView nv21(const uint8_t* y, int yStride, const uint8_t* vu, int vuStride, int width, int height) {
+        ImageView view = packed(PixelFormat::Nv21, y, width, height, yStride);
+        view.planes[1] = vu;
+        view.strides[1] = vuStride;
+        return view;
+    }
+
+    static ImageView nv12(const uint8_t* y, int yStride, const uint8_t* uv, int uvStride, int width, int height) {
+        ImageView view = packed(PixelFormat::Nv12, y, width, height, yStride);
+        view.planes[1] = uv;
+        view.strides[1] = uvStride;
+        return view;
+    }
+
+    static ImageView i420(const uint8_t* y, int yStride, const uint8_t* u, int uStride, const uint8_t* v,
+                          int vStride, int width, int height) {
+        ImageView view = packed(PixelFormat::I420, y, width, height, yStride);
+        view.planes[1] = u;
+        view.strides[1] = uStride;
+        view.planes[2] = v;
+        view.strides[2] = vStride;
+        return view;
+    }
+
+    // Any format from raw plane pointers, as handed over by the C ABI and the
+    // ByteBuffer entry points. Check valid() before reading through it.
+    static ImageView fromPlanes(PixelFormat format, const void* const* planes, const int* strides, int width,
+                                int height) {
+        ImageView view = packed(format, planes[0], width, height, strides[0]);
+        for (int i = 1; i < planeCount(format); ++i) {
+            view.planes[i] = static_cast<const uint8_t*>(planes[i]);
+            view.strides[i] = strides[i];
+        }
+        return view;
+    }
+
+    // Rows of plane `i`, and the bytes of pixels in each.
+    int planeRows(int i) const { return i == 0 ? height : (height + 1) / 2; }
+    int planeRowBytes(int i) const {
+        if (i == 0) return width * bytesPerPixel(format);
+        return format == PixelFormat::I420 ? (width + 1) / 2 : (width + 1) / 2 * 2;
+    }
+
+    // Bytes plane `i` spans: every row at its stride except the last, which
+    // only needs its pixels. 0 for a plane the format does not use.
+    size_t planeSize(int i) const {
+        if (i >= planeCount(format)) return 0;
+        return static_cast<size_t>(planeRows(i) - 1) * strides[i] + planeRowBytes(i);
+    }
+
+    // Positive size, and every plane the format needs present with rows at
+    // least as long as their pixels.
+    bool valid() const {
+        if (width <= 0 || height <= 0) return false;
+        for (int i = 0; i < planeCount(format); ++i) {
+            if (!planes[i] || strides[i] < planeRowBytes(i)) return false;
+        }
+        return true;
+    }
+
+    // The same pixels limited to `r` (in image coordinates, clamped to the
+    // current ROI).
+    ImageView cropped(const Rect& r) const {
+        ImageView view = *this;
+        view.roi.left = std::max(r.left, roi.left);
+        view.roi.top = std::max(r.top, roi.top);
+        view.roi.right = std::max(view.roi.left, std::min(r.right, roi.right));
+        view.roi.bottom = std::max(view.roi.top, std::min(r.bottom, roi.bottom));
+        return view;
+    }
+
+    bool empty() const { return roi.width() <= 0 || roi.height() <= 0; }
+
+    // The ROI as 32-bit RGBA pixels in place, with its row stride in pixels:
+    // only for Rgba8888 rows aligned to whole pixels, null otherwise.
+    const uint32_t* rgbaPixels(int& stridePixels) const {
+        if (format != PixelFormat::Rgba8888 || strides[0] % 4 != 0 ||
+            reinterpret_cast<uintptr_t>(planes[0]) % alignof(uint32_t) != 0) {
+            return nullptr;
+        }
+        stridePixels = strides[0] / 4;
+        return reinterpret_cast<const uint32_t*>(planes[0]) + static_cast<size_t>(roi.top) * stridePixels +
+               roi.left;
+    }
+};
+
+} // namespace ocr
@@ -0,0 +1,101 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "model_info.h"
+
+namespace ocr {
+
+// Float output of one run. `data` is owned by the scratch the run used and
+// stays valid until that scratch runs again.
+struct TensorView {
+    const float* data = nullptr;
+    std::vector<int64_t> shape;
+};
+
+// Per-caller state of one session: runtime handles that may not be shared
+// between threads (ORT run options, a cloned Paddle Lite predictor) and the
+// last output. Each RunContext owns one per model.
+class BackendScratch {
+public:
+    virtual ~BackendScratch() = default;
+
+    TensorView output;
+};
+
+struct SessionOptions {
+    // Model role ("det", "cls", "rec"), used in logs and traces.
+    std::string label;
+    int intraOpThreads = 1;
+    // Execution providers to try in order; empty means plain CPU.
+    std::vector<std::string> providers;
+    bool logPlacement = false;
+    // Fixes symbolic input dimensions (by name) to static sizes, so the
+    // runtime can plan memory and optimize the graph for one shape.
+    std::vector<std::pair<std::string, int64_t>> dimOverrides;
+    // Non-empty enables the runtime's own profiler, written next to this
+    // prefix and merged into the trace by finishProfiling().
+    std::string profilePrefix;
+};
+
+// One loaded model on some inference runtime. The session itself is only read
+// after loading, so any number of threads may run it concurrently as long as
+// each uses its own scratch.
+class InferenceSession {
+public:
+    virtual ~InferenceSession() = default;
+
+    // "onnxruntime", "paddle_lite", ...
+    virtual const char* backendName() const = 0;
+    // Execution provider the session was created with ("cpu", "xnnpack", ...).
+    virtual const std::string& provider() const = 0;
+    // Whether SessionOptions::dimOverrides has any effect.
+    virtual bool canSpecializeShapes() const { return false; }
+    const ModelInfo& info() const { return *info_; }
+
+    virtual std::unique_ptr<BackendScratch> createScratch(int contextId) = 0;
+
+    // Runs the model on one float NCHW tensor and returns the first output.
+    // Throws std::exception on runtime errors.
+    virtual const TensorView& run(BackendScratch& scratch, const float* input,
+                                  const std::array<int64_t, 4>& dims) = 0;
+
+    // Stops profiling and merges the runtime profile into the current trace.
+    virtual void finishProfiling() {}
+
+protected:
+    std::unique_ptr<ModelInfo> info_;
+};
+
+// Backend registry. Backends are compiled in when their runtime is found at
+// build time (WATER_OCR_WITH_ORT, WATER_OCR_WITH_PADDLE_LITE).
+
+// Names of the compiled-in backends, in order of preference, then the
+// registered ones.
+std::vector<std::string> availableBackends();
+
+using SessionFactory =
+    std::function<std::unique_ptr<InferenceSession>(const std::string& path, const SessionOptions& options)>;
+
+// Adds a backend that is not compiled in, e.g. scripted models for host
+// tests. A registered name shadows a compiled-in one. Not thread-safe:
+// register before opening any session.
+void registerBackend(const std::string& name, SessionFactory factory);
+
+// Backend for a model file by extension: ".nb" is Paddle Lite, anything else
+// ONNX Runtime.
+std::string backendForModel(const std::string& path);
+
+// Loads `path` on the named backend ("auto" picks by extension). Throws
+// std::runtime_error when the backend is not compiled in or the model fails
+// to load.
+std::unique_ptr<InferenceSession> openSession(const std::string& backend, const std::string& path,
+                                              const SessionOptions& options);
+
+} // namespace ocr
@@ -0,0 +1,114 @@
+#include "model_info.h"
+
+#include <stdexcept>
+
+#include "ocr_log.h"
+
+namespace ocr {
+
+namespace {
+
+const char* typeName(ElementType type) {
+    switch (type) {
+    case ElementType::Float: return "float";
+    case ElementType::Float16: return "float16";
+    case ElementType::Int8: return "int8";
+    case ElementType::UInt8: return "uint8";
+    case ElementType::Int32: return "int32";
+    case ElementType::Int64: return "int64";
+    case ElementType::Other: return "other";
+    case ElementType::Unknown: break;
+    }
+    return "unknown";
+}
+
+bool isFloatOrUnknown(const TensorInfo& tensor) {
+    return tensor.type == ElementType::Float || tensor.type == ElementType::Unknown;
+}
+
+[[noreturn]] void fail(const ModelInfo& info, const TensorInfo& tensor, const std::string& expected) {
+    throw std::runtime_error(info.label + " model: " + tensor.toString() + ", expected " + expected);
+}
+
+void requireSingleImageInput(const ModelInfo& info) {
+    if (info.inputs.size() != 1) {
+        throw std::runtime_error(info.label + " model has " + std::to_string(info.inputs.size()) +
+                                 " inputs, expected 1");
+    }
+    if (info.outputs.empty()) throw std::runtime_error(info.label + " model has no outputs");
+    const TensorInfo& input = info.inputs[0];
+    if (!isFloatOrUnknown(input) ||
+        (!input.dims.empty() && (input.dims.size() != 4 || (input.dims[1] >= 0 && input.dims[1] != 3)))) {
+        fail(info, input, "float[N,3,H,W]");
+    }
+    if (!isFloatOrUnknown(info.outputs[0])) fail(info, info.outputs[0], "float output");
+}
+
+} // namespace
+
+std::string TensorInfo::toString() const {
+    std::string out = name + ": " + typeName(type) + "[";
+    for (size_t i = 0; i < dims.size(); ++i) {
+        if (i) out += ",";
+        out += dims[i] < 0 ? (dimNames[i].empty() ? "?" : dimNames[i]) : std::to_string(dims[i]);
+    }
+    return out + "]";
+}
+
+void ModelInfo::resolveNames() {
+    inputNames.clear();
+    outputNames.clear();
+    for (const TensorInfo& t : inputs) inputNames.push_back(t.name.c_str());
+    for (const TensorInfo& t : outputs) outputNames.push_back(t.name.c_str());
+}
+
+void ModelInfo::log() const {
+    for (const TensorInfo& t : inputs) LOGI("%s input %s", label.c_str(), t.toString().c_str());
+    for (const TensorInfo& t : outputs) LOGI("%s output %s", label.c_str(), t.toString().c_str());
+}
+
+void validateDetModel(const ModelInfo& info) {
+    requireSingleImageInput(info);
+    const TensorInfo& output = info.outputs[0];
+    if (output.dims.empty()) return;
+    if (output.dims.size() == 3 && (output.dims[2] < 0 || output.dims[2] >= 9)) return;
+    if (output.dims.size() == 4 && output.dims[1] == 1) return;
+    fail(info, output, "[N,boxes,9] or [N,1,H,W]");
+}
+
+void validateClsModel(const ModelInfo& info, int& height, int& width) {
+    requireSingleImageInput(info);
+    const TensorInfo& output = info.outputs[0];
+    if (!output.dims.empty() && (output.dims.size() != 2 || (output.dims[1] >= 0 && output.dims[1] != 2))) {
+        fail(info, output, "[N,2]");
+    }
+    const TensorInfo& input = info.inputs[0];
+    if (input.dims.empty()) return;
+    if (input.dims[2] > 0) height = static_cast<int>(input.dims[2]);
+    if (input.dims[3] > 0) width = static_cast<int>(input.dims[3]);
+}
+
+void validateRecModel(const ModelInfo& info, int& height, int classCount) {
+    requireSingleImageInput(info);
+    const TensorInfo& input = info.inputs[0];
+    if (!input.dims.empty() && input.dims[2] > 0) {
+        if (height <= 0) {
+            height = static_cast<int>(input.dims[2]);
+        } else if (input.dims[2] != height) {
+            fail(info, input, "height " + std::to_string(height) + " (rec_height)");
+        }
+    }
+    const TensorInfo& output = info.outputs[0];
+    if (output.dims.empty()) return;
+    if (output.dims.size() != 3) fail(info, output, "[N,T,classes]");
+    validateRecClasses(info, output.dims, classCount);
+}
+
+void validateRecClasses(const ModelInfo& info, const std::vector<int64_t>& outputShape, int classCount) {
+    if (outputShape.size() != 3 || outputShape[2] < 0 || outputShape[2] == classCount) return;
+    throw std::runtime_error(info.label + " model has " + std::to_string(outputShape[2]) +
+                             " classes but the dictionary covers " + std::to_string(classCount) +
+                             " (blank included); set the dict option to the model's character list");
+}
+
+} // namespace ocr
@@ -0,0 +1,65 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace ocr {
+
+enum class ElementType { Unknown, Float, Float16, Int8, UInt8, Int32, Int64, Other };
+
+// Name, element type and shape of one model input or output. Dynamic
+// dimensions are -1 and keep their symbolic name in dimNames. Backends that
+// cannot report a declared shape leave dims empty.
+struct TensorInfo {
+    std::string name;
+    ElementType type = ElementType::Unknown;
+    std::vector<int64_t> dims;
+    std::vector<std::string> dimNames;
+
+    // e.g. "x: float[?,3,48,?]"
+    std::string toString() const;
+};
+
+// I/O metadata of a loaded model, read once so the hot path can run it
+// without querying or allocating names.
+struct ModelInfo {
+    std::string label;
+    std::vector<TensorInfo> inputs;
+    std::vector<TensorInfo> outputs;
+    // Point into inputs/outputs, in the form runtime Run() calls take them.
+    std::vector<const char*> inputNames;
+    std::vector<const char*> outputNames;
+
+    ModelInfo() = default;
+    ModelInfo(const ModelInfo&) = delete;
+    ModelInfo& operator=(const ModelInfo&) = delete;
+
+    // Fills inputNames/outputNames once inputs and outputs are complete.
+    void resolveNames();
+    void log() const;
+};
+
+// Validation throws std::runtime_error naming the model and the offending
+// tensor when a model cannot work with the pipeline. Unknown types and
+// shapes pass.
+
+// One float NCHW input with 3 channels; output either a box list
+// [N, boxes, >=9] or a DB probability map [N, 1, H, W].
+void validateDetModel(const ModelInfo& info);
+
+// One float NCHW input with 3 channels and a [B, 2] output. Static input
+// height/width override the configured ones.
+void validateClsModel(const ModelInfo& info, int& height, int& width);
+
+// One float NCHW input with 3 channels and a [B, T, C] output. A static
+// input height is taken when `height` is 0 and must equal it otherwise. A
+// static C must be `classCount`: class indices are dictionary lines, so any
+// other dictionary decodes garbage.
+void validateRecModel(const ModelInfo& info, int& height, int classCount);
+
+// The same class check on an output shape seen at run time, for models that
+// do not declare theirs (Paddle Lite).
+void validateRecClasses(const ModelInfo& info, const std::vector<int64_t>& outputShape, int classCount);
+
+} // namespace ocr
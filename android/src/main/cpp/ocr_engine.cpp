@@ -0,0 +1,1158 @@
+#include "ocr_engine.h"
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <stdexcept>
+
+#include "det_postprocess.h"
+#include "frame_arena.h"
+#include "inference_backend.h"
+#include "ocr_log.h"
+#include "ocr_trace.h"
+#include "pixel_convert.h"
+#include "quad_nms.h"
+#include "reading_fusion.h"
+
+namespace ocr {
+
+// Crop variants per rec crop with rec_tta
+constexpr size_t kMaxRecTta = 4;
+
+// Buffers keep their capacity between calls and the arena is reset when the
+// context returns to the pool, so once a context has seen its largest frame
+// the kernels' temporaries no longer come from the heap.
+struct RunContext {
+    int id = 0;
+    // Backend state per model slot, created on first use
+    std::vector<std::unique_ptr<BackendScratch>> scratch;
+    std::vector<float> detInput;
+    std::vector<float> recInput;
+    std::vector<float> clsInput;
+    RgbaImage recCrop;
+    RgbaImage clsCrop;
+    RgbaImage ttaCrops[kMaxRecTta];
+    // Per-frame temporaries: resize taps, flood-fill scratch
+    FrameArena arena;
+};
+
+namespace {
+
+// Scratch slots of the dynamic-shape sessions; shape buckets follow
+constexpr int kDetSlot = 0;
+constexpr int kClsSlot = 1;
+constexpr int kRecSlot = 2;
+
+bool parseInt(const std::string& text, int& out) {
+    char* end = nullptr;
+    long value = std::strtol(text.c_str(), &end, 10);
+    if (text.empty() || *end != '\0') return false;
+    out = static_cast<int>(value);
+    return true;
+}
+
+bool parsePositiveInt(const std::string& text, int& out) {
+    int value;
+    if (!parseInt(text, value) || value <= 0) return false;
+    out = value;
+    return true;
+}
+
+bool parseBool(const std::string& text, bool& out) {
+    if (text == "1" || text == "true") {
+        out = true;
+    } else if (text == "0" || text == "false") {
+        out = false;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+// Comma-separated execution provider names. CPU always takes the model, so
+// it may only come last: providers after it would never be tried.
+bool parseProviders(const std::string& text, std::vector<std::string>& out) {
+    std::vector<std::string> providers;
+    size_t start = 0;
+    while (start <= text.size()) {
+        size_t comma = std::min(text.find(',', start), text.size());
+        std::string name = text.substr(start, comma - start);
+        if (name != "cpu" && name != "xnnpack" && name != "nnapi") return false;
+        if (!providers.empty() && providers.back() == "cpu") return false;
+        providers.push_back(name);
+        start = comma + 1;
+    }
+    out = providers;
+    return true;
+}
+
+// Comma-separated TTA variant names, at most kMaxRecTta
+bool parseCropVariants(const std::string& text, std::vector<CropVariant>& out) {
+    std::vector<CropVariant> variants;
+    size_t start = 0;
+    while (start <= text.size()) {
+        size_t comma = std::min(text.find(',', start), text.size());
+        const std::string name = text.substr(start, comma - start);
+        if (name == "stretch") {
+            variants.push_back(CropVariant::Stretch);
+        } else if (name == "binary") {
+            variants.push_back(CropVariant::Binary);
+        } else {
+            return false;
+        }
+        start = comma + 1;
+    }
+    if (variants.size() > kMaxRecTta) return false;
+    out = variants;
+    return true;
+}
+
+// Comma-separated "WxH" sizes
+bool parseSizes(const std::string& text, std::vector<std::pair<int, int>>& out) {
+    std::vector<std::pair<int, int>> sizes;
+    size_t start = 0;
+    while (start <= text.size()) {
+        size_t comma = std::min(text.find(',', start), text.size());
+        std::string item = text.substr(start, comma - start);
+        size_t x = item.find('x');
+        std::pair<int, int> size;
+        if (x == std::string::npos || !parsePositiveInt(item.substr(0, x), size.first) ||
+            !parsePositiveInt(item.substr(x + 1), size.second)) {
+            return false;
+        }
+        sizes.push_back(size);
+        start = comma + 1;
+    }
+    out = sizes;
+    return true;
+}
+
+// Comma-separated positive integers
+bool parseIntList(const std::string& text, std::vector<int>& out) {
+    std::vector<int> values;
+    size_t start = 0;
+    while (start <= text.size()) {
+        size_t comma = std::min(text.find(',', start), text.size());
+        int value;
+        if (!parsePositiveInt(text.substr(start, comma - start), value)) return false;
+        values.push_back(value);
+        start = comma + 1;
+    }
+    out = values;
+    return true;
+}
+
+bool parseFloat(const std::string& text, float& out) {
+    char* end = nullptr;
+    float value = std::strtof(text.c_str(), &end);
+    if (text.empty() || *end != '\0') return false;
+    out = value;
+    return true;
+}
+
+// Exactly `count` comma-separated floats
+bool parseFloatList(const std::string& text, size_t count, float* out) {
+    std::vector<float> values;
+    size_t start = 0;
+    while (start <= text.size()) {
+        size_t comma = std::min(text.find(',', start), text.size());
+        float value;
+        if (!parseFloat(text.substr(start, comma - start), value)) return false;
+        values.push_back(value);
+        start = comma + 1;
+    }
+    if (values.size() != count) return false;
+    std::copy(values.begin(), values.end(), out);
+    return true;
+}
+
+// Preset input normalization by name
+bool parseNorm(const std::string& text, InputNorm& out) {
+    if (text == "auto") {
+        out = InputNorm();
+    } else if (text == "unit") {
+        out = InputNorm::unit();
+    } else if (text == "pm1") {
+        out = InputNorm::signedUnit();
+    } else if (text == "imagenet") {
+        out = InputNorm::imageNet();
+    } else {
+        return false;
+    }
+    return true;
+}
+
+// Per-channel mean or std of a custom normalization, starting from [0, 1]
+// when it was auto
+bool parseNormChannels(const std::string& text, bool isStd, InputNorm& norm) {
+    float values[3];
+    if (!parseFloatList(text, 3, values)) return false;
+    if (isStd && !(values[0] > 0.0f && values[1] > 0.0f && values[2] > 0.0f)) return false;
+    if (norm.automatic()) norm = InputNorm::unit();
+    std::copy(values, values + 3, isStd ? norm.std : norm.mean);
+    return true;
+}
+
+// Auto normalization of a model: PP-OCR's `ppocr` on Paddle Lite, else [0, 1]
+void resolveNorm(InputNorm& norm, const InferenceSession& session, const InputNorm& ppocr) {
+    if (!norm.automatic()) return;
+    norm = std::string(session.backendName()) == "paddle_lite" ? ppocr : InputNorm::unit();
+}
+
+// planeWidth x planeHeight CHW float32 planes normalized by `norm`
+TensorSpec tensorSpec(const InputNorm& norm, bool bgr, int planeWidth, int planeHeight) {
+    TensorSpec spec;
+    spec.planeWidth = planeWidth;
+    spec.planeHeight = planeHeight;
+    spec.bgr = bgr;
+    for (int c = 0; c < 3; ++c) {
+        spec.scale[c] = 1.0f / (255.0f * norm.std[c]);
+        spec.bias[c] = -norm.mean[c] / norm.std[c];
+    }
+    return spec;
+}
+
+// RGBA pixels to CHW float32 planes of planeWidth x planeHeight normalized
+// by `norm`, in RGB or BGR order. The image fills the top-left corner; the
+// caller zero-fills the padding.
+void writeChw(const uint32_t* pixels, int width, int height, int stride, const InputNorm& norm, bool bgr,
+              float* dst, int planeWidth, int planeHeight) {
+    writeTensor(ImageView::rgba(pixels, width, height, stride), tensorSpec(norm, bgr, planeWidth, planeHeight), dst);
+}
+
+// Det input of one image: its pixels as they are, or the enhanced luma
+// through scratch from `arena`
+void writeDetInput(const EngineConfig& config, FrameArena& arena, const uint32_t* pixels, int width, int height,
+                   int stride, float* dst, int planeWidth, int planeHeight) {
+    if (config.detEnhance == DetEnhance::None) {
+        writeChw(pixels, width, height, stride, config.detNorm, config.bgrInput, dst, planeWidth, planeHeight);
+        return;
+    }
+    const size_t size = static_cast<size_t>(width) * height;
+    uint8_t* luma = arena.allocate<uint8_t>(config.detEnhance == DetEnhance::Sauvola ? 2 * size : size);
+    convertToLuma(ImageView::rgba(pixels, width, height, stride), luma, width);
+    uint8_t* enhanced = luma;
+    if (config.detEnhance == DetEnhance::Sauvola) {
+        enhanced = luma + size;
+        sauvolaThreshold(luma, width, height, width, enhanced, width, config.sauvola, &arena);
+    } else {
+        equalizeClahe(luma, width, height, width, luma, width, config.clahe, &arena);
+    }
+    writeTensor(ImageView::packed(PixelFormat::A8, enhanced, width, height),
+                tensorSpec(config.detNorm, false, planeWidth, planeHeight), dst);
+}
+
+// The ROI of `image` as tightly packed RGBA: in place when it already is,
+// else converted into `storage`.
+const uint32_t* packedRgba(const ImageView& image, RgbaImage& storage) {
+    int stride = 0;
+    const uint32_t* pixels = image.rgbaPixels(stride);
+    if (pixels && stride == image.roi.width()) return pixels;
+    convertToRgba(image, storage);
+    return storage.pixels.data();
+}
+
+const TensorView& runModel(InferenceSession& session, int slot, RunContext& context,
+                           const std::vector<float>& tensor, const std::array<int64_t, 4>& dims) {
+    if (context.scratch.size() <= static_cast<size_t>(slot)) context.scratch.resize(slot + 1);
+    std::unique_ptr<BackendScratch>& scratch = context.scratch[slot];
+    if (!scratch) scratch = session.createScratch(context.id);
+    return session.run(*scratch, tensor.data(), dims);
+}
+
+} // namespace
+
+InputNorm InputNorm::unit() {
+    InputNorm norm;
+    std::fill(norm.std, norm.std + 3, 1.0f);
+    return norm;
+}
+
+InputNorm InputNorm::signedUnit() {
+    InputNorm norm;
+    std::fill(norm.mean, norm.mean + 3, 0.5f);
+    std::fill(norm.std, norm.std + 3, 0.5f);
+    return norm;
+}
+
+InputNorm InputNorm::imageNet() {
+    return InputNorm{{0.485f, 0.456f, 0.406f}, {0.229f, 0.224f, 0.225f}};
+}
+
+bool EngineConfig::applyOption(const std::string& option) {
+    size_t eq = option.find('=');
+    if (eq == std::string::npos) return false;
+    std::string key = option.substr(0, eq);
+    std::string value = option.substr(eq + 1);
+
+    if (key == "backend") {
+        backend = value;
+        return true;
+    }
+    if (key == "intra_op_threads") return parsePositiveInt(value, intraOpThreads);
+    if (key == "providers") return parseProviders(value, providers);
+    if (key == "det_providers") return parseProviders(value, detProviders);
+    if (key == "cls_providers") return parseProviders(value, clsProviders);
+    if (key == "rec_providers") return parseProviders(value, recProviders);
+    if (key == "log_placement") return parseBool(value, logPlacement);
+    if (key == "workers") return parseInt(value, workers) && workers >= -1;
+    if (key == "trace") {
+        tracePath = value;
+        return true;
+    }
+    if (key == "dict") {
+        dictPath = value;
+        return true;
+    }
+    if (key == "det_norm") return parseNorm(value, detNorm);
+    if (key == "cls_norm") return parseNorm(value, clsNorm);
+    if (key == "rec_norm") return parseNorm(value, recNorm);
+    if (key == "det_mean") return parseNormChannels(value, false, detNorm);
+    if (key == "cls_mean") return parseNormChannels(value, false, clsNorm);
+    if (key == "rec_mean") return parseNormChannels(value, false, recNorm);
+    if (key == "det_std") return parseNormChannels(value, true, detNorm);
+    if (key == "cls_std") return parseNormChannels(value, true, clsNorm);
+    if (key == "rec_std") return parseNormChannels(value, true, recNorm);
+    if (key == "rec_height") return parsePositiveInt(value, recHeight);
+    if (key == "rec_max_width") return parsePositiveInt(value, recMaxWidth);
+    if (key == "det_threshold") return parseFloat(value, detThreshold);
+    if (key == "det_bin_threshold") return parseFloat(value, detBinThreshold);
+    if (key == "det_unclip_ratio") return parseFloat(value, detUnclipRatio);
+    if (key == "det_tile") return parseInt(value, detTileSize) && detTileSize >= 0;
+    if (key == "det_tile_overlap") return parseInt(value, detTileOverlap) && detTileOverlap >= 0;
+    if (key == "det_nms_iou") return parseFloat(value, detNmsIou) && detNmsIou >= 0.0f;
+    if (key == "det_merge_lines") return parseBool(value, detMergeLines);
+    if (key == "det_merge_gap") return parseFloat(value, detMergeGap) && detMergeGap >= 0.0f;
+    if (key == "rank_top_k") return parseInt(value, rank.topK) && rank.topK >= 0;
+    if (key == "rank_min_confidence") return parseFloat(value, rank.minCharConfidence);
+    if (key == "rec_early_exit") return parseBool(value, recEarlyExit);
+    if (key == "rec_grammar") {
+        if (value == "0" || value == "off") {
+            recGrammar = false;
+            return true;
+        }
+        return recGrammar = parseReadingGrammar(value, reading);
+    }
+    if (key == "reading_beam") return parsePositiveInt(value, reading.beamWidth);
+    if (key == "reading_decrease_penalty") return parseFloat(value, reading.decreasePenalty);
+    if (key == "reading_jump_penalty") return parseFloat(value, reading.jumpPenalty);
+    if (key == "rank_min_digits") return parsePositiveInt(value, rank.minDigits);
+    if (key == "rank_max_digits") return parsePositiveInt(value, rank.maxDigits);
+    if (key == "rank_min_size") {
+        std::vector<std::pair<int, int>> sizes;
+        if (!parseSizes(value, sizes) || sizes.size() != 1) return false;
+        rank.minWidth = static_cast<float>(sizes[0].first);
+        rank.minHeight = static_cast<float>(sizes[0].second);
+        return true;
+    }
+    if (key == "rank_roi") {
+        float roi[4];
+        if (!parseFloatList(value, 4, roi) || roi[0] >= roi[2] || roi[1] >= roi[3]) return false;
+        rank.roiLeft = roi[0];
+        rank.roiTop = roi[1];
+        rank.roiRight = roi[2];
+        rank.roiBottom = roi[3];
+        return true;
+    }
+    if (key == "rank_weights") {
+        float weights[5];
+        if (!parseFloatList(value, 5, weights)) return false;
+        rank.aspectWeight = weights[0];
+        rank.positionWeight = weights[1];
+        rank.detWeight = weights[2];
+        rank.digitWeight = weights[3];
+        rank.recWeight = weights[4];
+        return true;
+    }
+    if (key == "channel_order") {
+        if (value != "rgb" && value != "bgr") return false;
+        bgrInput = value == "bgr";
+        return true;
+    }
+    if (key == "cls") return parseBool(value, useCls);
+    if (key == "cls_threshold") return parseFloat(value, clsThreshold);
+    if (key == "warm_up") {
+        if (value == "0" || value == "off") {
+            warmUp = WarmUpMode::Off;
+        } else if (value == "1" || value == "sync") {
+            warmUp = WarmUpMode::Sync;
+        } else if (value == "async") {
+            warmUp = WarmUpMode::Async;
+        } else {
+            return false;
+        }
+        return true;
+    }
+    if (key == "det_buckets") return parseSizes(value, detBuckets);
+    if (key == "rec_buckets") return parseIntList(value, recBuckets);
+    if (key == "det_max_side") return parsePositiveInt(value, detMaxSide);
+    if (key == "det_batch") return parsePositiveInt(value, detBatch);
+    if (key == "rec_batch") return parsePositiveInt(value, recBatch);
+    if (key == "decode_scaled") return parseBool(value, decodeScaled);
+    if (key == "decode_gray") return parseBool(value, decodeGray);
+    if (key == "quality_gate") return parseBool(value, qualityGate);
+    if (key == "quality_side") return parsePositiveInt(value, quality.thumbnailSide);
+    if (key == "quality_min_sharpness") return parseFloat(value, quality.minSharpness);
+    if (key == "quality_max_clipped") return parseFloat(value, quality.maxClipped);
+    if (key == "quality_min_mean") return parseFloat(value, quality.minMean);
+    if (key == "quality_min_spread") return parseFloat(value, quality.minSpread);
+    if (key == "det_enhance") {
+        if (value == "none") {
+            detEnhance = DetEnhance::None;
+        } else if (value == "clahe") {
+            detEnhance = DetEnhance::Clahe;
+        } else if (value == "sauvola") {
+            detEnhance = DetEnhance::Sauvola;
+        } else {
+            return false;
+        }
+        return true;
+    }
+    if (key == "sauvola_radius") return parsePositiveInt(value, sauvola.radius);
+    if (key == "sauvola_k") return parseFloat(value, sauvola.k);
+    if (key == "clahe_clip") return parseFloat(value, clahe.clipLimit);
+    if (key == "clahe_tiles") {
+        int tiles;
+        if (!parsePositiveInt(value, tiles)) return false;
+        clahe.tilesX = clahe.tilesY = tiles;
+        return true;
+    }
+    if (key == "burst_top_k") return parsePositiveInt(value, burstTopK);
+    if (key == "burst_fuse") return parseBool(value, burstFuse);
+    if (key == "rec_tta") {
+        if (value == "off") {
+            recTta.clear();
+            return true;
+        }
+        return parseCropVariants(value, recTta);
+    }
+    return false;
+}
+
+Engine::Engine(const EngineConfig& config) : config_(config) {
+    LOGI("Initializing OCR with models: det=%s, cls=%s, rec=%s", config_.detModelPath.c_str(),
+         config_.clsModelPath.c_str(), config_.recModelPath.c_str());
+
+    if (!config_.dictPath.empty() && !dict_.load(config_.dictPath)) {
+        throw std::runtime_error("Cannot load dictionary " + config_.dictPath);
+    }
+    reader_.reset(new ReadingDecoder(dict_));
+    if (config_.recGrammar && !reader_->valid()) {
+        LOGW("Dictionary lacks digits; rec_grammar is ignored");
+    }
+    int workers = config_.workers >= 0 ? config_.workers
+                                       : TaskScheduler::recommendedWorkers(config_.intraOpThreads);
+    scheduler_.reset(new TaskScheduler(workers));
+    LOGI("Scheduler: %d threads x %d intra-op threads", scheduler_->concurrency(), config_.intraOpThreads);
+
+    if (!config_.tracePath.empty()) {
+        ownsTrace_ = trace::start(config_.tracePath);
+    }
+    auto sessionOptions = [this](const char* label, const std::vector<std::string>& providers) {
+        SessionOptions options;
+        options.label = label;
+        options.intraOpThreads = config_.intraOpThreads;
+        options.providers = providers.empty() ? config_.providers : providers;
+        options.logPlacement = config_.logPlacement;
+        // ORT appends a timestamp and ".json" to the prefix.
+        if (ownsTrace_) options.profilePrefix = config_.tracePath + ".ort_" + label;
+        return options;
+    };
+    auto loadModel = [this](const std::string& path, const SessionOptions& options) {
+        std::unique_ptr<InferenceSession> session = openSession(config_.backend, path, options);
+        LOGI("%s model on %s/%s: %s", options.label.c_str(), session->backendName(), session->provider().c_str(),
+             path.c_str());
+        session->info().log();
+        return session;
+    };
+
+    try {
+        const SessionOptions detOptions = sessionOptions("det", config_.detProviders);
+        const SessionOptions recOptions = sessionOptions("rec", config_.recProviders);
+        det_ = loadModel(config_.detModelPath, detOptions);
+        cls_ = loadModel(config_.clsModelPath, sessionOptions("cls", config_.clsProviders));
+        rec_ = loadModel(config_.recModelPath, recOptions);
+
+        // Reject models that cannot work before the first frame
+        validateDetModel(det_->info());
+        validateClsModel(cls_->info(), config_.clsHeight, config_.clsWidth);
+        validateRecModel(rec_->info(), config_.recHeight, dict_.classCount());
+        if (config_.recHeight <= 0) {
+            config_.recHeight = std::string(rec_->backendName()) == "paddle_lite" ? 32 : 48;
+        }
+        resolveNorm(config_.detNorm, *det_, InputNorm::imageNet());
+        resolveNorm(config_.clsNorm, *cls_, InputNorm::signedUnit());
+        resolveNorm(config_.recNorm, *rec_, InputNorm::signedUnit());
+        const std::vector<int64_t>& recOutput = rec_->info().outputs[0].dims;
+        if (recOutput.size() != 3 || recOutput[2] < 0) probeRecClasses();
+
+        std::vector<std::pair<int, int>> recSizes;
+        for (int width : config_.recBuckets) recSizes.emplace_back(width, config_.recHeight);
+        loadBuckets(config_.detModelPath, *det_, detOptions, config_.detBuckets, detBuckets_);
+        loadBuckets(config_.recModelPath, *rec_, recOptions, recSizes, recBuckets_);
+        if (config_.warmUp == WarmUpMode::Sync) warmUp();
+    } catch (...) {
+        if (ownsTrace_) trace::finish();
+        throw;
+    }
+    if (config_.warmUp == WarmUpMode::Async) warmUpAsync();
+}
+
+void Engine::probeRecClasses() {
+    ContextLease lease = acquireContext();
+    RunContext& context = *lease;
+    const std::array<int64_t, 4> dims = {1, 3, config_.recHeight, 4 * config_.recHeight};
+    context.recInput.assign(static_cast<size_t>(3) * dims[2] * dims[3], 0.0f);
+    const TensorView& output = runModel(*rec_, kRecSlot, context, context.recInput, dims);
+    validateRecClasses(rec_->info(), output.shape, dict_.classCount());
+}
+
+Engine::~Engine() {
+    if (pendingWarmUp_.valid()) pendingWarmUp_.wait();
+    if (ownsTrace_) finishTrace();
+}
+
+void Engine::loadBuckets(const std::string& path, const InferenceSession& base, const SessionOptions& options,
+                         const std::vector<std::pair<int, int>>& sizes, std::vector<ShapeBucket>& buckets) {
+    if (sizes.empty()) return;
+    if (!base.canSpecializeShapes()) {
+        LOGW("%s: %s cannot specialize shapes, ignoring buckets", options.label.c_str(), base.backendName());
+        return;
+    }
+    const TensorInfo& input = base.info().inputs[0];
+    for (const std::pair<int, int>& size : sizes) {
+        SessionOptions bucketOptions = options;
+        bucketOptions.label = options.label + "_" + std::to_string(size.first) + "x" + std::to_string(size.second);
+        if (!options.profilePrefix.empty()) {
+            bucketOptions.profilePrefix = config_.tracePath + ".ort_" + bucketOptions.label;
+        }
+
+        // Batch 1 at the bucket size; dynamic dims are fixed by name
+        const int64_t wanted[4] = {1, 3, size.second, size.first};
+        bool fits = input.dims.size() == 4;
+        for (int axis : {0, 2, 3}) {
+            if (!fits) break;
+            if (input.dims[axis] >= 0) {
+                fits = input.dims[axis] == wanted[axis];
+                continue;
+            }
+            const std::string& name = input.dimNames[axis];
+            fits = !name.empty();
+            for (const auto& dim : bucketOptions.dimOverrides) {
+                if (dim.first == name && dim.second != wanted[axis]) fits = false;
+            }
+            bucketOptions.dimOverrides.emplace_back(name, wanted[axis]);
+        }
+        if (!fits) {
+            LOGW("%s: input %s cannot be fixed to the bucket size", bucketOptions.label.c_str(),
+                 input.toString().c_str());
+            continue;
+        }
+        ShapeBucket bucket{size.first, size.second, slotCount_++, openSession(config_.backend, path, bucketOptions)};
+        LOGI("%s: static shape session loaded", bucketOptions.label.c_str());
+        buckets.push_back(std::move(bucket));
+    }
+    std::sort(buckets.begin(), buckets.end(), [](const ShapeBucket& a, const ShapeBucket& b) {
+        return a.width * a.height < b.width * b.height;
+    });
+}
+
+const Engine::ShapeBucket* Engine::findBucket(const std::vector<ShapeBucket>& buckets, int width,
+                                              int height) const {
+    for (const ShapeBucket& bucket : buckets) {
+        if (bucket.width >= width && bucket.height >= height) return &bucket;
+    }
+    return nullptr;
+}
+
+ContextLease::ContextLease(Engine* engine, std::unique_ptr<RunContext> context)
+    : engine_(engine), context_(std::move(context)) {}
+
+ContextLease::ContextLease(ContextLease&& other) noexcept
+    : engine_(other.engine_), context_(std::move(other.context_)) {}
+
+ContextLease::~ContextLease() {
+    if (context_) engine_->releaseContext(std::move(context_));
+}
+
+ContextLease Engine::acquireContext() {
+    int id;
+    {
+        std::lock_guard<std::mutex> lock(contextMutex_);
+        if (!idleContexts_.empty()) {
+            std::unique_ptr<RunContext> context = std::move(idleContexts_.back());
+            idleContexts_.pop_back();
+            return ContextLease(this, std::move(context));
+        }
+        id = ++createdContexts_;
+    }
+    std::unique_ptr<RunContext> context(new RunContext());
+    context->id = id;
+    LOGD("Created OCR run context %d", context->id);
+    return ContextLease(this, std::move(context));
+}
+
+void Engine::releaseContext(std::unique_ptr<RunContext> context) {
+    context->arena.reset();
+    std::lock_guard<std::mutex> lock(contextMutex_);
+    idleContexts_.push_back(std::move(context));
+}
+
+WarmUpReport Engine::warmUp() {
+    OCR_TRACE_SCOPE("Engine::warmUp", "pipeline");
+    using Clock = std::chrono::steady_clock;
+    auto millisSince = [](Clock::time_point start) {
+        return std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+    };
+    const Clock::time_point start = Clock::now();
+
+    // Hold all leases at once so every pooled context gets warmed
+    std::vector<ContextLease> leases;
+    for (int i = 0; i < scheduler_->concurrency(); ++i) leases.push_back(acquireContext());
+
+    // Largest det input a frame is given: a tile, or the batch canvas
+    int detWidth = config_.detTileSize > 0 ? config_.detTileSize : (config_.detMaxSide + 31) / 32 * 32;
+    int detHeight = config_.detTileSize > 0 ? config_.detTileSize : (config_.detMaxSide * 3 / 4 + 31) / 32 * 32;
+    const std::array<int64_t, 4> detDims = {1, 3, detHeight, detWidth};
+    const std::array<int64_t, 4> clsDims = {1, 3, config_.clsHeight, config_.clsWidth};
+    const std::array<int64_t, 4> recDims = {1, 3, config_.recHeight, config_.recMaxWidth};
+
+    std::vector<std::array<double, 3>> times(leases.size());
+    scheduler_->parallelFor(static_cast<int>(leases.size()), [&](int i) {
+        RunContext& context = *leases[i];
+        auto run = [&](InferenceSession& session, int slot, std::vector<float>& tensor,
+                       const std::array<int64_t, 4>& dims) {
+            Clock::time_point modelStart = Clock::now();
+            // Mid-grey input; leaves the buffer at its steady-state capacity
+            tensor.assign(static_cast<size_t>(dims[1] * dims[2] * dims[3]), 0.5f);
+            runModel(session, slot, context, tensor, dims);
+            return millisSince(modelStart);
+        };
+        times[i][0] = run(*det_, kDetSlot, context.detInput, detDims);
+        for (const ShapeBucket& b : detBuckets_) {
+            times[i][0] += run(*b.session, b.slot, context.detInput, {1, 3, b.height, b.width});
+        }
+        if (config_.useCls) times[i][1] = run(*cls_, kClsSlot, context.clsInput, clsDims);
+        times[i][2] = run(*rec_, kRecSlot, context.recInput, recDims);
+        for (const ShapeBucket& b : recBuckets_) {
+            times[i][2] += run(*b.session, b.slot, context.recInput, {1, 3, b.height, b.width});
+        }
+    });
+
+    WarmUpReport report;
+    report.contexts = static_cast<int>(leases.size());
+    for (const std::array<double, 3>& t : times) {
+        report.detMs += t[0];
+        report.clsMs += t[1];
+        report.recMs += t[2];
+    }
+    report.totalMs = millisSince(start);
+    LOGI("Warm-up: %d contexts in %.1f ms (det %.1f, cls %.1f, rec %.1f ms)", report.contexts, report.totalMs,
+         report.detMs, report.clsMs, report.recMs);
+    return report;
+}
+
+void Engine::warmUpAsync() {
+    if (pendingWarmUp_.valid()) return;
+    pendingWarmUp_ = std::async(std::launch::async, [this]() {
+        try {
+            return warmUp();
+        } catch (const std::exception& e) {
+            // Real calls will report the same problem
+            LOGW("Warm-up failed: %s", e.what());
+            return WarmUpReport();
+        }
+    });
+}
+
+void Engine::finishTrace() {
+    for (InferenceSession* session : {det_.get(), cls_.get(), rec_.get()}) {
+        if (session) session->finishProfiling();
+    }
+    for (const std::vector<ShapeBucket>* buckets : {&detBuckets_, &recBuckets_}) {
+        for (const ShapeBucket& bucket : *buckets) bucket.session->finishProfiling();
+    }
+    trace::finish();
+}
+
+QuadSet Engine::detect(const uint32_t* pixels, int width, int height) {
+    const int tile = config_.detTileSize;
+    if (tile <= 0 || (width <= tile && height <= tile)) {
+        ContextLease lease = acquireContext();
+        return detect(*lease, pixels, width, height);
+    }
+
+    // Overlapping tiles, detected in parallel and shifted back to image
+    // coordinates. Text crossing a seam is found whole in the overlap.
+    OCR_TRACE_SCOPE("Engine::detectTiled", "pipeline");
+    const int step = std::max(1, tile - config_.detTileOverlap);
+    std::vector<Rect> tiles;
+    for (int top = 0;; top += step) {
+        int bottom = std::min(height, top + tile);
+        for (int left = 0;; left += step) {
+            int right = std::min(width, left + tile);
+            tiles.push_back({left, top, right, bottom});
+            if (right == width) break;
+        }
+        if (bottom == height) break;
+    }
+
+    std::vector<QuadSet> tileBoxes(tiles.size());
+    scheduler_->parallelFor(static_cast<int>(tiles.size()), [&](int t) {
+        const Rect& r = tiles[t];
+        ContextLease lease = acquireContext();
+        tileBoxes[t] = detectRegion(*lease, pixels + static_cast<size_t>(r.top) * width + r.left, width,
+                                    r.width(), r.height());
+        tileBoxes[t].translate(static_cast<float>(r.left), static_cast<float>(r.top));
+    });
+
+    QuadSet boxes;
+    for (const QuadSet& part : tileBoxes) boxes.append(part);
+    // Text inside an overlap was found by both tiles
+    ContextLease lease = acquireContext();
+    RunContext& context = *lease;
+    refineBoxes(boxes, &context.arena);
+    return boxes;
+}
+
+QuadSet Engine::detect(const ImageView& image) {
+    RgbaImage storage;
+    QuadSet boxes = detect(packedRgba(image, storage), image.roi.width(), image.roi.height());
+    boxes.translate(static_cast<float>(image.roi.left), static_cast<float>(image.roi.top));
+    return boxes;
+}
+
+QuadSet Engine::detect(RunContext& context, const uint32_t* pixels, int width, int height) {
+    return detectRegion(context, pixels, width, width, height);
+}
+
+QuadSet Engine::detectRegion(RunContext& context, const uint32_t* pixels, int stride, int width, int height) {
+    OCR_TRACE_SCOPE("Engine::detect", "pipeline");
+    // Smallest static-shape session that fits, padding right and bottom
+    const ShapeBucket* bucket = findBucket(detBuckets_, width, height);
+    const int planeWidth = bucket ? bucket->width : width;
+    const int planeHeight = bucket ? bucket->height : height;
+    std::vector<float>& inputTensor = context.detInput;
+    {
+        OCR_TRACE_SCOPE("det.preprocess", "preprocess");
+        const size_t tensorSize = static_cast<size_t>(3) * planeHeight * planeWidth;
+        if (bucket) {
+            inputTensor.assign(tensorSize, 0.0f);
+        } else {
+            inputTensor.resize(tensorSize);
+        }
+        writeDetInput(config_, context.arena, pixels, width, height, stride, inputTensor.data(), planeWidth,
+                      planeHeight);
+    }
+    std::array<int64_t, 4> dims = {1, 3, planeHeight, planeWidth};
+    const TensorView& output = bucket ? runModel(*bucket->session, bucket->slot, context, inputTensor, dims)
+                                      : runModel(*det_, kDetSlot, context, inputTensor, dims);
+    return parseDetOutput(context, output, 1, planeWidth, planeHeight)[0];
+}
+
+std::vector<QuadSet> Engine::detectBatch(RunContext& context, const std::vector<const uint32_t*>& images,
+                                               int width, int height) {
+    OCR_TRACE_SCOPE("Engine::detect", "pipeline");
+    const int batch = static_cast<int>(images.size());
+    const size_t imageSize = static_cast<size_t>(3) * height * width;
+    std::vector<float>& inputTensor = context.detInput;
+    {
+        OCR_TRACE_SCOPE("det.preprocess", "preprocess");
+        inputTensor.resize(imageSize * batch);
+        for (int b = 0; b < batch; ++b) {
+            writeDetInput(config_, context.arena, images[b], width, height, width,
+                          inputTensor.data() + b * imageSize, width, height);
+        }
+    }
+
+    // Run detection session
+    std::array<int64_t, 4> dims = {batch, 3, height, width};
+    const TensorView& output = runModel(*det_, kDetSlot, context, inputTensor, dims);
+    return parseDetOutput(context, output, batch, width, height);
+}
+
+// Parse detection output tensor into bounding boxes, one list per image.
+// Probability maps are scaled from map to input pixels.
+std::vector<QuadSet> Engine::parseDetOutput(RunContext& context, const TensorView& output, int batch, int width,
+                                            int height) const {
+    OCR_TRACE_SCOPE("det.postprocess", "postprocess");
+    const float* outputData = output.data;
+    const std::vector<int64_t>& outputShape = output.shape;
+
+    std::vector<QuadSet> results(batch);
+    if (outputShape.empty() || outputShape[0] != batch) return results;
+
+    if (outputShape.size() == 4 && outputShape[1] == 1) {
+        // [B, 1, H, W]
+        DbParams params;
+        params.binThreshold = config_.detBinThreshold;
+        params.boxThreshold = config_.detThreshold;
+        params.unclipRatio = config_.detUnclipRatio;
+        const int mapHeight = static_cast<int>(outputShape[2]);
+        const int mapWidth = static_cast<int>(outputShape[3]);
+        for (int b = 0; b < batch; b++) {
+            dbBoxes(outputData + static_cast<size_t>(b) * mapHeight * mapWidth, mapWidth, mapHeight, params,
+                    static_cast<float>(width) / mapWidth, static_cast<float>(height) / mapHeight, results[b],
+                    &context.arena);
+            refineBoxes(results[b], &context.arena);
+        }
+        return results;
+    }
+
+    // [B, N, 9] where N is number of detections
+    if (outputShape.size() != 3) {
+        LOGE("Unexpected det output rank %zu", outputShape.size());
+        return results;
+    }
+    int numDets = outputShape[1];
+    int featDim = outputShape[2];
+    if (featDim < 9) return results;
+    for (int b = 0; b < batch; b++) {
+        const float* imageDets = outputData + static_cast<size_t>(b) * numDets * featDim;
+        for (int i = 0; i < numDets; i++) {
+            const float* det = imageDets + static_cast<size_t>(i) * featDim;
+            // Filter by confidence threshold
+            if (det[8] > config_.detThreshold) results[b].push(det, det[8]);
+        }
+        refineBoxes(results[b], &context.arena);
+    }
+    return results;
+}
+
+void Engine::refineBoxes(QuadSet& boxes, FrameArena* arena) const {
+    if (config_.detNmsIou > 0.0f) {
+        suppressOverlaps(boxes, config_.detNmsIou, arena);
+    } else {
+        boxes.sortByScore();
+    }
+    if (config_.detMergeLines) {
+        LineMergeParams params;
+        params.maxGap = config_.detMergeGap;
+        mergeLines(boxes, params, arena);
+    }
+}
+
+Recognition Engine::recognize(const uint32_t* pixels, int width, int height) {
+    ContextLease lease = acquireContext();
+    return recognize(*lease, pixels, width, height);
+}
+
+Recognition Engine::recognize(RunContext& context, const uint32_t* pixels, int width, int height) {
+    RgbaImage& crop = context.recCrop;
+    int cropWidth = static_cast<int>(std::ceil(static_cast<float>(width) * config_.recHeight / height));
+    cropWidth = std::max(1, std::min(cropWidth, config_.recMaxWidth));
+    crop.resize(cropWidth, config_.recHeight);
+    resizeBilinear(pixels, width, height, width, crop.pixels.data(), cropWidth, config_.recHeight, cropWidth,
+                   &context.arena);
+    const RgbaImage* crops[1] = {&crop};
+    Recognition result;
+    recognizeInto(context, crops, 1, &result);
+    return result;
+}
+
+Recognition Engine::recognize(const ImageView& image) {
+    RgbaImage storage;
+    return recognize(packedRgba(image, storage), image.roi.width(), image.roi.height());
+}
+
+std::vector<Recognition> Engine::recognizeBatch(RunContext& context, const std::vector<const RgbaImage*>& crops) {
+    std::vector<Recognition> results(crops.size());
+    recognizeInto(context, crops.data(), static_cast<int>(crops.size()), results.data());
+    return results;
+}
+
+void Engine::recognizeInto(RunContext& context, const RgbaImage* const* crops, int batch, Recognition* results,
+                           const ReadingPrior* prior, int variants) {
+    OCR_TRACE_SCOPE("Engine::recognize", "pipeline");
+    const int height = config_.recHeight;
+    int width = 1;
+    for (int b = 0; b < batch; ++b) width = std::max(width, crops[b]->width);
+    // Single crops may run on a static-width session
+    const ShapeBucket* bucket = batch == 1 ? findBucket(recBuckets_, width, height) : nullptr;
+    if (bucket) width = bucket->width;
+
+    const size_t imageSize = static_cast<size_t>(3) * height * width;
+    std::vector<float>& inputTensor = context.recInput;
+    {
+        OCR_TRACE_SCOPE("rec.preprocess", "preprocess");
+        inputTensor.assign(imageSize * batch, 0.0f);
+        for (int b = 0; b < batch; ++b) {
+            const RgbaImage& crop = *crops[b];
+            writeChw(crop.pixels.data(), crop.width, std::min(crop.height, height), crop.width, config_.recNorm,
+                     config_.bgrInput, inputTensor.data() + b * imageSize, width, height);
+        }
+    }
+
+    // Create ONNX tensor and run recognition
+    std::array<int64_t, 4> dims = {batch, 3, height, width};
+    const TensorView& output = bucket ? runModel(*bucket->session, bucket->slot, context, inputTensor, dims)
+                                      : runModel(*rec_, kRecSlot, context, inputTensor, dims);
+
+    // Decode CTC output laid out as [B, T, C]
+    OCR_TRACE_SCOPE("rec.decode", "postprocess");
+    const std::vector<int64_t>& outputShape = output.shape;
+    if (outputShape.size() != 3 || outputShape[0] != batch) {
+        LOGE("Unexpected rec output rank %zu", outputShape.size());
+        return;
+    }
+    const int timeSteps = static_cast<int>(outputShape[1]);
+    const int numClasses = static_cast<int>(outputShape[2]);
+    const float* outputData = output.data;
+    const bool grammar = prior && config_.recGrammar && reader_->valid();
+    const size_t outputSize = static_cast<size_t>(timeSteps) * numClasses;
+    for (int b = 0; b < batch / variants; ++b) {
+        const float* probs = outputData + static_cast<size_t>(b) * variants * outputSize;
+        if (variants > 1) {
+            float* mean = context.arena.allocate<float>(outputSize);
+            averagePosteriors(probs, variants, outputSize, mean);
+            probs = mean;
+        }
+        if (grammar) {
+            reader_->decode(probs, timeSteps, numClasses, config_.reading, *prior, results[b], &context.arena);
+        } else {
+            ctcGreedyDecode(probs, timeSteps, numClasses, dict_, results[b]);
+        }
+    }
+}
+
+void Engine::orientCrop(RunContext& context, RgbaImage& crop) {
+    if (config_.useCls && isUpsideDown(context, crop)) rotate180(crop);
+}
+
+bool Engine::isUpsideDown(RunContext& context, const RgbaImage& crop) {
+    OCR_TRACE_SCOPE("Engine::classify", "pipeline");
+    const int height = config_.clsHeight;
+    const int width = config_.clsWidth;
+    std::vector<float>& inputTensor = context.clsInput;
+    {
+        OCR_TRACE_SCOPE("cls.preprocess", "preprocess");
+        // Same aspect-preserving resize as rec, padded to the cls width
+        RgbaImage& resized = context.clsCrop;
+        int resizedWidth = static_cast<int>(std::ceil(static_cast<float>(crop.width) * height / crop.height));
+        resizedWidth = std::max(1, std::min(resizedWidth, width));
+        resized.resize(resizedWidth, height);
+        resizeBilinear(crop.pixels.data(), crop.width, crop.height, crop.width, resized.pixels.data(),
+                       resizedWidth, height, resizedWidth, &context.arena);
+        inputTensor.assign(static_cast<size_t>(3) * height * width, 0.0f);
+        writeChw(resized.pixels.data(), resizedWidth, height, resizedWidth, config_.clsNorm, config_.bgrInput,
+                 inputTensor.data(), width, height);
+    }
+    std::array<int64_t, 4> dims = {1, 3, height, width};
+    const TensorView& output = runModel(*cls_, kClsSlot, context, inputTensor, dims);
+
+    // Output is [1, 2]: probabilities of 0 and 180 degrees
+    if (output.shape.size() != 2 || output.shape[1] < 2) return false;
+    const float* probs = output.data;
+    return probs[1] > probs[0] && probs[1] >= config_.clsThreshold;
+}
+
+std::vector<Recognition> Engine::recognizeRegions(const uint32_t* pixels, int width, int height,
+                                                  const std::vector<Rect>& regions) {
+    return recognizeRegions(ImageView::rgba(pixels, width, height), regions);
+}
+
+std::vector<Recognition> Engine::recognizeRegions(const ImageView& image, const std::vector<Rect>& regions) {
+    // Rectangles are clamped to the ROI rather than padded by its edge
+    QuadSet quads;
+    quads.reserve(regions.size());
+    for (const Rect& r : regions) {
+        const float left = static_cast<float>(std::max(r.left, image.roi.left));
+        const float top = static_cast<float>(std::max(r.top, image.roi.top));
+        const float right = static_cast<float>(std::min(r.right, image.roi.right));
+        const float bottom = static_cast<float>(std::min(r.bottom, image.roi.bottom));
+        quads.pushRect(left, top, std::max(left, right), std::max(top, bottom), 1.0f);
+    }
+    return recognizeQuads(image, quads);
+}
+
+std::vector<Recognition> Engine::recognizeQuads(const ImageView& image, const QuadSet& quads) {
+    OCR_TRACE_SCOPE("Engine::recognizeRegions", "pipeline");
+    std::vector<Recognition> results(quads.size());
+    scheduler_->parallelFor(static_cast<int>(quads.size()), [&](int i) {
+        float quad[8];
+        quads.corners(i, quad);
+        ContextLease lease = acquireContext();
+        recognizeRegion(*lease, image, quad, results[i]);
+    });
+    return results;
+}
+
+bool Engine::recognizeRegion(RunContext& context, const ImageView& image, const float* quad, Recognition& result,
+                             const ReadingPrior* prior) {
+    OCR_TRACE_SCOPE("region", "pipeline");
+    RgbaImage& crop = context.recCrop;
+    if (!sampleQuad(image, quad, config_.recHeight, config_.recMaxWidth, crop)) return false;
+    orientCrop(context, crop);
+    // The crop and its variants run as one batch and decode as one reading
+    const size_t variants = config_.recTta.size();
+    cropVariants(crop, config_.recTta.data(), variants, context.ttaCrops);
+    const RgbaImage* crops[1 + kMaxRecTta] = {&crop};
+    for (size_t v = 0; v < variants; ++v) crops[1 + v] = &context.ttaCrops[v];
+    const int batch = static_cast<int>(1 + variants);
+    recognizeInto(context, crops, batch, &result, prior, batch);
+    return true;
+}
+
+bool Engine::isReading(const Recognition& recognition) const {
+    // Grammar readings are as long as the grammar allows, decimals included
+    if (config_.recGrammar && reader_->valid()) return matchesReading(recognition, config_.rank, config_.reading);
+    return matchesReading(recognition, config_.rank);
+}
+
+std::vector<MeterCandidate> Engine::readMeter(const uint32_t* pixels, int width, int height,
+                                              const ReadingPrior& prior) {
+    return readMeter(ImageView::rgba(pixels, width, height), prior);
+}
+
+FrameQuality Engine::checkQuality(const ImageView& image) {
+    ContextLease lease = acquireContext();
+    return assessQuality(image, config_.quality, &(*lease).arena);
+}
+
+std::vector<MeterCandidate> Engine::readMeter(const ImageView& image, const ReadingPrior& prior,
+                                              FrameQuality* quality) {
+    OCR_TRACE_SCOPE("Engine::readMeter", "pipeline");
+    if (config_.qualityGate) {
+        const FrameQuality measured = checkQuality(image);
+        if (quality) *quality = measured;
+        if (!measured.usable()) {
+            LOGD("readMeter: frame rejected for %s (sharpness %.1f, clipped %.3f, mean %.1f, spread %.1f)",
+                 qualityIssueName(measured.issue), measured.sharpness, measured.clipped, measured.mean,
+                 measured.spread);
+            return {};
+        }
+    }
+    return readFrame(image, prior);
+}
+
+std::vector<MeterCandidate> Engine::readFrame(const ImageView& image, const ReadingPrior& prior) {
+    const int width = image.roi.width();
+    const int height = image.roi.height();
+    RgbaImage storage;
+    QuadSet boxes = detect(packedRgba(image, storage), width, height);
+
+    std::vector<float> geometry(boxes.size());
+    std::vector<uint32_t> order;
+    {
+        OCR_TRACE_SCOPE("rank", "postprocess");
+        scoreRegions(boxes, width, height, config_.rank, geometry.data());
+        topRegions(geometry.data(), geometry.size(), config_.rank.topK, order);
+    }
+
+    // Regions are sampled from the caller's pixels in image coordinates
+    boxes.translate(static_cast<float>(image.roi.left), static_cast<float>(image.roi.top));
+    std::vector<MeterCandidate> candidates(order.size());
+    for (size_t k = 0; k < order.size(); ++k) {
+        MeterCandidate& candidate = candidates[k];
+        boxes.corners(order[k], candidate.quad.data());
+        candidate.detScore = boxes.score(order[k]);
+        candidate.geometryScore = geometry[order[k]];
+    }
+
+    bool matched = false;
+    if (config_.recEarlyExit) {
+        // In rank order, stopping at the first text that reads as a meter
+        ContextLease lease = acquireContext();
+        size_t recognized = 0;
+        while (recognized < candidates.size() && !matched) {
+            MeterCandidate& candidate = candidates[recognized];
+            recognizeRegion(*lease, image, candidate.quad.data(), candidate.recognition, &prior);
+            matched = isReading(candidate.recognition);
+            ++recognized;
+        }
+        LOGD("readMeter: recognized %zu of %zu ranked regions", recognized, candidates.size());
+        candidates.resize(recognized);
+        // The match is the answer; the misses before it follow by score
+        if (matched) std::rotate(candidates.begin(), candidates.end() - 1, candidates.end());
+    } else {
+        scheduler_->parallelFor(static_cast<int>(candidates.size()), [&](int k) {
+            ContextLease lease = acquireContext();
+            recognizeRegion(*lease, image, candidates[k].quad.data(), candidates[k].recognition, &prior);
+        });
+    }
+    for (MeterCandidate& candidate : candidates) {
+        candidate.score = readingScore(candidate.geometryScore, candidate.recognition, config_.rank);
+    }
+    std::stable_sort(candidates.begin() + (matched ? 1 : 0), candidates.end(),
+                     [](const MeterCandidate& a, const MeterCandidate& b) { return a.score > b.score; });
+    return candidates;
+}
+
+BurstReading Engine::readBurst(const std::vector<ImageView>& frames, const ReadingPrior& prior) {
+    OCR_TRACE_SCOPE("Engine::readBurst", "pipeline");
+    BurstReading burst;
+    burst.quality.resize(frames.size());
+    scheduler_->parallelFor(static_cast<int>(frames.size()), [&](int i) {
+        // Only the part of the frame the reading is expected in matters
+        const Rect& r = frames[i].roi;
+        const RankParams& rank = config_.rank;
+        const Rect roi{r.left + static_cast<int>(rank.roiLeft * r.width()),
+                       r.top + static_cast<int>(rank.roiTop * r.height()),
+                       r.left + static_cast<int>(std::ceil(rank.roiRight * r.width())),
+                       r.top + static_cast<int>(std::ceil(rank.roiBottom * r.height()))};
+        const ImageView meter = frames[i].cropped(roi);
+        burst.quality[i] = checkQuality(meter.empty() ? frames[i] : meter);
+    });
+
+    std::vector<uint32_t> order;
+    rankFrames(burst.quality.data(), burst.quality.size(), config_.burstTopK, order);
+    if (config_.qualityGate) {
+        order.erase(std::find_if(order.begin(), order.end(),
+                                 [&](uint32_t i) { return !burst.quality[i].usable(); }),
+                    order.end());
+    }
+    LOGD("readBurst: reading %zu of %zu frames", order.size(), frames.size());
+
+    std::vector<std::vector<MeterCandidate>> reads(order.size());
+    scheduler_->parallelFor(static_cast<int>(order.size()),
+                            [&](int k) { reads[k] = readFrame(frames[order[k]], prior); });
+
+    // Each frame's answer comes first in its list; those that are readings
+    // are fused. Without early exit a frame may rank a serial number or a
+    // label first, which must not be fused into, or lead, the reading.
+    std::vector<const Recognition*> answers;
+    int leader = -1;
+    for (size_t k = 0; k < reads.size(); ++k) {
+        if (reads[k].empty() || !isReading(reads[k][0].recognition)) continue;
+        answers.push_back(&reads[k][0].recognition);
+        if (leader < 0 || reads[k][0].recognition.confidence > reads[leader][0].recognition.confidence) {
+            leader = static_cast<int>(k);
+        }
+    }
+    if (config_.burstFuse && answers.size() > 1) {
+        // Readings are digits when the grammar decodes them
+        const int alphabet = config_.recGrammar && reader_->valid() ? 10 : dict_.classCount() - 1;
+        MeterCandidate fused;
+        if (fuseRecognitions(answers.data(), answers.size(), alphabet, fused.recognition)) {
+            const MeterCandidate& source = reads[leader][0];
+            fused.quad = source.quad;
+            fused.detScore = source.detScore;
+            fused.geometryScore = source.geometryScore;
+            fused.score = readingScore(fused.geometryScore, fused.recognition, config_.rank);
+            burst.candidates.push_back(std::move(fused));
+            burst.frames.push_back(static_cast<int>(order[leader]));
+            burst.fused = true;
+        }
+    }
+
+    // After the fused reading: readings of the meter before other text,
+    // each by score
+    std::vector<std::pair<int, MeterCandidate*>> ranked;
+    for (size_t k = 0; k < reads.size(); ++k) {
+        for (MeterCandidate& candidate : reads[k]) ranked.emplace_back(static_cast<int>(order[k]), &candidate);
+    }
+    std::stable_sort(ranked.begin(), ranked.end(), [this](const auto& a, const auto& b) {
+        const bool matchA = isReading(a.second->recognition);
+        const bool matchB = isReading(b.second->recognition);
+        return matchA != matchB ? matchA : a.second->score > b.second->score;
+    });
+    for (auto& entry : ranked) {
+        burst.candidates.push_back(std::move(*entry.second));
+        burst.frames.push_back(entry.first);
+    }
+    return burst;
+}
+
+} // namespace ocr
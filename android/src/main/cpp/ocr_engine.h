@@ -0,0 +1,415 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "ctc_decoder.h"
+#include "frame_quality.h"
+#include "image_enhance.h"
+#include "image_ops.h"
+#include "image_view.h"
+#include "quad_set.h"
+#include "reading_decoder.h"
+#include "region_ranker.h"
+#include "task_scheduler.h"
+
+namespace ocr {
+
+class FrameArena;
+class InferenceSession;
+struct SessionOptions;
+struct TensorView;
+
+// Optional det preprocessing on the luma of the input; det then sees grey.
+enum class DetEnhance {
+    None,
+    Clahe,    // evens out lighting and lifts faint digits
+    Sauvola,  // binarizes against the local mean
+};
+
+enum class WarmUpMode {
+    Off,
+    Sync,   // before the constructor returns
+    Async,  // on a background thread, see Engine::warmUpAsync()
+};
+
+// Input normalization of one model: channel c of its input tensor is
+// (value / 255 - mean[c]) / std[c], channels in input order (see bgrInput).
+// A zero std means auto, resolved per backend when the model loads.
+struct InputNorm {
+    float mean[3] = {0.0f, 0.0f, 0.0f};
+    float std[3] = {0.0f, 0.0f, 0.0f};
+
+    bool automatic() const { return std[0] == 0.0f; }
+
+    static InputNorm unit();        // [0, 1]
+    static InputNorm signedUnit();  // [-1, 1], PP-OCR cls and rec
+    static InputNorm imageNet();    // ImageNet mean and std, PP-OCR det
+};
+
+// Engine settings. Besides the model paths every field can be set from a
+// "key=value" string so the JNI and CLI front ends share one option syntax.
+struct EngineConfig {
+    std::string detModelPath;
+    std::string clsModelPath;
+    std::string recModelPath;
+
+    // Inference backend for all three models: "onnxruntime", "paddle_lite",
+    // or "auto" to pick per model by file extension.
+    std::string backend = "auto";
+
+    int intraOpThreads = 1;
+
+    // Execution providers in order of preference ("xnnpack", "nnapi",
+    // "cpu"); a provider that is missing or fails to take the model falls
+    // through to the next, and CPU is always the last resort, so "cpu" may
+    // only be listed last. The per-model lists override `providers`. Only
+    // ONNX Runtime uses them.
+    std::vector<std::string> providers;
+    std::vector<std::string> detProviders;
+    std::vector<std::string> clsProviders;
+    std::vector<std::string> recProviders;
+    // Verbose runtime logging at session creation, which reports the
+    // provider every node was placed on.
+    bool logPlacement = false;
+
+    // Scheduler threads for crop and tile parallelism, besides the caller;
+    // -1 sizes the pool so that threads * intraOpThreads fits the cores.
+    int workers = -1;
+
+    // PaddleOCR character dictionary; empty means digits only.
+    std::string dictPath;
+
+    // Channel order of the model inputs. Pixels are RGB; PaddleOCR models
+    // trained on OpenCV-decoded images expect BGR.
+    bool bgrInput = false;
+    // Auto takes PP-OCR's normalization on Paddle Lite, where the stock
+    // PaddleOCR models run, and [0, 1] on ONNX Runtime.
+    InputNorm detNorm;
+    InputNorm clsNorm;
+    InputNorm recNorm;
+
+    // Recognition crops are resized to recHeight, keeping the aspect ratio up
+    // to recMaxWidth. 0 takes a static height from the rec model, else 32 on
+    // Paddle Lite (the bundled PP-OCR v2.0 models) and 48 on ONNX Runtime
+    // (PP-OCRv3 and later).
+    int recHeight = 0;
+    int recMaxWidth = 640;
+
+    // Minimum score for a detection to be reported.
+    float detThreshold = 0.5f;
+    // Probability-map det models only: binarization threshold and how far
+    // the shrunk text kernels are grown back.
+    float detBinThreshold = 0.3f;
+    float detUnclipRatio = 1.5f;
+
+    // Det input stage for dials under uneven light; off by default because
+    // stock det models are trained on colour photos.
+    DetEnhance detEnhance = DetEnhance::None;
+    SauvolaParams sauvola;
+    ClaheParams clahe;
+
+    // Images larger than detTileSize in either dimension are split into
+    // overlapping tiles detected in parallel; 0 disables tiling.
+    int detTileSize = 0;
+    int detTileOverlap = 64;
+
+    // Detections overlapping a higher-scored one by more than this IoU are
+    // dropped; 0 disables NMS.
+    float detNmsIou = 0.5f;
+    // Joins boxes side by side on one baseline (e.g. single digits) into
+    // one region when their gap is at most detMergeGap box heights.
+    bool detMergeLines = false;
+    float detMergeGap = 1.0f;
+
+    // How readMeter() ranks detected regions and how many it recognizes.
+    RankParams rank;
+    // readMeter() recognizes regions one at a time in rank order and stops
+    // at the first that matches the reading grammar (see matchesReading),
+    // instead of recognizing all top-K in parallel.
+    bool recEarlyExit = true;
+    // readMeter() decodes rec output as a reading of this meter type
+    // instead of free text: only digits, at most one decimal separator, and
+    // the ReadingPrior given to readMeter(). Off by default.
+    bool recGrammar = false;
+    ReadingGrammar reading;
+    // Test-time augmentation: readMeter() and recognizeRegions() also read
+    // every crop as each of these variants (at most 4), in the same rec
+    // batch, and decode the mean of their posteriors. Empty reads the crop
+    // as it is.
+    std::vector<CropVariant> recTta;
+
+    // Text direction classifier: crops classified as upside down with at
+    // least clsThreshold are rotated before rec.
+    bool useCls = true;
+    float clsThreshold = 0.9f;
+    int clsHeight = 48;
+    int clsWidth = 192;
+
+    // Shape buckets: extra det/rec sessions whose input size is fixed, so the
+    // runtime can plan memory and fold shapes for it. Single-image calls run
+    // on the smallest bucket that fits, zero-padding the input; larger inputs
+    // and batches use the dynamic session. Every bucket is a separate session
+    // with its own copy of the weights. ONNX Runtime only, and the model's
+    // dynamic dims must have symbolic names.
+    std::vector<std::pair<int, int>> detBuckets;  // width x height
+    std::vector<int> recBuckets;                  // widths at recHeight
+
+    // Batch inference: images are letterboxed so their longer side is
+    // detMaxSide, and det/rec run up to detBatch/recBatch inputs per call.
+    int detMaxSide = 960;
+    int detBatch = 4;
+    int recBatch = 8;
+    // BatchRunner decodes JPEGs straight to about detMaxSide inside the IDCT
+    // (see DecodeOptions), then decodes only the regions' bounding box at
+    // full resolution for rec. decodeGray decodes luma only.
+    bool decodeScaled = false;
+    bool decodeGray = false;
+
+    // readMeter() first measures blur and exposure on a thumbnail (see
+    // assessQuality) and returns no candidates, without running a model,
+    // for frames that miss `quality`. Meant for camera streams, where the
+    // next frame is usually better.
+    bool qualityGate = false;
+    QualityParams quality;
+
+    // readBurst() runs the pipeline on the burstTopK frames that score best
+    // in the meter ROI and, with burstFuse, fuses their readings character
+    // by character (see fuseRecognitions).
+    int burstTopK = 2;
+    bool burstFuse = true;
+
+    // Runs every model once per scheduler thread on dummy inputs at load.
+    WarmUpMode warmUp = WarmUpMode::Off;
+
+    // Chrome trace-event output; empty disables tracing. Also turns on the
+    // backend profiler where there is one (ORT), merged into the same file
+    // when the engine closes.
+    std::string tracePath;
+
+    // Applies one "key=value" option. Returns false for unknown keys or
+    // malformed values.
+    bool applyOption(const std::string& option);
+};
+
+// Per-worker scratch state: input buffers and backend run state. Defined in
+// ocr_engine.cpp; callers only hold it through a ContextLease.
+struct RunContext;
+
+class Engine;
+
+// Time spent in Engine::warmUp(), in milliseconds. Model times are summed
+// over the warmed contexts, which run in parallel.
+struct WarmUpReport {
+    int contexts = 0;
+    double detMs = 0.0;
+    double clsMs = 0.0;
+    double recMs = 0.0;
+    double totalMs = 0.0;
+};
+
+// A detected region that readMeter() recognized, with its ranking.
+struct MeterCandidate {
+    // Corners clockwise from the top-left, in image pixels.
+    std::array<float, 8> quad{};
+    float detScore = 0.0f;
+    // Aspect, position and det score before recognition.
+    float geometryScore = 0.0f;
+    Recognition recognition;
+    // Geometry combined with the digits and confidence of the text.
+    float score = 0.0f;
+};
+
+// readBurst() result for several shots of the same meter.
+struct BurstReading {
+    // Every frame, in input order, measured in the rank ROI.
+    std::vector<FrameQuality> quality;
+    // Candidates of the frames read, best first, and the frame each came
+    // from. When `fused`, the first is the fused reading, placed at the quad
+    // of its most confident frame.
+    std::vector<MeterCandidate> candidates;
+    std::vector<int> frames;
+    bool fused = false;
+};
+
+// Exclusive use of one RunContext, returned to the engine's pool on
+// destruction.
+class ContextLease {
+public:
+    ContextLease(ContextLease&& other) noexcept;
+    ContextLease& operator=(ContextLease&&) = delete;
+    ~ContextLease();
+
+    RunContext& operator*() const { return *context_; }
+
+private:
+    friend class Engine;
+    ContextLease(Engine* engine, std::unique_ptr<RunContext> context);
+
+    Engine* engine_;
+    std::unique_ptr<RunContext> context_;
+};
+
+// Runs the det/cls/rec models on RGBA pixel buffers through the configured
+// inference backends. Throws std::exception from the constructor when a model
+// fails to load or its inputs/outputs do not fit the pipeline.
+//
+// Thread safety: one Engine may be shared by any number of threads. The
+// sessions are created once and never modified afterwards, and everything a
+// call writes to, backend run state included, lives in a RunContext. Contexts
+// are pooled, so concurrent callers each get their own and sequential callers
+// reuse the same buffers. Destruction must
+// not race with calls in flight.
+class Engine {
+public:
+    explicit Engine(const EngineConfig& config);
+    ~Engine();
+
+    Engine(const Engine&) = delete;
+    Engine& operator=(const Engine&) = delete;
+
+    const EngineConfig& config() const { return config_; }
+
+    // Leases a context from the pool, creating one when all are busy.
+    ContextLease acquireContext();
+
+    // Text quads in input pixel coordinates.
+    QuadSet detect(RunContext& context, const uint32_t* pixels, int width, int height);
+    // Uses tiles when configured, detecting them in parallel.
+    QuadSet detect(const uint32_t* pixels, int width, int height);
+    // Any pixel format, stride and ROI; boxes are in image coordinates.
+    QuadSet detect(const ImageView& image);
+
+    // Runs det once on a batch of same-sized, tightly packed images (e.g. the
+    // output of letterbox()) and returns the boxes of each image.
+    std::vector<QuadSet> detectBatch(RunContext& context, const std::vector<const uint32_t*>& images,
+                                     int width, int height);
+
+    // Recognizes a whole crop, resizing it to the rec input height first.
+    Recognition recognize(RunContext& context, const uint32_t* pixels, int width, int height);
+    Recognition recognize(const uint32_t* pixels, int width, int height);
+    Recognition recognize(const ImageView& image);
+
+    // Turns `crop` by 180 degrees when cls finds it upside down, as
+    // readMeter() does before rec. Does nothing without useCls.
+    void orientCrop(RunContext& context, RgbaImage& crop);
+
+    // Runs rec once on crops already at config().recHeight (see cropToHeight);
+    // narrower crops are zero-padded to the widest one.
+    std::vector<Recognition> recognizeBatch(RunContext& context, const std::vector<const RgbaImage*>& crops);
+
+    // Samples each region from the tightly packed image straight to rec
+    // height, fixes its direction with cls and recognizes it. Regions are
+    // processed in parallel on the engine scheduler; results are in region
+    // order.
+    std::vector<Recognition> recognizeRegions(const uint32_t* pixels, int width, int height,
+                                              const std::vector<Rect>& regions);
+    // Regions in image coordinates, clamped to the view's ROI.
+    std::vector<Recognition> recognizeRegions(const ImageView& image, const std::vector<Rect>& regions);
+    // Same for quads, which are sampled along their edges so rotated text
+    // reaches rec level.
+    std::vector<Recognition> recognizeQuads(const ImageView& image, const QuadSet& quads);
+
+    // Detects text, ranks the regions as meter readings (config().rank) and
+    // recognizes only the top ones, so clutter such as serial numbers and
+    // brand names costs no rec time. With recEarlyExit, recognition stops at
+    // the first region that reads as a meter; it comes first and the regions
+    // after it are left out. Otherwise candidates come best first. With
+    // recGrammar, `prior` steers decoding towards plausible readings.
+    std::vector<MeterCandidate> readMeter(const uint32_t* pixels, int width, int height,
+                                          const ReadingPrior& prior = ReadingPrior());
+    // Any pixel format, stride and ROI; quads are in image coordinates. With
+    // qualityGate, `quality` receives the frame's measurements; a rejected
+    // frame has an issue set and no candidates.
+    std::vector<MeterCandidate> readMeter(const ImageView& image, const ReadingPrior& prior = ReadingPrior(),
+                                          FrameQuality* quality = nullptr);
+
+    // Blur and exposure of the frame against config().quality, whether or
+    // not the gate is on.
+    FrameQuality checkQuality(const ImageView& image);
+
+    // Reads a burst of frames of one meter at close to the cost of one:
+    // every frame is scored with checkQuality() inside the rank ROI, and
+    // only the burstTopK best go through det and rec, in parallel. With
+    // qualityGate, rejected frames are never read.
+    BurstReading readBurst(const std::vector<ImageView>& frames, const ReadingPrior& prior = ReadingPrior());
+
+    TaskScheduler& scheduler() { return *scheduler_; }
+
+    // Runs det, cls and rec on dummy inputs at the largest configured shapes
+    // in one context per scheduler thread, so that the runtimes' lazy
+    // allocations, kernel selection and weight page faults happen now rather
+    // than on the first real frame, and the pooled buffers reach their
+    // steady-state size.
+    WarmUpReport warmUp();
+    // Starts warmUp() on a background thread and returns immediately. Calls
+    // made meanwhile work as usual and may simply run slower; the destructor
+    // waits for the warm-up to finish.
+    void warmUpAsync();
+
+private:
+    friend class ContextLease;
+    void releaseContext(std::unique_ptr<RunContext> context);
+    // readMeter() past the quality gate.
+    std::vector<MeterCandidate> readFrame(const ImageView& image, const ReadingPrior& prior);
+    QuadSet detectRegion(RunContext& context, const uint32_t* pixels, int stride, int width, int height);
+    bool isUpsideDown(RunContext& context, const RgbaImage& crop);
+    // Sampling, cls and rec of one quad of `image`; false for a degenerate
+    // quad.
+    bool recognizeRegion(RunContext& context, const ImageView& image, const float* quad, Recognition& result,
+                         const ReadingPrior* prior = nullptr);
+    // recognizeBatch without the container allocations. With a prior and
+    // recGrammar the output is decoded as a reading. Each run of `variants`
+    // crops holds versions of one crop of the same size; their posteriors
+    // are averaged into one result.
+    void recognizeInto(RunContext& context, const RgbaImage* const* crops, int batch, Recognition* results,
+                       const ReadingPrior* prior = nullptr, int variants = 1);
+    void refineBoxes(QuadSet& boxes, FrameArena* arena) const;
+    // Runs rec once to learn the class count of a model that does not
+    // declare it, and throws when the dictionary does not match.
+    void probeRecClasses();
+    // matchesReading() under the bounds of the reading grammar when rec
+    // decodes with it.
+    bool isReading(const Recognition& recognition) const;
+    std::vector<QuadSet> parseDetOutput(RunContext& context, const TensorView& output, int batch, int width,
+                                        int height) const;
+
+    // A copy of a model specialized to one input size; `slot` indexes the
+    // scratch of each RunContext.
+    struct ShapeBucket {
+        int width;
+        int height;
+        int slot;
+        std::unique_ptr<InferenceSession> session;
+    };
+    void loadBuckets(const std::string& path, const InferenceSession& base, const SessionOptions& options,
+                     const std::vector<std::pair<int, int>>& sizes, std::vector<ShapeBucket>& buckets);
+    const ShapeBucket* findBucket(const std::vector<ShapeBucket>& buckets, int width, int height) const;
+    void finishTrace();
+
+    EngineConfig config_;
+    std::unique_ptr<InferenceSession> det_;
+    std::unique_ptr<InferenceSession> cls_;
+    std::unique_ptr<InferenceSession> rec_;
+    std::vector<ShapeBucket> detBuckets_;
+    std::vector<ShapeBucket> recBuckets_;
+    int slotCount_ = 3;
+    CharDict dict_;
+    std::unique_ptr<ReadingDecoder> reader_;
+    std::unique_ptr<TaskScheduler> scheduler_;
+
+    std::mutex contextMutex_;
+    std::vector<std::unique_ptr<RunContext>> idleContexts_;
+    int createdContexts_ = 0;
+
+    bool ownsTrace_ = false;
+    std::future<WarmUpReport> pendingWarmUp_;
+};
+
+} // namespace ocr
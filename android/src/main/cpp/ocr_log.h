@@ -0,0 +1,31 @@
+#pragma once
+
+// Logging shared by the JNI glue and the portable core. On Android messages go
+// to logcat; the Linux host build writes them to stderr.
+
+#ifdef __ANDROID__
+#include <android/log.h>
+
+#define TAG "PaddleOCR_JNI"
+#define LOGD(...) __android_log_print(ANDROID_LOG_DEBUG, TAG, __VA_ARGS__)
+#define LOGI(...) __android_log_print(ANDROID_LOG_INFO, TAG, __VA_ARGS__)
+#define LOGW(...) __android_log_print(ANDROID_LOG_WARN, TAG, __VA_ARGS__)
+#define LOGE(...) __android_log_print(ANDROID_LOG_ERROR, TAG, __VA_ARGS__)
+#else
+#include <cstdio>
+
+#define OCR_LOG_(level, ...) \
+    do { \
+        std::fprintf(stderr, "[" level "] "); \
+        std::fprintf(stderr, __VA_ARGS__); \
+        std::fprintf(stderr, "\n"); \
+    } while (0)
+#ifdef NDEBUG
+#define LOGD(...) do {} while (0)
+#else
+#define LOGD(...) OCR_LOG_("D", __VA_ARGS__)
+#endif
+#define LOGI(...) OCR_LOG_("I", __VA_ARGS__)
+#define LOGW(...) OCR_LOG_("W", __VA_ARGS__)
+#define LOGE(...) OCR_LOG_("E", __VA_ARGS__)
+#endif
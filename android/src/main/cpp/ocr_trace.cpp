@@ -0,0 +1,240 @@
+#include "ocr_trace.h"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <mutex>
+#include <sstream>
+#include <vector>
+
+#include "ocr_log.h"
+
+namespace ocr {
+namespace trace {
+
+namespace detail {
+std::atomic<bool> gEnabled{false};
+}
+
+namespace {
+
+constexpr int kPipelinePid = 1;
+constexpr int kFirstOrtPid = 100;
+
+struct Event {
+    const char* name;
+    const char* category;
+    int64_t startUs;
+    int64_t durationUs;
+    int tid;
+};
+
+struct State {
+    std::mutex mutex;
+    std::string path;
+    std::vector<Event> events;
+    // Already-serialized events taken over from ORT profiles.
+    std::vector<std::string> foreignEvents;
+    int nextForeignPid = kFirstOrtPid;
+};
+
+State& state() {
+    static State s;
+    return s;
+}
+
+const std::chrono::steady_clock::time_point kEpoch = std::chrono::steady_clock::now();
+
+int currentTid() {
+    static std::atomic<int> nextTid{1};
+    thread_local int tid = nextTid.fetch_add(1);
+    return tid;
+}
+
+void appendEscaped(std::string& out, const std::string& text) {
+    for (char c : text) {
+        if (c == '"' || c == '\\') {
+            out += '\\';
+            out += c;
+        } else if (static_cast<unsigned char>(c) < 0x20) {
+            out += ' ';
+        } else {
+            out += c;
+        }
+    }
+}
+
+std::string processNameEvent(int pid, const std::string& name) {
+    std::string out = "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":" + std::to_string(pid) +
+                      ",\"tid\":0,\"args\":{\"name\":\"";
+    appendEscaped(out, name);
+    out += "\"}}";
+    return out;
+}
+
+// Splits the top-level JSON array in `text` into the raw text of its object
+// elements. ORT writes one flat array of event objects, which is all we need.
+std::vector<std::string> splitArrayObjects(const std::string& text) {
+    std::vector<std::string> objects;
+    int depth = 0;
+    bool inString = false;
+    size_t objectStart = 0;
+    for (size_t i = 0; i < text.size(); ++i) {
+        char c = text[i];
+        if (inString) {
+            if (c == '\\') {
+                ++i;
+            } else if (c == '"') {
+                inString = false;
+            }
+            continue;
+        }
+        if (c == '"') {
+            inString = true;
+        } else if (c == '{' || c == '[') {
+            if (c == '{' && depth == 1) objectStart = i;
+            ++depth;
+        } else if (c == '}' || c == ']') {
+            --depth;
+            if (c == '}' && depth == 1) objects.push_back(text.substr(objectStart, i - objectStart + 1));
+        }
+    }
+    return objects;
+}
+
+// Replaces the integer value of top-level `key` in the JSON object `object`
+// with `transform(value)`. Returns false when the key is absent.
+template <typename Fn>
+bool rewriteIntField(std::string& object, const char* key, Fn transform) {
+    const std::string quoted = std::string("\"") + key + "\"";
+    int depth = 0;
+    bool inString = false;
+    for (size_t i = 0; i < object.size(); ++i) {
+        char c = object[i];
+        if (inString) {
+            if (c == '\\') {
+                ++i;
+            } else if (c == '"') {
+                inString = false;
+            }
+            continue;
+        }
+        if (c == '{' || c == '[') {
+            ++depth;
+        } else if (c == '}' || c == ']') {
+            --depth;
+        } else if (c == '"') {
+            if (depth == 1 && object.compare(i, quoted.size(), quoted) == 0) {
+                size_t pos = i + quoted.size();
+                while (pos < object.size() && object[pos] == ' ') ++pos;
+                if (pos < object.size() && object[pos] == ':') {
+                    ++pos;
+                    while (pos < object.size() && object[pos] == ' ') ++pos;
+                    size_t end = pos;
+                    if (end < object.size() && object[end] == '-') ++end;
+                    while (end < object.size() && object[end] >= '0' && object[end] <= '9') ++end;
+                    if (end == pos) return false;
+                    long long value = std::strtoll(object.c_str() + pos, nullptr, 10);
+                    object.replace(pos, end - pos, std::to_string(transform(static_cast<int64_t>(value))));
+                    return true;
+                }
+            }
+            inString = true;
+        }
+    }
+    return false;
+}
+
+} // namespace
+
+bool start(const std::string& path) {
+    State& s = state();
+    std::lock_guard<std::mutex> lock(s.mutex);
+    if (detail::gEnabled.load()) {
+        LOGW("Trace already running, writing to %s", s.path.c_str());
+        return false;
+    }
+    s.path = path;
+    s.events.clear();
+    s.foreignEvents.clear();
+    s.nextForeignPid = kFirstOrtPid;
+    detail::gEnabled.store(true);
+    LOGI("Tracing native pipeline to %s", path.c_str());
+    return true;
+}
+
+std::string outputPath() {
+    State& s = state();
+    std::lock_guard<std::mutex> lock(s.mutex);
+    return detail::gEnabled.load() ? s.path : std::string();
+}
+
+int64_t nowUs() {
+    return std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::steady_clock::now() - kEpoch).count();
+}
+
+void recordComplete(const char* name, const char* category, int64_t startUs, int64_t durationUs) {
+    if (!enabled()) return;
+    int tid = currentTid();
+    State& s = state();
+    std::lock_guard<std::mutex> lock(s.mutex);
+    s.events.push_back({name, category, startUs, durationUs, tid});
+}
+
+bool mergeOrtProfile(const std::string& ortProfilePath, const std::string& label, int64_t ortStartUs) {
+    if (!enabled()) return false;
+    std::ifstream in(ortProfilePath);
+    if (!in) {
+        LOGE("Cannot open ORT profile %s", ortProfilePath.c_str());
+        return false;
+    }
+    std::stringstream buffer;
+    buffer << in.rdbuf();
+    std::vector<std::string> objects = splitArrayObjects(buffer.str());
+
+    State& s = state();
+    std::lock_guard<std::mutex> lock(s.mutex);
+    const int pid = s.nextForeignPid++;
+    s.foreignEvents.push_back(processNameEvent(pid, label));
+    for (std::string& object : objects) {
+        rewriteIntField(object, "ts", [&](int64_t ts) { return ts + ortStartUs; });
+        rewriteIntField(object, "pid", [&](int64_t) { return static_cast<int64_t>(pid); });
+        s.foreignEvents.push_back(std::move(object));
+    }
+    LOGI("Merged %zu ORT profile events from %s", objects.size(), ortProfilePath.c_str());
+    return true;
+}
+
+bool finish() {
+    State& s = state();
+    std::lock_guard<std::mutex> lock(s.mutex);
+    if (!detail::gEnabled.load()) return false;
+    detail::gEnabled.store(false);
+
+    std::ofstream out(s.path, std::ios::trunc);
+    if (!out) {
+        LOGE("Cannot write trace to %s", s.path.c_str());
+        return false;
+    }
+    out << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n";
+    out << processNameEvent(kPipelinePid, "water_meter_ocr");
+    for (const Event& e : s.events) {
+        out << ",\n{\"name\":\"" << e.name << "\",\"cat\":\"" << e.category
+            << "\",\"ph\":\"X\",\"pid\":" << kPipelinePid << ",\"tid\":" << e.tid
+            << ",\"ts\":" << e.startUs << ",\"dur\":" << e.durationUs << "}";
+    }
+    for (const std::string& e : s.foreignEvents) {
+        out << ",\n" << e;
+    }
+    out << "\n]}\n";
+    LOGI("Wrote %zu trace events to %s", s.events.size() + s.foreignEvents.size(), s.path.c_str());
+
+    s.events.clear();
+    s.foreignEvents.clear();
+    return static_cast<bool>(out);
+}
+
+} // namespace trace
+} // namespace ocr
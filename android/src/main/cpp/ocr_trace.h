@@ -0,0 +1,68 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <string>
+
+// Chrome trace-event recorder for the native pipeline.
+//
+// When started, spans recorded through OCR_TRACE_SCOPE are buffered in memory
+// and written by finish() as a trace-event JSON file that loads in Perfetto
+// (ui.perfetto.dev) or chrome://tracing. ONNX Runtime's own profile files can
+// be merged into the same timeline with mergeOrtProfile(). When tracing is off
+// a scope costs one relaxed atomic load.
+
+namespace ocr {
+namespace trace {
+
+namespace detail {
+extern std::atomic<bool> gEnabled;
+}
+
+// Starts buffering events; they are written to `path` by finish().
+bool start(const std::string& path);
+
+inline bool enabled() { return detail::gEnabled.load(std::memory_order_relaxed); }
+
+// Path passed to start(), empty when tracing is off.
+std::string outputPath();
+
+// Microseconds on the trace clock (steady, process-relative).
+int64_t nowUs();
+
+// Records a complete ("X") event. `name` and `category` must be string
+// literals or otherwise outlive the trace.
+void recordComplete(const char* name, const char* category, int64_t startUs, int64_t durationUs);
+
+// Merges an ONNX Runtime profile (the file named by Session::EndProfiling) into
+// the trace. ORT timestamps are relative to its own profiling start, so
+// `ortStartUs` is our clock reading taken when the session was created. The
+// events are shown as a separate process named `label`.
+bool mergeOrtProfile(const std::string& ortProfilePath, const std::string& label, int64_t ortStartUs);
+
+// Writes the buffered events and stops tracing.
+bool finish();
+
+class Scope {
+public:
+    Scope(const char* name, const char* category)
+        : name_(name), category_(category), startUs_(enabled() ? nowUs() : -1) {}
+    ~Scope() {
+        if (startUs_ >= 0) recordComplete(name_, category_, startUs_, nowUs() - startUs_);
+    }
+    Scope(const Scope&) = delete;
+    Scope& operator=(const Scope&) = delete;
+
+private:
+    const char* name_;
+    const char* category_;
+    int64_t startUs_;
+};
+
+} // namespace trace
+} // namespace ocr
+
+#define OCR_TRACE_CONCAT_(a, b) a##b
+#define OCR_TRACE_CONCAT(a, b) OCR_TRACE_CONCAT_(a, b)
+#define OCR_TRACE_SCOPE(name, category) \
+    ::ocr::trace::Scope OCR_TRACE_CONCAT(traceScope_, __LINE__)(name, category)
@@ -0,0 +1,213 @@
+#include "ort_backend.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <exception>
+
+#include "onnxruntime_cxx_api.h"
+#ifdef __ANDROID__
+#include "nnapi_provider_factory.h"
+#endif
+#include "ocr_log.h"
+#include "ocr_trace.h"
+
+namespace ocr {
+
+namespace {
+
+// ONNX Runtime global environment
+Ort::Env& ortEnv() {
+    static Ort::Env env(ORT_LOGGING_LEVEL_WARNING, "WaterOCR");
+    return env;
+}
+
+const Ort::MemoryInfo& cpuMemoryInfo() {
+    static const Ort::MemoryInfo info = Ort::MemoryInfo::CreateCpu(OrtArenaAllocator, OrtMemTypeDefault);
+    return info;
+}
+
+ElementType toElementType(ONNXTensorElementDataType type) {
+    switch (type) {
+    case ONNX_TENSOR_ELEMENT_DATA_TYPE_FLOAT: return ElementType::Float;
+    case ONNX_TENSOR_ELEMENT_DATA_TYPE_FLOAT16: return ElementType::Float16;
+    case ONNX_TENSOR_ELEMENT_DATA_TYPE_INT8: return ElementType::Int8;
+    case ONNX_TENSOR_ELEMENT_DATA_TYPE_UINT8: return ElementType::UInt8;
+    case ONNX_TENSOR_ELEMENT_DATA_TYPE_INT32: return ElementType::Int32;
+    case ONNX_TENSOR_ELEMENT_DATA_TYPE_INT64: return ElementType::Int64;
+    case ONNX_TENSOR_ELEMENT_DATA_TYPE_UNDEFINED: return ElementType::Unknown;
+    default: return ElementType::Other;
+    }
+}
+
+TensorInfo readTensor(const Ort::TypeInfo& typeInfo, std::string name) {
+    TensorInfo info;
+    info.name = std::move(name);
+    auto tensorInfo = typeInfo.GetTensorTypeAndShapeInfo();
+    info.type = toElementType(tensorInfo.GetElementType());
+    info.dims = tensorInfo.GetShape();
+    std::vector<const char*> symbolic = tensorInfo.GetSymbolicDimensions();
+    info.dimNames.resize(info.dims.size());
+    for (size_t i = 0; i < symbolic.size() && i < info.dims.size(); ++i) {
+        if (info.dims[i] < 0 && symbolic[i]) info.dimNames[i] = symbolic[i];
+    }
+    return info;
+}
+
+bool isAvailable(const char* ortName) {
+    static const std::vector<std::string> available = Ort::GetAvailableProviders();
+    return std::find(available.begin(), available.end(), ortName) != available.end();
+}
+
+// Registers `provider` on `options`. Returns false when this ORT build does
+// not include it.
+bool appendProvider(Ort::SessionOptions& options, const std::string& provider, int threads) {
+    if (provider == "cpu") return true;
+    if (provider == "xnnpack") {
+        if (!isAvailable("XnnpackExecutionProvider")) return false;
+        // XNNPACK brings its own thread pool; keep ORT's from competing
+        options.AppendExecutionProvider("XNNPACK", {{"intra_op_num_threads", std::to_string(threads)}});
+        options.SetIntraOpNumThreads(1);
+        options.AddConfigEntry("session.intra_op.allow_spinning", "0");
+        return true;
+    }
+#ifdef __ANDROID__
+    if (provider == "nnapi") {
+        if (!isAvailable("NnapiExecutionProvider")) return false;
+        Ort::ThrowOnError(OrtSessionOptionsAppendExecutionProvider_Nnapi(options, NNAPI_FLAG_USE_NONE));
+        return true;
+    }
+#endif
+    return false;
+}
+
+struct OrtScratch : BackendScratch {
+    Ort::RunOptions runOptions;
+    // Input wrapper and output of the last run. While the caller passes the
+    // same buffer and shape, both are reused and ORT writes the output in
+    // place instead of allocating a new tensor per run.
+    Ort::Value inputValue{nullptr};
+    const float* inputData = nullptr;
+    std::array<int64_t, 4> inputDims{};
+    Ort::Value outputValue{nullptr};
+};
+
+class OrtSession : public InferenceSession {
+public:
+    OrtSession(const std::string& path, const SessionOptions& options) : label_(options.label) {
+        // Try each provider in turn; plain CPU is always the last resort
+        std::vector<std::string> providers = options.providers;
+        if (providers.empty() || providers.back() != "cpu") providers.push_back("cpu");
+        for (const std::string& provider : providers) {
+            Ort::SessionOptions sessionOptions;
+            sessionOptions.SetIntraOpNumThreads(options.intraOpThreads);
+            // Verbose session logs include the provider of every node
+            if (options.logPlacement) sessionOptions.SetLogSeverityLevel(ORT_LOGGING_LEVEL_VERBOSE);
+            for (const auto& dim : options.dimOverrides) {
+                sessionOptions.AddFreeDimensionOverrideByName(dim.first.c_str(), dim.second);
+            }
+            if (!appendProvider(sessionOptions, provider, options.intraOpThreads)) {
+                LOGW("%s: execution provider %s is not available", label_.c_str(), provider.c_str());
+                continue;
+            }
+            if (!options.profilePrefix.empty()) {
+                sessionOptions.EnableProfiling(options.profilePrefix.c_str());
+            }
+            profileStartUs_ = trace::nowUs();
+            try {
+                session_.reset(new Ort::Session(ortEnv(), path.c_str(), sessionOptions));
+            } catch (const Ort::Exception& e) {
+                if (provider == "cpu") throw;
+                LOGW("%s: execution provider %s rejected the model: %s", label_.c_str(), provider.c_str(),
+                     e.what());
+                continue;
+            }
+            provider_ = provider;
+            profiling_ = !options.profilePrefix.empty();
+            break;
+        }
+
+        // Resolve I/O names once
+        info_.reset(new ModelInfo());
+        info_->label = options.label;
+        Ort::AllocatorWithDefaultOptions allocator;
+        for (size_t i = 0; i < session_->GetInputCount(); ++i) {
+            info_->inputs.push_back(readTensor(session_->GetInputTypeInfo(i),
+                                               session_->GetInputNameAllocated(i, allocator).get()));
+        }
+        for (size_t i = 0; i < session_->GetOutputCount(); ++i) {
+            info_->outputs.push_back(readTensor(session_->GetOutputTypeInfo(i),
+                                                session_->GetOutputNameAllocated(i, allocator).get()));
+        }
+        info_->resolveNames();
+    }
+
+    const char* backendName() const override { return "onnxruntime"; }
+    const std::string& provider() const override { return provider_; }
+    bool canSpecializeShapes() const override { return true; }
+
+    std::unique_ptr<BackendScratch> createScratch(int contextId) override {
+        std::unique_ptr<OrtScratch> scratch(new OrtScratch());
+        scratch->runOptions.SetRunTag(("ctx" + std::to_string(contextId)).c_str());
+        return scratch;
+    }
+
+    const TensorView& run(BackendScratch& base, const float* input, const std::array<int64_t, 4>& dims) override {
+        OrtScratch& scratch = static_cast<OrtScratch&>(base);
+        const bool reuse = scratch.inputData == input && scratch.inputDims == dims;
+        if (!reuse) {
+            scratch.inputData = nullptr;
+            size_t count = static_cast<size_t>(dims[0] * dims[1] * dims[2] * dims[3]);
+            // ORT only reads inputs
+            scratch.inputValue = Ort::Value::CreateTensor<float>(cpuMemoryInfo(), const_cast<float*>(input), count,
+                                                                 dims.data(), dims.size());
+            // A null value makes ORT allocate one of the right shape
+            scratch.outputValue = Ort::Value(nullptr);
+        }
+        {
+            OCR_TRACE_SCOPE("Session::Run", "ort");
+            session_->Run(scratch.runOptions, info_->inputNames.data(), &scratch.inputValue, 1,
+                          info_->outputNames.data(), &scratch.outputValue, 1);
+        }
+        if (!reuse) {
+            // Same input shape, same output shape: only read after allocating
+            Ort::TensorTypeAndShapeInfo shapeInfo = scratch.outputValue.GetTensorTypeAndShapeInfo();
+            scratch.output.data = scratch.outputValue.GetTensorData<float>();
+            scratch.output.shape.resize(shapeInfo.GetDimensionsCount());
+            shapeInfo.GetDimensions(scratch.output.shape.data(), scratch.output.shape.size());
+            scratch.inputData = input;
+            scratch.inputDims = dims;
+        }
+        return scratch.output;
+    }
+
+    void finishProfiling() override {
+        if (!profiling_) return;
+        profiling_ = false;
+        const std::string traceLabel = "onnxruntime " + label_;
+        try {
+            Ort::AllocatorWithDefaultOptions allocator;
+            Ort::AllocatedStringPtr file = session_->EndProfilingAllocated(allocator);
+            if (file && trace::mergeOrtProfile(file.get(), traceLabel, profileStartUs_)) {
+                std::remove(file.get());
+            }
+        } catch (const std::exception& e) {
+            LOGE("Failed to collect ORT profile for %s: %s", traceLabel.c_str(), e.what());
+        }
+    }
+
+private:
+    std::string label_;
+    std::string provider_;
+    std::unique_ptr<Ort::Session> session_;
+    bool profiling_ = false;
+    // Trace clock at session creation, used to align the ORT profile.
+    int64_t profileStartUs_ = 0;
+};
+
+} // namespace
+
+std::unique_ptr<InferenceSession> openOrtSession(const std::string& path, const SessionOptions& options) {
+    return std::unique_ptr<InferenceSession>(new OrtSession(path, options));
+}
+
+} // namespace ocr
@@ -0,0 +1,13 @@
+#pragma once
+
+#include <memory>
+#include <string>
+
+#include "inference_backend.h"
+
+namespace ocr {
+
+// ONNX Runtime backend for .onnx/.ort models.
+std::unique_ptr<InferenceSession> openOrtSession(const std::string& path, const SessionOptions& options);
+
+} // namespace ocr
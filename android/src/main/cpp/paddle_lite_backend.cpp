@@ -0,0 +1,102 @@
+#include "paddle_lite_backend.h"
+
+#include <algorithm>
+#include <mutex>
+#include <stdexcept>
+
+#include "paddle_api.h"
+#include "ocr_log.h"
+#include "ocr_trace.h"
+
+namespace ocr {
+
+namespace {
+
+using paddle::lite_api::MobileConfig;
+using paddle::lite_api::PaddlePredictor;
+using paddle::lite_api::Tensor;
+
+struct PaddleLiteScratch : BackendScratch {
+    // Predictors hold their own activations, so every context runs a clone
+    std::shared_ptr<PaddlePredictor> predictor;
+    std::unique_ptr<const Tensor> outputTensor;
+};
+
+class PaddleLiteSession : public InferenceSession {
+public:
+    PaddleLiteSession(const std::string& path, const SessionOptions& options) {
+        MobileConfig config;
+        config.set_model_from_file(path);
+        config.set_threads(options.intraOpThreads);
+        config.set_power_mode(paddle::lite_api::LITE_POWER_NO_BIND);
+        predictor_ = paddle::lite_api::CreatePaddlePredictor<MobileConfig>(config);
+        if (!predictor_) throw std::runtime_error("Paddle Lite failed to load " + path);
+        for (const std::string& provider : options.providers) {
+            // Paddle Lite targets are fixed when the .nb model is optimized
+            if (provider != "cpu") LOGW("%s: Paddle Lite ignores provider %s", options.label.c_str(), provider.c_str());
+        }
+        if (!options.dimOverrides.empty()) {
+            LOGW("%s: Paddle Lite models cannot be specialized per shape", options.label.c_str());
+        }
+        if (!options.profilePrefix.empty()) {
+            LOGW("Paddle Lite has no runtime profiler; %s runs are traced as spans only", options.label.c_str());
+        }
+
+        // Optimized models do not declare shapes, only names
+        info_.reset(new ModelInfo());
+        info_->label = options.label;
+        for (const std::string& name : predictor_->GetInputNames()) {
+            TensorInfo tensor;
+            tensor.name = name;
+            info_->inputs.push_back(tensor);
+        }
+        for (const std::string& name : predictor_->GetOutputNames()) {
+            TensorInfo tensor;
+            tensor.name = name;
+            info_->outputs.push_back(tensor);
+        }
+        info_->resolveNames();
+    }
+
+    const char* backendName() const override { return "paddle_lite"; }
+    const std::string& provider() const override { return provider_; }
+
+    std::unique_ptr<BackendScratch> createScratch(int contextId) override {
+        std::unique_ptr<PaddleLiteScratch> scratch(new PaddleLiteScratch());
+        std::lock_guard<std::mutex> lock(cloneMutex_);
+        scratch->predictor = predictor_->Clone();
+        return scratch;
+    }
+
+    const TensorView& run(BackendScratch& base, const float* input, const std::array<int64_t, 4>& dims) override {
+        PaddleLiteScratch& scratch = static_cast<PaddleLiteScratch&>(base);
+        PaddlePredictor& predictor = *scratch.predictor;
+        {
+            std::unique_ptr<Tensor> tensor = predictor.GetInput(0);
+            tensor->Resize({dims[0], dims[1], dims[2], dims[3]});
+            size_t count = static_cast<size_t>(dims[0] * dims[1] * dims[2] * dims[3]);
+            std::copy(input, input + count, tensor->mutable_data<float>());
+        }
+        {
+            OCR_TRACE_SCOPE("Predictor::Run", "paddle_lite");
+            predictor.Run();
+        }
+        scratch.outputTensor = predictor.GetOutput(0);
+        scratch.output.data = scratch.outputTensor->data<float>();
+        scratch.output.shape = scratch.outputTensor->shape();
+        return scratch.output;
+    }
+
+private:
+    std::shared_ptr<PaddlePredictor> predictor_;
+    const std::string provider_ = "cpu";
+    std::mutex cloneMutex_;
+};
+
+} // namespace
+
+std::unique_ptr<InferenceSession> openPaddleLiteSession(const std::string& path, const SessionOptions& options) {
+    return std::unique_ptr<InferenceSession>(new PaddleLiteSession(path, options));
+}
+
+} // namespace ocr
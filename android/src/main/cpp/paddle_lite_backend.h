@@ -0,0 +1,13 @@
+#pragma once
+
+#include <memory>
+#include <string>
+
+#include "inference_backend.h"
+
+namespace ocr {
+
+// Paddle Lite backend for optimized .nb models (the output of paddle_lite_opt).
+std::unique_ptr<InferenceSession> openPaddleLiteSession(const std::string& path, const SessionOptions& options);
+
+} // namespace ocr
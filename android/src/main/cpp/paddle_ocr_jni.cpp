@@ -1,128 +1,212 @@
 #include <jni.h>
-#include <android/log.h>
 #include <android/bitmap.h>
+#include <algorithm>
+#include <memory>
 #include <string>
 #include <vector>
-#include "onnxruntime_cxx_api.h"
 
-#define TAG "PaddleOCR_JNI"
-#define LOGI(...) __android_log_print(ANDROID_LOG_INFO, TAG, __VA_ARGS__)
-#define LOGE(...) __android_log_print(ANDROID_LOG_ERROR, TAG, __VA_ARGS__)
+#include "ocr_engine.h"
+#include "ocr_log.h"
+#include "ocr_trace.h"
+#include "water_ocr.h"
 
 extern "C" {
 
-// ONNX Runtime global environment
-static Ort::Env env(ORT_LOGGING_LEVEL_WARNING, "WaterOCR");
-
-// Native handle structure with ONNX sessions
+// Native handle structure owning the OCR engine. The engine is thread-safe, so
+// one handle serves concurrent calls from any number of Kotlin threads.
 struct OCRHandle {
-    Ort::Session* detSession;
-    Ort::Session* clsSession;
-    Ort::Session* recSession;
+    std::unique_ptr<ocr::Engine> engine;
+};
+
+static std::string toStdString(JNIEnv *envJ, jstring value) {
+    if (!value) return std::string();
+    const char *chars = envJ->GetStringUTFChars(value, nullptr);
+    std::string result(chars);
+    envJ->ReleaseStringUTFChars(value, chars);
+    return result;
+}
+
+static jobjectArray toStringArray(JNIEnv *envJ, const std::vector<ocr::Recognition>& results) {
+    jobjectArray texts = envJ->NewObjectArray(static_cast<jsize>(results.size()),
+                                              envJ->FindClass("java/lang/String"), nullptr);
+    for (size_t i = 0; i < results.size(); ++i) {
+        jstring text = envJ->NewStringUTF(results[i].text.c_str());
+        envJ->SetObjectArrayElement(texts, static_cast<jsize>(i), text);
+        envJ->DeleteLocalRef(text);
+    }
+    return texts;
+}
+
+// MeterCandidate(text, fractionDigits, confidence, score, quad) objects
+static jobjectArray toCandidateArray(JNIEnv *envJ, const std::vector<ocr::MeterCandidate>& candidates) {
+    jclass candidateClass = envJ->FindClass("com/example/water_meter_sdk/MeterCandidate");
+    jmethodID constructor = envJ->GetMethodID(candidateClass, "<init>", "(Ljava/lang/String;IFF[F)V");
+    jobjectArray out = envJ->NewObjectArray(static_cast<jsize>(candidates.size()), candidateClass, nullptr);
+    for (size_t i = 0; i < candidates.size(); ++i) {
+        const ocr::MeterCandidate& c = candidates[i];
+        jstring text = envJ->NewStringUTF(c.recognition.text.c_str());
+        jfloatArray quad = envJ->NewFloatArray(8);
+        envJ->SetFloatArrayRegion(quad, 0, 8, c.quad.data());
+        jobject candidate = envJ->NewObject(candidateClass, constructor, text, c.recognition.fractionDigits,
+                                            c.recognition.confidence, c.score, quad);
+        envJ->SetObjectArrayElement(out, static_cast<jsize>(i), candidate);
+        envJ->DeleteLocalRef(candidate);
+        envJ->DeleteLocalRef(quad);
+        envJ->DeleteLocalRef(text);
+    }
+    return out;
+}
+
+// Views the direct ByteBuffers of a PixelFrame where they are: no copy, no
+// lock to hold. False, logged, when they do not hold a frame of this format
+// and size.
+static bool bufferView(JNIEnv *envJ, jobjectArray planes, jintArray strides, jint format, jint width, jint height,
+                       ocr::ImageView& view) {
+    if (format < WATER_OCR_FORMAT_RGBA_8888 || format > WATER_OCR_FORMAT_NV12) {
+        LOGE("Unsupported pixel format %d", format);
+        return false;
+    }
+    const void* addresses[3] = {nullptr, nullptr, nullptr};
+    jlong capacities[3] = {0, 0, 0};
+    int rowStrides[3] = {0, 0, 0};
+    const jsize given = std::min({envJ->GetArrayLength(planes), envJ->GetArrayLength(strides), jsize(3)});
+    envJ->GetIntArrayRegion(strides, 0, given, rowStrides);
+    for (jsize i = 0; i < given; ++i) {
+        jobject buffer = envJ->GetObjectArrayElement(planes, i);
+        if (buffer) {
+            addresses[i] = envJ->GetDirectBufferAddress(buffer);
+            capacities[i] = envJ->GetDirectBufferCapacity(buffer);
+            envJ->DeleteLocalRef(buffer);
+        }
+    }
+    // Interleaved camera chroma comes as a V and a U buffer over the same
+    // bytes (PixelFrame.fromImage), V first on some devices (NV21) and U
+    // first on others (NV12). The one that starts first is the chroma plane;
+    // it stops one byte short of the last sample, which the other covers.
+    if (format == WATER_OCR_FORMAT_NV21 && addresses[1] && addresses[2]) {
+        const uint8_t* v = static_cast<const uint8_t*>(addresses[1]);
+        const uint8_t* u = static_cast<const uint8_t*>(addresses[2]);
+        if (u == v + 1) {
+            capacities[1] = std::max(capacities[1], capacities[2] + 1);
+        } else if (v == u + 1) {
+            format = WATER_OCR_FORMAT_NV12;
+            addresses[1] = u;
+            rowStrides[1] = rowStrides[2];
+            capacities[1] = std::max(capacities[2], capacities[1] + 1);
+        }
+    }
+    view = ocr::ImageView::fromPlanes(static_cast<ocr::PixelFormat>(format), addresses, rowStrides, width, height);
+    if (!view.valid()) {
+        LOGE("Buffers do not match a %dx%d frame of format %d, or are not direct", width, height, format);
+        return false;
+    }
+    for (int i = 0; i < 3; ++i) {
+        if (static_cast<size_t>(capacities[i]) < view.planeSize(i)) {
+            LOGE("Plane %d holds %lld bytes, the frame needs %zu", i, static_cast<long long>(capacities[i]),
+                 view.planeSize(i));
+            return false;
+        }
+    }
+    return true;
+}
+
+// Locks a bitmap's pixels for its lifetime and views them in the bitmap's own
+// format and row stride, so no Kotlin-side conversion or copy is needed.
+class LockedBitmap {
+public:
+    LockedBitmap(JNIEnv *envJ, jobject bitmap) : env_(envJ), bitmap_(bitmap) {
+        AndroidBitmapInfo info;
+        if (AndroidBitmap_getInfo(envJ, bitmap, &info) != ANDROID_BITMAP_RESULT_SUCCESS) return;
+        ocr::PixelFormat format;
+        switch (info.format) {
+        case ANDROID_BITMAP_FORMAT_RGBA_8888: format = ocr::PixelFormat::Rgba8888; break;
+        case ANDROID_BITMAP_FORMAT_RGB_565: format = ocr::PixelFormat::Rgb565; break;
+        case ANDROID_BITMAP_FORMAT_A_8: format = ocr::PixelFormat::A8; break;
+        case ANDROID_BITMAP_FORMAT_RGBA_F16: format = ocr::PixelFormat::RgbaF16; break;
+        default:
+            LOGE("Unsupported bitmap format %d", info.format);
+            return;
+        }
+        if (AndroidBitmap_lockPixels(envJ, bitmap, &pixels_) != ANDROID_BITMAP_RESULT_SUCCESS) {
+            pixels_ = nullptr;
+            return;
+        }
+        view_ = ocr::ImageView::packed(format, pixels_, static_cast<int>(info.width), static_cast<int>(info.height),
+                                       static_cast<int>(info.stride));
+    }
+    ~LockedBitmap() {
+        if (pixels_) AndroidBitmap_unlockPixels(env_, bitmap_);
+    }
+    LockedBitmap(const LockedBitmap&) = delete;
+    LockedBitmap& operator=(const LockedBitmap&) = delete;
+
+    bool ok() const { return pixels_ != nullptr; }
+    const ocr::ImageView& view() const { return view_; }
+
+private:
+    JNIEnv *env_;
+    jobject bitmap_;
+    void* pixels_ = nullptr;
+    ocr::ImageView view_;
 };
 
 JNIEXPORT jlong JNICALL
-Java_com_example_flutter_1water_1meter_1ocr_OCRPipeline_nativeInit(
-    JNIEnv *envJ, jobject thiz, jstring detModelPath, jstring clsModelPath, jstring recModelPath) {
-    const char *detPath = envJ->GetStringUTFChars(detModelPath, nullptr);
-    const char *clsPath = envJ->GetStringUTFChars(clsModelPath, nullptr);
-    const char *recPath = envJ->GetStringUTFChars(recModelPath, nullptr);
-    LOGI("Initializing OCR with models: det=%s, cls=%s, rec=%s", detPath, clsPath, recPath);
-    
+Java_com_example_water_1meter_1sdk_OCRPipeline_nativeInit(
+    JNIEnv *envJ, jobject thiz, jstring detModelPath, jstring clsModelPath, jstring recModelPath,
+    jobjectArray options) {
+    ocr::EngineConfig config;
+    config.detModelPath = toStdString(envJ, detModelPath);
+    config.clsModelPath = toStdString(envJ, clsModelPath);
+    config.recModelPath = toStdString(envJ, recModelPath);
+
+    // Options arrive as "key=value" strings
+    jsize optionCount = options ? envJ->GetArrayLength(options) : 0;
+    for (jsize i = 0; i < optionCount; ++i) {
+        auto option = static_cast<jstring>(envJ->GetObjectArrayElement(options, i));
+        std::string text = toStdString(envJ, option);
+        envJ->DeleteLocalRef(option);
+        if (!config.applyOption(text)) {
+            LOGW("Ignoring unknown OCR option: %s", text.c_str());
+        }
+    }
+
     try {
-        Ort::SessionOptions options;
-        options.SetIntraOpNumThreads(1);
-        OCRHandle* handle = new OCRHandle();
-        handle->detSession = new Ort::Session(::env, detPath, options);
-        handle->clsSession = new Ort::Session(::env, clsPath, options);
-        handle->recSession = new Ort::Session(::env, recPath, options);
-        
-        envJ->ReleaseStringUTFChars(detModelPath, detPath);
-        envJ->ReleaseStringUTFChars(clsModelPath, clsPath);
-        envJ->ReleaseStringUTFChars(recModelPath, recPath);
-        
-        LOGI("OCR initialized successfully via ONNX Runtime");
-        return reinterpret_cast<jlong>(handle);
+        std::unique_ptr<OCRHandle> handle(new OCRHandle());
+        handle->engine.reset(new ocr::Engine(config));
+        LOGI("OCR initialized successfully");
+        return reinterpret_cast<jlong>(handle.release());
     } catch (const std::exception& e) {
         LOGE("Failed to initialize OCR: %s", e.what());
-        envJ->ReleaseStringUTFChars(detModelPath, detPath);
-        envJ->ReleaseStringUTFChars(clsModelPath, clsPath);
-        envJ->ReleaseStringUTFChars(recModelPath, recPath);
         return 0;
     }
 }
 
 JNIEXPORT jobjectArray JNICALL
-Java_com_example_flutter_1water_1meter_1ocr_OCRPipeline_nativeDetectText(
+Java_com_example_water_1meter_1sdk_OCRPipeline_nativeDetectText(
     JNIEnv *envJ, jobject thiz, jlong handle, jobject bitmap) {
     if (!handle) return nullptr;
+    OCR_TRACE_SCOPE("nativeDetectText", "jni");
     auto* h = reinterpret_cast<OCRHandle*>(handle);
-    
+
     try {
-        // Convert Android Bitmap to float tensor
-        AndroidBitmapInfo info;
-        void* pixels;
-        AndroidBitmap_getInfo(envJ, bitmap, &info);
-        AndroidBitmap_lockPixels(envJ, bitmap, &pixels);
-        int width = info.width, height = info.height;
-        
-        // Convert RGBA bitmap to RGB CHW float32 tensor
-        std::vector<float> inputTensor(3 * height * width);
-        uint32_t* rgbaPixels = static_cast<uint32_t*>(pixels);
-        
-        for (int y = 0; y < height; y++) {
-            for (int x = 0; x < width; x++) {
-                uint32_t pixel = rgbaPixels[y * width + x];
-                uint8_t r = (pixel >> 16) & 0xFF;
-                uint8_t g = (pixel >> 8) & 0xFF;
-                uint8_t b = pixel & 0xFF;
-                
-                // Normalize to [0,1] and arrange in CHW format
-                int idx = y * width + x;
-                inputTensor[0 * height * width + idx] = r / 255.0f;
-                inputTensor[1 * height * width + idx] = g / 255.0f;
-                inputTensor[2 * height * width + idx] = b / 255.0f;
-            }
-        }
-        AndroidBitmap_unlockPixels(envJ, bitmap);
-        
-        // Create ONNX tensor
-        std::array<int64_t, 4> dims = {1, 3, height, width};
-        Ort::Value input = Ort::Value::CreateTensor<float>(env.GetAllocatorWithDefaultOptions(), inputTensor.data(), inputTensor.size(), dims.data(), dims.size());
-        
-        // Run detection session
-        const char* inputName = h->detSession->GetInputName(0, env.GetAllocatorWithDefaultOptions());
-        auto output = h->detSession->Run(Ort::RunOptions{nullptr}, &inputName, &input, 1, h->detSession->GetOutputNames(nullptr), h->detSession->GetOutputCount());
-        
-        // Parse detection output tensor into bounding boxes
-        float* outputData = output[0].GetTensorMutableData<float>();
-        auto outputShape = output[0].GetTensorTypeAndShapeInfo().GetShape();
-        
-        std::vector<std::vector<float>> dets;
-        // Assuming output shape is [1, N, 9] where N is number of detections
-        if (outputShape.size() >= 3) {
-            int numDets = outputShape[1];
-            int featDim = outputShape[2];
-            
-            for (int i = 0; i < numDets; i++) {
-                std::vector<float> detection;
-                for (int j = 0; j < featDim; j++) {
-                    detection.push_back(outputData[i * featDim + j]);
-                }
-                // Filter by confidence threshold
-                if (detection.size() > 8 && detection[8] > 0.5f) {
-                    dets.push_back(detection);
-                }
-            }
-        }
-        
-        // Convert to Java float[][] array
+        ocr::QuadSet dets;
+        {
+            LockedBitmap locked(envJ, bitmap);
+            if (!locked.ok()) return nullptr;
+            dets = h->engine->detect(locked.view());
+        }
+
+        // Convert to Java float[][]: 8 quad coordinates followed by the score
         jclass floatArrayClass = envJ->FindClass("[F");
         jobjectArray outer = envJ->NewObjectArray(dets.size(), floatArrayClass, nullptr);
         for (size_t i = 0; i < dets.size(); ++i) {
-            jfloatArray inner = envJ->NewFloatArray(dets[i].size());
-            envJ->SetFloatArrayRegion(inner, 0, dets[i].size(), dets[i].data());
+            float box[9];
+            dets.corners(i, box);
+            box[8] = dets.score(i);
+            jfloatArray inner = envJ->NewFloatArray(9);
+            envJ->SetFloatArrayRegion(inner, 0, 9, box);
             envJ->SetObjectArrayElement(outer, i, inner);
+            envJ->DeleteLocalRef(inner);
         }
         return outer;
     } catch (const std::exception& e) {
@@ -131,66 +215,219 @@ Java_com_example_flutter_1water_1meter_1ocr_OCRPipeline_nativeDetectText(
     }
 }
 
-JNIEXPORT jstring JNICALL
-Java_com_example_flutter_1water_1meter_1ocr_OCRPipeline_nativeRecognizeText(
-    JNIEnv *envJ, jobject thiz, jlong handle, jobject bitmap) {
+JNIEXPORT jobjectArray JNICALL
+Java_com_example_water_1meter_1sdk_OCRPipeline_nativeRecognizeRegions(
+    JNIEnv *envJ, jobject thiz, jlong handle, jobject bitmap, jintArray rects) {
     if (!handle) return nullptr;
+    OCR_TRACE_SCOPE("nativeRecognizeRegions", "jni");
     auto* h = reinterpret_cast<OCRHandle*>(handle);
-    
+
     try {
-        // Convert bitmap to tensor for recognition
-        AndroidBitmapInfo info;
-        void* pixels;
-        AndroidBitmap_getInfo(envJ, bitmap, &info);
-        AndroidBitmap_lockPixels(envJ, bitmap, &pixels);
-        int width = info.width, height = info.height;
-        
-        // Convert to CHW float32 tensor (same as detection)
-        std::vector<float> inputTensor(3 * height * width);
-        uint32_t* rgbaPixels = static_cast<uint32_t*>(pixels);
-        
-        for (int y = 0; y < height; y++) {
-            for (int x = 0; x < width; x++) {
-                uint32_t pixel = rgbaPixels[y * width + x];
-                uint8_t r = (pixel >> 16) & 0xFF;
-                uint8_t g = (pixel >> 8) & 0xFF;
-                uint8_t b = pixel & 0xFF;
-                
-                int idx = y * width + x;
-                inputTensor[0 * height * width + idx] = r / 255.0f;
-                inputTensor[1 * height * width + idx] = g / 255.0f;
-                inputTensor[2 * height * width + idx] = b / 255.0f;
-            }
-        }
-        AndroidBitmap_unlockPixels(envJ, bitmap);
-        
-        // Create ONNX tensor and run recognition
-        std::array<int64_t, 4> dims = {1, 3, height, width};
-        Ort::Value input = Ort::Value::CreateTensor<float>(env.GetAllocatorWithDefaultOptions(), inputTensor.data(), inputTensor.size(), dims.data(), dims.size());
-        
-        const char* inputName = h->recSession->GetInputName(0, env.GetAllocatorWithDefaultOptions());
-        auto output = h->recSession->Run(Ort::RunOptions{nullptr}, &inputName, &input, 1, h->recSession->GetOutputNames(nullptr), h->recSession->GetOutputCount());
-        
-        // Decode recognition output (CTC or attention-based)
-        // For now, return placeholder - implement CTC decoding based on your model
-        std::string result = "123456"; // Mock water meter reading
-        return envJ->NewStringUTF(result.c_str());
+        // rects holds left, top, right, bottom per region
+        std::vector<ocr::Rect> regions(envJ->GetArrayLength(rects) / 4);
+        std::vector<jint> coords(regions.size() * 4);
+        envJ->GetIntArrayRegion(rects, 0, static_cast<jsize>(coords.size()), coords.data());
+        for (size_t i = 0; i < regions.size(); ++i) {
+            regions[i] = {coords[i * 4], coords[i * 4 + 1], coords[i * 4 + 2], coords[i * 4 + 3]};
+        }
+
+        std::vector<ocr::Recognition> results;
+        {
+            LockedBitmap locked(envJ, bitmap);
+            if (!locked.ok()) return nullptr;
+            results = h->engine->recognizeRegions(locked.view(), regions);
+        }
+
+        return toStringArray(envJ, results);
+    } catch (const std::exception& e) {
+        LOGE("Error in nativeRecognizeRegions: %s", e.what());
+        return nullptr;
+    }
+}
+
+JNIEXPORT jobjectArray JNICALL
+Java_com_example_water_1meter_1sdk_OCRPipeline_nativeRecognizeQuads(
+    JNIEnv *envJ, jobject thiz, jlong handle, jobject bitmap, jfloatArray quads) {
+    if (!handle) return nullptr;
+    OCR_TRACE_SCOPE("nativeRecognizeQuads", "jni");
+    auto* h = reinterpret_cast<OCRHandle*>(handle);
+
+    try {
+        // quads holds x, y of four corners per region
+        std::vector<jfloat> coords(envJ->GetArrayLength(quads) / 8 * 8);
+        envJ->GetFloatArrayRegion(quads, 0, static_cast<jsize>(coords.size()), coords.data());
+        ocr::QuadSet regions;
+        regions.reserve(coords.size() / 8);
+        for (size_t i = 0; i < coords.size(); i += 8) regions.push(&coords[i], 1.0f);
+
+        std::vector<ocr::Recognition> results;
+        {
+            LockedBitmap locked(envJ, bitmap);
+            if (!locked.ok()) return nullptr;
+            results = h->engine->recognizeQuads(locked.view(), regions);
+        }
+        return toStringArray(envJ, results);
+    } catch (const std::exception& e) {
+        LOGE("Error in nativeRecognizeQuads: %s", e.what());
+        return nullptr;
+    }
+}
+
+JNIEXPORT jobjectArray JNICALL
+Java_com_example_water_1meter_1sdk_OCRPipeline_nativeReadMeter(
+    JNIEnv *envJ, jobject thiz, jlong handle, jobject bitmap, jdouble lastValue, jdouble maxIncrease) {
+    if (!handle) return nullptr;
+    OCR_TRACE_SCOPE("nativeReadMeter", "jni");
+    auto* h = reinterpret_cast<OCRHandle*>(handle);
+
+    try {
+        ocr::ReadingPrior prior;
+        prior.lastValue = lastValue;
+        prior.maxIncrease = maxIncrease;
+        std::vector<ocr::MeterCandidate> candidates;
+        {
+            LockedBitmap locked(envJ, bitmap);
+            if (!locked.ok()) return nullptr;
+            candidates = h->engine->readMeter(locked.view(), prior);
+        }
+        return toCandidateArray(envJ, candidates);
+    } catch (const std::exception& e) {
+        LOGE("Error in nativeReadMeter: %s", e.what());
+        return nullptr;
+    }
+}
+
+JNIEXPORT jobjectArray JNICALL
+Java_com_example_water_1meter_1sdk_OCRPipeline_nativeReadMeterBuffers(
+    JNIEnv *envJ, jobject thiz, jlong handle, jobjectArray planes, jintArray strides, jint format, jint width,
+    jint height, jdouble lastValue, jdouble maxIncrease) {
+    if (!handle) return nullptr;
+    OCR_TRACE_SCOPE("nativeReadMeterBuffers", "jni");
+    auto* h = reinterpret_cast<OCRHandle*>(handle);
+
+    try {
+        ocr::ImageView view;
+        if (!bufferView(envJ, planes, strides, format, width, height, view)) return nullptr;
+
+        ocr::ReadingPrior prior;
+        prior.lastValue = lastValue;
+        prior.maxIncrease = maxIncrease;
+        return toCandidateArray(envJ, h->engine->readMeter(view, prior));
     } catch (const std::exception& e) {
-        LOGE("Error in nativeRecognizeText: %s", e.what());
+        LOGE("Error in nativeReadMeterBuffers: %s", e.what());
         return nullptr;
     }
 }
 
+// BurstReading(candidates, frames, fused, quality) with the quality of every
+// frame as five floats, in the order of nativeCheckFrameBuffers
+JNIEXPORT jobject JNICALL
+Java_com_example_water_1meter_1sdk_OCRPipeline_nativeReadBurstBuffers(
+    JNIEnv *envJ, jobject thiz, jlong handle, jobjectArray planes, jobjectArray strides, jintArray formats,
+    jintArray widths, jintArray heights, jdouble lastValue, jdouble maxIncrease) {
+    if (!handle) return nullptr;
+    OCR_TRACE_SCOPE("nativeReadBurstBuffers", "jni");
+    auto* h = reinterpret_cast<OCRHandle*>(handle);
+
+    try {
+        const jsize count = envJ->GetArrayLength(formats);
+        if (envJ->GetArrayLength(planes) != count || envJ->GetArrayLength(strides) != count ||
+            envJ->GetArrayLength(widths) != count || envJ->GetArrayLength(heights) != count) {
+            LOGE("Burst frame arrays differ in length");
+            return nullptr;
+        }
+        std::vector<jint> format(count), width(count), height(count);
+        envJ->GetIntArrayRegion(formats, 0, count, format.data());
+        envJ->GetIntArrayRegion(widths, 0, count, width.data());
+        envJ->GetIntArrayRegion(heights, 0, count, height.data());
+        std::vector<ocr::ImageView> views(count);
+        for (jsize i = 0; i < count; ++i) {
+            auto framePlanes = static_cast<jobjectArray>(envJ->GetObjectArrayElement(planes, i));
+            auto frameStrides = static_cast<jintArray>(envJ->GetObjectArrayElement(strides, i));
+            const bool valid = framePlanes && frameStrides &&
+                               bufferView(envJ, framePlanes, frameStrides, format[i], width[i], height[i], views[i]);
+            envJ->DeleteLocalRef(framePlanes);
+            envJ->DeleteLocalRef(frameStrides);
+            if (!valid) return nullptr;
+        }
+
+        ocr::ReadingPrior prior;
+        prior.lastValue = lastValue;
+        prior.maxIncrease = maxIncrease;
+        const ocr::BurstReading burst = h->engine->readBurst(views, prior);
+
+        jobjectArray candidates = toCandidateArray(envJ, burst.candidates);
+        jintArray frames = envJ->NewIntArray(static_cast<jsize>(burst.frames.size()));
+        envJ->SetIntArrayRegion(frames, 0, static_cast<jsize>(burst.frames.size()), burst.frames.data());
+        std::vector<jfloat> values;
+        for (const ocr::FrameQuality& q : burst.quality) {
+            values.insert(values.end(), {static_cast<jfloat>(q.issue), q.sharpness, q.clipped, q.mean, q.spread});
+        }
+        jfloatArray quality = envJ->NewFloatArray(static_cast<jsize>(values.size()));
+        envJ->SetFloatArrayRegion(quality, 0, static_cast<jsize>(values.size()), values.data());
+
+        jclass burstClass = envJ->FindClass("com/example/water_meter_sdk/BurstReading");
+        jmethodID constructor =
+            envJ->GetMethodID(burstClass, "<init>", "([Lcom/example/water_meter_sdk/MeterCandidate;[IZ[F)V");
+        return envJ->NewObject(burstClass, constructor, candidates, frames, static_cast<jboolean>(burst.fused),
+                               quality);
+    } catch (const std::exception& e) {
+        LOGE("Error in nativeReadBurstBuffers: %s", e.what());
+        return nullptr;
+    }
+}
+
+// [issue, sharpness, clipped, mean, spread] of the frame, see FrameQuality
+JNIEXPORT jfloatArray JNICALL
+Java_com_example_water_1meter_1sdk_OCRPipeline_nativeCheckFrameBuffers(
+    JNIEnv *envJ, jobject thiz, jlong handle, jobjectArray planes, jintArray strides, jint format, jint width,
+    jint height) {
+    if (!handle) return nullptr;
+    OCR_TRACE_SCOPE("nativeCheckFrameBuffers", "jni");
+    auto* h = reinterpret_cast<OCRHandle*>(handle);
+
+    try {
+        ocr::ImageView view;
+        if (!bufferView(envJ, planes, strides, format, width, height, view)) return nullptr;
+        const ocr::FrameQuality quality = h->engine->checkQuality(view);
+        const jfloat values[5] = {static_cast<jfloat>(quality.issue), quality.sharpness, quality.clipped,
+                                  quality.mean, quality.spread};
+        jfloatArray out = envJ->NewFloatArray(5);
+        envJ->SetFloatArrayRegion(out, 0, 5, values);
+        return out;
+    } catch (const std::exception& e) {
+        LOGE("Error in nativeCheckFrameBuffers: %s", e.what());
+        return nullptr;
+    }
+}
+
+JNIEXPORT jdouble JNICALL
+Java_com_example_water_1meter_1sdk_OCRPipeline_nativeWarmUp(
+    JNIEnv *envJ, jobject thiz, jlong handle, jboolean async) {
+    if (!handle) return -1.0;
+    OCR_TRACE_SCOPE("nativeWarmUp", "jni");
+    auto* h = reinterpret_cast<OCRHandle*>(handle);
+
+    try {
+        if (async) {
+            h->engine->warmUpAsync();
+            return -1.0;
+        }
+        return h->engine->warmUp().totalMs;
+    } catch (const std::exception& e) {
+        LOGE("Error in nativeWarmUp: %s", e.what());
+        return -1.0;
+    }
+}
+
 JNIEXPORT void JNICALL
-Java_com_example_flutter_1water_1meter_1ocr_OCRPipeline_nativeDispose(
+Java_com_example_water_1meter_1sdk_OCRPipeline_nativeDispose(
     JNIEnv *envJ, jobject thiz, jlong handle) {
     if (!handle) return;
     auto* h = reinterpret_cast<OCRHandle*>(handle);
-    delete h->detSession;
-    delete h->clsSession;
-    delete h->recSession;
+    // Destroying the engine also writes the trace file when tracing is on
     delete h;
-    LOGI("OCR resources disposed via ONNX Runtime");
+    LOGI("OCR resources disposed");
 }
 
 } // extern "C"
@@ -0,0 +1,460 @@
+#include "pixel_convert.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <vector>
+
+namespace ocr {
+
+namespace {
+
+int clampByte(int value) {
+    return std::min(255, std::max(0, value));
+}
+
+// Full-range BT.601, as Android cameras deliver, in 16.16 fixed point
+void yuvToRgb(int y, int u, int v, int* rgb) {
+    const int d = u - 128;
+    const int e = v - 128;
+    rgb[0] = clampByte(y + ((91881 * e + 32768) >> 16));
+    rgb[1] = clampByte(y - ((22554 * d + 46802 * e + 32768) >> 16));
+    rgb[2] = clampByte(y + ((116130 * d + 32768) >> 16));
+}
+
+// One row of a source format: read(x) gives the R, G, B bytes of image
+// column x. Rows and columns are image coordinates, so chroma subsampling
+// lines up for any ROI.
+template <PixelFormat F>
+struct RowReader;
+
+template <>
+struct RowReader<PixelFormat::Rgba8888> {
+    const uint8_t* row;
+    RowReader(const ImageView& view, int y) : row(view.planes[0] + static_cast<size_t>(y) * view.strides[0]) {}
+    void read(int x, int* rgb) const {
+        const uint8_t* p = row + 4 * x;
+        rgb[0] = p[0];
+        rgb[1] = p[1];
+        rgb[2] = p[2];
+    }
+};
+
+template <>
+struct RowReader<PixelFormat::Rgb565> {
+    const uint8_t* row;
+    RowReader(const ImageView& view, int y) : row(view.planes[0] + static_cast<size_t>(y) * view.strides[0]) {}
+    void read(int x, int* rgb) const {
+        uint16_t word;
+        std::memcpy(&word, row + 2 * x, sizeof(word));
+        const int r = word >> 11;
+        const int g = (word >> 5) & 0x3F;
+        const int b = word & 0x1F;
+        rgb[0] = (r << 3) | (r >> 2);
+        rgb[1] = (g << 2) | (g >> 4);
+        rgb[2] = (b << 3) | (b >> 2);
+    }
+};
+
+template <>
+struct RowReader<PixelFormat::A8> {
+    const uint8_t* row;
+    RowReader(const ImageView& view, int y) : row(view.planes[0] + static_cast<size_t>(y) * view.strides[0]) {}
+    void read(int x, int* rgb) const { rgb[0] = rgb[1] = rgb[2] = row[x]; }
+};
+
+template <>
+struct RowReader<PixelFormat::RgbaF16> {
+    const uint8_t* row;
+    RowReader(const ImageView& view, int y) : row(view.planes[0] + static_cast<size_t>(y) * view.strides[0]) {}
+    void read(int x, int* rgb) const {
+        uint16_t halves[3];
+        std::memcpy(halves, row + 8 * x, sizeof(halves));
+        for (int c = 0; c < 3; ++c) {
+            rgb[c] = static_cast<int>(std::min(1.0f, std::max(0.0f, halfToFloat(halves[c]))) * 255.0f + 0.5f);
+        }
+    }
+};
+
+template <>
+struct RowReader<PixelFormat::Nv21> {
+    const uint8_t* luma;
+    const uint8_t* chroma;
+    RowReader(const ImageView& view, int y)
+        : luma(view.planes[0] + static_cast<size_t>(y) * view.strides[0]),
+          chroma(view.planes[1] + static_cast<size_t>(y / 2) * view.strides[1]) {}
+    void read(int x, int* rgb) const {
+        const uint8_t* vu = chroma + (x & ~1);
+        yuvToRgb(luma[x], vu[1], vu[0], rgb);
+    }
+};
+
+template <>
+struct RowReader<PixelFormat::Nv12> {
+    const uint8_t* luma;
+    const uint8_t* chroma;
+    RowReader(const ImageView& view, int y)
+        : luma(view.planes[0] + static_cast<size_t>(y) * view.strides[0]),
+          chroma(view.planes[1] + static_cast<size_t>(y / 2) * view.strides[1]) {}
+    void read(int x, int* rgb) const {
+        const uint8_t* uv = chroma + (x & ~1);
+        yuvToRgb(luma[x], uv[0], uv[1], rgb);
+    }
+};
+
+template <>
+struct RowReader<PixelFormat::I420> {
+    const uint8_t* luma;
+    const uint8_t* u;
+    const uint8_t* v;
+    RowReader(const ImageView& view, int y)
+        : luma(view.planes[0] + static_cast<size_t>(y) * view.strides[0]),
+          u(view.planes[1] + static_cast<size_t>(y / 2) * view.strides[1]),
+          v(view.planes[2] + static_cast<size_t>(y / 2) * view.strides[2]) {}
+    void read(int x, int* rgb) const { yuvToRgb(luma[x], u[x / 2], v[x / 2], rgb); }
+};
+
+template <TensorType T>
+struct TensorTraits;
+
+template <>
+struct TensorTraits<TensorType::F32> {
+    using Value = float;
+    static float store(int value, float scale, float bias) { return value * scale + bias; }
+};
+
+template <>
+struct TensorTraits<TensorType::F16> {
+    using Value = uint16_t;
+    static uint16_t store(int value, float scale, float bias) { return floatToHalf(value * scale + bias); }
+};
+
+template <>
+struct TensorTraits<TensorType::U8> {
+    using Value = uint8_t;
+    static uint8_t store(int value, float, float) { return static_cast<uint8_t>(value); }
+};
+
+template <PixelFormat F, TensorLayout L, TensorType T>
+void convertRows(const ImageView& src, const TensorSpec& spec, void* dst) {
+    using Traits = TensorTraits<T>;
+    using Value = typename Traits::Value;
+    const int width = std::min(src.roi.width(), spec.planeWidth);
+    const int height = std::min(src.roi.height(), spec.planeHeight);
+    const size_t planeSize = static_cast<size_t>(spec.planeWidth) * spec.planeHeight;
+
+    // Where source channel c lands, and its normalization
+    const bool chw = L == TensorLayout::Chw;
+    const int pixelStep = chw ? 1 : 3;
+    const size_t rowStep = static_cast<size_t>(spec.planeWidth) * pixelStep;
+    size_t offset[3];
+    float scale[3], bias[3];
+    for (int c = 0; c < 3; ++c) {
+        const int channel = spec.bgr ? 2 - c : c;
+        offset[c] = chw ? channel * planeSize : channel;
+        scale[c] = spec.scale[channel];
+        bias[c] = spec.bias[channel];
+    }
+
+    Value* out = static_cast<Value*>(dst);
+    for (int y = 0; y < height; ++y) {
+        RowReader<F> reader(src, src.roi.top + y);
+        Value* row = out + y * rowStep;
+        for (int x = 0; x < width; ++x) {
+            int rgb[3];
+            reader.read(src.roi.left + x, rgb);
+            Value* p = row + x * pixelStep;
+            p[offset[0]] = Traits::store(rgb[0], scale[0], bias[0]);
+            p[offset[1]] = Traits::store(rgb[1], scale[1], bias[1]);
+            p[offset[2]] = Traits::store(rgb[2], scale[2], bias[2]);
+        }
+    }
+}
+
+template <PixelFormat F, TensorLayout L>
+void convertType(const ImageView& src, const TensorSpec& spec, void* dst) {
+    switch (spec.type) {
+    case TensorType::F32: return convertRows<F, L, TensorType::F32>(src, spec, dst);
+    case TensorType::F16: return convertRows<F, L, TensorType::F16>(src, spec, dst);
+    case TensorType::U8: return convertRows<F, L, TensorType::U8>(src, spec, dst);
+    }
+}
+
+template <PixelFormat F>
+void convertLayout(const ImageView& src, const TensorSpec& spec, void* dst) {
+    if (spec.layout == TensorLayout::Chw) {
+        convertType<F, TensorLayout::Chw>(src, spec, dst);
+    } else {
+        convertType<F, TensorLayout::Hwc>(src, spec, dst);
+    }
+}
+
+template <PixelFormat F>
+void rowsToRgba(const ImageView& src, uint32_t* dst, int dstStride) {
+    for (int y = 0; y < src.roi.height(); ++y) {
+        RowReader<F> reader(src, src.roi.top + y);
+        uint8_t* row = reinterpret_cast<uint8_t*>(dst + static_cast<size_t>(y) * dstStride);
+        for (int x = 0; x < src.roi.width(); ++x) {
+            int rgb[3];
+            reader.read(src.roi.left + x, rgb);
+            uint8_t* p = row + 4 * x;
+            p[0] = static_cast<uint8_t>(rgb[0]);
+            p[1] = static_cast<uint8_t>(rgb[1]);
+            p[2] = static_cast<uint8_t>(rgb[2]);
+            p[3] = 0xFF;
+        }
+    }
+}
+
+template <>
+void rowsToRgba<PixelFormat::Rgba8888>(const ImageView& src, uint32_t* dst, int dstStride) {
+    const size_t rowBytes = static_cast<size_t>(src.roi.width()) * 4;
+    for (int y = 0; y < src.roi.height(); ++y) {
+        const uint8_t* row = src.planes[0] + static_cast<size_t>(src.roi.top + y) * src.strides[0];
+        std::memcpy(dst + static_cast<size_t>(y) * dstStride, row + 4 * src.roi.left, rowBytes);
+    }
+}
+
+// Bilinear sampling along the rows of the quad: within one output row the
+// source position moves linearly, so it is stepped rather than recomputed.
+template <PixelFormat F>
+void sampleRows(const ImageView& src, const float* q, RgbaImage& dst) {
+    const int width = dst.width;
+    const int height = dst.height;
+    const float maxX = static_cast<float>(src.roi.right - 1);
+    const float maxY = static_cast<float>(src.roi.bottom - 1);
+    const float minX = static_cast<float>(src.roi.left);
+    const float minY = static_cast<float>(src.roi.top);
+    for (int v = 0; v < height; ++v) {
+        const float t = (v + 0.5f) / height;
+        // Row start on the left edge, and the step along it per output pixel
+        const float startX = q[0] + t * (q[6] - q[0]);
+        const float startY = q[1] + t * (q[7] - q[1]);
+        const float stepX = ((q[2] + t * (q[4] - q[2])) - startX) / width;
+        const float stepY = ((q[3] + t * (q[5] - q[3])) - startY) / width;
+        uint8_t* out = reinterpret_cast<uint8_t*>(dst.pixels.data() + static_cast<size_t>(v) * width);
+        for (int u = 0; u < width; ++u) {
+            // Pixel centres sit at +0.5
+            const float sx = std::min(maxX, std::max(minX, startX + (u + 0.5f) * stepX - 0.5f));
+            const float sy = std::min(maxY, std::max(minY, startY + (u + 0.5f) * stepY - 0.5f));
+            const int x0 = static_cast<int>(sx);
+            const int y0 = static_cast<int>(sy);
+            const int x1 = std::min(x0 + 1, src.roi.right - 1);
+            const int y1 = std::min(y0 + 1, src.roi.bottom - 1);
+            const int wx = static_cast<int>((sx - x0) * 256.0f);
+            const int wy = static_cast<int>((sy - y0) * 256.0f);
+            int a[3], b[3], c[3], d[3];
+            RowReader<F> top(src, y0);
+            RowReader<F> bottom(src, y1);
+            top.read(x0, a);
+            top.read(x1, b);
+            bottom.read(x0, c);
+            bottom.read(x1, d);
+            uint8_t* p = out + 4 * u;
+            for (int k = 0; k < 3; ++k) {
+                const int upper = a[k] * 256 + (b[k] - a[k]) * wx;
+                const int lower = c[k] * 256 + (d[k] - c[k]) * wx;
+                p[k] = static_cast<uint8_t>((upper * 256 + (lower - upper) * wy + 32768) >> 16);
+            }
+            p[3] = 0xFF;
+        }
+    }
+}
+
+// Luma of column x of a row; YUV formats have it stored
+template <PixelFormat F>
+int lumaOf(const RowReader<F>& reader, int x) {
+    int rgb[3];
+    reader.read(x, rgb);
+    return (77 * rgb[0] + 150 * rgb[1] + 29 * rgb[2] + 128) >> 8;
+}
+
+template <>
+int lumaOf<PixelFormat::Nv21>(const RowReader<PixelFormat::Nv21>& reader, int x) {
+    return reader.luma[x];
+}
+
+template <>
+int lumaOf<PixelFormat::I420>(const RowReader<PixelFormat::I420>& reader, int x) {
+    return reader.luma[x];
+}
+
+template <>
+int lumaOf<PixelFormat::Nv12>(const RowReader<PixelFormat::Nv12>& reader, int x) {
+    return reader.luma[x];
+}
+
+// Each thumbnail pixel averages the 2 x 2 taps a quarter into its block
+template <PixelFormat F>
+void thumbnailRows(const ImageView& src, int width, int height, uint8_t* dst) {
+    const Rect& roi = src.roi;
+    std::vector<int> columns(static_cast<size_t>(2) * width);
+    for (int x = 0; x < width; ++x) {
+        const int left = roi.left + static_cast<int>(static_cast<int64_t>(x) * roi.width() / width);
+        const int right = roi.left + static_cast<int>(static_cast<int64_t>(x + 1) * roi.width() / width);
+        columns[2 * x] = left + (right - left) / 4;
+        columns[2 * x + 1] = left + (right - left) * 3 / 4;
+    }
+    for (int y = 0; y < height; ++y) {
+        const int top = roi.top + static_cast<int>(static_cast<int64_t>(y) * roi.height() / height);
+        const int bottom = roi.top + static_cast<int>(static_cast<int64_t>(y + 1) * roi.height() / height);
+        RowReader<F> upper(src, top + (bottom - top) / 4);
+        RowReader<F> lower(src, top + (bottom - top) * 3 / 4);
+        uint8_t* out = dst + static_cast<size_t>(y) * width;
+        for (int x = 0; x < width; ++x) {
+            const int sum = lumaOf(upper, columns[2 * x]) + lumaOf(upper, columns[2 * x + 1]) +
+                            lumaOf(lower, columns[2 * x]) + lumaOf(lower, columns[2 * x + 1]);
+            out[x] = static_cast<uint8_t>((sum + 2) >> 2);
+        }
+    }
+}
+
+template <PixelFormat F>
+void lumaRows(const ImageView& src, uint8_t* dst, int dstStride) {
+    const Rect& roi = src.roi;
+    for (int y = 0; y < roi.height(); ++y) {
+        RowReader<F> reader(src, roi.top + y);
+        uint8_t* out = dst + static_cast<size_t>(y) * dstStride;
+        for (int x = 0; x < roi.width(); ++x) out[x] = static_cast<uint8_t>(lumaOf(reader, roi.left + x));
+    }
+}
+
+float distance(float x0, float y0, float x1, float y1) {
+    return std::sqrt((x1 - x0) * (x1 - x0) + (y1 - y0) * (y1 - y0));
+}
+
+} // namespace
+
+bool sampleQuad(const ImageView& src, const float* quad, int targetHeight, int maxWidth, RgbaImage& dst) {
+    if (src.empty() || targetHeight <= 0) return false;
+    // Size of the quad from its longer opposite edges
+    const float quadWidth = std::max(distance(quad[0], quad[1], quad[2], quad[3]),
+                                     distance(quad[6], quad[7], quad[4], quad[5]));
+    const float quadHeight = std::max(distance(quad[0], quad[1], quad[6], quad[7]),
+                                      distance(quad[2], quad[3], quad[4], quad[5]));
+    if (quadWidth < 1.0f || quadHeight < 1.0f) return false;
+    int width = static_cast<int>(std::ceil(quadWidth * targetHeight / quadHeight));
+    width = std::max(1, std::min(width, maxWidth));
+    dst.resize(width, targetHeight);
+
+    switch (src.format) {
+    case PixelFormat::Rgba8888: sampleRows<PixelFormat::Rgba8888>(src, quad, dst); break;
+    case PixelFormat::Rgb565: sampleRows<PixelFormat::Rgb565>(src, quad, dst); break;
+    case PixelFormat::A8: sampleRows<PixelFormat::A8>(src, quad, dst); break;
+    case PixelFormat::RgbaF16: sampleRows<PixelFormat::RgbaF16>(src, quad, dst); break;
+    case PixelFormat::Nv21: sampleRows<PixelFormat::Nv21>(src, quad, dst); break;
+    case PixelFormat::I420: sampleRows<PixelFormat::I420>(src, quad, dst); break;
+    case PixelFormat::Nv12: sampleRows<PixelFormat::Nv12>(src, quad, dst); break;
+    }
+    return true;
+}
+
+void lumaThumbnail(const ImageView& src, int width, int height, uint8_t* dst) {
+    if (src.empty() || width <= 0 || height <= 0) return;
+    switch (src.format) {
+    case PixelFormat::Rgba8888: return thumbnailRows<PixelFormat::Rgba8888>(src, width, height, dst);
+    case PixelFormat::Rgb565: return thumbnailRows<PixelFormat::Rgb565>(src, width, height, dst);
+    case PixelFormat::A8: return thumbnailRows<PixelFormat::A8>(src, width, height, dst);
+    case PixelFormat::RgbaF16: return thumbnailRows<PixelFormat::RgbaF16>(src, width, height, dst);
+    case PixelFormat::Nv21: return thumbnailRows<PixelFormat::Nv21>(src, width, height, dst);
+    case PixelFormat::I420: return thumbnailRows<PixelFormat::I420>(src, width, height, dst);
+    case PixelFormat::Nv12: return thumbnailRows<PixelFormat::Nv12>(src, width, height, dst);
+    }
+}
+
+void convertToLuma(const ImageView& src, uint8_t* dst, int dstStride) {
+    if (src.empty()) return;
+    switch (src.format) {
+    case PixelFormat::Rgba8888: return lumaRows<PixelFormat::Rgba8888>(src, dst, dstStride);
+    case PixelFormat::Rgb565: return lumaRows<PixelFormat::Rgb565>(src, dst, dstStride);
+    case PixelFormat::A8: return lumaRows<PixelFormat::A8>(src, dst, dstStride);
+    case PixelFormat::RgbaF16: return lumaRows<PixelFormat::RgbaF16>(src, dst, dstStride);
+    case PixelFormat::Nv21: return lumaRows<PixelFormat::Nv21>(src, dst, dstStride);
+    case PixelFormat::I420: return lumaRows<PixelFormat::I420>(src, dst, dstStride);
+    case PixelFormat::Nv12: return lumaRows<PixelFormat::Nv12>(src, dst, dstStride);
+    }
+}
+
+void writeTensor(const ImageView& src, const TensorSpec& spec, void* dst) {
+    if (src.empty()) return;
+    switch (src.format) {
+    case PixelFormat::Rgba8888: return convertLayout<PixelFormat::Rgba8888>(src, spec, dst);
+    case PixelFormat::Rgb565: return convertLayout<PixelFormat::Rgb565>(src, spec, dst);
+    case PixelFormat::A8: return convertLayout<PixelFormat::A8>(src, spec, dst);
+    case PixelFormat::RgbaF16: return convertLayout<PixelFormat::RgbaF16>(src, spec, dst);
+    case PixelFormat::Nv21: return convertLayout<PixelFormat::Nv21>(src, spec, dst);
+    case PixelFormat::I420: return convertLayout<PixelFormat::I420>(src, spec, dst);
+    case PixelFormat::Nv12: return convertLayout<PixelFormat::Nv12>(src, spec, dst);
+    }
+}
+
+void convertToRgba(const ImageView& src, uint32_t* dst, int dstStride) {
+    if (src.empty()) return;
+    switch (src.format) {
+    case PixelFormat::Rgba8888: return rowsToRgba<PixelFormat::Rgba8888>(src, dst, dstStride);
+    case PixelFormat::Rgb565: return rowsToRgba<PixelFormat::Rgb565>(src, dst, dstStride);
+    case PixelFormat::A8: return rowsToRgba<PixelFormat::A8>(src, dst, dstStride);
+    case PixelFormat::RgbaF16: return rowsToRgba<PixelFormat::RgbaF16>(src, dst, dstStride);
+    case PixelFormat::Nv21: return rowsToRgba<PixelFormat::Nv21>(src, dst, dstStride);
+    case PixelFormat::I420: return rowsToRgba<PixelFormat::I420>(src, dst, dstStride);
+    case PixelFormat::Nv12: return rowsToRgba<PixelFormat::Nv12>(src, dst, dstStride);
+    }
+}
+
+void convertToRgba(const ImageView& src, RgbaImage& dst) {
+    dst.resize(src.roi.width(), src.roi.height());
+    convertToRgba(src, dst.pixels.data(), dst.width);
+}
+
+#if defined(__aarch64__)
+
+uint16_t floatToHalf(float value) {
+    __fp16 half = static_cast<__fp16>(value);
+    uint16_t bits;
+    std::memcpy(&bits, &half, sizeof(bits));
+    return bits;
+}
+
+float halfToFloat(uint16_t value) {
+    __fp16 half;
+    std::memcpy(&half, &value, sizeof(half));
+    return static_cast<float>(half);
+}
+
+#else
+
+uint16_t floatToHalf(float value) {
+    uint32_t bits;
+    std::memcpy(&bits, &value, sizeof(bits));
+    const uint16_t sign = static_cast<uint16_t>((bits >> 16) & 0x8000);
+    const uint32_t magnitude = bits & 0x7FFFFFFF;
+    if (magnitude >= 0x7F800000) return sign | (magnitude > 0x7F800000 ? 0x7E00 : 0x7C00);
+    // 65520 and up round to infinity
+    if (magnitude >= 0x477FF000) return sign | 0x7C00;
+    if (magnitude < 0x38800000) {
+        // Subnormal: a multiple of 2^-24, rounded to nearest even
+        return sign | static_cast<uint16_t>(std::nearbyint(std::fabs(value) * 16777216.0f));
+    }
+    // Rebias the exponent and round the mantissa to nearest even
+    const uint32_t rounded = magnitude + 0xFFF + ((magnitude >> 13) & 1);
+    return sign | static_cast<uint16_t>((rounded - 0x38000000) >> 13);
+}
+
+float halfToFloat(uint16_t value) {
+    const uint32_t sign = static_cast<uint32_t>(value & 0x8000) << 16;
+    const uint32_t exponent = (value >> 10) & 0x1F;
+    const uint32_t mantissa = value & 0x3FF;
+    if (exponent == 0) {
+        const float magnitude = std::ldexp(static_cast<float>(mantissa), -24);
+        return sign ? -magnitude : magnitude;
+    }
+    uint32_t bits = sign | (mantissa << 13);
+    bits |= exponent == 0x1F ? 0x7F800000 : (exponent + 112) << 23;
+    float result;
+    std::memcpy(&result, &bits, sizeof(result));
+    return result;
+}
+
+#endif
+
+} // namespace ocr
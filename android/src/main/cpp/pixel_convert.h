@@ -0,0 +1,69 @@
+#pragma once
+
+#include <cstdint>
+
+#include "image_view.h"
+
+namespace ocr {
+
+enum class TensorLayout {
+    Chw,  // one plane per channel
+    Hwc,  // channels interleaved per pixel
+};
+
+enum class TensorType {
+    F32,
+    F16,  // IEEE half floats stored as uint16_t
+    U8,   // raw 0..255 values; scale and bias are ignored
+};
+
+// Destination of writeTensor(): a planeWidth x planeHeight tensor whose
+// top-left corner receives the view's ROI. Channel c of the output is
+// value * scale[c] + bias[c], so mean/std normalization folds into the two
+// arrays; with `bgr` channel 0 is blue.
+struct TensorSpec {
+    TensorLayout layout = TensorLayout::Chw;
+    TensorType type = TensorType::F32;
+    int planeWidth = 0;
+    int planeHeight = 0;
+    bool bgr = false;
+    float scale[3] = {1.0f / 255.0f, 1.0f / 255.0f, 1.0f / 255.0f};
+    float bias[3] = {0.0f, 0.0f, 0.0f};
+};
+
+// Converts the ROI of `src` into the tensor at `dst`, leaving the padding
+// beyond the ROI untouched (the caller zero-fills it when it matters). Each
+// source format, layout and type pairs up in its own instantiation of one
+// row loop, so the per-pixel work has no format branches. ROIs larger than
+// the plane are cut off at the plane edge.
+void writeTensor(const ImageView& src, const TensorSpec& spec, void* dst);
+
+// Converts the ROI of `src` to 32-bit RGBA pixels (alpha 255) in `dst`,
+// which holds roi.height() rows of dstStride pixels.
+void convertToRgba(const ImageView& src, uint32_t* dst, int dstStride);
+
+// Same into an owned image of the ROI size.
+void convertToRgba(const ImageView& src, RgbaImage& dst);
+
+// Samples the quad `quad` (x, y of four corners clockwise from the top-left,
+// in image coordinates) of `src` into `dst`, targetHeight rows high and as
+// wide as the quad's aspect ratio asks up to maxWidth. Reads the source
+// format directly with bilinear taps, so a region costs no copy of the frame
+// and rotated text comes out level. Taps outside the ROI repeat its edge.
+// Returns false for a degenerate quad.
+bool sampleQuad(const ImageView& src, const float* quad, int targetHeight, int maxWidth, RgbaImage& dst);
+
+// Grey width x height thumbnail of the ROI of `src` into `dst` (tightly
+// packed bytes). Each pixel averages four taps inside its block of the ROI,
+// so the cost depends on the thumbnail size, not the frame's. YUV frames
+// give their Y plane as is.
+void lumaThumbnail(const ImageView& src, int width, int height, uint8_t* dst);
+
+// Grey pixels of the ROI of `src` into `dst`, roi.height() rows of dstStride
+// bytes, with the weights of lumaThumbnail.
+void convertToLuma(const ImageView& src, uint8_t* dst, int dstStride);
+
+uint16_t floatToHalf(float value);
+float halfToFloat(uint16_t value);
+
+} // namespace ocr
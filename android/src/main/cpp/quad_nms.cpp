@@ -0,0 +1,234 @@
+#include "quad_nms.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <numeric>
+#include <vector>
+
+#include "frame_arena.h"
+
+namespace ocr {
+
+namespace {
+
+struct Point {
+    float x;
+    float y;
+};
+
+float cross(Point o, Point a, Point b) {
+    return (a.x - o.x) * (b.y - o.y) - (a.y - o.y) * (b.x - o.x);
+}
+
+float signedArea(const Point* polygon, int count) {
+    float sum = 0.0f;
+    for (int i = 0; i < count; ++i) {
+        const Point& a = polygon[i];
+        const Point& b = polygon[(i + 1) % count];
+        sum += a.x * b.y - b.x * a.y;
+    }
+    return 0.5f * sum;
+}
+
+// Sutherland-Hodgman: clips `subject` by each edge of the convex `clip`,
+// whose winding has the sign of `orientation`. Two quads intersect in at
+// most eight vertices.
+int clipPolygon(const Point* subject, int count, const Point* clip, float orientation, Point* out) {
+    Point buffers[2][8];
+    const Point* input = subject;
+    int inputCount = count;
+    for (int e = 0; e < 4 && inputCount > 0; ++e) {
+        Point c0 = clip[e];
+        Point c1 = clip[(e + 1) % 4];
+        Point* output = e == 3 ? out : buffers[e % 2];
+        int outputCount = 0;
+        for (int i = 0; i < inputCount; ++i) {
+            Point s = input[i];
+            Point t = input[(i + 1) % inputCount];
+            float ds = orientation * cross(c0, c1, s);
+            float dt = orientation * cross(c0, c1, t);
+            if (ds >= 0.0f) output[outputCount++] = s;
+            if ((ds >= 0.0f) != (dt >= 0.0f)) {
+                float k = ds / (ds - dt);
+                output[outputCount++] = {s.x + k * (t.x - s.x), s.y + k * (t.y - s.y)};
+            }
+        }
+        input = output;
+        inputCount = outputCount;
+    }
+    return inputCount;
+}
+
+void loadQuad(const QuadSet& quads, size_t index, Point* out) {
+    for (int c = 0; c < 4; ++c) out[c] = {quads.x(c, index), quads.y(c, index)};
+}
+
+bool isAxisAlignedRect(const QuadSet& quads, size_t i) {
+    const float eps = 1e-3f;
+    return std::fabs(quads.x(0, i) - quads.x(3, i)) < eps && std::fabs(quads.x(1, i) - quads.x(2, i)) < eps &&
+           std::fabs(quads.y(0, i) - quads.y(1, i)) < eps && std::fabs(quads.y(2, i) - quads.y(3, i)) < eps;
+}
+
+} // namespace
+
+float quadIou(const QuadSet& quads, size_t a, size_t b) {
+    Point pa[4], pb[4];
+    loadQuad(quads, a, pa);
+    loadQuad(quads, b, pb);
+    const float areaA = std::fabs(signedArea(pa, 4));
+    const float signedB = signedArea(pb, 4);
+    const float areaB = std::fabs(signedB);
+    if (areaA <= 0.0f || areaB <= 0.0f) return 0.0f;
+
+    Point clipped[8];
+    int count = clipPolygon(pa, 4, pb, signedB > 0.0f ? 1.0f : -1.0f, clipped);
+    if (count < 3) return 0.0f;
+    float intersection = std::fabs(signedArea(clipped, count));
+    return intersection / (areaA + areaB - intersection);
+}
+
+void suppressOverlaps(QuadSet& quads, float iouThreshold, FrameArena* arena) {
+    quads.sortByScore();
+    const size_t n = quads.size();
+    if (n < 2) return;
+
+    std::vector<float> heapBounds;
+    float* left = scratch(arena, heapBounds, 6 * n);
+    float* top = left + n;
+    float* right = top + n;
+    float* bottom = right + n;
+    float* area = bottom + n;
+    float* iou = area + n;
+    bool axisAligned = true;
+    for (size_t i = 0; i < n; ++i) {
+        quads.bounds(i, left[i], top[i], right[i], bottom[i]);
+        area[i] = (right[i] - left[i]) * (bottom[i] - top[i]);
+        axisAligned = axisAligned && isAxisAlignedRect(quads, i);
+    }
+
+    // Row i has bit j set when the lower-scored quad j overlaps quad i
+    const size_t words = (n + 63) / 64;
+    std::vector<uint64_t> heapMask;
+    uint64_t* mask = scratch(arena, heapMask, n * words + words);
+    std::memset(mask, 0, (n * words + words) * sizeof(uint64_t));
+    for (size_t i = 0; i + 1 < n; ++i) {
+        if (axisAligned) {
+            for (size_t j = i + 1; j < n; ++j) {
+                float w = std::max(0.0f, std::min(right[i], right[j]) - std::max(left[i], left[j]));
+                float h = std::max(0.0f, std::min(bottom[i], bottom[j]) - std::max(top[i], top[j]));
+                float intersection = w * h;
+                iou[j] = intersection / std::max(area[i] + area[j] - intersection, 1e-6f);
+            }
+        } else {
+            for (size_t j = i + 1; j < n; ++j) {
+                bool apart = right[j] <= left[i] || right[i] <= left[j] || bottom[j] <= top[i] ||
+                             bottom[i] <= top[j];
+                iou[j] = apart ? 0.0f : quadIou(quads, i, j);
+            }
+        }
+        uint64_t* row = mask + i * words;
+        for (size_t j = i + 1; j < n; ++j) {
+            row[j >> 6] |= static_cast<uint64_t>(iou[j] > iouThreshold) << (j & 63);
+        }
+    }
+
+    // One sweep in score order: a survivor suppresses everything in its row
+    uint64_t* removed = mask + n * words;
+    std::vector<uint8_t> heapKeep;
+    uint8_t* keep = scratch(arena, heapKeep, n);
+    for (size_t i = 0; i < n; ++i) {
+        keep[i] = ((removed[i >> 6] >> (i & 63)) & 1) == 0;
+        if (!keep[i]) continue;
+        const uint64_t* row = mask + i * words;
+        for (size_t w = 0; w < words; ++w) removed[w] |= row[w];
+    }
+    quads.compact(keep);
+}
+
+void mergeLines(QuadSet& quads, const LineMergeParams& params, FrameArena* arena) {
+    const size_t n = quads.size();
+    if (n < 2) return;
+
+    std::vector<float> heapBoxes;
+    float* left = scratch(arena, heapBoxes, 4 * n);
+    float* top = left + n;
+    float* right = top + n;
+    float* bottom = right + n;
+    for (size_t i = 0; i < n; ++i) quads.bounds(i, left[i], top[i], right[i], bottom[i]);
+
+    std::vector<uint32_t> heapOrder;
+    uint32_t* order = scratch(arena, heapOrder, n);
+    std::iota(order, order + n, 0u);
+    std::sort(order, order + n, [left](uint32_t a, uint32_t b) {
+        return left[a] < left[b] || (left[a] == left[b] && a < b);
+    });
+
+    // Line bounds, the last box joined (to follow a drifting baseline) and
+    // the weighted score
+    std::vector<float> heapLines;
+    float* lineLeft = scratch(arena, heapLines, 8 * n);
+    float* lineTop = lineLeft + n;
+    float* lineRight = lineTop + n;
+    float* lineBottom = lineRight + n;
+    float* lastTop = lineBottom + n;
+    float* lastBottom = lastTop + n;
+    float* scoreSum = lastBottom + n;
+    float* weight = scoreSum + n;
+    size_t lines = 0;
+
+    for (size_t k = 0; k < n; ++k) {
+        const uint32_t i = order[k];
+        const float height = bottom[i] - top[i];
+        size_t best = lines;
+        float bestGap = std::numeric_limits<float>::max();
+        for (size_t l = 0; l < lines; ++l) {
+            const float lastHeight = lastBottom[l] - lastTop[l];
+            const float shorter = std::min(height, lastHeight);
+            const float taller = std::max(height, lastHeight);
+            const float overlap = std::min(bottom[i], lastBottom[l]) - std::max(top[i], lastTop[l]);
+            const float gap = left[i] - lineRight[l];
+            if (overlap < params.minVerticalOverlap * shorter || shorter < params.minHeightRatio * taller ||
+                gap > params.maxGap * taller) {
+                continue;
+            }
+            if (std::fabs(gap) < bestGap) {
+                bestGap = std::fabs(gap);
+                best = l;
+            }
+        }
+
+        const float width = std::max(1.0f, right[i] - left[i]);
+        const float score = quads.score(i);
+        if (best == lines) {
+            lineLeft[lines] = left[i];
+            lineTop[lines] = top[i];
+            lineRight[lines] = right[i];
+            lineBottom[lines] = bottom[i];
+            scoreSum[lines] = 0.0f;
+            weight[lines] = 0.0f;
+            ++lines;
+        } else {
+            lineLeft[best] = std::min(lineLeft[best], left[i]);
+            lineTop[best] = std::min(lineTop[best], top[i]);
+            lineRight[best] = std::max(lineRight[best], right[i]);
+            lineBottom[best] = std::max(lineBottom[best], bottom[i]);
+        }
+        lastTop[best] = top[i];
+        lastBottom[best] = bottom[i];
+        scoreSum[best] += score * width;
+        weight[best] += width;
+    }
+
+    if (lines < n) {
+        quads.clear();
+        for (size_t l = 0; l < lines; ++l) {
+            quads.pushRect(lineLeft[l], lineTop[l], lineRight[l], lineBottom[l], scoreSum[l] / weight[l]);
+        }
+    }
+    quads.sortByScore();
+}
+
+} // namespace ocr
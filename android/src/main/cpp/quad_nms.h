@@ -0,0 +1,43 @@
+#pragma once
+
+#include <cstddef>
+
+#include "quad_set.h"
+
+namespace ocr {
+
+class FrameArena;
+
+// Intersection over union of quads a and b of `quads`. Quads are treated as
+// convex polygons, so rotated boxes get their exact overlap.
+float quadIou(const QuadSet& quads, size_t a, size_t b);
+
+// Sorts `quads` by score and drops every quad that overlaps a higher-scored
+// survivor by more than iouThreshold.
+//
+// The pairwise overlaps are computed once into one bitmask row per quad, then
+// a single pass over the rows in score order clears the suppressed quads.
+// When every quad is an axis-aligned rectangle, as DB output is, IoU comes
+// from the bounding boxes in a branch-free loop over whole planes; otherwise
+// pairs whose bounds meet are clipped as polygons. The bitmask and bounds
+// come from `arena` when one is given.
+void suppressOverlaps(QuadSet& quads, float iouThreshold, FrameArena* arena = nullptr);
+
+struct LineMergeParams {
+    // Neighbours must share at least this fraction of the shorter height.
+    float minVerticalOverlap = 0.6f;
+    // Shorter over taller height, so digits don't join larger labels.
+    float minHeightRatio = 0.6f;
+    // Largest horizontal gap, in multiples of the taller height.
+    float maxGap = 1.0f;
+};
+
+// Joins boxes that sit side by side on the same baseline, e.g. digits the
+// detector found one by one, into one axis-aligned box per line. Boxes are
+// chained left to right, each one to the closest line that it continues;
+// a line's score is the width-weighted mean of its boxes. When any boxes
+// join, every line comes back as its axis-aligned bounds. The result is
+// sorted by score.
+void mergeLines(QuadSet& quads, const LineMergeParams& params, FrameArena* arena = nullptr);
+
+} // namespace ocr
@@ -0,0 +1,140 @@
+#include "quad_set.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <numeric>
+
+namespace ocr {
+
+void QuadSet::reserve(size_t count) {
+    if (count > capacity_) grow(count);
+}
+
+void QuadSet::grow(size_t minCapacity) {
+    size_t capacity = std::max({minCapacity, capacity_ * 2, kLanes});
+    capacity = (capacity + kLanes - 1) / kLanes * kLanes;
+    std::vector<float> storage(capacity * kPlanes, 0.0f);
+    for (int p = 0; p < kPlanes && size_ > 0; ++p) {
+        std::memcpy(storage.data() + p * capacity, plane(static_cast<Plane>(p)), size_ * sizeof(float));
+    }
+    storage_.swap(storage);
+    capacity_ = capacity;
+}
+
+void QuadSet::push(const float* quad, float score) {
+    pushQuad(quad, score, std::atan2(quad[3] - quad[1], quad[2] - quad[0]));
+}
+
+void QuadSet::pushRect(float left, float top, float right, float bottom, float score) {
+    const float quad[8] = {left, top, right, top, right, bottom, left, bottom};
+    pushQuad(quad, score, 0.0f);
+}
+
+void QuadSet::pushQuad(const float* quad, float score, float angle) {
+    if (size_ == capacity_) grow(size_ + 1);
+    for (int c = 0; c < 4; ++c) {
+        plane(static_cast<Plane>(X0 + c))[size_] = quad[2 * c];
+        plane(static_cast<Plane>(Y0 + c))[size_] = quad[2 * c + 1];
+    }
+    plane(Score)[size_] = score;
+    plane(Angle)[size_] = angle;
+    ++size_;
+}
+
+void QuadSet::append(const QuadSet& other) {
+    if (other.empty()) return;
+    reserve(size_ + other.size_);
+    for (int p = 0; p < kPlanes; ++p) {
+        Plane id = static_cast<Plane>(p);
+        std::memcpy(plane(id) + size_, other.plane(id), other.size_ * sizeof(float));
+    }
+    size_ += other.size_;
+}
+
+void QuadSet::corners(size_t index, float* out) const {
+    for (int c = 0; c < 4; ++c) {
+        out[2 * c] = x(c, index);
+        out[2 * c + 1] = y(c, index);
+    }
+}
+
+void QuadSet::bounds(size_t index, float& left, float& top, float& right, float& bottom) const {
+    left = std::min(std::min(x(0, index), x(1, index)), std::min(x(2, index), x(3, index)));
+    right = std::max(std::max(x(0, index), x(1, index)), std::max(x(2, index), x(3, index)));
+    top = std::min(std::min(y(0, index), y(1, index)), std::min(y(2, index), y(3, index)));
+    bottom = std::max(std::max(y(0, index), y(1, index)), std::max(y(2, index), y(3, index)));
+}
+
+void QuadSet::translate(float dx, float dy) {
+    for (int c = 0; c < 4; ++c) {
+        float* px = plane(static_cast<Plane>(X0 + c));
+        float* py = plane(static_cast<Plane>(Y0 + c));
+        for (size_t i = 0; i < size_; ++i) {
+            px[i] += dx;
+            py[i] += dy;
+        }
+    }
+}
+
+void QuadSet::scale(float sx, float sy) {
+    for (int c = 0; c < 4; ++c) {
+        float* px = plane(static_cast<Plane>(X0 + c));
+        float* py = plane(static_cast<Plane>(Y0 + c));
+        for (size_t i = 0; i < size_; ++i) {
+            px[i] *= sx;
+            py[i] *= sy;
+        }
+    }
+    if (sx != sy) {
+        float* angle = plane(Angle);
+        for (size_t i = 0; i < size_; ++i) {
+            angle[i] = std::atan2(std::sin(angle[i]) * sy, std::cos(angle[i]) * sx);
+        }
+    }
+}
+
+void QuadSet::compact(const uint8_t* keep) {
+    size_t kept = 0;
+    for (int p = 0; p < kPlanes; ++p) {
+        float* values = plane(static_cast<Plane>(p));
+        // Branch-free: always write, advance only past kept entries
+        size_t w = 0;
+        for (size_t i = 0; i < size_; ++i) {
+            values[w] = values[i];
+            w += keep[i] != 0;
+        }
+        kept = w;
+    }
+    size_ = kept;
+}
+
+void QuadSet::filterByScore(float minScore) {
+    mask_.resize(size_);
+    const float* score = scores();
+    for (size_t i = 0; i < size_; ++i) mask_[i] = score[i] >= minScore;
+    compact(mask_.data());
+}
+
+void QuadSet::sortByScore() {
+    order_.resize(size_);
+    std::iota(order_.begin(), order_.end(), 0u);
+    const float* score = scores();
+    // Index tie-break instead of stable_sort, which allocates a merge buffer
+    std::sort(order_.begin(), order_.end(), [score](uint32_t a, uint32_t b) {
+        return score[a] > score[b] || (score[a] == score[b] && a < b);
+    });
+    permute(order_.data(), order_.size());
+}
+
+void QuadSet::permute(const uint32_t* order, size_t count) {
+    gather_.resize(count);
+    for (int p = 0; p < kPlanes; ++p) {
+        float* values = plane(static_cast<Plane>(p));
+        for (size_t i = 0; i < count; ++i) gather_[i] = values[order[i]];
+        std::copy(gather_.begin(), gather_.end(), values);
+    }
+    size_ = count;
+}
+
+} // namespace ocr
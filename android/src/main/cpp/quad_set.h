@@ -0,0 +1,78 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace ocr {
+
+// Detected text quads in struct-of-arrays layout: one plane per corner
+// coordinate plus score and angle, all in a single buffer. Corners run
+// clockwise from the top-left; the angle is that of the top edge in radians.
+//
+// Stages that look at one field of every quad (score filters, bounds for
+// NMS) read one plane linearly, and each plane is padded to a multiple of
+// kLanes so those loops can run full vector widths. clear() keeps the
+// capacity, so a set reused across frames stops allocating.
+class QuadSet {
+public:
+    enum Plane { X0, X1, X2, X3, Y0, Y1, Y2, Y3, Score, Angle, kPlanes };
+    static constexpr size_t kLanes = 8;
+
+    size_t size() const { return size_; }
+    bool empty() const { return size_ == 0; }
+    size_t capacity() const { return capacity_; }
+
+    void clear() { size_ = 0; }
+    void reserve(size_t count);
+
+    // `quad` holds x0, y0, x1, y1, x2, y2, x3, y3; the angle is derived from
+    // the top edge.
+    void push(const float* quad, float score);
+    // Axis-aligned box, angle 0.
+    void pushRect(float left, float top, float right, float bottom, float score);
+    void append(const QuadSet& other);
+
+    const float* plane(Plane p) const { return storage_.data() + p * capacity_; }
+    float* plane(Plane p) { return storage_.data() + p * capacity_; }
+    const float* xs(int corner) const { return plane(static_cast<Plane>(X0 + corner)); }
+    const float* ys(int corner) const { return plane(static_cast<Plane>(Y0 + corner)); }
+    const float* scores() const { return plane(Score); }
+    const float* angles() const { return plane(Angle); }
+
+    float x(int corner, size_t index) const { return xs(corner)[index]; }
+    float y(int corner, size_t index) const { return ys(corner)[index]; }
+    float score(size_t index) const { return scores()[index]; }
+    float angle(size_t index) const { return angles()[index]; }
+
+    // Interleaved x0, y0, ... x3, y3 of one quad.
+    void corners(size_t index, float* out) const;
+    // Axis-aligned bounds of one quad.
+    void bounds(size_t index, float& left, float& top, float& right, float& bottom) const;
+
+    void translate(float dx, float dy);
+    void scale(float sx, float sy);
+
+    // Keeps the quads whose keep[i] is non-zero, in order.
+    void compact(const uint8_t* keep);
+    void filterByScore(float minScore);
+    // Highest score first; ties keep their order.
+    void sortByScore();
+    // Reorders so that quad i becomes the old quad order[i]; `order` may
+    // name a subset, which drops the rest.
+    void permute(const uint32_t* order, size_t count);
+
+private:
+    void grow(size_t minCapacity);
+    void pushQuad(const float* quad, float score, float angle);
+
+    std::vector<float> storage_;
+    size_t size_ = 0;
+    size_t capacity_ = 0;
+    // Sort and permute scratch, kept for reuse
+    std::vector<uint32_t> order_;
+    std::vector<float> gather_;
+    std::vector<uint8_t> mask_;
+};
+
+} // namespace ocr
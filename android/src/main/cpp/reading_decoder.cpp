@@ -0,0 +1,254 @@
+#include "reading_decoder.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <limits>
+#include <vector>
+
+#include "frame_arena.h"
+
+namespace ocr {
+
+namespace {
+
+// Symbols of the grammar: the ten digits, then the two separators
+constexpr int kDigits = 10;
+constexpr int kSymbols = 12;
+constexpr float kNegInf = -std::numeric_limits<float>::infinity();
+
+float logAdd(float a, float b) {
+    if (a == kNegInf) return b;
+    if (b == kNegInf) return a;
+    const float high = std::max(a, b);
+    return high + std::log1p(std::exp(std::min(a, b) - high));
+}
+
+float safeLog(float p) {
+    return p > 0.0f ? std::log(p) : kNegInf;
+}
+
+// One prefix of the trie. Children are found through a sibling list, so
+// paths that reach the same prefix share one node and their probability.
+struct Node {
+    int parent;
+    int firstChild;
+    int nextSibling;
+    int symbol;     // -1 for the root
+    int integers;   // digits before any separator
+    int fraction;   // digits after it
+    bool separated;
+    float confidence;
+    // Step that last added this node as a candidate, and its slot then
+    int step;
+    int slot;
+};
+
+struct Beam {
+    int node;
+    float logBlank;
+    float logNonBlank;
+
+    float total() const { return logAdd(logBlank, logNonBlank); }
+};
+
+bool canExtend(const Node& node, int symbol, const ReadingGrammar& grammar) {
+    if (symbol >= kDigits) {
+        return grammar.fractionDigits > 0 && !node.separated && node.integers >= grammar.minDigits &&
+               node.integers <= grammar.maxDigits;
+    }
+    if (node.separated) return node.fraction < grammar.fractionDigits;
+    return node.integers < grammar.maxDigits + grammar.fractionDigits;
+}
+
+bool isComplete(const Node& node, const ReadingGrammar& grammar) {
+    if (node.separated) return node.fraction > 0;
+    return node.integers >= grammar.minDigits && node.integers <= grammar.maxDigits + grammar.fractionDigits;
+}
+
+// Decimal digits of a complete prefix
+int fractionOf(const Node& node, const ReadingGrammar& grammar) {
+    return node.separated ? node.fraction : std::max(0, node.integers - grammar.maxDigits);
+}
+
+} // namespace
+
+bool parseReadingGrammar(const std::string& text, ReadingGrammar& grammar) {
+    const char* p = text.c_str();
+    char* end = nullptr;
+    const long minDigits = std::strtol(p, &end, 10);
+    if (end == p || minDigits <= 0) return false;
+    long maxDigits = minDigits;
+    if (*end == '-') {
+        p = end + 1;
+        maxDigits = std::strtol(p, &end, 10);
+        if (end == p || maxDigits < minDigits) return false;
+    }
+    long fractionDigits = 0;
+    if (*end == '+') {
+        p = end + 1;
+        fractionDigits = std::strtol(p, &end, 10);
+        if (end == p || fractionDigits < 0) return false;
+    }
+    if (*end != '\0' || maxDigits + fractionDigits > 16) return false;
+    grammar.minDigits = static_cast<int>(minDigits);
+    grammar.maxDigits = static_cast<int>(maxDigits);
+    grammar.fractionDigits = static_cast<int>(fractionDigits);
+    return true;
+}
+
+ReadingDecoder::ReadingDecoder(const CharDict& dict) {
+    std::fill(digitClass_, digitClass_ + kDigits, -1);
+    separatorClass_[0] = separatorClass_[1] = -1;
+    for (int c = 1; c < dict.classCount(); ++c) {
+        const std::string& label = dict.label(c);
+        if (label.size() != 1) continue;
+        const char ch = label[0];
+        if (ch >= '0' && ch <= '9' && digitClass_[ch - '0'] < 0) digitClass_[ch - '0'] = c;
+        if (ch == '.' && separatorClass_[0] < 0) separatorClass_[0] = c;
+        if (ch == ',' && separatorClass_[1] < 0) separatorClass_[1] = c;
+    }
+    valid_ = std::none_of(digitClass_, digitClass_ + kDigits, [](int c) { return c < 0; });
+}
+
+void ReadingDecoder::decode(const float* probs, int timeSteps, int numClasses, const ReadingGrammar& grammar,
+                            const ReadingPrior& prior, Recognition& result, FrameArena* arena) const {
+    result.text.clear();
+    result.charConfidences.clear();
+    result.confidence = 0.0f;
+    result.fractionDigits = 0;
+    if (!valid_ || timeSteps <= 0) return;
+
+    int classOf[kSymbols];
+    std::copy(digitClass_, digitClass_ + kDigits, classOf);
+    classOf[kDigits] = separatorClass_[0];
+    classOf[kDigits + 1] = separatorClass_[1];
+
+    // Every step adds at most one node per beam and symbol
+    const int beamWidth = std::max(1, grammar.beamWidth);
+    const size_t maxNodes = 1 + static_cast<size_t>(timeSteps) * beamWidth * kSymbols;
+    const size_t maxCandidates = static_cast<size_t>(beamWidth) * (kSymbols + 1);
+    std::vector<Node> heapNodes;
+    std::vector<Beam> heapBeams;
+    Node* nodes = scratch(arena, heapNodes, maxNodes);
+    Beam* beams = scratch(arena, heapBeams, maxCandidates + beamWidth);
+    Beam* candidates = beams + beamWidth;
+
+    nodes[0] = {-1, -1, -1, -1, 0, 0, false, 0.0f, -1, 0};
+    size_t nodeCount = 1;
+    beams[0] = {0, 0.0f, kNegInf};
+    int beamCount = 1;
+
+    for (int t = 0; t < timeSteps; ++t) {
+        const float* step = probs + static_cast<size_t>(t) * numClasses;
+        float prob[kSymbols];
+        float logProb[kSymbols];
+        for (int s = 0; s < kSymbols; ++s) {
+            prob[s] = classOf[s] >= 0 && classOf[s] < numClasses ? step[classOf[s]] : 0.0f;
+            logProb[s] = safeLog(prob[s]);
+        }
+        // Without decimals a separator is noise between digits, like a blank
+        const float blankProb = grammar.fractionDigits > 0 ? step[0] : step[0] + prob[kDigits] + prob[kDigits + 1];
+        const float logBlank = safeLog(blankProb);
+
+        int candidateCount = 0;
+        auto add = [&](int node, float blank, float nonBlank) {
+            Node& n = nodes[node];
+            if (n.step != t) {
+                n.step = t;
+                n.slot = candidateCount;
+                candidates[candidateCount++] = {node, blank, nonBlank};
+                return;
+            }
+            Beam& c = candidates[n.slot];
+            c.logBlank = logAdd(c.logBlank, blank);
+            c.logNonBlank = logAdd(c.logNonBlank, nonBlank);
+        };
+
+        for (int b = 0; b < beamCount; ++b) {
+            const Beam beam = beams[b];
+            const int parent = beam.node;
+            const float total = beam.total();
+            add(parent, total + logBlank, kNegInf);
+            // The last symbol held over another step
+            const int last = nodes[parent].symbol;
+            if (last >= 0 && prob[last] > 0.0f) {
+                add(parent, kNegInf, beam.logNonBlank + logProb[last]);
+                nodes[parent].confidence = std::max(nodes[parent].confidence, prob[last]);
+            }
+            for (int s = 0; s < kSymbols; ++s) {
+                if (prob[s] < grammar.minClassProb || !canExtend(nodes[parent], s, grammar)) continue;
+                int child = nodes[parent].firstChild;
+                while (child >= 0 && nodes[child].symbol != s) child = nodes[child].nextSibling;
+                if (child < 0) {
+                    child = static_cast<int>(nodeCount++);
+                    const Node& p = nodes[parent];
+                    Node& n = nodes[child];
+                    n = {parent, -1, p.firstChild, s, p.integers, p.fraction, p.separated, 0.0f, -1, 0};
+                    if (s >= kDigits) {
+                        n.separated = true;
+                    } else if (p.separated) {
+                        ++n.fraction;
+                    } else {
+                        ++n.integers;
+                    }
+                    nodes[parent].firstChild = child;
+                }
+                nodes[child].confidence = std::max(nodes[child].confidence, prob[s]);
+                // A repeated symbol only starts a new character after a blank
+                const float base = s == last ? beam.logBlank : total;
+                add(child, kNegInf, base + logProb[s]);
+            }
+        }
+
+        beamCount = std::min(candidateCount, beamWidth);
+        std::partial_sort(candidates, candidates + beamCount, candidates + candidateCount,
+                          [](const Beam& a, const Beam& b) { return a.total() > b.total(); });
+        std::copy(candidates, candidates + beamCount, beams);
+    }
+
+    // Best complete reading, with the prior on its value
+    int best = -1;
+    float bestScore = kNegInf;
+    for (int b = 0; b < beamCount; ++b) {
+        const Node& node = nodes[beams[b].node];
+        if (!isComplete(node, grammar)) continue;
+        float score = beams[b].total();
+        if (prior.lastValue >= 0.0) {
+            const int fraction = fractionOf(node, grammar);
+            double value = 0.0;
+            double scale = 1.0;
+            for (int n = beams[b].node; nodes[n].symbol >= 0; n = nodes[n].parent) {
+                if (nodes[n].symbol >= kDigits) continue;
+                value += nodes[n].symbol * scale;
+                scale *= 10.0;
+            }
+            value /= std::pow(10.0, fraction);
+            if (value < prior.lastValue) {
+                score -= grammar.decreasePenalty;
+            } else if (prior.maxIncrease > 0.0 && value - prior.lastValue > prior.maxIncrease) {
+                score -= grammar.jumpPenalty;
+            }
+        }
+        if (score > bestScore) {
+            bestScore = score;
+            best = beams[b].node;
+        }
+    }
+    if (best < 0) return;
+
+    for (int n = best; nodes[n].symbol >= 0; n = nodes[n].parent) {
+        if (nodes[n].symbol >= kDigits) continue;
+        result.text += static_cast<char>('0' + nodes[n].symbol);
+        result.charConfidences.push_back(nodes[n].confidence);
+    }
+    std::reverse(result.text.begin(), result.text.end());
+    std::reverse(result.charConfidences.begin(), result.charConfidences.end());
+    result.fractionDigits = fractionOf(nodes[best], grammar);
+    float sum = 0.0f;
+    for (float confidence : result.charConfidences) sum += confidence;
+    result.confidence = sum / result.charConfidences.size();
+}
+
+} // namespace ocr
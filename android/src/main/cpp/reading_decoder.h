@@ -0,0 +1,65 @@
+#pragma once
+
+#include <string>
+
+#include "ctc_decoder.h"
+
+namespace ocr {
+
+class FrameArena;
+
+// What a reading of one meter type looks like: a run of integer (black drum)
+// digits, then optionally decimal (red drum) digits. The model may read a '.'
+// or ',' between the two; without one, digits past maxDigits are the decimals.
+struct ReadingGrammar {
+    int minDigits = 4;
+    int maxDigits = 8;
+    int fractionDigits = 0;
+
+    // Log-probability costs of readings that go backwards from the last known
+    // value, or jump ahead of it by more than the plausible increase.
+    float decreasePenalty = 3.0f;
+    float jumpPenalty = 2.0f;
+
+    // Paths below this per-step probability are not extended.
+    float minClassProb = 1e-4f;
+    int beamWidth = 8;
+};
+
+// "N", "MIN-MAX", either optionally followed by "+F" decimal digits, e.g.
+// "5+3" for five black and three red digits. Returns false on bad syntax.
+bool parseReadingGrammar(const std::string& text, ReadingGrammar& grammar);
+
+// Last known state of the meter being read.
+struct ReadingPrior {
+    // Last reading, in units of the integer digits; negative when unknown.
+    double lastValue = -1.0;
+    // Largest plausible increase since then; 0 for no limit.
+    double maxIncrease = 0.0;
+};
+
+// Decodes rec output restricted to the digit grammar. Finds the digit and
+// separator classes of the dictionary once; decoding is then a CTC prefix
+// beam search that only extends prefixes the grammar can still complete.
+// Complete readings are ranked by path probability plus the prior.
+class ReadingDecoder {
+public:
+    explicit ReadingDecoder(const CharDict& dict);
+
+    // Whether the dictionary has all ten digits.
+    bool valid() const { return valid_; }
+
+    // Overwrites `result` with the best reading; its text holds the integer
+    // digits then the decimals, with fractionDigits set. Empty when nothing
+    // fits the grammar. Trie and beams come from `arena` when one is given.
+    void decode(const float* probs, int timeSteps, int numClasses, const ReadingGrammar& grammar,
+                const ReadingPrior& prior, Recognition& result, FrameArena* arena = nullptr) const;
+
+private:
+    // Class index of each digit, and of the '.' and ',' labels (-1 if absent)
+    int digitClass_[10];
+    int separatorClass_[2];
+    bool valid_ = true;
+};
+
+} // namespace ocr
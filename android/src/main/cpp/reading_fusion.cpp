@@ -0,0 +1,102 @@
+#include "reading_fusion.h"
+
+#include <algorithm>
+#include <cmath>
+#include <string>
+#include <vector>
+
+namespace ocr {
+
+namespace {
+
+// Posteriors are clamped so that no single frame is treated as certain
+constexpr double kMinProb = 1e-3;
+constexpr double kMaxProb = 1.0 - 1e-3;
+
+bool fusable(const Recognition& r) {
+    return !r.text.empty() && r.charConfidences.size() == r.text.size();
+}
+
+bool sameLayout(const Recognition& a, const Recognition& b) {
+    return a.text.size() == b.text.size() && a.fractionDigits == b.fractionDigits;
+}
+
+} // namespace
+
+bool fuseRecognitions(const Recognition* const* reads, size_t count, int alphabetSize, Recognition& result) {
+    const double others = std::max(1, alphabetSize - 1);
+
+    // The layout most of the confidence agrees on
+    const Recognition* leader = nullptr;
+    float leaderWeight = 0.0f;
+    for (size_t i = 0; i < count; ++i) {
+        if (!reads[i] || !fusable(*reads[i])) continue;
+        float weight = 0.0f;
+        for (size_t j = 0; j < count; ++j) {
+            if (reads[j] && fusable(*reads[j]) && sameLayout(*reads[i], *reads[j])) weight += reads[j]->confidence;
+        }
+        if (!leader || weight > leaderWeight) {
+            leader = reads[i];
+            leaderWeight = weight;
+        }
+    }
+    if (!leader) return false;
+
+    std::vector<const Recognition*> members;
+    for (size_t i = 0; i < count; ++i) {
+        if (reads[i] && fusable(*reads[i]) && sameLayout(*leader, *reads[i])) members.push_back(reads[i]);
+    }
+
+    const size_t length = leader->text.size();
+    std::string text(length, '\0');
+    std::vector<float> confidences(length);
+    std::string labels;
+    std::vector<double> gains;
+    for (size_t pos = 0; pos < length; ++pos) {
+        // Log-likelihood of a label no frame read here, and what reading a
+        // label adds to it for every frame that did
+        double unread = 0.0;
+        labels.clear();
+        gains.clear();
+        for (const Recognition* r : members) {
+            const double p = std::min(kMaxProb, std::max(kMinProb, static_cast<double>(r->charConfidences[pos])));
+            const double rest = std::log((1.0 - p) / others);
+            unread += rest;
+            const size_t k = labels.find(r->text[pos]);
+            if (k == std::string::npos) {
+                labels.push_back(r->text[pos]);
+                gains.push_back(std::log(p) - rest);
+            } else {
+                gains[k] += std::log(p) - rest;
+            }
+        }
+
+        const size_t best = std::max_element(gains.begin(), gains.end()) - gains.begin();
+        // Posterior of the best label among all of the alphabet
+        double norm = std::max(0.0, others + 1.0 - labels.size()) * std::exp(-gains[best]);
+        for (double gain : gains) norm += std::exp(gain - gains[best]);
+        text[pos] = labels[best];
+        confidences[pos] = static_cast<float>(1.0 / norm);
+    }
+
+    float sum = 0.0f;
+    for (float confidence : confidences) sum += confidence;
+    result.text = std::move(text);
+    result.charConfidences = std::move(confidences);
+    result.confidence = sum / length;
+    result.fractionDigits = leader->fractionDigits;
+    return true;
+}
+
+void averagePosteriors(const float* outputs, size_t count, size_t size, float* dst) {
+    if (count == 0) return;
+    std::copy(outputs, outputs + size, dst);
+    for (size_t v = 1; v < count; ++v) {
+        const float* output = outputs + v * size;
+        for (size_t i = 0; i < size; ++i) dst[i] += output[i];
+    }
+    const float scale = 1.0f / static_cast<float>(count);
+    for (size_t i = 0; i < size; ++i) dst[i] *= scale;
+}
+
+} // namespace ocr
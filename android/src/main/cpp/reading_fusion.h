@@ -0,0 +1,26 @@
+#pragma once
+
+#include <cstddef>
+
+#include "ctc_decoder.h"
+
+namespace ocr {
+
+// Combines recognitions of the same text from several frames, e.g. a burst
+// of shots of one meter, into one reading. They are grouped by length and
+// decimal digits, and the group with the most total confidence is fused:
+// every character position takes the label with the highest product of
+// per-frame posteriors. A frame that read another label there contributes
+// the probability it left over, spread evenly over the other
+// `alphabetSize - 1` labels, so one confident frame outvotes two unsure ones.
+// Only recognitions with one byte per character (digits, separators) take
+// part. Returns false, leaving `result` untouched, when there are none.
+bool fuseRecognitions(const Recognition* const* reads, size_t count, int alphabetSize, Recognition& result);
+
+// Mean of `count` rec outputs of `size` floats each, stored one after
+// another, written to `dst`. Meant for variants of one crop (see
+// CropVariant): they share the crop's geometry, so their CTC time steps line
+// up and can be fused before decoding, unlike reads of different frames.
+void averagePosteriors(const float* outputs, size_t count, size_t size, float* dst);
+
+} // namespace ocr
@@ -0,0 +1,114 @@
+#include "region_ranker.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace ocr {
+
+namespace {
+
+// 1 inside [low, high], falling off with the ratio to the nearest bound
+float rangeFit(float value, float low, float high) {
+    if (value <= 0.0f) return 0.0f;
+    if (value < low) return value / low;
+    if (value > high) return high / value;
+    return 1.0f;
+}
+
+int countDigits(const std::string& text) {
+    return static_cast<int>(std::count_if(text.begin(), text.end(), [](char c) { return c >= '0' && c <= '9'; }));
+}
+
+// minLength to maxLength characters, all digits, each recognized with at
+// least minConfidence
+bool matchesDigits(const Recognition& recognition, int minLength, int maxLength, float minConfidence) {
+    const std::string& text = recognition.text;
+    const int length = static_cast<int>(text.size());
+    if (length < minLength || length > maxLength || countDigits(text) != length) return false;
+    if (recognition.charConfidences.size() != text.size()) return false;
+    for (float confidence : recognition.charConfidences) {
+        if (confidence < minConfidence) return false;
+    }
+    return true;
+}
+
+} // namespace
+
+void scoreRegions(const QuadSet& quads, int imageWidth, int imageHeight, const RankParams& params, float* scores) {
+    const float weightSum = params.aspectWeight + params.positionWeight + params.detWeight;
+    const float minAspect = params.minDigits * params.digitAspect;
+    const float maxAspect = params.maxDigits * params.digitAspect;
+    const float roiLeft = params.roiLeft * imageWidth;
+    const float roiTop = params.roiTop * imageHeight;
+    const float roiRight = params.roiRight * imageWidth;
+    const float roiBottom = params.roiBottom * imageHeight;
+    const float roiCenterX = 0.5f * (roiLeft + roiRight);
+    const float roiCenterY = 0.5f * (roiTop + roiBottom);
+    const float roiHalfWidth = std::max(1.0f, 0.5f * (roiRight - roiLeft));
+    const float roiHalfHeight = std::max(1.0f, 0.5f * (roiBottom - roiTop));
+
+    for (size_t i = 0; i < quads.size(); ++i) {
+        float left, top, right, bottom;
+        quads.bounds(i, left, top, right, bottom);
+        const float width = right - left;
+        const float height = bottom - top;
+        if (width < params.minWidth || height < params.minHeight || height <= 0.0f) {
+            scores[i] = -1.0f;
+            continue;
+        }
+
+        // Normalized distance of the centre from the ROI centre; 1 on its edge
+        const float dx = (0.5f * (left + right) - roiCenterX) / roiHalfWidth;
+        const float dy = (0.5f * (top + bottom) - roiCenterY) / roiHalfHeight;
+        const float distance = std::max(std::fabs(dx), std::fabs(dy));
+        const float position = distance >= 1.0f ? 0.0f : 1.0f - distance * distance;
+
+        const float aspect = rangeFit(width / height, minAspect, maxAspect);
+        const float det = std::min(1.0f, std::max(0.0f, quads.score(i)));
+        const float sum = params.aspectWeight * aspect + params.positionWeight * position + params.detWeight * det;
+        scores[i] = weightSum > 0.0f ? sum / weightSum : 0.0f;
+    }
+}
+
+void topRegions(const float* scores, size_t count, int topK, std::vector<uint32_t>& out) {
+    out.clear();
+    for (size_t i = 0; i < count; ++i) {
+        if (scores[i] >= 0.0f) out.push_back(static_cast<uint32_t>(i));
+    }
+    auto better = [scores](uint32_t a, uint32_t b) {
+        return scores[a] > scores[b] || (scores[a] == scores[b] && a < b);
+    };
+    if (topK > 0 && out.size() > static_cast<size_t>(topK)) {
+        std::partial_sort(out.begin(), out.begin() + topK, out.end(), better);
+        out.resize(topK);
+    } else {
+        std::sort(out.begin(), out.end(), better);
+    }
+}
+
+bool matchesReading(const Recognition& recognition, const RankParams& params) {
+    return matchesDigits(recognition, params.minDigits, params.maxDigits, params.minCharConfidence);
+}
+
+bool matchesReading(const Recognition& recognition, const RankParams& params, const ReadingGrammar& grammar) {
+    return matchesDigits(recognition, grammar.minDigits + grammar.fractionDigits,
+                         grammar.maxDigits + grammar.fractionDigits, params.minCharConfidence);
+}
+
+float readingScore(float geometryScore, const Recognition& recognition, const RankParams& params) {
+    const float geometryWeight = params.aspectWeight + params.positionWeight + params.detWeight;
+    const float weightSum = geometryWeight + params.digitWeight + params.recWeight;
+    if (weightSum <= 0.0f) return 0.0f;
+
+    // Digits within range score 1; non-digit characters dilute the score
+    const int digits = countDigits(recognition.text);
+    float digitFit = rangeFit(static_cast<float>(digits), static_cast<float>(params.minDigits),
+                              static_cast<float>(params.maxDigits));
+    if (!recognition.text.empty()) digitFit *= static_cast<float>(digits) / recognition.text.size();
+
+    const float sum = geometryWeight * std::max(0.0f, geometryScore) + params.digitWeight * digitFit +
+                      params.recWeight * recognition.confidence;
+    return sum / weightSum;
+}
+
+} // namespace ocr
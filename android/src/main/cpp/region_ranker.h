@@ -0,0 +1,63 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "ctc_decoder.h"
+#include "quad_set.h"
+#include "reading_decoder.h"
+
+namespace ocr {
+
+// Scores candidate regions as meter readings so that only the best few go
+// to recognition. Every term is in [0, 1] and the weights set their mix.
+struct RankParams {
+    // Regions smaller than this, in image pixels, are not candidates.
+    float minWidth = 0.0f;
+    float minHeight = 0.0f;
+    // Expected digits in a reading; with digitAspect (width over height of
+    // one digit cell) this also gives the expected aspect ratio of a region.
+    int minDigits = 4;
+    int maxDigits = 8;
+    float digitAspect = 0.6f;
+    // Where the reading is expected, as fractions of the image size.
+    // Regions centred outside it score 0 for position.
+    float roiLeft = 0.0f;
+    float roiTop = 0.0f;
+    float roiRight = 1.0f;
+    float roiBottom = 1.0f;
+    // Regions recognized per frame, best first; 0 keeps all.
+    int topK = 3;
+    // Every character of a reading must be recognized at least this sure.
+    float minCharConfidence = 0.8f;
+
+    float aspectWeight = 1.0f;
+    float positionWeight = 1.0f;
+    float detWeight = 1.0f;
+    float digitWeight = 1.0f;
+    float recWeight = 1.0f;
+};
+
+// Geometric score of each quad from its aspect ratio, position in the ROI
+// and detection score, written to scores[i]; -1 for quads below the minimum
+// size.
+void scoreRegions(const QuadSet& quads, int imageWidth, int imageHeight, const RankParams& params, float* scores);
+
+// Indices of the topK best non-negative scores, best first.
+void topRegions(const float* scores, size_t count, int topK, std::vector<uint32_t>& out);
+
+// Meter reading grammar: minDigits to maxDigits characters, all digits, each
+// recognized with at least minCharConfidence.
+bool matchesReading(const Recognition& recognition, const RankParams& params);
+
+// Same for text decoded with `grammar` (rec_grammar), whose readings run to
+// its maxDigits plus fractionDigits: the length bounds come from the grammar
+// instead of from params.
+bool matchesReading(const Recognition& recognition, const RankParams& params, const ReadingGrammar& grammar);
+
+// Final score of a recognized region: the geometric score, how well the
+// number of digits fits the expected range and the rec confidence.
+float readingScore(float geometryScore, const Recognition& recognition, const RankParams& params);
+
+} // namespace ocr
@@ -0,0 +1,135 @@
+#include "task_scheduler.h"
+
+#include <algorithm>
+#include <exception>
+
+namespace ocr {
+
+struct TaskScheduler::Group {
+    const std::function<void(int)>* fn;
+    std::atomic<int> pending;
+    std::mutex mutex;
+    std::condition_variable done;
+    std::exception_ptr error;
+};
+
+TaskScheduler::TaskScheduler(int workers) {
+    workers = std::max(0, workers);
+    // Queue 0 belongs to external callers, 1..workers to the threads
+    for (int i = 0; i <= workers; ++i) queues_.emplace_back(new Queue());
+    for (int i = 1; i <= workers; ++i) workers_.emplace_back(&TaskScheduler::workerLoop, this, i);
+}
+
+TaskScheduler::~TaskScheduler() {
+    {
+        std::lock_guard<std::mutex> lock(wakeMutex_);
+        stopping_ = true;
+    }
+    wakeCv_.notify_all();
+    for (std::thread& t : workers_) t.join();
+}
+
+int TaskScheduler::recommendedWorkers(int intraOpThreads) {
+    int hardware = static_cast<int>(std::thread::hardware_concurrency());
+    if (hardware <= 0) hardware = 1;
+    return std::max(0, hardware / std::max(1, intraOpThreads) - 1);
+}
+
+void TaskScheduler::parallelFor(int count, const std::function<void(int)>& fn) {
+    if (count <= 0) return;
+    if (workers_.empty() || count == 1) {
+        for (int i = 0; i < count; ++i) fn(i);
+        return;
+    }
+
+    Group group;
+    group.fn = &fn;
+    group.pending.store(count);
+
+    // Count before publishing so queued_ never underflows
+    queued_.fetch_add(count);
+
+    // Deal indices round-robin so every worker starts with local work
+    const int queueCount = static_cast<int>(queues_.size());
+    const unsigned first = nextQueue_.fetch_add(1);
+    for (int q = 0; q < queueCount; ++q) {
+        Queue& queue = *queues_[(first + q) % queueCount];
+        std::lock_guard<std::mutex> lock(queue.mutex);
+        for (int i = q; i < count; i += queueCount) queue.tasks.push_back({&group, i});
+    }
+    {
+        std::lock_guard<std::mutex> lock(wakeMutex_);
+    }
+    wakeCv_.notify_all();
+
+    // Help until our own group has drained, then wait for stragglers
+    Task task;
+    while (group.pending.load() > 0) {
+        if (steal(-1, task)) {
+            execute(task);
+        } else {
+            std::unique_lock<std::mutex> lock(group.mutex);
+            group.done.wait(lock, [&] { return group.pending.load() == 0; });
+        }
+    }
+    // Synchronizes with the last execute() releasing the group
+    std::lock_guard<std::mutex> lock(group.mutex);
+    if (group.error) std::rethrow_exception(group.error);
+}
+
+void TaskScheduler::workerLoop(int self) {
+    Task task;
+    for (;;) {
+        if (popOwn(self, task) || steal(self, task)) {
+            execute(task);
+            continue;
+        }
+        std::unique_lock<std::mutex> lock(wakeMutex_);
+        wakeCv_.wait(lock, [&] { return stopping_ || queued_.load() > 0; });
+        if (stopping_) return;
+    }
+}
+
+bool TaskScheduler::popOwn(int self, Task& task) {
+    Queue& queue = *queues_[self];
+    std::lock_guard<std::mutex> lock(queue.mutex);
+    if (queue.tasks.empty()) return false;
+    task = queue.tasks.back();
+    queue.tasks.pop_back();
+    queued_.fetch_sub(1);
+    return true;
+}
+
+bool TaskScheduler::steal(int self, Task& task) {
+    const int queueCount = static_cast<int>(queues_.size());
+    const int start = self < 0 ? 0 : self + 1;
+    for (int k = 0; k < queueCount; ++k) {
+        int victim = (start + k) % queueCount;
+        if (victim == self) continue;
+        Queue& queue = *queues_[victim];
+        std::lock_guard<std::mutex> lock(queue.mutex);
+        if (queue.tasks.empty()) continue;
+        task = queue.tasks.front();
+        queue.tasks.pop_front();
+        queued_.fetch_sub(1);
+        return true;
+    }
+    return false;
+}
+
+void TaskScheduler::execute(const Task& task) {
+    Group& group = *task.group;
+    std::exception_ptr error;
+    try {
+        (*group.fn)(task.index);
+    } catch (...) {
+        error = std::current_exception();
+    }
+    // Decrement under the lock: once the owner sees zero it may destroy the
+    // group, which must not happen while we still touch it.
+    std::lock_guard<std::mutex> lock(group.mutex);
+    if (error && !group.error) group.error = error;
+    if (group.pending.fetch_sub(1) == 1) group.done.notify_all();
+}
+
+} // namespace ocr
@@ -0,0 +1,70 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace ocr {
+
+// Work-stealing scheduler for the fork/join parallelism in the pipeline
+// (crops, det tiles, batch stages).
+//
+// Each worker owns a deque; it pops its own tasks newest-first and steals the
+// oldest task of another worker when idle. parallelFor() blocks the calling
+// thread, which runs tasks too while it waits, so nested parallelFor calls
+// from inside a task cannot deadlock.
+//
+// Size the pool so that concurrency() * ORT intra-op threads does not exceed
+// the core count; recommendedWorkers() does that.
+class TaskScheduler {
+public:
+    // `workers` background threads; 0 runs everything on the caller.
+    explicit TaskScheduler(int workers);
+    ~TaskScheduler();
+
+    TaskScheduler(const TaskScheduler&) = delete;
+    TaskScheduler& operator=(const TaskScheduler&) = delete;
+
+    // Threads that execute tasks, the calling thread included.
+    int concurrency() const { return static_cast<int>(workers_.size()) + 1; }
+
+    // Calls fn(i) for every i in [0, count) and returns when all are done.
+    // The first exception thrown by fn is rethrown here after the others
+    // finish.
+    void parallelFor(int count, const std::function<void(int)>& fn);
+
+    // Background workers that keep cores busy without oversubscribing when
+    // each task runs ORT with `intraOpThreads` threads.
+    static int recommendedWorkers(int intraOpThreads);
+
+private:
+    struct Group;
+    struct Task {
+        Group* group;
+        int index;
+    };
+    struct Queue {
+        std::mutex mutex;
+        std::deque<Task> tasks;
+    };
+
+    void workerLoop(int self);
+    bool popOwn(int self, Task& task);
+    bool steal(int self, Task& task);
+    void execute(const Task& task);
+
+    std::vector<std::unique_ptr<Queue>> queues_;
+    std::vector<std::thread> workers_;
+    std::atomic<int> queued_{0};
+    std::atomic<unsigned> nextQueue_{0};
+    std::mutex wakeMutex_;
+    std::condition_variable wakeCv_;
+    bool stopping_ = false;
+};
+
+} // namespace ocr
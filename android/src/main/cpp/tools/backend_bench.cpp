@@ -0,0 +1,203 @@
+// Compares inference backends and execution providers on the same images:
+// model load time and per-image det / cls+rec latency.
+//
+//   backend_bench --models onnxruntime:det.onnx,cls.onnx,rec.onnx
+//                 --models onnxruntime/xnnpack:det.onnx,cls.onnx,rec.onnx
+//                 --models paddle_lite:det.nb,cls.nb,rec.nb
+//                 [--iterations N] [--opt key=value]... <image>...
+//
+// A backend may name execution providers after a slash, joined with '+'
+// (onnxruntime/nnapi+xnnpack).
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <vector>
+
+#include "image_io.h"
+#include "image_ops.h"
+#include "inference_backend.h"
+#include "ocr_engine.h"
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+struct ModelSet {
+    std::string label;
+    std::string backend;
+    std::vector<std::string> providers;
+    std::string det;
+    std::string cls;
+    std::string rec;
+};
+
+void usage() {
+    std::fprintf(stderr,
+                 "usage: backend_bench --models <backend>[/<provider>+...]:<det>,<cls>,<rec> [--models ...]\n"
+                 "                     [--iterations N] [--opt key=value]... <image>...\n");
+}
+
+bool parseModelSet(const std::string& text, ModelSet& set) {
+    size_t colon = text.find(':');
+    size_t first = text.find(',', colon + 1);
+    size_t second = first == std::string::npos ? first : text.find(',', first + 1);
+    if (colon == std::string::npos || second == std::string::npos) return false;
+    set.label = text.substr(0, colon);
+    size_t slash = set.label.find('/');
+    set.backend = set.label.substr(0, slash);
+    if (slash != std::string::npos) {
+        std::string providers = set.label.substr(slash + 1);
+        for (size_t start = 0; start <= providers.size();) {
+            size_t plus = std::min(providers.find('+', start), providers.size());
+            set.providers.push_back(providers.substr(start, plus - start));
+            start = plus + 1;
+        }
+    }
+    set.det = text.substr(colon + 1, first - colon - 1);
+    set.cls = text.substr(first + 1, second - first - 1);
+    set.rec = text.substr(second + 1);
+    return true;
+}
+
+double millisSince(Clock::time_point start) {
+    return std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+}
+
+double percentile(std::vector<double> values, double p) {
+    if (values.empty()) return 0.0;
+    std::sort(values.begin(), values.end());
+    size_t index = static_cast<size_t>(p * (values.size() - 1) + 0.5);
+    return values[index];
+}
+
+const char* hostArch() {
+#if defined(__aarch64__)
+    return "arm64";
+#elif defined(__x86_64__)
+    return "x86_64";
+#elif defined(__arm__)
+    return "arm";
+#else
+    return "unknown";
+#endif
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    ocr::EngineConfig baseConfig;
+    std::vector<ModelSet> sets;
+    std::vector<std::string> paths;
+    int iterations = 10;
+
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        auto value = [&]() -> std::string {
+            if (i + 1 >= argc) {
+                usage();
+                std::exit(2);
+            }
+            return argv[++i];
+        };
+        if (arg == "--models") {
+            ModelSet set;
+            std::string text = value();
+            if (!parseModelSet(text, set)) {
+                std::fprintf(stderr, "Invalid model set: %s\n", text.c_str());
+                return 2;
+            }
+            sets.push_back(set);
+        } else if (arg == "--iterations") {
+            iterations = std::max(1, std::atoi(value().c_str()));
+        } else if (arg == "--opt") {
+            std::string option = value();
+            if (!baseConfig.applyOption(option)) {
+                std::fprintf(stderr, "Invalid option: %s\n", option.c_str());
+                return 2;
+            }
+        } else if (arg == "-h" || arg == "--help") {
+            usage();
+            return 0;
+        } else {
+            paths.push_back(arg);
+        }
+    }
+    if (sets.empty() || paths.empty()) {
+        usage();
+        return 2;
+    }
+
+    std::vector<ocr::RgbaImage> images;
+    for (const std::string& path : paths) {
+        ocr::RgbaImage image;
+        std::string error;
+        if (!ocr::decodeImageFile(path, image, error)) {
+            std::fprintf(stderr, "%s: %s\n", path.c_str(), error.c_str());
+            return 1;
+        }
+        images.push_back(std::move(image));
+    }
+
+    std::string compiled;
+    for (const std::string& name : ocr::availableBackends()) compiled += " " + name;
+    std::printf("host %s, backends:%s, %zu images x %d iterations, %d intra-op threads\n", hostArch(),
+                compiled.empty() ? " none" : compiled.c_str(), images.size(), iterations,
+                baseConfig.intraOpThreads);
+    std::printf("%-20s %9s %9s %9s %9s %9s %9s %7s\n", "backend", "load ms", "warm ms", "det p50", "det p90",
+                "rec p50", "rec p90", "regions");
+
+    int status = 0;
+    for (const ModelSet& set : sets) {
+        ocr::EngineConfig config = baseConfig;
+        config.backend = set.backend;
+        if (!set.providers.empty()) config.providers = set.providers;
+        config.detModelPath = set.det;
+        config.clsModelPath = set.cls;
+        config.recModelPath = set.rec;
+        try {
+            Clock::time_point loadStart = Clock::now();
+            ocr::Engine engine(config);
+            double loadMs = millisSince(loadStart);
+            double warmMs = engine.warmUp().totalMs;
+
+            std::vector<double> detMs, recMs;
+            size_t regions = 0;
+            // The first pass only counts regions
+            for (int iteration = 0; iteration <= iterations; ++iteration) {
+                for (const ocr::RgbaImage& image : images) {
+                    Clock::time_point start = Clock::now();
+                    ocr::QuadSet boxes = engine.detect(image.pixels.data(), image.width, image.height);
+                    double det = millisSince(start);
+
+                    std::vector<ocr::Rect> rects;
+                    for (size_t q = 0; q < boxes.size(); ++q) {
+                        float left, top, right, bottom;
+                        boxes.bounds(q, left, top, right, bottom);
+                        rects.push_back({static_cast<int>(left), static_cast<int>(top), static_cast<int>(right),
+                                         static_cast<int>(bottom)});
+                    }
+                    start = Clock::now();
+                    engine.recognizeRegions(image.pixels.data(), image.width, image.height, rects);
+                    double rec = millisSince(start);
+
+                    if (iteration == 0) {
+                        regions += rects.size();
+                        continue;
+                    }
+                    detMs.push_back(det);
+                    recMs.push_back(rec);
+                }
+            }
+            std::printf("%-20s %9.1f %9.1f %9.2f %9.2f %9.2f %9.2f %7zu\n", set.label.c_str(), loadMs, warmMs,
+                        percentile(detMs, 0.5), percentile(detMs, 0.9), percentile(recMs, 0.5),
+                        percentile(recMs, 0.9), regions);
+        } catch (const std::exception& e) {
+            std::printf("%-20s failed: %s\n", set.label.c_str(), e.what());
+            status = 1;
+        }
+    }
+    return status;
+}
@@ -0,0 +1,122 @@
+// Batch OCR over a directory of meter photos, one JSON object per line.
+//
+//   ocr_batch --det det.onnx --cls cls.onnx --rec rec.onnx [--opt key=value]...
+//             [--workers N] [--chunk N] <dir-or-image>... > readings.jsonl
+
+#include <algorithm>
+#include <cctype>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "batch_runner.h"
+#include "ocr_engine.h"
+
+namespace fs = std::filesystem;
+
+namespace {
+
+void usage() {
+    std::fprintf(stderr,
+                 "usage: ocr_batch --det <model> --cls <model> --rec <model> [--opt key=value]...\n"
+                 "                 [--workers N] [--chunk N] <dir-or-image>...\n");
+}
+
+bool isImageFile(const fs::path& path) {
+    std::string ext = path.extension().string();
+    std::transform(ext.begin(), ext.end(), ext.begin(), [](unsigned char c) { return std::tolower(c); });
+    return ext == ".jpg" || ext == ".jpeg" || ext == ".png";
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    ocr::EngineConfig config;
+    int workers = 0;
+    int chunk = 256;
+    std::vector<std::string> inputs;
+
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        auto value = [&]() -> std::string {
+            if (i + 1 >= argc) {
+                usage();
+                std::exit(2);
+            }
+            return argv[++i];
+        };
+        if (arg == "--det") {
+            config.detModelPath = value();
+        } else if (arg == "--cls") {
+            config.clsModelPath = value();
+        } else if (arg == "--rec") {
+            config.recModelPath = value();
+        } else if (arg == "--opt") {
+            std::string option = value();
+            if (!config.applyOption(option)) {
+                std::fprintf(stderr, "Invalid option: %s\n", option.c_str());
+                return 2;
+            }
+        } else if (arg == "--workers") {
+            workers = std::atoi(value().c_str());
+        } else if (arg == "--chunk") {
+            chunk = std::max(1, std::atoi(value().c_str()));
+        } else if (arg == "-h" || arg == "--help") {
+            usage();
+            return 0;
+        } else {
+            inputs.push_back(arg);
+        }
+    }
+    if (config.detModelPath.empty() || config.recModelPath.empty() || config.clsModelPath.empty() ||
+        inputs.empty()) {
+        usage();
+        return 2;
+    }
+
+    std::vector<std::string> files;
+    for (const std::string& input : inputs) {
+        std::error_code ec;
+        if (fs::is_directory(input, ec)) {
+            for (const fs::directory_entry& entry : fs::recursive_directory_iterator(input, ec)) {
+                if (entry.is_regular_file() && isImageFile(entry.path())) files.push_back(entry.path().string());
+            }
+        } else {
+            files.push_back(input);
+        }
+    }
+    std::sort(files.begin(), files.end());
+
+    try {
+        // The runner shares the engine's pool; --workers counts the caller
+        if (workers > 0) config.workers = workers - 1;
+        ocr::Engine engine(config);
+        ocr::BatchRunner runner(engine);
+        std::fprintf(stderr, "Processing %zu images with %d workers\n", files.size(), runner.workers());
+
+        auto start = std::chrono::steady_clock::now();
+        size_t failed = 0;
+        // Chunks bound the number of decoded images held in memory
+        for (size_t begin = 0; begin < files.size(); begin += chunk) {
+            size_t end = std::min(files.size(), begin + chunk);
+            std::vector<ocr::BatchInput> batch(end - begin);
+            for (size_t k = begin; k < end; ++k) batch[k - begin].path = files[k];
+            for (const ocr::BatchResult& result : runner.run(batch)) {
+                if (!result.error.empty()) ++failed;
+                std::cout << ocr::toJsonLine(result) << '\n';
+            }
+            std::cout.flush();
+        }
+        double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        std::fprintf(stderr, "Done: %zu images, %zu failed, %.2f s (%.1f images/s)\n", files.size(), failed,
+                     seconds, seconds > 0 ? files.size() / seconds : 0.0);
+        return failed == files.size() && !files.empty() ? 1 : 0;
+    } catch (const std::exception& e) {
+        std::fprintf(stderr, "ocr_batch: %s\n", e.what());
+        return 1;
+    }
+}
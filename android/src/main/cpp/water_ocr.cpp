@@ -0,0 +1,292 @@
+#include "water_ocr.h"
+
+#include <algorithm>
+#include <cstring>
+#include <exception>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "image_enhance.h"
+#include "ocr_engine.h"
+#include "ocr_log.h"
+#include "ocr_trace.h"
+#include "pixel_convert.h"
+
+static_assert(WATER_OCR_FORMAT_NV21 == static_cast<int>(ocr::PixelFormat::Nv21) &&
+                  WATER_OCR_FORMAT_I420 == static_cast<int>(ocr::PixelFormat::I420) &&
+                  WATER_OCR_FORMAT_NV12 == static_cast<int>(ocr::PixelFormat::Nv12),
+              "C formats follow ocr::PixelFormat");
+static_assert(WATER_OCR_QUALITY_LOW_CONTRAST == static_cast<int>(ocr::QualityIssue::LowContrast),
+              "C quality codes follow ocr::QualityIssue");
+
+struct WaterOcrEngine {
+    std::unique_ptr<ocr::Engine> engine;
+};
+
+namespace {
+
+thread_local std::string lastError;
+
+int32_t fail(int32_t code, const std::string& message) {
+    lastError = message;
+    LOGE("%s", message.c_str());
+    return code;
+}
+
+// The caller's frame as an ImageView: 0, or the error code with the error set
+int32_t viewOf(int32_t format, int32_t width, int32_t height, const void* const* planes, const int* strides,
+               ocr::ImageView& view) {
+    if (format < WATER_OCR_FORMAT_RGBA_8888 || format > WATER_OCR_FORMAT_NV12) {
+        return fail(WATER_OCR_ERROR_IMAGE, "Unknown pixel format " + std::to_string(format));
+    }
+    view = ocr::ImageView::fromPlanes(static_cast<ocr::PixelFormat>(format), planes, strides, width, height);
+    if (!view.valid()) return fail(WATER_OCR_ERROR_IMAGE, "Image planes do not match its format and size");
+    return 0;
+}
+
+// Grey and YUV frames start with a plane of luma
+bool hasLumaPlane(const ocr::ImageView& view) {
+    return view.format == ocr::PixelFormat::A8 || view.format == ocr::PixelFormat::Nv21 ||
+           view.format == ocr::PixelFormat::I420 || view.format == ocr::PixelFormat::Nv12;
+}
+
+// Luma plane of the frame: the caller's own when it has one, otherwise
+// converted into `storage`
+const uint8_t* lumaPlane(const ocr::ImageView& view, std::vector<uint8_t>& storage, int& stride) {
+    if (hasLumaPlane(view)) {
+        stride = view.strides[0];
+        return view.planes[0];
+    }
+    storage.resize(static_cast<size_t>(view.width) * view.height);
+    ocr::convertToLuma(view, storage.data(), view.width);
+    stride = view.width;
+    return storage.data();
+}
+
+void writeReading(const ocr::MeterCandidate& c, WaterOcrReading& out) {
+    const size_t length = std::min(c.recognition.text.size(), sizeof(out.text) - 1);
+    std::memcpy(out.text, c.recognition.text.data(), length);
+    out.text[length] = '\0';
+    out.fraction_digits = c.recognition.fractionDigits;
+    out.confidence = c.recognition.confidence;
+    out.score = c.score;
+    std::copy(c.quad.begin(), c.quad.end(), out.quad);
+}
+
+} // namespace
+
+extern "C" {
+
+WaterOcrEngine* water_ocr_create(const char* det_model, const char* cls_model, const char* rec_model,
+                                 const char* const* options, int32_t option_count) {
+    lastError.clear();
+    ocr::EngineConfig config;
+    config.detModelPath = det_model ? det_model : "";
+    config.clsModelPath = cls_model ? cls_model : "";
+    config.recModelPath = rec_model ? rec_model : "";
+    for (int32_t i = 0; options && i < option_count; ++i) {
+        if (options[i] && !config.applyOption(options[i])) {
+            LOGW("Ignoring unknown OCR option: %s", options[i]);
+        }
+    }
+
+    try {
+        std::unique_ptr<WaterOcrEngine> handle(new WaterOcrEngine());
+        handle->engine.reset(new ocr::Engine(config));
+        return handle.release();
+    } catch (const std::exception& e) {
+        fail(WATER_OCR_ERROR_ENGINE, std::string("Failed to initialize OCR: ") + e.what());
+        return nullptr;
+    }
+}
+
+void water_ocr_destroy(WaterOcrEngine* engine) {
+    delete engine;
+}
+
+double water_ocr_warm_up(WaterOcrEngine* engine) {
+    lastError.clear();
+    if (!engine) return fail(WATER_OCR_ERROR_ARGUMENT, "No engine");
+    try {
+        return engine->engine->warmUp().totalMs;
+    } catch (const std::exception& e) {
+        return fail(WATER_OCR_ERROR_ENGINE, std::string("Error in water_ocr_warm_up: ") + e.what());
+    }
+}
+
+int32_t water_ocr_detect(WaterOcrEngine* engine, int32_t format, int32_t width, int32_t height, const uint8_t* plane0,
+                         int32_t stride0, const uint8_t* plane1, int32_t stride1, const uint8_t* plane2,
+                         int32_t stride2, float* quads, int32_t capacity) {
+    lastError.clear();
+    if (!engine || capacity < 0 || (capacity > 0 && !quads)) {
+        return fail(WATER_OCR_ERROR_ARGUMENT, "No engine or output");
+    }
+    const void* planes[3] = {plane0, plane1, plane2};
+    const int strides[3] = {stride0, stride1, stride2};
+    ocr::ImageView view;
+    if (const int32_t error = viewOf(format, width, height, planes, strides, view)) return error;
+    OCR_TRACE_SCOPE("water_ocr_detect", "capi");
+
+    try {
+        const ocr::QuadSet dets = engine->engine->detect(view);
+        const size_t count = std::min(dets.size(), static_cast<size_t>(capacity));
+        for (size_t i = 0; i < count; ++i) {
+            dets.corners(i, quads + i * 9);
+            quads[i * 9 + 8] = dets.score(i);
+        }
+        return static_cast<int32_t>(dets.size());
+    } catch (const std::exception& e) {
+        return fail(WATER_OCR_ERROR_ENGINE, std::string("Error in water_ocr_detect: ") + e.what());
+    }
+}
+
+int32_t water_ocr_read_meter(WaterOcrEngine* engine, int32_t format, int32_t width, int32_t height,
+                             const uint8_t* plane0, int32_t stride0, const uint8_t* plane1, int32_t stride1,
+                             const uint8_t* plane2, int32_t stride2, double last_value, double max_increase,
+                             WaterOcrReading* readings, int32_t capacity) {
+    lastError.clear();
+    if (!engine || capacity < 0 || (capacity > 0 && !readings)) {
+        return fail(WATER_OCR_ERROR_ARGUMENT, "No engine or output");
+    }
+    const void* planes[3] = {plane0, plane1, plane2};
+    const int strides[3] = {stride0, stride1, stride2};
+    ocr::ImageView view;
+    if (const int32_t error = viewOf(format, width, height, planes, strides, view)) return error;
+    OCR_TRACE_SCOPE("water_ocr_read_meter", "capi");
+
+    try {
+        ocr::ReadingPrior prior;
+        prior.lastValue = last_value;
+        prior.maxIncrease = max_increase;
+        const std::vector<ocr::MeterCandidate> candidates = engine->engine->readMeter(view, prior);
+        const size_t count = std::min(candidates.size(), static_cast<size_t>(capacity));
+        for (size_t i = 0; i < count; ++i) writeReading(candidates[i], readings[i]);
+        return static_cast<int32_t>(count);
+    } catch (const std::exception& e) {
+        return fail(WATER_OCR_ERROR_ENGINE, std::string("Error in water_ocr_read_meter: ") + e.what());
+    }
+}
+
+int32_t water_ocr_read_burst(WaterOcrEngine* engine, const WaterOcrFrame* frames, int32_t frame_count,
+                             double last_value, double max_increase, WaterOcrReading* readings,
+                             int32_t* frames_read, int32_t capacity) {
+    lastError.clear();
+    if (!engine || frame_count < 0 || (frame_count > 0 && !frames) || capacity < 0 ||
+        (capacity > 0 && !readings)) {
+        return fail(WATER_OCR_ERROR_ARGUMENT, "No engine, frames or output");
+    }
+    std::vector<ocr::ImageView> views(frame_count);
+    for (int32_t i = 0; i < frame_count; ++i) {
+        const WaterOcrFrame& frame = frames[i];
+        const void* planes[3] = {frame.planes[0], frame.planes[1], frame.planes[2]};
+        const int strides[3] = {frame.strides[0], frame.strides[1], frame.strides[2]};
+        if (const int32_t error = viewOf(frame.format, frame.width, frame.height, planes, strides, views[i])) {
+            return error;
+        }
+    }
+    OCR_TRACE_SCOPE("water_ocr_read_burst", "capi");
+
+    try {
+        ocr::ReadingPrior prior;
+        prior.lastValue = last_value;
+        prior.maxIncrease = max_increase;
+        const ocr::BurstReading burst = engine->engine->readBurst(views, prior);
+        const size_t count = std::min(burst.candidates.size(), static_cast<size_t>(capacity));
+        for (size_t i = 0; i < count; ++i) {
+            writeReading(burst.candidates[i], readings[i]);
+            if (frames_read) frames_read[i] = burst.frames[i];
+        }
+        return static_cast<int32_t>(count);
+    } catch (const std::exception& e) {
+        return fail(WATER_OCR_ERROR_ENGINE, std::string("Error in water_ocr_read_burst: ") + e.what());
+    }
+}
+
+int32_t water_ocr_check_frame(WaterOcrEngine* engine, int32_t format, int32_t width, int32_t height,
+                              const uint8_t* plane0, int32_t stride0, const uint8_t* plane1, int32_t stride1,
+                              const uint8_t* plane2, int32_t stride2, WaterOcrQuality* quality) {
+    lastError.clear();
+    const void* planes[3] = {plane0, plane1, plane2};
+    const int strides[3] = {stride0, stride1, stride2};
+    ocr::ImageView view;
+    if (const int32_t error = viewOf(format, width, height, planes, strides, view)) return error;
+
+    try {
+        const ocr::FrameQuality measured =
+            engine ? engine->engine->checkQuality(view) : ocr::assessQuality(view, ocr::QualityParams());
+        if (quality) {
+            quality->sharpness = measured.sharpness;
+            quality->clipped = measured.clipped;
+            quality->mean = measured.mean;
+            quality->spread = measured.spread;
+        }
+        return static_cast<int32_t>(measured.issue);
+    } catch (const std::exception& e) {
+        return fail(WATER_OCR_ERROR_ENGINE, std::string("Error in water_ocr_check_frame: ") + e.what());
+    }
+}
+
+int32_t water_ocr_sauvola(int32_t format, int32_t width, int32_t height, const uint8_t* plane0, int32_t stride0,
+                          const uint8_t* plane1, int32_t stride1, const uint8_t* plane2, int32_t stride2,
+                          int32_t radius, float k, uint8_t* dst, int32_t dst_stride) {
+    lastError.clear();
+    if (!dst || dst_stride < width || radius <= 0) return fail(WATER_OCR_ERROR_ARGUMENT, "Bad output or radius");
+    const void* planes[3] = {plane0, plane1, plane2};
+    const int strides[3] = {stride0, stride1, stride2};
+    ocr::ImageView view;
+    if (const int32_t error = viewOf(format, width, height, planes, strides, view)) return error;
+    OCR_TRACE_SCOPE("water_ocr_sauvola", "capi");
+
+    try {
+        std::vector<uint8_t> storage;
+        int stride = 0;
+        const uint8_t* luma = lumaPlane(view, storage, stride);
+        ocr::SauvolaParams params;
+        params.radius = radius;
+        params.k = k;
+        ocr::sauvolaThreshold(luma, width, height, stride, dst, dst_stride, params);
+        return 0;
+    } catch (const std::exception& e) {
+        return fail(WATER_OCR_ERROR_ENGINE, std::string("Error in water_ocr_sauvola: ") + e.what());
+    }
+}
+
+int32_t water_ocr_clahe(int32_t format, int32_t width, int32_t height, const uint8_t* plane0, int32_t stride0,
+                        const uint8_t* plane1, int32_t stride1, const uint8_t* plane2, int32_t stride2,
+                        int32_t tiles, float clip_limit, uint8_t* dst, int32_t dst_stride) {
+    lastError.clear();
+    if (!dst || dst_stride < width || tiles <= 0) return fail(WATER_OCR_ERROR_ARGUMENT, "Bad output or tile count");
+    const void* planes[3] = {plane0, plane1, plane2};
+    const int strides[3] = {stride0, stride1, stride2};
+    ocr::ImageView view;
+    if (const int32_t error = viewOf(format, width, height, planes, strides, view)) return error;
+    OCR_TRACE_SCOPE("water_ocr_clahe", "capi");
+
+    try {
+        // Colour frames convert straight into dst, which is then equalized in place
+        const uint8_t* luma = nullptr;
+        int stride = 0;
+        if (hasLumaPlane(view)) {
+            luma = view.planes[0];
+            stride = view.strides[0];
+        } else {
+            ocr::convertToLuma(view, dst, dst_stride);
+            luma = dst;
+            stride = dst_stride;
+        }
+        ocr::ClaheParams params;
+        params.tilesX = params.tilesY = tiles;
+        params.clipLimit = clip_limit;
+        ocr::equalizeClahe(luma, width, height, stride, dst, dst_stride, params);
+        return 0;
+    } catch (const std::exception& e) {
+        return fail(WATER_OCR_ERROR_ENGINE, std::string("Error in water_ocr_clahe: ") + e.what());
+    }
+}
+
+const char* water_ocr_last_error(void) {
+    return lastError.c_str();
+}
+
+} // extern "C"
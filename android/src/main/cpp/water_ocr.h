@@ -0,0 +1,164 @@
+#ifndef WATER_OCR_H
+#define WATER_OCR_H
+
+// Plain C entry points into the OCR engine, for callers that hold frames as
+// raw memory: Dart through dart:ffi, Kotlin through direct ByteBuffers, or
+// any other host language. Pixels are read in place and never copied or
+// written to disk; they only need to stay valid for the duration of a call.
+//
+// Functions returning int32_t report failures as a negative WATER_OCR_ERROR_*
+// code, with a description from water_ocr_last_error() on the same thread.
+// An engine may be used from several threads at once.
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#if defined(_WIN32)
+#define WATER_OCR_API __declspec(dllexport)
+#else
+#define WATER_OCR_API __attribute__((visibility("default")))
+#endif
+
+typedef struct WaterOcrEngine WaterOcrEngine;
+
+// Memory layouts, in the order of ocr::PixelFormat.
+enum {
+    WATER_OCR_FORMAT_RGBA_8888 = 0,  // R, G, B, A bytes
+    WATER_OCR_FORMAT_RGB_565 = 1,    // 16-bit native-endian words
+    WATER_OCR_FORMAT_A_8 = 2,        // one grey byte per pixel
+    WATER_OCR_FORMAT_RGBA_F16 = 3,   // four half floats per pixel
+    WATER_OCR_FORMAT_NV21 = 4,       // Y plane, then interleaved V/U
+    WATER_OCR_FORMAT_I420 = 5,       // Y, U and V planes
+    WATER_OCR_FORMAT_NV12 = 6,       // Y plane, then interleaved U/V
+};
+
+enum {
+    WATER_OCR_ERROR_ARGUMENT = -1,  // null engine or output, negative capacity
+    WATER_OCR_ERROR_IMAGE = -2,     // unknown format, missing plane or short stride
+    WATER_OCR_ERROR_ENGINE = -3,    // the engine failed while running
+};
+
+// Why water_ocr_check_frame() turned a frame down; 0 for a usable frame.
+enum {
+    WATER_OCR_QUALITY_OK = 0,
+    WATER_OCR_QUALITY_BLUR = 1,
+    WATER_OCR_QUALITY_GLARE = 2,         // clipped highlights, e.g. flash on the glass
+    WATER_OCR_QUALITY_DARK = 3,
+    WATER_OCR_QUALITY_LOW_CONTRAST = 4,
+};
+
+// Measurements behind the verdict, on a luma thumbnail of the frame.
+typedef struct WaterOcrQuality {
+    float sharpness;  // variance of the Laplacian
+    float clipped;    // fraction of clipped highlights
+    float mean;       // mean luma, 0..255
+    float spread;     // 5th to 95th percentile luma
+} WaterOcrQuality;
+
+// One meter reading candidate. The last fraction_digits of text are decimals;
+// quad holds x, y of four corners clockwise from the top-left.
+typedef struct WaterOcrReading {
+    char text[64];
+    int32_t fraction_digits;
+    float confidence;
+    float score;
+    float quad[8];
+} WaterOcrReading;
+
+// One frame of a burst. Unlike single frames, bursts are described in memory,
+// so their planes must be native memory that stays put for the call.
+typedef struct WaterOcrFrame {
+    int32_t format;
+    int32_t width;
+    int32_t height;
+    const uint8_t* planes[3];
+    int32_t strides[3];
+} WaterOcrFrame;
+
+// Loads the models and applies "key=value" options (see the README). Returns
+// null on failure.
+WATER_OCR_API WaterOcrEngine* water_ocr_create(const char* det_model, const char* cls_model, const char* rec_model,
+                                               const char* const* options, int32_t option_count);
+
+// Frees the engine; null is ignored.
+WATER_OCR_API void water_ocr_destroy(WaterOcrEngine* engine);
+
+// Runs every model once so the first frame is not slow. Returns the time it
+// took in milliseconds, or a negative error code.
+WATER_OCR_API double water_ocr_warm_up(WaterOcrEngine* engine);
+
+// Frames are passed as a format, a size and three planes with their row
+// strides in bytes; planes the format does not use may be null. They are
+// plain arguments rather than a struct so that bindings can hand over memory
+// that is only pinned for the call, like TypedData.address in dart:ffi leaf
+// calls.
+
+// Detects text quads, writing up to `capacity` of them as nine floats each
+// (the corners, then the score) to `quads`. Returns the number found, which
+// may exceed `capacity`.
+WATER_OCR_API int32_t water_ocr_detect(WaterOcrEngine* engine, int32_t format, int32_t width, int32_t height,
+                                       const uint8_t* plane0, int32_t stride0, const uint8_t* plane1,
+                                       int32_t stride1, const uint8_t* plane2, int32_t stride2, float* quads,
+                                       int32_t capacity);
+
+// Reads the meter: up to `capacity` candidates, best first, into `readings`.
+// A non-negative last_value is the previous reading of this meter, and a
+// positive max_increase how far it can plausibly have moved since. Returns
+// the number of candidates written. With the quality_gate option, a frame
+// water_ocr_check_frame() would reject yields 0 candidates without running
+// the models.
+WATER_OCR_API int32_t water_ocr_read_meter(WaterOcrEngine* engine, int32_t format, int32_t width, int32_t height,
+                                           const uint8_t* plane0, int32_t stride0, const uint8_t* plane1,
+                                           int32_t stride1, const uint8_t* plane2, int32_t stride2,
+                                           double last_value, double max_increase, WaterOcrReading* readings,
+                                           int32_t capacity);
+
+// Reads several shots of the same meter: scores every frame in the meter ROI,
+// runs the models on the burst_top_k best and, with burst_fuse, puts their
+// fused reading first. Candidates are written as for water_ocr_read_meter();
+// `frames_read`, if not null, receives the frame index of each. Returns the
+// number of candidates written.
+WATER_OCR_API int32_t water_ocr_read_burst(WaterOcrEngine* engine, const WaterOcrFrame* frames, int32_t frame_count,
+                                           double last_value, double max_increase, WaterOcrReading* readings,
+                                           int32_t* frames_read, int32_t capacity);
+
+// Measures blur and exposure in well under a millisecond, so a stream can
+// skip frames not worth reading. Thresholds are the engine's quality_*
+// options, or the defaults for a null engine. Returns a WATER_OCR_QUALITY_*
+// code, or a negative error code; `quality` may be null.
+WATER_OCR_API int32_t water_ocr_check_frame(WaterOcrEngine* engine, int32_t format, int32_t width, int32_t height,
+                                            const uint8_t* plane0, int32_t stride0, const uint8_t* plane1,
+                                            int32_t stride1, const uint8_t* plane2, int32_t stride2,
+                                            WaterOcrQuality* quality);
+
+// Image filters for callers that preprocess frames themselves; they need no
+// engine. Both read the frame's luma (the Y plane of YUV frames as is) and
+// write width x height bytes to `dst`, rows dst_stride apart. Returns 0 or a
+// negative error code.
+
+// Local Sauvola binarization over (2 * radius + 1)^2 windows, radius at most
+// 127: 0 where the frame is darker than its surroundings by the factor k
+// (0.2 is typical), 255 elsewhere. `dst` must not overlap the frame.
+WATER_OCR_API int32_t water_ocr_sauvola(int32_t format, int32_t width, int32_t height, const uint8_t* plane0,
+                                        int32_t stride0, const uint8_t* plane1, int32_t stride1,
+                                        const uint8_t* plane2, int32_t stride2, int32_t radius, float k,
+                                        uint8_t* dst, int32_t dst_stride);
+
+// CLAHE on tiles x tiles tiles, histogram bins capped at clip_limit times
+// their mean (0 for plain tiled equalization). `dst` may be the Y plane.
+WATER_OCR_API int32_t water_ocr_clahe(int32_t format, int32_t width, int32_t height, const uint8_t* plane0,
+                                      int32_t stride0, const uint8_t* plane1, int32_t stride1, const uint8_t* plane2,
+                                      int32_t stride2, int32_t tiles, float clip_limit, uint8_t* dst,
+                                      int32_t dst_stride);
+
+// Description of the last failure on this thread, empty if there was none.
+WATER_OCR_API const char* water_ocr_last_error(void);
+
+#ifdef __cplusplus
+} // extern "C"
+#endif
+
+#endif // WATER_OCR_H
@@ -0,0 +1,140 @@
+package com.example.water_meter_sdk
+
+import android.content.Context
+import android.graphics.Bitmap
+import android.graphics.BitmapFactory
+import android.media.ExifInterface
+import android.os.Process
+import android.util.Log
+import java.io.IOException
+import java.util.concurrent.ArrayBlockingQueue
+import java.util.concurrent.RejectedExecutionException
+import java.util.concurrent.SynchronousQueue
+import java.util.concurrent.ThreadFactory
+import java.util.concurrent.ThreadPoolExecutor
+import java.util.concurrent.TimeUnit
+import java.util.concurrent.atomic.AtomicInteger
+
+/**
+ * Process-wide home of the native engine for the Flutter plugin: one warm
+ * [WaterMeterProcessor], created on first use and kept across calls and
+ * plugin instances so back-to-back frames reuse its loaded sessions, plus a
+ * bounded executor the work runs on so the platform thread never waits for
+ * a decode or an inference.
+ *
+ * At most `maxConcurrency` frames run at once and `queueDepth` more wait;
+ * beyond that [submit] refuses the work instead of piling up stale frames.
+ */
+object NativeMeterService {
+    private const val TAG = "NativeMeterService"
+
+    // Frames are decoded no smaller than this; the processor works at 640 wide
+    private const val DECODE_MIN_WIDTH = 1280
+
+    // Guards the executor; held only briefly, the platform thread takes it
+    private val lock = Any()
+    // Guards creating and releasing the processor, which takes model-loading time
+    private val processorLock = Any()
+    private var executor: ThreadPoolExecutor = newExecutor(1, 2)
+    @Volatile
+    private var options: Map<String, String> = emptyMap()
+    @Volatile
+    private var processor: WaterMeterProcessor? = null
+
+    /**
+     * Replace the executor limits and the engine options. Work already queued
+     * finishes on the old executor; changed options release the processor so
+     * the next call initializes it with them.
+     */
+    fun configure(maxConcurrency: Int, queueDepth: Int, engineOptions: Map<String, String>) {
+        require(maxConcurrency > 0 && queueDepth >= 0) { "Invalid executor limits" }
+        synchronized(lock) {
+            executor.shutdown()
+            executor = newExecutor(maxConcurrency, queueDepth)
+            if (engineOptions != options) {
+                options = engineOptions
+                // Disposal waits for calls in flight, so keep it off the caller
+                executor.execute {
+                    val stale = synchronized(processorLock) { processor.also { processor = null } }
+                    stale?.dispose()
+                }
+            }
+        }
+    }
+
+    /**
+     * Run [task] on the executor. Returns false, without running it, when the
+     * queue is full.
+     */
+    fun submit(task: Runnable): Boolean {
+        return try {
+            synchronized(lock) { executor.execute(task) }
+            true
+        } catch (e: RejectedExecutionException) {
+            Log.w(TAG, "OCR queue full, rejecting frame")
+            false
+        }
+    }
+
+    /** The warm processor, initializing it on first use. Call from the executor. */
+    fun processor(context: Context): WaterMeterProcessor {
+        processor?.let { return it }
+        synchronized(processorLock) {
+            processor?.let { return it }
+            val created = WaterMeterProcessor(context.applicationContext, options)
+            created.initialize()
+            processor = created
+            return created
+        }
+    }
+
+    /**
+     * Decode [path] no larger than the pipeline needs: a sample size that
+     * keeps the width at or above [DECODE_MIN_WIDTH] skips most of a
+     * full-resolution JPEG decode.
+     */
+    fun decodeForOcr(path: String): Bitmap? {
+        val bounds = BitmapFactory.Options().apply { inJustDecodeBounds = true }
+        BitmapFactory.decodeFile(path, bounds)
+        if (bounds.outWidth <= 0 || bounds.outHeight <= 0) return null
+        var sampleSize = 1
+        while (bounds.outWidth / (sampleSize * 2) >= DECODE_MIN_WIDTH) sampleSize *= 2
+        return BitmapFactory.decodeFile(path, BitmapFactory.Options().apply { inSampleSize = sampleSize })
+    }
+
+    /**
+     * EXIF orientation of [path], an `ExifInterface.ORIENTATION_*` value.
+     * BitmapFactory ignores it, so the pixels of [decodeForOcr] are as
+     * stored; [WaterMeterProcessor.processImage] turns them upright while it
+     * scales.
+     */
+    fun exifOrientation(path: String): Int = try {
+        ExifInterface(path).getAttributeInt(ExifInterface.TAG_ORIENTATION, ExifInterface.ORIENTATION_NORMAL)
+    } catch (e: IOException) {
+        ExifInterface.ORIENTATION_NORMAL
+    }
+
+    /** Clockwise rotation that shows an [orientation] upright, mirroring aside. */
+    fun rotationDegrees(orientation: Int): Int = when (orientation) {
+        ExifInterface.ORIENTATION_ROTATE_90, ExifInterface.ORIENTATION_TRANSPOSE -> 90
+        ExifInterface.ORIENTATION_ROTATE_180, ExifInterface.ORIENTATION_FLIP_VERTICAL -> 180
+        ExifInterface.ORIENTATION_ROTATE_270, ExifInterface.ORIENTATION_TRANSVERSE -> 270
+        else -> 0
+    }
+
+    private fun newExecutor(maxConcurrency: Int, queueDepth: Int): ThreadPoolExecutor {
+        val count = AtomicInteger()
+        val factory = ThreadFactory { runnable ->
+            Thread({
+                Process.setThreadPriority(Process.THREAD_PRIORITY_BACKGROUND)
+                runnable.run()
+            }, "water-meter-ocr-${count.incrementAndGet()}")
+        }
+        // A SynchronousQueue stands in for a depth of 0: hand-off or reject
+        val queue = if (queueDepth > 0) ArrayBlockingQueue<Runnable>(queueDepth) else SynchronousQueue<Runnable>()
+        return ThreadPoolExecutor(maxConcurrency, maxConcurrency, 30, TimeUnit.SECONDS, queue, factory).apply {
+            // Idle workers exit; the processor and its sessions stay warm
+            allowCoreThreadTimeOut(true)
+        }
+    }
+}
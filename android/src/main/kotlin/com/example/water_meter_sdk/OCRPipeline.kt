@@ -7,26 +7,65 @@ import android.util.Log
 import java.io.File
 import java.io.FileOutputStream
 import java.io.InputStream
+import java.nio.ByteBuffer
+import java.util.concurrent.locks.ReentrantReadWriteLock
+import kotlin.concurrent.read
+import kotlin.concurrent.write
 
 /**
  * OCR Pipeline using PaddleOCR models
  * Handles text detection and recognition
+ *
+ * [options] are passed to the native engine as "key=value" pairs, e.g.
+ * `"trace" to "/sdcard/Download/ocr_trace.json"` records a Chrome/Perfetto
+ * trace (merged with ONNX Runtime's profile) that is written on [dispose].
+ *
+ * A single instance may be shared by several threads: the native engine keeps
+ * one copy of each model and gives every concurrent call its own scratch
+ * buffers. [initialize] and [dispose] wait for calls in flight to finish.
  */
-class OCRPipeline(private val context: Context) {
+class OCRPipeline(
+    private val context: Context,
+    private val options: Map<String, String> = emptyMap()
+) {
     private val TAG = "OCRPipeline"
     
     // Model file names
     private val DET_MODEL_NAME = "ch_ppocr_mobile_v2.0_det_slim_opt.nb"
     private val CLS_MODEL_NAME = "ch_ppocr_mobile_v2.0_cls_slim_opt.nb"
     private val REC_MODEL_NAME = "ch_ppocr_mobile_v2.0_rec_slim_opt.nb"
+    // Character list of the rec model, which native builds add to the
+    // assets; the engine refuses a rec model whose classes do not match its
+    // dictionary (digits only without this asset)
+    private val DICT_NAME = "ppocr_keys_v1.txt"
     
     // Native OCR interface - you'll need to implement JNI bindings
+    @Volatile
     private var nativeHandle: Long = 0
+
+    // Readers are native calls using the handle, the writer creates or frees it
+    private val handleLock = ReentrantReadWriteLock()
     
     // Native method bindings
-    private external fun nativeInit(detModelPath: String, clsModelPath: String, recModelPath: String): Long
+    private external fun nativeInit(detModelPath: String, clsModelPath: String, recModelPath: String, options: Array<String>): Long
     private external fun nativeDetectText(handle: Long, bitmap: Bitmap): Array<FloatArray>?
-    private external fun nativeRecognizeText(handle: Long, bitmap: Bitmap): String?
+    private external fun nativeRecognizeRegions(handle: Long, bitmap: Bitmap, rects: IntArray): Array<String?>?
+    private external fun nativeRecognizeQuads(handle: Long, bitmap: Bitmap, quads: FloatArray): Array<String?>?
+    private external fun nativeReadMeter(
+        handle: Long, bitmap: Bitmap, lastValue: Double, maxIncrease: Double
+    ): Array<MeterCandidate>?
+    private external fun nativeReadMeterBuffers(
+        handle: Long, planes: Array<ByteBuffer?>, strides: IntArray, format: Int, width: Int, height: Int,
+        lastValue: Double, maxIncrease: Double
+    ): Array<MeterCandidate>?
+    private external fun nativeReadBurstBuffers(
+        handle: Long, planes: Array<Array<ByteBuffer?>>, strides: Array<IntArray>, formats: IntArray,
+        widths: IntArray, heights: IntArray, lastValue: Double, maxIncrease: Double
+    ): BurstReading?
+    private external fun nativeCheckFrameBuffers(
+        handle: Long, planes: Array<ByteBuffer?>, strides: IntArray, format: Int, width: Int, height: Int
+    ): FloatArray?
+    private external fun nativeWarmUp(handle: Long, async: Boolean): Double
     private external fun nativeDispose(handle: Long)
     
     companion object {
@@ -42,7 +81,7 @@ class OCRPipeline(private val context: Context) {
     /**
      * Initialize OCR pipeline with PaddleOCR models
      */
-    fun initialize() {
+    fun initialize() = handleLock.write {
         try {
             Log.d(TAG, "Initializing OCR Pipeline...")
             
@@ -52,7 +91,13 @@ class OCRPipeline(private val context: Context) {
             val recModelPath = copyAssetToFile(REC_MODEL_NAME)
             
             // Initialize native OCR (JNI)
-            nativeHandle = nativeInit(detModelPath, clsModelPath, recModelPath)
+            val withDict = if ("dict" !in options && context.assets.list("")?.contains(DICT_NAME) == true) {
+                options + ("dict" to copyAssetToFile(DICT_NAME))
+            } else {
+                options
+            }
+            val nativeOptions = withDict.map { (key, value) -> "$key=$value" }.toTypedArray()
+            nativeHandle = nativeInit(detModelPath, clsModelPath, recModelPath, nativeOptions)
             
             if (nativeHandle == 0L) {
                 throw RuntimeException("Failed to initialize native OCR")
@@ -68,10 +113,10 @@ class OCRPipeline(private val context: Context) {
     /**
      * Detect text regions in image using real implementation
      */
-    fun detectText(bitmap: Bitmap): List<TextDetection> {
+    fun detectText(bitmap: Bitmap): List<TextDetection> = handleLock.read {
         if (nativeHandle == 0L) {
             Log.e(TAG, "OCR not initialized")
-            return emptyList()
+            return@read emptyList()
         }
         
         try {
@@ -111,39 +156,75 @@ class OCRPipeline(private val context: Context) {
             }
             
             Log.d(TAG, "Detected ${detections.size} text regions using real implementation")
-            return detections
+            detections
         } catch (e: Exception) {
             Log.e(TAG, "Error detecting text", e)
-            return emptyList()
+            emptyList()
         }
     }
     
     /**
-     * Recognize text in specific region using real implementation
+     * Recognize text in specific region. The region is sampled natively from
+     * the bitmap's own pixels; no cropped Bitmap is created.
      */
     fun recognizeText(bitmap: Bitmap, region: Rect): String? {
+        val recognizedText = recognizeRegions(bitmap, listOf(region)).firstOrNull()
+        Log.d(TAG, "Recognized text: $recognizedText")
+        return recognizedText
+    }
+    
+    /**
+     * Recognize text in several regions of the same bitmap in one native call.
+     * Regions are sampled straight from the bitmap's pixels, orientation-checked
+     * and recognized in parallel on the engine's task scheduler; results are in
+     * region order, null for a region that produced nothing.
+     */
+    fun recognizeRegions(bitmap: Bitmap, regions: List<Rect>): List<String?> = handleLock.read {
         if (nativeHandle == 0L) {
             Log.e(TAG, "OCR not initialized")
-            return null
+            return@read List(regions.size) { null }
         }
-        
+        if (regions.isEmpty()) return@read emptyList()
+
         try {
-            // Crop bitmap to region
-            val croppedBitmap = cropBitmap(bitmap, region)
-            
-            // Use actual PaddleOCR recognition
-            // This would call native PaddleOCR recognition method
-            val recognizedText = nativeRecognizeText(nativeHandle, croppedBitmap)
-            
-            Log.d(TAG, "Recognized text: $recognizedText")
-            return recognizedText
-            
+            val rects = IntArray(regions.size * 4)
+            regions.forEachIndexed { i, r ->
+                rects[i * 4] = r.left
+                rects[i * 4 + 1] = r.top
+                rects[i * 4 + 2] = r.right
+                rects[i * 4 + 3] = r.bottom
+            }
+            val texts = nativeRecognizeRegions(nativeHandle, bitmap, rects)
+            texts?.map { it?.ifEmpty { null } } ?: List(regions.size) { null }
         } catch (e: Exception) {
-            Log.e(TAG, "Error recognizing text", e)
-            return null
+            Log.e(TAG, "Error recognizing regions", e)
+            List(regions.size) { null }
         }
     }
-    
+
+    /**
+     * Like [recognizeRegions] for quadrilaterals, each given as x, y of four
+     * corners clockwise from the top-left. Quads are sampled along their
+     * edges, so rotated text reaches recognition level.
+     */
+    fun recognizeQuads(bitmap: Bitmap, quads: List<FloatArray>): List<String?> = handleLock.read {
+        if (nativeHandle == 0L) {
+            Log.e(TAG, "OCR not initialized")
+            return@read List(quads.size) { null }
+        }
+        if (quads.isEmpty()) return@read emptyList()
+
+        try {
+            val coords = FloatArray(quads.size * 8)
+            quads.forEachIndexed { i, quad -> quad.copyInto(coords, i * 8, 0, 8) }
+            val texts = nativeRecognizeQuads(nativeHandle, bitmap, coords)
+            texts?.map { it?.ifEmpty { null } } ?: List(quads.size) { null }
+        } catch (e: Exception) {
+            Log.e(TAG, "Error recognizing quads", e)
+            List(quads.size) { null }
+        }
+    }
+
     /**
      * Copy asset file to internal storage
      */
@@ -176,21 +257,136 @@ class OCRPipeline(private val context: Context) {
     }
     
     /**
-     * Crop bitmap to specific region
+     * Detect text, rank the regions as meter readings natively (aspect ratio,
+     * position in the meter ROI, detection score) and recognize only the top
+     * ones, so clutter on the dial costs no recognition time. Candidates are
+     * re-ranked with their digit count and recognition confidence and come
+     * back best first. Ranking is configured with the `rank_*` options.
+     *
+     * With the `rec_grammar` option the text is decoded as a reading of that
+     * meter type. [lastReading], the meter's last known value, then favours
+     * readings that did not go backwards nor rise by more than [maxIncrease]
+     * (0 for no limit).
      */
-    private fun cropBitmap(bitmap: Bitmap, region: Rect): Bitmap {
-        val x = maxOf(0, region.left)
-        val y = maxOf(0, region.top)
-        val width = minOf(bitmap.width - x, region.width())
-        val height = minOf(bitmap.height - y, region.height())
-        
-        return Bitmap.createBitmap(bitmap, x, y, width, height)
+    fun readMeter(
+        bitmap: Bitmap,
+        lastReading: Double? = null,
+        maxIncrease: Double = 0.0
+    ): List<MeterCandidate> = handleLock.read {
+        if (nativeHandle == 0L) {
+            Log.e(TAG, "OCR not initialized")
+            return@read emptyList()
+        }
+        try {
+            nativeReadMeter(nativeHandle, bitmap, lastReading ?: -1.0, maxIncrease)?.toList() ?: emptyList()
+        } catch (e: Exception) {
+            Log.e(TAG, "Error reading meter", e)
+            emptyList()
+        }
     }
-    
+
+    /**
+     * [readMeter] on a frame in direct buffers, e.g. a camera image or pixels
+     * shared with Dart: the native engine reads them in place, so the frame is
+     * never copied into a Bitmap.
+     */
+    fun readMeter(
+        frame: PixelFrame,
+        lastReading: Double? = null,
+        maxIncrease: Double = 0.0
+    ): List<MeterCandidate> = handleLock.read {
+        if (nativeHandle == 0L) {
+            Log.e(TAG, "OCR not initialized")
+            return@read emptyList()
+        }
+        try {
+            nativeReadMeterBuffers(
+                nativeHandle, frame.planes, frame.strides, frame.format, frame.width, frame.height,
+                lastReading ?: -1.0, maxIncrease
+            )?.toList() ?: emptyList()
+        } catch (e: Exception) {
+            Log.e(TAG, "Error reading meter", e)
+            emptyList()
+        }
+    }
+
+    /**
+     * [readMeter] on several shots of the same meter, e.g. a burst from the
+     * camera, at close to the cost of one: every frame is scored for
+     * sharpness and exposure in the meter ROI, the `burst_top_k` best are
+     * read, and with `burst_fuse` their readings are fused digit by digit
+     * into the first candidate. Null on failure.
+     */
+    fun readBurst(
+        frames: List<PixelFrame>,
+        lastReading: Double? = null,
+        maxIncrease: Double = 0.0
+    ): BurstReading? = handleLock.read {
+        if (nativeHandle == 0L) {
+            Log.e(TAG, "OCR not initialized")
+            return@read null
+        }
+        try {
+            nativeReadBurstBuffers(
+                nativeHandle,
+                Array(frames.size) { frames[it].planes },
+                Array(frames.size) { frames[it].strides },
+                IntArray(frames.size) { frames[it].format },
+                IntArray(frames.size) { frames[it].width },
+                IntArray(frames.size) { frames[it].height },
+                lastReading ?: -1.0, maxIncrease
+            )
+        } catch (e: Exception) {
+            Log.e(TAG, "Error reading burst", e)
+            null
+        }
+    }
+
+    /**
+     * Measure blur and exposure of [frame] on a small luma thumbnail, well
+     * under a millisecond, so a camera stream can skip frames not worth
+     * reading. Thresholds are the `quality_*` options; with `quality_gate`
+     * [readMeter] applies the same check itself. Null on failure.
+     */
+    fun checkFrame(frame: PixelFrame): FrameQuality? = handleLock.read {
+        if (nativeHandle == 0L) {
+            Log.e(TAG, "OCR not initialized")
+            return@read null
+        }
+        try {
+            nativeCheckFrameBuffers(
+                nativeHandle, frame.planes, frame.strides, frame.format, frame.width, frame.height
+            )?.let { FrameQuality(it[0].toInt(), it[1], it[2], it[3], it[4]) }
+        } catch (e: Exception) {
+            Log.e(TAG, "Error checking frame", e)
+            null
+        }
+    }
+
+    /**
+     * Run every model once on dummy inputs so the first real frame does not
+     * pay for lazy allocations and page faults. With [async] the warm-up runs
+     * on a native background thread (e.g. while the camera opens) and this
+     * returns null at once; otherwise returns the warm-up time in ms.
+     */
+    fun warmUp(async: Boolean = true): Double? = handleLock.read {
+        if (nativeHandle == 0L) {
+            Log.e(TAG, "OCR not initialized")
+            return@read null
+        }
+        val millis = nativeWarmUp(nativeHandle, async)
+        if (millis >= 0) {
+            Log.d(TAG, "Warm-up took $millis ms")
+            millis
+        } else {
+            null
+        }
+    }
+
     /**
      * Release resources
      */
-    fun dispose() {
+    fun dispose() = handleLock.write {
         if (nativeHandle != 0L) {
             nativeDispose(nativeHandle)
             nativeHandle = 0
@@ -205,24 +401,20 @@ class OCRPipeline(private val context: Context) {
         try {
             Log.d(TAG, "Processing image for water meter reading...")
             
-            // Step 1: Detect text regions
-            val detections = detectText(bitmap)
-            if (detections.isEmpty()) {
+            // Step 1: Detect, rank and recognize; the native side stops at the
+            // first region that reads as a meter and returns it first
+            val candidates = readMeter(bitmap)
+            if (candidates.isEmpty()) {
                 Log.d(TAG, "No text regions detected")
                 return null
             }
             
-            // Step 2: Recognize text in each detected region
-            val recognizedTexts = mutableListOf<String>()
-            for (detection in detections) {
-                val text = recognizeText(bitmap, detection.bounds)
-                if (!text.isNullOrEmpty()) {
-                    recognizedTexts.add(text)
-                }
+            // Step 2: Extract and format meter reading from the best candidate
+            // that yields one
+            for (candidate in candidates) {
+                extractMeterReading(listOf(candidate.text.dropLast(candidate.fractionDigits)))?.let { return it }
             }
-            
-            // Step 3: Extract and format meter reading
-            return extractMeterReading(recognizedTexts)
+            return null
             
         } catch (e: Exception) {
             Log.e(TAG, "Error processing image", e)
@@ -280,25 +472,78 @@ class OCRPipeline(private val context: Context) {
      * Recognize text in specific regions
      */
     fun recognizeTextInRegions(bitmap: Bitmap, regions: List<List<Double>>): List<String> {
-        val results = mutableListOf<String>()
-        
-        for (regionCoords in regions) {
-            if (regionCoords.size >= 8) {
-                // Convert coordinates to Rect
-                val minX = regionCoords.filterIndexed { index, _ -> index % 2 == 0 }.minOrNull()?.toInt() ?: 0
-                val maxX = regionCoords.filterIndexed { index, _ -> index % 2 == 0 }.maxOrNull()?.toInt() ?: bitmap.width
-                val minY = regionCoords.filterIndexed { index, _ -> index % 2 == 1 }.minOrNull()?.toInt() ?: 0
-                val maxY = regionCoords.filterIndexed { index, _ -> index % 2 == 1 }.maxOrNull()?.toInt() ?: bitmap.height
-                
-                val rect = Rect(minX, minY, maxX, maxY)
-                val text = recognizeText(bitmap, rect)
-                
-                if (!text.isNullOrEmpty()) {
-                    results.add(text)
-                }
-            }
+        // Polygons go to native as quads, so tilted regions are sampled level
+        val quads = regions.filter { it.size >= 8 }.map { coords ->
+            FloatArray(8) { coords[it].toFloat() }
         }
-        
-        return results
+        return recognizeQuads(bitmap, quads).filterNotNull()
+    }
+}
+
+/**
+ * A region [OCRPipeline.readMeter] recognized: raw [text] of which the last
+ * [fractionDigits] are decimals, its recognition [confidence], the overall
+ * ranking [score] and the detected [quad] (x, y of four corners clockwise from
+ * the top-left). Created from native code.
+ */
+class MeterCandidate(
+    val text: String,
+    val fractionDigits: Int,
+    val confidence: Float,
+    val score: Float,
+    val quad: FloatArray
+) {
+    val bounds: Rect
+        get() = Rect(
+            minOf(quad[0], quad[2], quad[4], quad[6]).toInt(),
+            minOf(quad[1], quad[3], quad[5], quad[7]).toInt(),
+            maxOf(quad[0], quad[2], quad[4], quad[6]).toInt(),
+            maxOf(quad[1], quad[3], quad[5], quad[7]).toInt()
+        )
+}
+
+/**
+ * Result of [OCRPipeline.readBurst]: the [candidates] of the frames read,
+ * best first, and the index of the frame each came from in [frames]. When
+ * [fused], the first candidate combines the readings of several frames. The
+ * [quality] of every frame is in input order. Created from native code.
+ */
+class BurstReading(
+    val candidates: Array<MeterCandidate>,
+    val frames: IntArray,
+    val fused: Boolean,
+    quality: FloatArray
+) {
+    val quality: List<FrameQuality> = List(quality.size / 5) {
+        FrameQuality(
+            quality[it * 5].toInt(), quality[it * 5 + 1], quality[it * 5 + 2], quality[it * 5 + 3],
+            quality[it * 5 + 4]
+        )
+    }
+}
+
+/**
+ * Verdict of [OCRPipeline.checkFrame]: the [issue] that makes the frame not
+ * worth reading, [NONE] if there is none (the codes match `water_ocr.h`),
+ * and the measurements behind it: variance of the Laplacian ([sharpness]),
+ * fraction of [clipped] highlights, [mean] luma and the 5th to 95th
+ * percentile [spread], on a 0..255 scale.
+ */
+class FrameQuality(
+    val issue: Int,
+    val sharpness: Float,
+    val clipped: Float,
+    val mean: Float,
+    val spread: Float
+) {
+    val usable: Boolean
+        get() = issue == NONE
+
+    companion object {
+        const val NONE = 0
+        const val BLUR = 1
+        const val GLARE = 2
+        const val DARK = 3
+        const val LOW_CONTRAST = 4
     }
 }
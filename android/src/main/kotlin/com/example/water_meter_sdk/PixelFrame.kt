@@ -0,0 +1,72 @@
+package com.example.water_meter_sdk
+
+import android.graphics.ImageFormat
+import android.media.Image
+import java.nio.ByteBuffer
+
+/**
+ * A frame held in direct [ByteBuffer]s, handed to the native engine without a
+ * Bitmap, a copy or a file: [OCRPipeline.readMeter] reads the buffers in
+ * place. [format] is one of the constants below (they match `water_ocr.h`),
+ * [strides] are the row strides of [planes] in bytes.
+ *
+ * The buffers must stay untouched until the call returns.
+ */
+class PixelFrame(
+    val format: Int,
+    val width: Int,
+    val height: Int,
+    val planes: Array<ByteBuffer?>,
+    val strides: IntArray
+) {
+    init {
+        require(planes.all { it == null || it.isDirect }) { "PixelFrame needs direct buffers" }
+    }
+
+    companion object {
+        const val RGBA_8888 = 0
+        const val RGB_565 = 1
+        const val A_8 = 2
+        const val RGBA_F16 = 3
+        const val NV21 = 4
+        const val I420 = 5
+        const val NV12 = 6
+
+        /** Tightly packed or strided RGBA bytes, e.g. from `Bitmap.copyPixelsToBuffer`. */
+        fun rgba(pixels: ByteBuffer, width: Int, height: Int, rowStride: Int = width * 4) =
+            PixelFrame(RGBA_8888, width, height, arrayOf(pixels), intArrayOf(rowStride))
+
+        fun nv21(y: ByteBuffer, yStride: Int, vu: ByteBuffer, vuStride: Int, width: Int, height: Int) =
+            PixelFrame(NV21, width, height, arrayOf(y, vu), intArrayOf(yStride, vuStride))
+
+        fun nv12(y: ByteBuffer, yStride: Int, uv: ByteBuffer, uvStride: Int, width: Int, height: Int) =
+            PixelFrame(NV12, width, height, arrayOf(y, uv), intArrayOf(yStride, uvStride))
+
+        fun i420(
+            y: ByteBuffer, yStride: Int, u: ByteBuffer, uStride: Int, v: ByteBuffer, vStride: Int,
+            width: Int, height: Int
+        ) = PixelFrame(I420, width, height, arrayOf(y, u, v), intArrayOf(yStride, uStride, vStride))
+
+        /**
+         * Wraps a YUV_420_888 camera [image] (CameraX `ImageProxy.image`,
+         * ImageReader). Planar chroma maps to I420. Chroma with a pixel stride
+         * of 2 is interleaved, V first (NV21) on some devices and U first
+         * (NV12) on others, which the image does not tell: the frame is passed
+         * as NV21 with the V and U buffers as planes 1 and 2, and native code
+         * reads it as NV12 when the U buffer is the one that starts first.
+         */
+        fun fromImage(image: Image): PixelFrame {
+            require(image.format == ImageFormat.YUV_420_888) { "Unsupported image format ${image.format}" }
+            val (y, u, v) = image.planes
+            return if (u.pixelStride == 1 && v.pixelStride == 1) {
+                i420(y.buffer, y.rowStride, u.buffer, u.rowStride, v.buffer, v.rowStride, image.width, image.height)
+            } else {
+                PixelFrame(
+                    NV21, image.width, image.height,
+                    arrayOf(y.buffer, v.buffer, u.buffer),
+                    intArrayOf(y.rowStride, v.rowStride, u.rowStride)
+                )
+            }
+        }
+    }
+}
@@ -2,34 +2,60 @@ package com.example.water_meter_sdk
 
 import android.content.Context
 import android.graphics.Bitmap
+import android.graphics.Matrix
 import android.graphics.Rect
+import android.graphics.RectF
+import android.media.ExifInterface
 import android.util.Log
 
 /**
  * Water Meter Processor for Android
  * Handles OCR processing using PaddleOCR models
  */
-class WaterMeterProcessor(private val context: Context) {
+class WaterMeterProcessor(
+    private val context: Context,
+    private val ocrOptions: Map<String, String> = emptyMap()
+) {
     private val TAG = "WaterMeterProcessor"
+    @Volatile
     private var isInitialized = false
     
-    // OCR pipeline components
+    // OCR pipeline components, safe to share between calling threads
+    @Volatile
     private var ocrPipeline: OCRPipeline? = null
     
-    // Preprocess image: resize to target width and convert to grayscale
-    private fun preprocess(bitmap: Bitmap): Bitmap {
+    // Preprocess image: turn upright, resize to target width and convert to
+    // grayscale, all in one draw
+    private fun preprocess(bitmap: Bitmap, orientation: Int): Bitmap {
         val targetWidth = 640
-        val scale = targetWidth.toFloat() / bitmap.width
-        val newHeight = (bitmap.height * scale).toInt()
-        val resized = Bitmap.createScaledBitmap(bitmap, targetWidth, newHeight, true)
-        val grayBitmap = Bitmap.createBitmap(resized.width, resized.height, Bitmap.Config.ARGB_8888)
+        val transform = orientationMatrix(orientation)
+        val upright = RectF(0f, 0f, bitmap.width.toFloat(), bitmap.height.toFloat())
+        transform.mapRect(upright)
+        val scale = targetWidth / upright.width()
+        val newHeight = (upright.height() * scale).toInt()
+        transform.postTranslate(-upright.left, -upright.top)
+        transform.postScale(scale, scale)
+        val grayBitmap = Bitmap.createBitmap(targetWidth, newHeight, Bitmap.Config.ARGB_8888)
         val canvas = android.graphics.Canvas(grayBitmap)
-        val paint = android.graphics.Paint()
+        val paint = android.graphics.Paint(android.graphics.Paint.FILTER_BITMAP_FLAG)
         val colorMatrix = android.graphics.ColorMatrix().apply { setSaturation(0f) }
         paint.colorFilter = android.graphics.ColorMatrixColorFilter(colorMatrix)
-        canvas.drawBitmap(resized, 0f, 0f, paint)
+        canvas.drawBitmap(bitmap, transform, paint)
         return grayBitmap
     }
+
+    // Rotation and mirroring of an EXIF orientation, about the origin
+    private fun orientationMatrix(orientation: Int): Matrix = Matrix().apply {
+        when (orientation) {
+            ExifInterface.ORIENTATION_FLIP_HORIZONTAL -> setScale(-1f, 1f)
+            ExifInterface.ORIENTATION_ROTATE_180 -> setRotate(180f)
+            ExifInterface.ORIENTATION_FLIP_VERTICAL -> setScale(1f, -1f)
+            ExifInterface.ORIENTATION_TRANSPOSE -> { setRotate(90f); postScale(-1f, 1f) }
+            ExifInterface.ORIENTATION_ROTATE_90 -> setRotate(90f)
+            ExifInterface.ORIENTATION_TRANSVERSE -> { setRotate(-90f); postScale(-1f, 1f) }
+            ExifInterface.ORIENTATION_ROTATE_270 -> setRotate(-90f)
+        }
+    }
     
     /**
      * Initialize the processor with PaddleOCR models
@@ -38,9 +64,15 @@ class WaterMeterProcessor(private val context: Context) {
         try {
             Log.d(TAG, "Initializing WaterMeterProcessor...")
             
-            // Initialize OCR pipeline with models from assets
-            ocrPipeline = OCRPipeline(context)
+            // Initialize OCR pipeline with models from assets. Readings are
+            // often detected digit by digit, so join boxes on one baseline
+            // natively, and rank out regions too small to be a reading,
+            // unless the caller says otherwise.
+            val defaults = mapOf("det_merge_lines" to "1", "rank_min_size" to "50x20")
+            ocrPipeline = OCRPipeline(context, defaults + ocrOptions)
             ocrPipeline?.initialize()
+            // Finish first-run allocations in the background before the first frame
+            ocrPipeline?.warmUp(async = true)
             
             isInitialized = true
             Log.d(TAG, "WaterMeterProcessor initialized successfully")
@@ -51,9 +83,13 @@ class WaterMeterProcessor(private val context: Context) {
     }
     
     /**
-     * Process image and extract water meter reading
+     * Process image and extract water meter reading. [orientation] is the
+     * EXIF orientation the pixels are stored in; regions come back upright.
      */
-    fun processImage(bitmap: Bitmap): Map<String, Any?>? {
+    fun processImage(
+        bitmap: Bitmap,
+        orientation: Int = ExifInterface.ORIENTATION_NORMAL
+    ): Map<String, Any?>? {
         if (!isInitialized) {
             Log.e(TAG, "Processor not initialized")
             return null
@@ -63,43 +99,31 @@ class WaterMeterProcessor(private val context: Context) {
         
         try {
             // Step 1: Preprocess image for detection
-            val prepped = preprocess(bitmap)
-            val detections = ocrPipeline?.detectText(prepped) ?: emptyList()
-            
-            if (detections.isEmpty()) {
-                return createResult(false, 0.0f, null, null, System.currentTimeMillis() - startTime)
-            }
+            val prepped = preprocess(bitmap, orientation)
             
-            // Step 2: Filter detections - keep reasonable regions
-            val meterDetections = detections.filter { detection ->
-                detection.confidence > 0.3f &&
-                detection.bounds.width() > 50 &&
-                detection.bounds.height() > 20
-            }
+            // Step 2: Detect, rank and recognize natively; only the best
+            // ranked regions are recognized and they come back best first
+            val candidates = ocrPipeline?.readMeter(prepped) ?: emptyList()
             
-            if (meterDetections.isEmpty()) {
+            if (candidates.isEmpty()) {
                 return createResult(false, 0.0f, null, null, System.currentTimeMillis() - startTime)
             }
             
-            // Step 3: Extract text from meter regions
+            // Step 3: Keep readings in ranking order
             val readings = mutableListOf<String>()
             var maxConfidence = 0.0f
             
-            for (detection in meterDetections) {
-                val rect = detection.bounds
-                val text = ocrPipeline?.recognizeText(prepped, rect)
-                if (!text.isNullOrEmpty()) {
-                    // Keep only digit sequences of length 4 or 5
-                    val digits = text.filter { it.isDigit() }
-                    if (digits.length in 4..5) {
-                        readings.add(digits)
-                        maxConfidence = maxOf(maxConfidence, detection.confidence)
-                    }
+            for (candidate in candidates) {
+                // Keep only integer digit sequences of length 4 or 5
+                val digits = candidate.text.dropLast(candidate.fractionDigits).filter { it.isDigit() }
+                if (digits.length in 4..5) {
+                    readings.add(digits)
+                    maxConfidence = maxOf(maxConfidence, candidate.confidence)
                 }
             }
             
             // Step 4: Process and validate readings
-            // Deduplicate and pick first as best reading
+            // Deduplicate; the first is the best ranked reading
             val uniqueReadings = readings.distinct()
             val bestReading = uniqueReadings.firstOrNull()
             val meterType = determineMeterType(bestReading)
@@ -112,7 +136,9 @@ class WaterMeterProcessor(private val context: Context) {
                 reading = bestReading,
                 meterType = meterType,
                 processingTime = processingTime,
-                textRegions = meterDetections.map { it.toMap() }
+                textRegions = candidates.map {
+                    TextDetection(text = it.text, confidence = it.score, bounds = it.bounds).toMap()
+                }
             )
             
         } catch (e: Exception) {
@@ -122,9 +148,13 @@ class WaterMeterProcessor(private val context: Context) {
     }
     
     /**
-     * Detect water meter regions only
+     * Detect water meter regions only. [orientation] is as for
+     * [processImage]; regions are in upright coordinates.
      */
-    fun detectMeterRegions(bitmap: Bitmap): List<Map<String, Any>>? {
+    fun detectMeterRegions(
+        bitmap: Bitmap,
+        orientation: Int = ExifInterface.ORIENTATION_NORMAL
+    ): List<Map<String, Any>>? {
         if (!isInitialized) {
             Log.e(TAG, "Processor not initialized")
             return null
@@ -132,7 +162,7 @@ class WaterMeterProcessor(private val context: Context) {
         
         try {
             // Preprocess image for detection
-            val prepped = preprocess(bitmap)
+            val prepped = preprocess(bitmap, orientation)
             val detections = ocrPipeline?.detectText(prepped) ?: emptyList()
             val meterDetections = filterWaterMeterDetections(detections)
             return meterDetections.map { it.toMap() }
@@ -143,9 +173,14 @@ class WaterMeterProcessor(private val context: Context) {
     }
     
     /**
-     * Recognize text in specific regions
+     * Recognize text in specific regions, given in the upright coordinates
+     * of [bitmap] stored in EXIF [orientation]
      */
-    fun recognizeTextInRegions(bitmap: Bitmap, regions: List<List<Double>>): List<String>? {
+    fun recognizeTextInRegions(
+        bitmap: Bitmap,
+        regions: List<List<Double>>,
+        orientation: Int = ExifInterface.ORIENTATION_NORMAL
+    ): List<String>? {
         if (!isInitialized) {
             Log.e(TAG, "Processor not initialized")
             return null
@@ -153,23 +188,16 @@ class WaterMeterProcessor(private val context: Context) {
         
         try {
             // Use preprocessed image for recognition as well
-            val prepped = preprocess(bitmap)
-            val results = mutableListOf<String>()
-            
-            for (region in regions) {
-                if (region.size >= 4) {
-                    val rect = Rect(
-                        region[0].toInt(),
-                        region[1].toInt(),
-                        (region[0] + region[2]).toInt(),
-                        (region[1] + region[3]).toInt()
-                    )
-                    val text = ocrPipeline?.recognizeText(prepped, rect)
-                    if (!text.isNullOrEmpty()) {
-                        results.add(text)
-                    }
-                }
+            val prepped = preprocess(bitmap, orientation)
+            val rects = regions.filter { it.size >= 4 }.map { region ->
+                Rect(
+                    region[0].toInt(),
+                    region[1].toInt(),
+                    (region[0] + region[2]).toInt(),
+                    (region[1] + region[3]).toInt()
+                )
             }
+            val results = ocrPipeline?.recognizeRegions(prepped, rects)?.filterNotNull() ?: emptyList()
             
             return results
         } catch (e: Exception) {
@@ -1,7 +1,8 @@
 package com.example.water_meter_sdk
 
 import android.content.Context
-import android.graphics.BitmapFactory
+import android.os.Handler
+import android.os.Looper
 import androidx.annotation.NonNull
 import com.google.mlkit.vision.common.InputImage
 import com.google.mlkit.vision.text.TextRecognition
@@ -14,6 +15,8 @@ import io.flutter.plugin.common.MethodChannel
 import io.flutter.plugin.common.MethodChannel.MethodCallHandler
 import io.flutter.plugin.common.MethodChannel.Result
 import java.io.File
+import java.util.concurrent.ExecutorService
+import java.util.concurrent.Executors
 
 /** WaterMeterSdkPlugin */
 class WaterMeterSdkPlugin: FlutterPlugin, MethodCallHandler {
@@ -24,11 +27,16 @@ class WaterMeterSdkPlugin: FlutterPlugin, MethodCallHandler {
   private lateinit var channel : MethodChannel
   private lateinit var context: Context
   private lateinit var textRecognizer: TextRecognizer
+  // Decodes photos for ML Kit one at a time. Its queue is unbounded: unlike
+  // native frames, every ML Kit request is answered, however many wait.
+  private lateinit var decodeExecutor: ExecutorService
+  private val mainHandler = Handler(Looper.getMainLooper())
 
   override fun onAttachedToEngine(@NonNull flutterPluginBinding: FlutterPlugin.FlutterPluginBinding) {
     channel = MethodChannel(flutterPluginBinding.binaryMessenger, "water_meter_sdk")
     context = flutterPluginBinding.applicationContext
     textRecognizer = TextRecognition.getClient(TextRecognizerOptions.DEFAULT_OPTIONS)
+    decodeExecutor = Executors.newSingleThreadExecutor { runnable -> Thread(runnable, "water-meter-decode") }
     channel.setMethodCallHandler(this)
   }
 
@@ -43,7 +51,27 @@ class WaterMeterSdkPlugin: FlutterPlugin, MethodCallHandler {
           result.error("INVALID_ARGUMENTS", "Missing imagePath", null)
           return
         }
-        processImage(imagePath, result)
+        if (call.argument<String>("engine") == "native") {
+          processImageNative(imagePath, result)
+        } else {
+          processImage(imagePath, result)
+        }
+      }
+      "configureNative" -> {
+        val maxConcurrency = call.argument<Int>("maxConcurrency") ?: 1
+        val queueDepth = call.argument<Int>("queueDepth") ?: 2
+        val options = call.argument<Map<String, String>>("options") ?: emptyMap()
+        try {
+          NativeMeterService.configure(maxConcurrency, queueDepth, options)
+        } catch (e: IllegalArgumentException) {
+          result.error("INVALID_ARGUMENTS", e.message, null)
+          return
+        }
+        // Load the models now rather than on the first frame
+        if (call.argument<Boolean>("preload") != false) {
+          NativeMeterService.submit(Runnable { runCatching { NativeMeterService.processor(context) } })
+        }
+        result.success(null)
       }
       else -> {
         result.notImplemented()
@@ -51,17 +79,62 @@ class WaterMeterSdkPlugin: FlutterPlugin, MethodCallHandler {
     }
   }
 
-  private fun processImage(imagePath: String, result: Result) {
-    try {
-      val file = File(imagePath)
-      if (!file.exists()) {
-        result.error("FILE_NOT_FOUND", "Image file not found", null)
-        return
+  /**
+   * Read the meter with the native engine. Decoding and inference run on
+   * [NativeMeterService]'s executor against its warm processor; the result
+   * is posted back to the platform thread.
+   */
+  private fun processImageNative(imagePath: String, result: Result) {
+    val accepted = NativeMeterService.submit(Runnable {
+      try {
+        val bitmap = NativeMeterService.decodeForOcr(imagePath)
+        val orientation = NativeMeterService.exifOrientation(imagePath)
+        val output = bitmap?.let { NativeMeterService.processor(context).processImage(it, orientation) }
+        mainHandler.post {
+          when {
+            bitmap == null -> result.error("FILE_NOT_FOUND", "Image file not found or not decodable", null)
+            output == null -> result.error("PROCESSING_ERROR", "Native processing failed", null)
+            else -> result.success(output)
+          }
+        }
+      } catch (e: Exception) {
+        mainHandler.post { result.error("PROCESSING_ERROR", e.localizedMessage, null) }
       }
+    })
+    if (!accepted) {
+      result.error("BUSY", "Too many images in flight", null)
+    }
+  }
 
-      val bitmap = BitmapFactory.decodeFile(imagePath)
-      val image = InputImage.fromBitmap(bitmap, 0)
+  private fun processImage(imagePath: String, result: Result) {
+    // Decoding a photo takes too long for the platform thread. It runs on
+    // the plugin's own executor, not the native engine's bounded one, so the
+    // default engine never answers BUSY.
+    decodeExecutor.execute {
+      try {
+        val bitmap = if (File(imagePath).exists()) NativeMeterService.decodeForOcr(imagePath) else null
+        val rotation = if (bitmap != null) {
+          NativeMeterService.rotationDegrees(NativeMeterService.exifOrientation(imagePath))
+        } else {
+          0
+        }
+        mainHandler.post {
+          if (bitmap == null) {
+            result.error("FILE_NOT_FOUND", "Image file not found", null)
+          } else {
+            // ML Kit turns the bitmap upright itself
+            recognizeWithMlKit(InputImage.fromBitmap(bitmap, rotation), result)
+          }
+        }
+      } catch (e: Throwable) {
+        // OutOfMemoryError included: the Dart future must always complete
+        mainHandler.post { result.error("PROCESSING_ERROR", e.localizedMessage, null) }
+      }
+    }
+  }
 
+  private fun recognizeWithMlKit(image: InputImage, result: Result) {
+    try {
       textRecognizer.process(image)
         .addOnSuccessListener { visionText ->
           // Process the text
@@ -101,5 +174,7 @@ class WaterMeterSdkPlugin: FlutterPlugin, MethodCallHandler {
 
   override fun onDetachedFromEngine(@NonNull binding: FlutterPlugin.FlutterPluginBinding) {
     channel.setMethodCallHandler(null)
+    // Photos already queued are still decoded and answered
+    decodeExecutor.shutdown()
   }
 }
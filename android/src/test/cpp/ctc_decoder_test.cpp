@@ -0,0 +1,72 @@
+#include <cstdio>
+#include <fstream>
+#include <vector>
+
+#include "ctc_decoder.h"
+#include "test_util.h"
+
+namespace {
+
+// One-hot-ish posteriors: each step puts `p` on one class and spreads the rest
+std::vector<float> posteriors(const std::vector<int>& path, int numClasses, float p = 0.9f) {
+    std::vector<float> probs(path.size() * numClasses, (1.0f - p) / (numClasses - 1));
+    for (size_t t = 0; t < path.size(); ++t) probs[t * numClasses + path[t]] = p;
+    return probs;
+}
+
+void defaultDictionaryIsDigits() {
+    ocr::CharDict dict;
+    EXPECT_EQ(dict.classCount(), 11);
+    EXPECT_EQ(dict.label(0), "");
+    EXPECT_EQ(dict.label(1), "0");
+    EXPECT_EQ(dict.label(10), "9");
+    EXPECT_EQ(dict.label(11), "");
+}
+
+void greedyDecodeMergesRepeatsAndDropsBlanks() {
+    ocr::CharDict dict;
+    // classes: 0 blank, 1 -> '0', ..., 10 -> '9'
+    // path "0 0 blank 0 2 2 blank 5" decodes to "0015"
+    std::vector<int> path = {1, 1, 0, 1, 3, 3, 0, 6};
+    std::vector<float> probs = posteriors(path, dict.classCount());
+    ocr::Recognition rec = ocr::ctcGreedyDecode(probs.data(), static_cast<int>(path.size()), dict.classCount(), dict);
+    EXPECT_EQ(rec.text, "0025");
+    EXPECT_EQ(rec.charConfidences.size(), 4u);
+    EXPECT_NEAR(rec.confidence, 0.9f, 1e-5);
+}
+
+void allBlankDecodesToEmpty() {
+    ocr::CharDict dict;
+    std::vector<int> path = {0, 0, 0};
+    std::vector<float> probs = posteriors(path, dict.classCount());
+    ocr::Recognition rec = ocr::ctcGreedyDecode(probs.data(), 3, dict.classCount(), dict);
+    EXPECT_TRUE(rec.text.empty());
+    EXPECT_EQ(rec.confidence, 0.0f);
+}
+
+void loadsPaddleDictionary() {
+    const char* path = "ctc_decoder_test_dict.txt";
+    {
+        std::ofstream out(path);
+        out << "a\r\nb\nc\n";
+    }
+    ocr::CharDict dict;
+    EXPECT_TRUE(dict.load(path));
+    // a, b, c and the appended space, plus the blank
+    EXPECT_EQ(dict.classCount(), 5);
+    EXPECT_EQ(dict.label(1), "a");
+    EXPECT_EQ(dict.label(3), "c");
+    EXPECT_EQ(dict.label(4), " ");
+    EXPECT_TRUE(!dict.load("missing_dictionary.txt"));
+    std::remove(path);
+}
+
+} // namespace
+
+int main() {
+    defaultDictionaryIsDigits();
+    greedyDecodeMergesRepeatsAndDropsBlanks();
+    allBlankDecodesToEmpty();
+    loadsPaddleDictionary();
+    return TEST_RESULT();
+}
@@ -0,0 +1,57 @@
+#include <vector>
+
+#include "det_postprocess.h"
+#include "test_util.h"
+
+namespace {
+
+void fill(std::vector<float>& map, int width, int left, int top, int right, int bottom, float value) {
+    for (int y = top; y < bottom; ++y) {
+        for (int x = left; x < right; ++x) map[y * width + x] = value;
+    }
+}
+
+void findsSeparateRegionsWithScores() {
+    const int width = 40, height = 20;
+    std::vector<float> map(width * height, 0.0f);
+    fill(map, width, 2, 2, 12, 8, 0.9f);
+    fill(map, width, 20, 10, 36, 16, 0.7f);
+    ocr::QuadSet boxes;
+    ocr::DbParams params;
+    params.unclipRatio = 0.0f;
+    ocr::dbBoxes(map.data(), width, height, params, 1.0f, 1.0f, boxes);
+    EXPECT_EQ(boxes.size(), 2u);
+    if (boxes.size() != 2) return;
+    EXPECT_NEAR(boxes.x(0, 0), 2, 1e-6);
+    EXPECT_NEAR(boxes.y(0, 0), 2, 1e-6);
+    EXPECT_NEAR(boxes.x(2, 0), 12, 1e-6);
+    EXPECT_NEAR(boxes.y(2, 0), 8, 1e-6);
+    EXPECT_NEAR(boxes.score(0), 0.9, 1e-6);
+    EXPECT_NEAR(boxes.angle(0), 0, 1e-6);
+    EXPECT_NEAR(boxes.score(1), 0.7, 1e-6);
+}
+
+void unclipsScalesAndFilters() {
+    const int width = 40, height = 20;
+    std::vector<float> map(width * height, 0.0f);
+    fill(map, width, 10, 5, 30, 15, 0.8f);
+    fill(map, width, 0, 0, 2, 2, 0.9f);   // below minSize
+    fill(map, width, 35, 0, 40, 6, 0.4f); // below boxThreshold
+    ocr::QuadSet boxes;
+    ocr::dbBoxes(map.data(), width, height, ocr::DbParams(), 2.0f, 2.0f, boxes);
+    EXPECT_EQ(boxes.size(), 1u);
+    if (boxes.empty()) return;
+    // 20x10 region: margin = 200 * 1.5 / 60 = 5, then scaled by 2
+    EXPECT_NEAR(boxes.x(0, 0), 10, 1e-4);
+    EXPECT_NEAR(boxes.y(0, 0), 0, 1e-4);
+    EXPECT_NEAR(boxes.x(2, 0), 70, 1e-4);
+    EXPECT_NEAR(boxes.y(2, 0), 40, 1e-4);
+}
+
+} // namespace
+
+int main() {
+    findsSeparateRegionsWithScores();
+    unclipsScalesAndFilters();
+    return TEST_RESULT();
+}
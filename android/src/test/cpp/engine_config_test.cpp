@@ -0,0 +1,157 @@
+#include <string>
+#include <vector>
+
+#include "ocr_engine.h"
+#include "test_util.h"
+
+namespace {
+
+void parsesScalarOptions() {
+    ocr::EngineConfig config;
+    EXPECT_TRUE(config.applyOption("intra_op_threads=2"));
+    EXPECT_EQ(config.intraOpThreads, 2);
+    EXPECT_TRUE(config.applyOption("det_threshold=0.25"));
+    EXPECT_NEAR(config.detThreshold, 0.25, 1e-6);
+    EXPECT_TRUE(config.applyOption("cls=false"));
+    EXPECT_TRUE(!config.useCls);
+    EXPECT_TRUE(config.applyOption("warm_up=async"));
+    EXPECT_TRUE(config.warmUp == ocr::WarmUpMode::Async);
+    EXPECT_TRUE(config.applyOption("det_nms_iou=0"));
+    EXPECT_NEAR(config.detNmsIou, 0, 1e-6);
+    EXPECT_TRUE(config.applyOption("det_merge_lines=1"));
+    EXPECT_TRUE(config.detMergeLines);
+    EXPECT_TRUE(config.applyOption("rec_early_exit=0"));
+    EXPECT_TRUE(!config.recEarlyExit);
+    EXPECT_TRUE(!config.bgrInput);
+    EXPECT_TRUE(config.applyOption("channel_order=bgr"));
+    EXPECT_TRUE(config.bgrInput);
+    EXPECT_TRUE(!config.applyOption("channel_order=rgba"));
+    EXPECT_TRUE(!config.recGrammar);
+    EXPECT_TRUE(config.applyOption("rec_grammar=5+3"));
+    EXPECT_TRUE(config.recGrammar);
+    EXPECT_EQ(config.reading.maxDigits, 5);
+    EXPECT_EQ(config.reading.fractionDigits, 3);
+    EXPECT_TRUE(!config.applyOption("rec_grammar=five"));
+    EXPECT_TRUE(config.applyOption("rec_grammar=off"));
+    EXPECT_TRUE(!config.recGrammar);
+    EXPECT_TRUE(config.applyOption("reading_beam=4"));
+    EXPECT_EQ(config.reading.beamWidth, 4);
+    EXPECT_TRUE(!config.applyOption("reading_beam=0"));
+    EXPECT_TRUE(config.applyOption("reading_decrease_penalty=6"));
+    EXPECT_NEAR(config.reading.decreasePenalty, 6.0, 1e-6);
+    EXPECT_TRUE(config.applyOption("rank_top_k=2"));
+    EXPECT_EQ(config.rank.topK, 2);
+    EXPECT_TRUE(config.applyOption("rank_min_size=50x20"));
+    EXPECT_NEAR(config.rank.minHeight, 20, 1e-6);
+    EXPECT_TRUE(config.applyOption("rank_roi=0.1,0.2,0.9,0.7"));
+    EXPECT_NEAR(config.rank.roiBottom, 0.7, 1e-6);
+    EXPECT_TRUE(config.applyOption("rank_weights=1,0.5,1,2,1"));
+    EXPECT_NEAR(config.rank.digitWeight, 2, 1e-6);
+    EXPECT_TRUE(!config.decodeScaled);
+    EXPECT_TRUE(config.applyOption("decode_scaled=1"));
+    EXPECT_TRUE(config.decodeScaled);
+    EXPECT_TRUE(config.applyOption("decode_gray=true"));
+    EXPECT_TRUE(config.decodeGray);
+    EXPECT_TRUE(config.applyOption("quality_gate=1"));
+    EXPECT_TRUE(config.qualityGate);
+    EXPECT_TRUE(config.applyOption("quality_min_sharpness=80"));
+    EXPECT_NEAR(config.quality.minSharpness, 80, 1e-6);
+    EXPECT_TRUE(config.applyOption("quality_max_clipped=0.05"));
+    EXPECT_NEAR(config.quality.maxClipped, 0.05, 1e-6);
+    EXPECT_TRUE(!config.applyOption("quality_side=0"));
+    EXPECT_TRUE(config.applyOption("burst_top_k=3"));
+    EXPECT_EQ(config.burstTopK, 3);
+    EXPECT_TRUE(config.applyOption("burst_fuse=0"));
+    EXPECT_TRUE(!config.burstFuse);
+    EXPECT_TRUE(!config.applyOption("burst_top_k=0"));
+    EXPECT_TRUE(config.applyOption("det_enhance=sauvola"));
+    EXPECT_TRUE(config.detEnhance == ocr::DetEnhance::Sauvola);
+    EXPECT_TRUE(config.applyOption("sauvola_radius=9"));
+    EXPECT_EQ(config.sauvola.radius, 9);
+    EXPECT_TRUE(config.applyOption("clahe_tiles=4"));
+    EXPECT_EQ(config.clahe.tilesX, 4);
+    EXPECT_EQ(config.clahe.tilesY, 4);
+    EXPECT_TRUE(!config.applyOption("det_enhance=sharpen"));
+    EXPECT_TRUE(config.applyOption("rec_tta=stretch,binary"));
+    EXPECT_EQ(config.recTta.size(), 2u);
+    EXPECT_TRUE(config.recTta[1] == ocr::CropVariant::Binary);
+    EXPECT_TRUE(!config.applyOption("rec_tta=stretch,blur"));
+    EXPECT_TRUE(!config.applyOption("rec_tta=binary,binary,binary,binary,binary"));
+    EXPECT_EQ(config.recTta.size(), 2u);
+    EXPECT_TRUE(config.applyOption("rec_tta=off"));
+    EXPECT_TRUE(config.recTta.empty());
+
+    EXPECT_TRUE(!config.applyOption("intra_op_threads=0"));
+    EXPECT_TRUE(!config.applyOption("warm_up=later"));
+    EXPECT_TRUE(!config.applyOption("det_merge_gap=-1"));
+    EXPECT_TRUE(!config.applyOption("rank_roi=0.9,0.2,0.1,0.7"));
+    EXPECT_TRUE(!config.applyOption("rank_weights=1,1,1"));
+    EXPECT_TRUE(!config.applyOption("no_such_key=1"));
+    EXPECT_TRUE(!config.applyOption("missing_equals"));
+    EXPECT_EQ(config.intraOpThreads, 2);
+}
+
+void parsesProviderLists() {
+    ocr::EngineConfig config;
+    EXPECT_TRUE(config.applyOption("providers=xnnpack,cpu"));
+    EXPECT_EQ(config.providers, (std::vector<std::string>{"xnnpack", "cpu"}));
+    EXPECT_TRUE(config.applyOption("rec_providers=cpu"));
+    EXPECT_EQ(config.recProviders, std::vector<std::string>{"cpu"});
+    // Unknown names are rejected and leave the list alone
+    EXPECT_TRUE(!config.applyOption("providers=xnnpack,gpu"));
+    EXPECT_EQ(config.providers.size(), 2u);
+    // Nothing after CPU would ever be tried
+    EXPECT_TRUE(!config.applyOption("providers=cpu,xnnpack"));
+    EXPECT_TRUE(!config.applyOption("det_providers=nnapi,cpu,xnnpack"));
+    EXPECT_EQ(config.providers, (std::vector<std::string>{"xnnpack", "cpu"}));
+    EXPECT_TRUE(config.detProviders.empty());
+}
+
+void parsesShapeBuckets() {
+    ocr::EngineConfig config;
+    EXPECT_TRUE(config.applyOption("det_buckets=640x480,960x720"));
+    EXPECT_EQ(config.detBuckets.size(), 2u);
+    EXPECT_TRUE(config.detBuckets[1] == std::make_pair(960, 720));
+    EXPECT_TRUE(config.applyOption("rec_buckets=160,320,640"));
+    EXPECT_EQ(config.recBuckets, (std::vector<int>{160, 320, 640}));
+
+    EXPECT_TRUE(!config.applyOption("det_buckets=640x"));
+    EXPECT_TRUE(!config.applyOption("det_buckets=640x480,"));
+    EXPECT_TRUE(!config.applyOption("rec_buckets=160,-1"));
+    EXPECT_EQ(config.detBuckets.size(), 2u);
+    EXPECT_EQ(config.recBuckets.size(), 3u);
+}
+
+void parsesInputNorms() {
+    ocr::EngineConfig config;
+    EXPECT_TRUE(config.detNorm.automatic());
+    EXPECT_TRUE(config.applyOption("rec_norm=pm1"));
+    EXPECT_NEAR(config.recNorm.mean[2], 0.5, 1e-6);
+    EXPECT_NEAR(config.recNorm.std[0], 0.5, 1e-6);
+    EXPECT_TRUE(config.applyOption("det_norm=imagenet"));
+    EXPECT_NEAR(config.detNorm.std[1], 0.224, 1e-6);
+    // A custom mean alone keeps the [0, 1] std
+    EXPECT_TRUE(config.applyOption("cls_mean=0.5,0.4,0.3"));
+    EXPECT_NEAR(config.clsNorm.mean[1], 0.4, 1e-6);
+    EXPECT_NEAR(config.clsNorm.std[2], 1.0, 1e-6);
+    EXPECT_TRUE(config.applyOption("det_std=0.2,0.2,0.2"));
+    EXPECT_NEAR(config.detNorm.mean[0], 0.485, 1e-6);
+    EXPECT_NEAR(config.detNorm.std[0], 0.2, 1e-6);
+
+    EXPECT_TRUE(!config.applyOption("rec_std=0.5,0,0.5"));
+    EXPECT_TRUE(!config.applyOption("rec_mean=0.5,0.5"));
+    EXPECT_TRUE(!config.applyOption("rec_norm=zscore"));
+    EXPECT_NEAR(config.recNorm.std[1], 0.5, 1e-6);
+    EXPECT_TRUE(config.applyOption("rec_norm=auto"));
+    EXPECT_TRUE(config.recNorm.automatic());
+}
+
+} // namespace
+
+int main() {
+    parsesScalarOptions();
+    parsesProviderLists();
+    parsesShapeBuckets();
+    parsesInputNorms();
+    return TEST_RESULT();
+}
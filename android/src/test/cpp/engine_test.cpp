@@ -0,0 +1,174 @@
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "inference_backend.h"
+#include "ocr_engine.h"
+#include "test_util.h"
+
+namespace {
+
+constexpr int kWidth = 200;
+constexpr int kHeight = 100;
+constexpr int kRecSteps = 24;
+constexpr int kRecClasses = 11;
+
+// A serial number above the reading, detected with more confidence. The
+// script tells the two apart by grey level: the serial plate is light.
+constexpr float kSerialBox[9] = {10, 10, 110, 10, 110, 30, 10, 30, 0.95f};
+constexpr float kReadingBox[9] = {10, 50, 110, 50, 110, 70, 10, 70, 0.7f};
+const char* const kSerial = "1234567890";
+const char* const kReading = "04321";
+
+struct FakeScratch : ocr::BackendScratch {
+    std::vector<float> data;
+};
+
+// Scripted det, cls and rec models on the "fake" backend, chosen by model
+// path: det finds both boxes, cls keeps every crop upright and rec reads the
+// serial from light crops and the reading from dark ones.
+class FakeSession : public ocr::InferenceSession {
+public:
+    FakeSession(const std::string& path, const ocr::SessionOptions& options) : model_(path) {
+        info_.reset(new ocr::ModelInfo());
+        info_->label = options.label;
+        ocr::TensorInfo input;
+        input.name = "x";
+        input.type = ocr::ElementType::Float;
+        input.dims = {-1, 3, -1, -1};
+        input.dimNames = {"", "", "", ""};
+        ocr::TensorInfo output;
+        output.name = "y";
+        output.type = ocr::ElementType::Float;
+        if (model_ == "cls") output.dims = {-1, 2};
+        if (model_ == "rec") output.dims = {-1, -1, kRecClasses};
+        output.dimNames.resize(output.dims.size());
+        info_->inputs.push_back(input);
+        info_->outputs.push_back(output);
+        info_->resolveNames();
+    }
+
+    const char* backendName() const override { return "fake"; }
+    const std::string& provider() const override { return provider_; }
+
+    std::unique_ptr<ocr::BackendScratch> createScratch(int) override {
+        return std::unique_ptr<ocr::BackendScratch>(new FakeScratch());
+    }
+
+    const ocr::TensorView& run(ocr::BackendScratch& scratch, const float* input,
+                               const std::array<int64_t, 4>& dims) override {
+        FakeScratch& fake = static_cast<FakeScratch&>(scratch);
+        const int64_t batch = dims[0];
+        if (model_ == "det") {
+            fake.data.assign(kSerialBox, kSerialBox + 9);
+            fake.data.insert(fake.data.end(), kReadingBox, kReadingBox + 9);
+            fake.output.shape = {1, 2, 9};
+        } else if (model_ == "cls") {
+            fake.data.assign(static_cast<size_t>(batch) * 2, 0.0f);
+            for (int64_t b = 0; b < batch; ++b) fake.data[b * 2] = 1.0f;
+            fake.output.shape = {batch, 2};
+        } else {
+            const size_t plane = static_cast<size_t>(dims[2]) * dims[3];
+            fake.data.assign(static_cast<size_t>(batch) * kRecSteps * kRecClasses, 0.0f);
+            for (int64_t b = 0; b < batch; ++b) {
+                // Red channel a few pixels into the middle row
+                const float grey = input[b * 3 * plane + (dims[2] / 2) * dims[3] + 4];
+                writeText(grey > 0.5f ? kSerial : kReading, fake.data.data() + b * kRecSteps * kRecClasses);
+            }
+            fake.output.shape = {batch, kRecSteps, kRecClasses};
+        }
+        fake.output.data = fake.data.data();
+        return fake.output;
+    }
+
+private:
+    // One-hot CTC posteriors: each digit followed by a blank
+    static void writeText(const std::string& text, float* probs) {
+        for (int t = 0; t < kRecSteps; ++t) {
+            const size_t i = static_cast<size_t>(t / 2);
+            const int cls = t % 2 == 0 && i < text.size() ? text[i] - '0' + 1 : 0;
+            probs[t * kRecClasses + cls] = 1.0f;
+        }
+    }
+
+    std::string model_;
+    std::string provider_ = "cpu";
+};
+
+// Light serial plate over a dark reading window on a mid-grey meter
+std::vector<uint32_t> meterFrame() {
+    std::vector<uint32_t> pixels(static_cast<size_t>(kWidth) * kHeight, 0xFF808080u);
+    for (int y = 2; y < 38; ++y) {
+        for (int x = 2; x < 118; ++x) pixels[y * kWidth + x] = 0xFFDCDCDCu;
+    }
+    for (int y = 42; y < 78; ++y) {
+        for (int x = 2; x < 118; ++x) pixels[y * kWidth + x] = 0xFF1E1E1Eu;
+    }
+    return pixels;
+}
+
+ocr::EngineConfig fakeConfig() {
+    ocr::registerBackend("fake", [](const std::string& path, const ocr::SessionOptions& options) {
+        return std::unique_ptr<ocr::InferenceSession>(new FakeSession(path, options));
+    });
+    ocr::EngineConfig config;
+    config.detModelPath = "det";
+    config.clsModelPath = "cls";
+    config.recModelPath = "rec";
+    config.workers = 0;
+    EXPECT_TRUE(config.applyOption("backend=fake"));
+    // Rank by det score alone, so the serial comes first in each frame
+    EXPECT_TRUE(config.applyOption("rank_weights=0,0,1,0,0"));
+    EXPECT_TRUE(config.applyOption("burst_top_k=2"));
+    return config;
+}
+
+void readsTheReadingAfterTheSerial() {
+    ocr::EngineConfig config = fakeConfig();
+    EXPECT_TRUE(config.applyOption("rec_early_exit=0"));
+    ocr::Engine engine(config);
+    const std::vector<uint32_t> frame = meterFrame();
+    const std::vector<ocr::MeterCandidate> candidates =
+        engine.readMeter(ocr::ImageView::rgba(frame.data(), kWidth, kHeight));
+    EXPECT_EQ(candidates.size(), 2u);
+    if (candidates.size() != 2) return;
+    EXPECT_EQ(candidates[0].recognition.text, std::string(kSerial));
+    EXPECT_EQ(candidates[1].recognition.text, std::string(kReading));
+}
+
+void burstDoesNotFuseFramesLedByOtherText() {
+    ocr::EngineConfig config = fakeConfig();
+    EXPECT_TRUE(config.applyOption("rec_early_exit=0"));
+    ocr::Engine engine(config);
+    const std::vector<uint32_t> frame = meterFrame();
+    const ocr::ImageView view = ocr::ImageView::rgba(frame.data(), kWidth, kHeight);
+    const ocr::BurstReading burst = engine.readBurst({view, view});
+    // Both frames lead with the serial, which is no reading to fuse
+    EXPECT_TRUE(!burst.fused);
+    EXPECT_EQ(burst.candidates.size(), 4u);
+    if (burst.candidates.empty()) return;
+    EXPECT_EQ(burst.candidates[0].recognition.text, std::string(kReading));
+}
+
+void burstFusesFramesLedByTheReading() {
+    ocr::EngineConfig config = fakeConfig();
+    ocr::Engine engine(config);
+    const std::vector<uint32_t> frame = meterFrame();
+    const ocr::ImageView view = ocr::ImageView::rgba(frame.data(), kWidth, kHeight);
+    const ocr::BurstReading burst = engine.readBurst({view, view});
+    // Early exit moves the reading to the front of each frame
+    EXPECT_TRUE(burst.fused);
+    if (burst.candidates.empty()) return;
+    EXPECT_EQ(burst.candidates[0].recognition.text, std::string(kReading));
+    EXPECT_NEAR(burst.candidates[0].quad[1], kReadingBox[1], 1e-3);
+}
+
+} // namespace
+
+int main() {
+    readsTheReadingAfterTheSerial();
+    burstDoesNotFuseFramesLedByOtherText();
+    burstFusesFramesLedByTheReading();
+    return TEST_RESULT();
+}
@@ -0,0 +1,167 @@
+#include <atomic>
+#include <cstdint>
+#include <cstdlib>
+#include <new>
+#include <vector>
+
+#include "ctc_decoder.h"
+#include "det_postprocess.h"
+#include "frame_arena.h"
+#include "image_ops.h"
+#include "quad_nms.h"
+#include "test_util.h"
+
+// Heap calls made while counting is on. operator new covers the containers;
+// on glibc malloc itself is interposed too, which catches C allocations.
+namespace {
+std::atomic<bool> counting{false};
+std::atomic<int> heapCalls{0};
+
+void countCall() {
+    if (counting.load(std::memory_order_relaxed)) heapCalls.fetch_add(1, std::memory_order_relaxed);
+}
+} // namespace
+
+#if defined(__GLIBC__)
+extern "C" void* __libc_malloc(size_t size);
+extern "C" void* __libc_calloc(size_t count, size_t size);
+extern "C" void* __libc_realloc(void* ptr, size_t size);
+
+extern "C" void* malloc(size_t size) {
+    countCall();
+    return __libc_malloc(size);
+}
+
+extern "C" void* calloc(size_t count, size_t size) {
+    countCall();
+    return __libc_calloc(count, size);
+}
+
+extern "C" void* realloc(void* ptr, size_t size) {
+    countCall();
+    return __libc_realloc(ptr, size);
+}
+#endif
+
+void* operator new(size_t size) {
+    countCall();
+    if (void* p = std::malloc(size ? size : 1)) return p;
+    throw std::bad_alloc();
+}
+
+void* operator new[](size_t size) { return operator new(size); }
+void operator delete(void* p) noexcept { std::free(p); }
+void operator delete[](void* p) noexcept { std::free(p); }
+void operator delete(void* p, size_t) noexcept { std::free(p); }
+void operator delete[](void* p, size_t) noexcept { std::free(p); }
+
+namespace {
+
+void allocationsAreAlignedAndDistinct() {
+    ocr::FrameArena arena(1024);
+    char* a = arena.allocate<char>(3);
+    double* b = arena.allocate<double>(4);
+    void* c = arena.allocate(16, 64);
+    EXPECT_EQ(reinterpret_cast<uintptr_t>(b) % alignof(double), 0u);
+    EXPECT_EQ(reinterpret_cast<uintptr_t>(c) % 64, 0u);
+    EXPECT_TRUE(reinterpret_cast<char*>(b) >= a + 3);
+    EXPECT_TRUE(reinterpret_cast<char*>(c) >= reinterpret_cast<char*>(b + 4));
+    EXPECT_TRUE(arena.used() >= 3 + 4 * sizeof(double) + 16);
+    arena.reset();
+    EXPECT_EQ(arena.used(), 0u);
+    // Storage is handed out again from the start
+    EXPECT_EQ(arena.allocate<char>(3), a);
+}
+
+void growthIsFoldedIntoOneBlockOnReset() {
+    ocr::FrameArena arena(1024);
+    for (int i = 0; i < 10; ++i) arena.allocate(900);
+    size_t grown = arena.heapAllocations();
+    EXPECT_TRUE(grown > 1);
+    arena.reset();
+    size_t afterReset = arena.heapAllocations();
+    for (int frame = 0; frame < 5; ++frame) {
+        for (int i = 0; i < 10; ++i) arena.allocate(900);
+        arena.reset();
+    }
+    EXPECT_EQ(arena.heapAllocations(), afterReset);
+}
+
+void containersUseTheArena() {
+    ocr::FrameArena arena(1024);
+    arena.allocate(1);
+    ocr::ArenaVector<int> values{ocr::ArenaAllocator<int>(arena)};
+    for (int i = 0; i < 100; ++i) values.push_back(i);
+    EXPECT_EQ(values[99], 99);
+    EXPECT_TRUE(arena.used() >= 100 * sizeof(int));
+}
+
+// The kernel half of a frame: letterbox, DB boxes, NMS, crop and CTC decode, with
+// scratch from the arena and outputs in reused buffers.
+struct Frame {
+    ocr::FrameArena arena;
+    ocr::RgbaImage source;
+    ocr::RgbaImage canvas;
+    ocr::RgbaImage crop;
+    std::vector<float> probMap;
+    ocr::QuadSet boxes;
+    std::vector<float> posteriors;
+    ocr::CharDict dict;
+    ocr::Recognition text;
+
+    Frame() {
+        source.resize(320, 240);
+        for (size_t i = 0; i < source.pixels.size(); ++i) source.pixels[i] = 0xFF000000u | static_cast<uint32_t>(i);
+        probMap.assign(80 * 60, 0.0f);
+        for (int y = 20; y < 30; ++y) {
+            for (int x = 10; x < 70; ++x) probMap[y * 80 + x] = 0.9f;
+        }
+        // "0123456789" then a blank, repeated past the short-string buffer
+        const int classes = dict.classCount();
+        for (int t = 0; t < 40; ++t) {
+            int best = t % 2 ? 0 : 1 + (t / 2) % 10;
+            for (int c = 0; c < classes; ++c) posteriors.push_back(c == best ? 0.9f : 0.01f);
+        }
+    }
+
+    void run() {
+        ocr::letterbox(source, 160, 160, canvas, &arena);
+        boxes.clear();
+        ocr::dbBoxes(probMap.data(), 80, 60, ocr::DbParams(), 2.0f, 2.0f, boxes, &arena);
+        ocr::suppressOverlaps(boxes, 0.5f, &arena);
+        for (size_t i = 0; i < boxes.size(); ++i) {
+            float left, top, right, bottom;
+            boxes.bounds(i, left, top, right, bottom);
+            ocr::cropToHeight(canvas, static_cast<int>(left), static_cast<int>(top), static_cast<int>(right),
+                              static_cast<int>(bottom), 48, 320, crop, &arena);
+        }
+        ocr::ctcGreedyDecode(posteriors.data(), 40, dict.classCount(), dict, text);
+        arena.reset();
+    }
+};
+
+void steadyStateFramesDoNotAllocate() {
+    Frame frame;
+    // The first frames size the arena and the reused buffers
+    frame.run();
+    frame.run();
+    EXPECT_EQ(frame.boxes.size(), 1u);
+    EXPECT_EQ(frame.text.text, "01234567890123456789");
+
+    heapCalls.store(0);
+    counting.store(true);
+    for (int i = 0; i < 20; ++i) frame.run();
+    counting.store(false);
+    EXPECT_EQ(heapCalls.load(), 0);
+    EXPECT_EQ(frame.text.text, "01234567890123456789");
+}
+
+} // namespace
+
+int main() {
+    allocationsAreAlignedAndDistinct();
+    growthIsFoldedIntoOneBlockOnReset();
+    containersUseTheArena();
+    steadyStateFramesDoNotAllocate();
+    return TEST_RESULT();
+}
@@ -0,0 +1,147 @@
+#include <cstdint>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "frame_arena.h"
+#include "frame_quality.h"
+#include "test_util.h"
+
+namespace {
+
+// Grey frame of dark vertical bars on a mid background, like digits
+std::vector<uint8_t> bars(int width, int height, int background, int ink) {
+    std::vector<uint8_t> pixels(static_cast<size_t>(width) * height);
+    for (int y = 0; y < height; ++y) {
+        for (int x = 0; x < width; ++x) pixels[y * width + x] = (x / 20) % 2 ? ink : background;
+    }
+    return pixels;
+}
+
+// Horizontal box blur of `radius`, which softens the bars' edges to ramps
+std::vector<uint8_t> blurred(const std::vector<uint8_t>& pixels, int width, int height, int radius) {
+    std::vector<uint8_t> out(pixels.size());
+    for (int y = 0; y < height; ++y) {
+        for (int x = 0; x < width; ++x) {
+            int sum = 0;
+            int n = 0;
+            for (int k = -radius; k <= radius; ++k) {
+                const int sx = x + k;
+                if (sx < 0 || sx >= width) continue;
+                sum += pixels[y * width + sx];
+                ++n;
+            }
+            out[y * width + x] = static_cast<uint8_t>(sum / n);
+        }
+    }
+    return out;
+}
+
+ocr::FrameQuality assess(const std::vector<uint8_t>& pixels, int width, int height) {
+    return ocr::assessQuality(ocr::ImageView::packed(ocr::PixelFormat::A8, pixels.data(), width, height));
+}
+
+void acceptsSharpWellExposedFrames() {
+    const ocr::FrameQuality quality = assess(bars(200, 120, 180, 40), 200, 120);
+    EXPECT_TRUE(quality.usable());
+    EXPECT_NEAR(quality.spread, 140, 1e-3);
+    EXPECT_NEAR(quality.clipped, 0, 1e-6);
+}
+
+void rejectsEachIssue() {
+    EXPECT_TRUE(assess(blurred(bars(200, 120, 180, 40), 200, 120, 6), 200, 120).issue == ocr::QualityIssue::Blur);
+    // Half the frame blown out by a reflection
+    std::vector<uint8_t> glare = bars(200, 120, 180, 40);
+    for (int y = 0; y < 60; ++y) {
+        for (int x = 0; x < 200; ++x) glare[y * 200 + x] = 255;
+    }
+    EXPECT_TRUE(assess(glare, 200, 120).issue == ocr::QualityIssue::Glare);
+    EXPECT_TRUE(assess(bars(200, 120, 30, 5), 200, 120).issue == ocr::QualityIssue::Dark);
+    EXPECT_TRUE(assess(bars(200, 120, 140, 120), 200, 120).issue == ocr::QualityIssue::LowContrast);
+    EXPECT_TRUE(std::string(ocr::qualityIssueName(ocr::QualityIssue::Glare)) == "glare");
+}
+
+void laplacianMatchesScalar() {
+    // Small enough to be its own thumbnail, odd width for the vector tail
+    const int width = 37;
+    const int height = 9;
+    std::mt19937 random(3);
+    std::vector<uint8_t> pixels(width * height);
+    for (uint8_t& p : pixels) p = static_cast<uint8_t>(random() & 0xFF);
+    double sum = 0;
+    double squares = 0;
+    for (int y = 1; y + 1 < height; ++y) {
+        for (int x = 1; x + 1 < width; ++x) {
+            const int i = y * width + x;
+            const int lap = 4 * pixels[i] - pixels[i - 1] - pixels[i + 1] - pixels[i - width] - pixels[i + width];
+            sum += lap;
+            squares += static_cast<double>(lap) * lap;
+        }
+    }
+    const double n = (width - 2) * (height - 2);
+    const double variance = squares / n - (sum / n) * (sum / n);
+    EXPECT_NEAR(assess(pixels, width, height).sharpness, variance, variance * 1e-5);
+}
+
+void readsLumaOfAnyFormat() {
+    // The same bars as NV21: the Y plane decides, chroma is ignored
+    const std::vector<uint8_t> y = bars(200, 120, 180, 40);
+    const std::vector<uint8_t> vu(200 * 60, 128);
+    ocr::FrameArena arena;
+    const ocr::FrameQuality nv21 =
+        ocr::assessQuality(ocr::ImageView::nv21(y.data(), 200, vu.data(), 200, 200, 120), ocr::QualityParams(),
+                           &arena);
+    const ocr::FrameQuality grey = assess(y, 200, 120);
+    EXPECT_NEAR(nv21.sharpness, grey.sharpness, 1e-3);
+    EXPECT_NEAR(nv21.mean, grey.mean, 1e-3);
+
+    // RGBA grey matches within rounding; a large frame is thumbnailed
+    std::vector<uint32_t> rgba(1000 * 600);
+    for (int i = 0; i < 1000 * 600; ++i) {
+        const uint32_t v = (i % 1000 / 100) % 2 ? 40 : 180;
+        rgba[i] = 0xFF000000u | v << 16 | v << 8 | v;
+    }
+    const ocr::FrameQuality large = ocr::assessQuality(ocr::ImageView::rgba(rgba.data(), 1000, 600));
+    EXPECT_TRUE(large.usable());
+    EXPECT_NEAR(large.mean, 110, 4);
+}
+
+void ranksBurstFramesUsableThenSharpest() {
+    ocr::FrameQuality frames[4];
+    frames[0].sharpness = 80.0f;
+    frames[1].sharpness = 900.0f;
+    frames[1].issue = ocr::QualityIssue::Glare;
+    frames[2].sharpness = 250.0f;
+    frames[3].sharpness = 120.0f;
+    std::vector<uint32_t> order;
+    ocr::rankFrames(frames, 4, 2, order);
+    EXPECT_EQ(order.size(), 2u);
+    EXPECT_EQ(order[0], 2u);
+    EXPECT_EQ(order[1], 3u);
+    ocr::rankFrames(frames, 4, 0, order);
+    EXPECT_EQ(order.size(), 4u);
+    EXPECT_EQ(order[3], 1u);
+}
+
+void findsLumaPercentiles() {
+    // 10 pixels at 20, 80 at 100 and 10 at 240
+    uint32_t histogram[256] = {};
+    histogram[20] = 10;
+    histogram[100] = 80;
+    histogram[240] = 10;
+    EXPECT_EQ(ocr::lumaPercentile(histogram, 100, 0.05f), 20);
+    EXPECT_EQ(ocr::lumaPercentile(histogram, 100, 0.1f), 100);
+    EXPECT_EQ(ocr::lumaPercentile(histogram, 100, 0.95f), 240);
+}
+
+} // namespace
+
+int main() {
+    acceptsSharpWellExposedFrames();
+    rejectsEachIssue();
+    laplacianMatchesScalar();
+    readsLumaOfAnyFormat();
+    ranksBurstFramesUsableThenSharpest();
+    findsLumaPercentiles();
+    return TEST_RESULT();
+}
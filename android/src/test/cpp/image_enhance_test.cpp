@@ -0,0 +1,172 @@
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <vector>
+
+#include "frame_arena.h"
+#include "image_enhance.h"
+#include "test_util.h"
+
+namespace {
+
+// Dark digit-like bars on a face lit from the left: 230 falling to 70
+std::vector<uint8_t> unevenlyLit(int width, int height) {
+    std::vector<uint8_t> image(static_cast<size_t>(width) * height);
+    for (int y = 0; y < height; ++y) {
+        for (int x = 0; x < width; ++x) {
+            const float light = 230.0f - 160.0f * x / width;
+            const bool bar = (x / 6) % 3 == 0 && y > height / 4 && y < height * 3 / 4;
+            image[static_cast<size_t>(y) * width + x] = static_cast<uint8_t>(bar ? light * 0.4f : light);
+        }
+    }
+    return image;
+}
+
+uint8_t referenceSauvola(const std::vector<uint8_t>& image, int width, int height, int x, int y,
+                         const ocr::SauvolaParams& params) {
+    double sum = 0.0;
+    double squares = 0.0;
+    int count = 0;
+    for (int v = std::max(0, y - params.radius); v < std::min(height, y + params.radius + 1); ++v) {
+        for (int u = std::max(0, x - params.radius); u < std::min(width, x + params.radius + 1); ++u) {
+            const double value = image[static_cast<size_t>(v) * width + u];
+            sum += value;
+            squares += value * value;
+            ++count;
+        }
+    }
+    const double mean = sum / count;
+    const double deviation = std::sqrt(std::max(0.0, squares / count - mean * mean));
+    const double threshold = mean * (1.0 + params.k * (deviation / params.range - 1.0));
+    return image[static_cast<size_t>(y) * width + x] > threshold ? 255 : 0;
+}
+
+void sauvolaMatchesReference() {
+    const int width = 97;
+    const int height = 41;
+    std::vector<uint8_t> image = unevenlyLit(width, height);
+    for (size_t i = 0; i < image.size(); ++i) image[i] = static_cast<uint8_t>(image[i] ^ (i * 7 % 13));
+    ocr::SauvolaParams params;
+    params.radius = 7;
+    // Strided rows on both sides
+    std::vector<uint8_t> src(static_cast<size_t>(width + 3) * height);
+    for (int y = 0; y < height; ++y) {
+        std::copy_n(image.data() + static_cast<size_t>(y) * width, width,
+                    src.data() + static_cast<size_t>(y) * (width + 3));
+    }
+    std::vector<uint8_t> dst(static_cast<size_t>(width + 5) * height, 7);
+    ocr::sauvolaThreshold(src.data(), width, height, width + 3, dst.data(), width + 5, params);
+
+    int mismatches = 0;
+    for (int y = 0; y < height; ++y) {
+        for (int x = 0; x < width; ++x) {
+            if (dst[static_cast<size_t>(y) * (width + 5) + x] != referenceSauvola(image, width, height, x, y, params)) {
+                ++mismatches;
+            }
+        }
+        EXPECT_EQ(dst[static_cast<size_t>(y) * (width + 5) + width], 7);
+    }
+    // Only pixels within rounding of their threshold may differ
+    EXPECT_TRUE(mismatches <= width * height / 1000);
+}
+
+void sauvolaFollowsTheLight() {
+    const int width = 240;
+    const int height = 60;
+    const std::vector<uint8_t> image = unevenlyLit(width, height);
+    std::vector<uint8_t> dst(image.size());
+    ocr::FrameArena arena;
+    ocr::sauvolaThreshold(image.data(), width, height, width, dst.data(), width, ocr::SauvolaParams(), &arena);
+    // Bars are found at the bright and the dim end alike, where a global
+    // cut-off at 128 keeps them all or none
+    for (int x : {6 * 3, 6 * 3 + 5, 6 * 36, 6 * 36 + 5}) {
+        EXPECT_EQ(dst[static_cast<size_t>(height / 2) * width + x], 0);
+    }
+    for (int x : {6 * 3 + 8, 6 * 36 + 8}) {
+        EXPECT_EQ(dst[static_cast<size_t>(height / 2) * width + x], 255);
+    }
+}
+
+void claheStretchesFlatContrast() {
+    const int width = 512;
+    const int height = 384;
+    std::vector<uint8_t> image(static_cast<size_t>(width) * height);
+    for (int y = 0; y < height; ++y) {
+        for (int x = 0; x < width; ++x) {
+            image[static_cast<size_t>(y) * width + x] = static_cast<uint8_t>(100 + (x + y) % 40);
+        }
+    }
+    std::vector<uint8_t> dst(image.size());
+    ocr::equalizeClahe(image.data(), width, height, width, dst.data(), width);
+    const auto range = std::minmax_element(dst.begin(), dst.end());
+    EXPECT_TRUE(*range.second - *range.first > 2 * 40);
+    // Equalization keeps the order of grey levels within a tile
+    EXPECT_TRUE(dst[static_cast<size_t>(8) * width + 8 + 20] > dst[static_cast<size_t>(8) * width + 8]);
+
+    // Clipping keeps a flat face flat instead of turning it into noise
+    std::vector<uint8_t> flat(image.size(), 120);
+    ocr::equalizeClahe(flat.data(), width, height, width, dst.data(), width);
+    const auto flatRange = std::minmax_element(dst.begin(), dst.end());
+    EXPECT_EQ(*flatRange.first, *flatRange.second);
+    EXPECT_NEAR(*flatRange.first, 120, 12);
+}
+
+void claheWorksInPlace() {
+    const int width = 75;
+    const int height = 50;
+    std::vector<uint8_t> image = unevenlyLit(width, height);
+    std::vector<uint8_t> copy(image.size());
+    ocr::ClaheParams params;
+    params.tilesX = 4;
+    params.tilesY = 3;
+    params.clipLimit = 3.0f;
+    ocr::equalizeClahe(image.data(), width, height, width, copy.data(), width, params);
+    ocr::FrameArena arena;
+    ocr::equalizeClahe(image.data(), width, height, width, image.data(), width, params, &arena);
+    EXPECT_TRUE(image == copy);
+}
+
+void cropVariantsKeepDigitsDark() {
+    // A faint dark bar on a greyish, slightly red crop
+    ocr::RgbaImage crop;
+    crop.resize(40, 12);
+    for (int y = 0; y < crop.height; ++y) {
+        for (int x = 0; x < crop.width; ++x) {
+            const uint32_t grey = x >= 16 && x < 24 ? 100 : 140;
+            crop.pixels[static_cast<size_t>(y) * crop.width + x] = 0xFF000000u | grey << 16 | grey << 8 | (grey + 10);
+        }
+    }
+    const ocr::CropVariant variants[] = {ocr::CropVariant::Binary, ocr::CropVariant::Stretch};
+    ocr::RgbaImage out[2];
+    ocr::cropVariants(crop, variants, 2, out);
+    EXPECT_EQ(out[0].width, crop.width);
+    EXPECT_EQ(out[1].height, crop.height);
+
+    const size_t bar = 5 * crop.width + 20;
+    const size_t face = 5 * crop.width + 4;
+    EXPECT_EQ(out[0].pixels[bar], 0xFF000000u);
+    EXPECT_EQ(out[0].pixels[face], 0xFFFFFFFFu);
+    // Stretched to the full range, red channel kept apart
+    EXPECT_TRUE((out[1].pixels[bar] & 0xFF00) >> 8 < 16);
+    EXPECT_TRUE((out[1].pixels[face] & 0xFF00) >> 8 > 200);
+    EXPECT_TRUE((out[1].pixels[bar] & 0xFF) > ((out[1].pixels[bar] >> 8) & 0xFF));
+    EXPECT_EQ(out[1].pixels[face] >> 24, 0xFFu);
+
+    // A flat crop is not blown up into black and white
+    std::fill(crop.pixels.begin(), crop.pixels.end(), 0xFF787878u);
+    crop.pixels[7] = 0xFF7C7C7Cu;
+    ocr::cropVariants(crop, variants + 1, 1, out);
+    const int level = out[0].pixels[7] & 0xFF;
+    EXPECT_TRUE(level > 100 && level < 200);
+}
+
+} // namespace
+
+int main() {
+    sauvolaMatchesReference();
+    sauvolaFollowsTheLight();
+    claheStretchesFlatContrast();
+    claheWorksInPlace();
+    cropVariantsKeepDigitsDark();
+    return TEST_RESULT();
+}
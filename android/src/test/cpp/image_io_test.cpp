@@ -0,0 +1,260 @@
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include "image_io.h"
+#include "test_util.h"
+
+#ifdef WATER_OCR_HAVE_JPEG
+#include <jpeglib.h>
+#endif
+#ifdef WATER_OCR_HAVE_PNG
+#include <png.h>
+#endif
+
+namespace {
+
+constexpr int kWidth = 128;
+constexpr int kHeight = 96;
+
+// Quadrants of flat colour, split on MCU boundaries so JPEG keeps them clean
+const uint8_t kColours[4][3] = {{200, 40, 40}, {40, 200, 40}, {40, 40, 200}, {220, 220, 220}};
+
+int quadrant(int x, int y) {
+    return (y >= kHeight / 2 ? 2 : 0) + (x >= kWidth / 2 ? 1 : 0);
+}
+
+std::vector<uint8_t> rgbPixels() {
+    std::vector<uint8_t> rgb(kWidth * kHeight * 3);
+    for (int y = 0; y < kHeight; ++y) {
+        for (int x = 0; x < kWidth; ++x) {
+            for (int c = 0; c < 3; ++c) rgb[(y * kWidth + x) * 3 + c] = kColours[quadrant(x, y)][c];
+        }
+    }
+    return rgb;
+}
+
+// Pixel (x, y) of `image` is within `tolerance` of a quadrant's colour
+bool near(const ocr::RgbaImage& image, int x, int y, const uint8_t* rgb, int tolerance) {
+    const uint8_t* p = reinterpret_cast<const uint8_t*>(&image.pixels[static_cast<size_t>(y) * image.width + x]);
+    for (int c = 0; c < 3; ++c) {
+        if (std::abs(p[c] - rgb[c]) > tolerance) return false;
+    }
+    return true;
+}
+
+void rejectsUnknownData() {
+    const uint8_t junk[16] = {1, 2, 3};
+    ocr::RgbaImage image;
+    std::string error;
+    EXPECT_TRUE(!ocr::decodeImage(junk, sizeof(junk), image, error));
+    EXPECT_TRUE(!error.empty());
+}
+
+// A TIFF block with only an orientation tag, as EXIF stores it
+std::vector<uint8_t> exifBlock(int orientation, bool bigEndian) {
+    std::vector<uint8_t> tiff = {'I', 'I', 42, 0, 8, 0, 0, 0, 1, 0, 0x12, 0x01, 3, 0, 1, 0, 0, 0,
+                                 static_cast<uint8_t>(orientation), 0, 0, 0, 0, 0, 0, 0};
+    if (bigEndian) {
+        tiff = {'M', 'M', 0, 42, 0, 0, 0, 8, 0, 1, 0x01, 0x12, 0, 3, 0, 0, 0, 1,
+                0, static_cast<uint8_t>(orientation), 0, 0, 0, 0, 0, 0};
+    }
+    return tiff;
+}
+
+void readsPngOrientation() {
+    // Signature, then an eXIf chunk; the parser stops before any pixels
+    std::vector<uint8_t> png = {0x89, 'P', 'N', 'G', 0x0D, 0x0A, 0x1A, 0x0A};
+    const std::vector<uint8_t> tiff = exifBlock(8, false);
+    const uint8_t header[8] = {0, 0, 0, static_cast<uint8_t>(tiff.size()), 'e', 'X', 'I', 'f'};
+    png.insert(png.end(), header, header + 8);
+    png.insert(png.end(), tiff.begin(), tiff.end());
+    png.insert(png.end(), 4, 0);
+    EXPECT_TRUE(ocr::exifOrientation(png.data(), png.size()) == ocr::Orientation::Rotate270);
+    EXPECT_TRUE(ocr::exifOrientation(png.data(), 8) == ocr::Orientation::Normal);
+}
+
+#ifdef WATER_OCR_HAVE_JPEG
+std::vector<uint8_t> encodeJpeg(int orientation = 0) {
+    std::vector<uint8_t> rgb = rgbPixels();
+    jpeg_compress_struct cinfo;
+    jpeg_error_mgr jerr;
+    cinfo.err = jpeg_std_error(&jerr);
+    jpeg_create_compress(&cinfo);
+    unsigned char* buffer = nullptr;
+    unsigned long size = 0;
+    jpeg_mem_dest(&cinfo, &buffer, &size);
+    cinfo.image_width = kWidth;
+    cinfo.image_height = kHeight;
+    cinfo.input_components = 3;
+    cinfo.in_color_space = JCS_RGB;
+    jpeg_set_defaults(&cinfo);
+    jpeg_set_quality(&cinfo, 95, TRUE);
+    jpeg_start_compress(&cinfo, TRUE);
+    if (orientation) {
+        std::vector<uint8_t> exif = {'E', 'x', 'i', 'f', 0, 0};
+        const std::vector<uint8_t> tiff = exifBlock(orientation, true);
+        exif.insert(exif.end(), tiff.begin(), tiff.end());
+        jpeg_write_marker(&cinfo, JPEG_APP0 + 1, exif.data(), static_cast<unsigned>(exif.size()));
+    }
+    while (cinfo.next_scanline < cinfo.image_height) {
+        JSAMPROW row = &rgb[cinfo.next_scanline * kWidth * 3];
+        jpeg_write_scanlines(&cinfo, &row, 1);
+    }
+    jpeg_finish_compress(&cinfo);
+    std::vector<uint8_t> bytes(buffer, buffer + size);
+    jpeg_destroy_compress(&cinfo);
+    std::free(buffer);
+    return bytes;
+}
+
+void decodesJpegScaled() {
+    const std::vector<uint8_t> jpeg = encodeJpeg();
+    ocr::RgbaImage image;
+    ocr::DecodeInfo info;
+    std::string error;
+    // 1/4 keeps the long side at 32
+    ocr::DecodeOptions options;
+    options.minLongSide = 30;
+    EXPECT_TRUE(ocr::decodeImage(jpeg.data(), jpeg.size(), options, image, &info, error));
+    EXPECT_EQ(info.scale, 4);
+    EXPECT_EQ(info.width, kWidth);
+    EXPECT_EQ(info.height, kHeight);
+    EXPECT_EQ(image.width, kWidth / 4);
+    EXPECT_EQ(image.height, kHeight / 4);
+    EXPECT_TRUE(near(image, 2, 2, kColours[0], 12));
+    EXPECT_TRUE(near(image, 29, 21, kColours[3], 12));
+
+    // A short-side minimum can hold the scale back
+    options.minShortSide = 40;
+    EXPECT_TRUE(ocr::decodeImage(jpeg.data(), jpeg.size(), options, image, &info, error));
+    EXPECT_EQ(info.scale, 2);
+    EXPECT_EQ(image.width, kWidth / 2);
+}
+
+void decodesJpegGrayscale() {
+    const std::vector<uint8_t> jpeg = encodeJpeg();
+    ocr::RgbaImage image;
+    std::string error;
+    ocr::DecodeOptions options;
+    options.grayscale = true;
+    EXPECT_TRUE(ocr::decodeImage(jpeg.data(), jpeg.size(), options, image, nullptr, error));
+    EXPECT_EQ(image.width, kWidth);
+    const uint8_t* p = reinterpret_cast<const uint8_t*>(&image.pixels[10 * kWidth + 10]);
+    EXPECT_TRUE(p[0] == p[1] && p[1] == p[2]);
+    EXPECT_EQ(p[3], 0xFF);
+}
+
+void reportsJpegOrientation() {
+    ocr::RgbaImage image;
+    ocr::DecodeInfo info;
+    std::string error;
+    std::vector<uint8_t> jpeg = encodeJpeg();
+    EXPECT_TRUE(ocr::decodeImage(jpeg.data(), jpeg.size(), ocr::DecodeOptions(), image, &info, error));
+    EXPECT_TRUE(info.orientation == ocr::Orientation::Normal);
+
+    // Pixels stay as stored
+    jpeg = encodeJpeg(6);
+    EXPECT_TRUE(ocr::exifOrientation(jpeg.data(), jpeg.size()) == ocr::Orientation::Rotate90);
+    EXPECT_TRUE(ocr::decodeImage(jpeg.data(), jpeg.size(), ocr::DecodeOptions(), image, &info, error));
+    EXPECT_TRUE(info.orientation == ocr::Orientation::Rotate90);
+    EXPECT_EQ(image.width, kWidth);
+}
+
+void decodesJpegRoi() {
+    const std::vector<uint8_t> jpeg = encodeJpeg();
+    ocr::RgbaImage image;
+    ocr::DecodeInfo info;
+    std::string error;
+    ocr::DecodeOptions options;
+    options.roi = {70, 50, 120, 90};
+    EXPECT_TRUE(ocr::decodeImage(jpeg.data(), jpeg.size(), options, image, &info, error));
+    EXPECT_EQ(image.width, 50);
+    EXPECT_EQ(image.height, 40);
+    EXPECT_EQ(info.roi.left, 70);
+    EXPECT_EQ(info.roi.bottom, 90);
+    EXPECT_TRUE(near(image, 0, 0, kColours[3], 12));
+    EXPECT_TRUE(near(image, 49, 39, kColours[3], 12));
+
+    // Straddling the quadrants, at half scale: edges round outwards
+    options.roi = {60, 10, 69, 31};
+    options.minLongSide = 8;
+    EXPECT_TRUE(ocr::decodeImage(jpeg.data(), jpeg.size(), options, image, &info, error));
+    EXPECT_EQ(info.scale, 2);
+    EXPECT_EQ(info.roi.left, 60);
+    EXPECT_EQ(info.roi.right, 70);
+    EXPECT_EQ(info.roi.bottom, 32);
+    EXPECT_EQ(image.width, 5);
+    EXPECT_EQ(image.height, 11);
+    EXPECT_TRUE(near(image, 0, 5, kColours[0], 16));
+    EXPECT_TRUE(near(image, 4, 5, kColours[1], 16));
+
+    // Clamped to the image; nothing left is an error
+    options = ocr::DecodeOptions();
+    options.roi = {100, 80, 400, 400};
+    EXPECT_TRUE(ocr::decodeImage(jpeg.data(), jpeg.size(), options, image, &info, error));
+    EXPECT_EQ(image.width, 28);
+    EXPECT_EQ(image.height, 16);
+    options.roi = {200, 200, 300, 300};
+    EXPECT_TRUE(!ocr::decodeImage(jpeg.data(), jpeg.size(), options, image, &info, error));
+}
+#endif
+
+#ifdef WATER_OCR_HAVE_PNG
+void decodesPngScaledRoi() {
+    std::vector<uint8_t> rgb = rgbPixels();
+    png_image png;
+    std::memset(&png, 0, sizeof(png));
+    png.version = PNG_IMAGE_VERSION;
+    png.width = kWidth;
+    png.height = kHeight;
+    png.format = PNG_FORMAT_RGB;
+    png_alloc_size_t size = 0;
+    EXPECT_TRUE(png_image_write_to_memory(&png, nullptr, &size, 0, rgb.data(), 0, nullptr));
+    std::vector<uint8_t> bytes(size);
+    EXPECT_TRUE(png_image_write_to_memory(&png, bytes.data(), &size, 0, rgb.data(), 0, nullptr));
+
+    ocr::RgbaImage image;
+    ocr::DecodeInfo info;
+    std::string error;
+    EXPECT_TRUE(ocr::decodeImage(bytes.data(), size, image, error));
+    EXPECT_EQ(image.width, kWidth);
+    EXPECT_TRUE(near(image, 100, 10, kColours[1], 0));
+
+    // Blocks straddling the split average the two colours
+    ocr::DecodeOptions options;
+    options.minLongSide = 16;
+    options.roi = {60, 0, 128, 48};
+    EXPECT_TRUE(ocr::decodeImage(bytes.data(), size, options, image, &info, error));
+    EXPECT_EQ(info.scale, 4);
+    EXPECT_EQ(image.width, 17);
+    EXPECT_EQ(image.height, 12);
+    EXPECT_TRUE(near(image, 0, 0, kColours[0], 0));
+    EXPECT_TRUE(near(image, 16, 11, kColours[1], 0));
+
+    options.grayscale = true;
+    EXPECT_TRUE(ocr::decodeImage(bytes.data(), size, options, image, &info, error));
+    const uint8_t* p = reinterpret_cast<const uint8_t*>(&image.pixels[0]);
+    EXPECT_TRUE(p[0] == p[1] && p[1] == p[2]);
+}
+#endif
+
+} // namespace
+
+int main() {
+    rejectsUnknownData();
+    readsPngOrientation();
+#ifdef WATER_OCR_HAVE_JPEG
+    decodesJpegScaled();
+    decodesJpegGrayscale();
+    reportsJpegOrientation();
+    decodesJpegRoi();
+#endif
+#ifdef WATER_OCR_HAVE_PNG
+    decodesPngScaledRoi();
+#endif
+    return TEST_RESULT();
+}
@@ -0,0 +1,122 @@
+#include <cstdint>
+
+#include "image_ops.h"
+#include "test_util.h"
+
+namespace {
+
+ocr::RgbaImage solid(int width, int height, uint32_t color) {
+    ocr::RgbaImage image;
+    image.resize(width, height);
+    for (uint32_t& p : image.pixels) p = color;
+    return image;
+}
+
+void letterboxKeepsAspectAndPadsWithZeros() {
+    ocr::RgbaImage src = solid(400, 200, 0xFF336699u);
+    ocr::RgbaImage dst;
+    float scale = ocr::letterbox(src, 96, 96, dst);
+    EXPECT_NEAR(scale, 0.24f, 1e-6);
+    EXPECT_EQ(dst.width, 96);
+    EXPECT_EQ(dst.height, 96);
+    // 400x200 -> 96x48: content on top, zero padding below
+    EXPECT_EQ(dst.pixels[10 * 96 + 50], 0xFF336699u);
+    EXPECT_EQ(dst.pixels[47 * 96 + 95], 0xFF336699u);
+    EXPECT_EQ(dst.pixels[48 * 96 + 0], 0u);
+    EXPECT_EQ(dst.pixels[95 * 96 + 95], 0u);
+}
+
+void resizeInterpolatesChannels() {
+    // Left half black, right half white; the middle column blends
+    ocr::RgbaImage src;
+    src.resize(2, 1);
+    src.pixels[0] = 0xFF000000u;
+    src.pixels[1] = 0xFFFFFFFFu;
+    ocr::RgbaImage dst;
+    dst.resize(4, 1);
+    ocr::resizeBilinear(src.pixels.data(), 2, 1, 2, dst.pixels.data(), 4, 1, 4);
+    EXPECT_EQ(dst.pixels[0], 0xFF000000u);
+    EXPECT_EQ(dst.pixels[3], 0xFFFFFFFFu);
+    uint32_t mid = dst.pixels[1] & 0xFF;
+    EXPECT_TRUE(mid > 0 && mid < 0xFF);
+    EXPECT_EQ(dst.pixels[1] >> 24, 0xFFu);
+}
+
+void cropToHeightClampsAndScales() {
+    ocr::RgbaImage src = solid(100, 50, 0xFF0000FFu);
+    ocr::RgbaImage crop;
+    // Rectangle partially outside the image: clamped to 80x20
+    EXPECT_TRUE(ocr::cropToHeight(src, 20, -10, 140, 20, 48, 640, crop));
+    EXPECT_EQ(crop.height, 48);
+    EXPECT_EQ(crop.width, 192);
+    EXPECT_EQ(crop.pixels[0], 0xFF0000FFu);
+    // Width limit
+    EXPECT_TRUE(ocr::cropToHeight(src, 0, 0, 100, 10, 48, 320, crop));
+    EXPECT_EQ(crop.width, 320);
+    // Empty intersection
+    EXPECT_TRUE(!ocr::cropToHeight(src, 200, 0, 300, 10, 48, 320, crop));
+}
+
+// Upright 1:1 copies of the stored image
+//   a b c
+//   d e f
+// for each orientation, as the rows a viewer shows
+void resizeTurnsUpright() {
+    const uint32_t src[6] = {'a', 'b', 'c', 'd', 'e', 'f'};
+    struct Case {
+        ocr::Orientation orientation;
+        const char* upright;
+    };
+    const Case cases[] = {
+        {ocr::Orientation::Normal, "abcdef"},   {ocr::Orientation::FlipHorizontal, "cbafed"},
+        {ocr::Orientation::Rotate180, "fedcba"}, {ocr::Orientation::FlipVertical, "defabc"},
+        {ocr::Orientation::Transpose, "adbecf"}, {ocr::Orientation::Rotate90, "daebfc"},
+        {ocr::Orientation::Transverse, "fcebda"}, {ocr::Orientation::Rotate270, "cfbead"},
+    };
+    for (const Case& c : cases) {
+        const bool swap = ocr::swapsAxes(c.orientation);
+        const int width = swap ? 2 : 3;
+        const int height = swap ? 3 : 2;
+        uint32_t dst[6] = {};
+        ocr::resizeBilinear(src, 3, 2, 3, c.orientation, dst, width, height, width);
+        for (int i = 0; i < 6; ++i) EXPECT_EQ(dst[i], static_cast<uint32_t>(c.upright[i]));
+
+        // Rectangles map to stored pixels and back
+        const ocr::Rect r{1, 0, 2, 2};
+        const ocr::Rect stored = ocr::storedRect(r, c.orientation, 3, 2);
+        const ocr::Rect back = ocr::uprightRect(stored, c.orientation, 3, 2);
+        EXPECT_TRUE(back.left == r.left && back.top == r.top && back.right == r.right && back.bottom == r.bottom);
+    }
+}
+
+void cropToHeightReadsUprightCoordinates() {
+    // 40x20 stored sideways: left half red, right half blue. Turned
+    // clockwise it is 20x40 with red on top
+    ocr::RgbaImage src = solid(40, 20, 0xFF0000FFu);
+    for (int y = 0; y < 20; ++y) {
+        for (int x = 0; x < 20; ++x) src.pixels[y * 40 + x] = 0xFFFF0000u;
+    }
+    ocr::RgbaImage crop;
+    EXPECT_TRUE(ocr::cropToHeight(src, ocr::Orientation::Rotate90, 0, 0, 20, 20, 10, 100, crop));
+    EXPECT_EQ(crop.width, 10);
+    EXPECT_EQ(crop.pixels[5 * 10 + 5], 0xFFFF0000u);
+    EXPECT_TRUE(ocr::cropToHeight(src, ocr::Orientation::Rotate90, 0, 20, 20, 40, 10, 100, crop));
+    EXPECT_EQ(crop.pixels[5 * 10 + 5], 0xFF0000FFu);
+
+    ocr::RgbaImage canvas;
+    EXPECT_NEAR(ocr::letterbox(src, ocr::Orientation::Rotate90, 40, 40, canvas), 1.0f, 1e-6);
+    EXPECT_EQ(canvas.pixels[10 * 40 + 10], 0xFFFF0000u);
+    EXPECT_EQ(canvas.pixels[30 * 40 + 10], 0xFF0000FFu);
+    EXPECT_EQ(canvas.pixels[10 * 40 + 30], 0u);
+}
+
+} // namespace
+
+int main() {
+    letterboxKeepsAspectAndPadsWithZeros();
+    resizeInterpolatesChannels();
+    cropToHeightClampsAndScales();
+    resizeTurnsUpright();
+    cropToHeightReadsUprightCoordinates();
+    return TEST_RESULT();
+}
@@ -0,0 +1,74 @@
+#include <cstdint>
+#include <stdexcept>
+#include <vector>
+
+#include "model_info.h"
+#include "test_util.h"
+
+namespace {
+
+void describe(ocr::ModelInfo& info, std::vector<int64_t> input, std::vector<int64_t> output) {
+    info.label = "rec";
+    ocr::TensorInfo in;
+    in.name = "x";
+    in.dims = std::move(input);
+    in.dimNames.resize(in.dims.size());
+    ocr::TensorInfo out;
+    out.name = "softmax";
+    out.dims = std::move(output);
+    out.dimNames.resize(out.dims.size());
+    info.inputs.push_back(in);
+    info.outputs.push_back(out);
+    info.resolveNames();
+}
+
+bool rejects(const ocr::ModelInfo& info, int height, int classCount) {
+    try {
+        ocr::validateRecModel(info, height, classCount);
+    } catch (const std::runtime_error&) {
+        return true;
+    }
+    return false;
+}
+
+void recHeightComesFromTheModel() {
+    ocr::ModelInfo info;
+    describe(info, {-1, 3, 32, -1}, {-1, -1, 11});
+    int height = 0;
+    ocr::validateRecModel(info, height, 11);
+    EXPECT_EQ(height, 32);
+    height = 32;
+    ocr::validateRecModel(info, height, 11);
+    EXPECT_TRUE(rejects(info, 48, 11));
+}
+
+void recClassesMustMatchTheDictionary() {
+    // PP-OCR v2.0 rec with the digits-only default dictionary
+    ocr::ModelInfo info;
+    describe(info, {-1, 3, 32, -1}, {-1, -1, 6625});
+    EXPECT_TRUE(rejects(info, 32, 11));
+    EXPECT_TRUE(!rejects(info, 32, 6625));
+
+    // Undeclared shapes pass until an output is seen
+    ocr::ModelInfo undeclared;
+    describe(undeclared, {}, {});
+    int height = 0;
+    ocr::validateRecModel(undeclared, height, 11);
+    EXPECT_EQ(height, 0);
+    bool threw = false;
+    try {
+        ocr::validateRecClasses(undeclared, {1, 40, 6625}, 11);
+    } catch (const std::runtime_error&) {
+        threw = true;
+    }
+    EXPECT_TRUE(threw);
+    ocr::validateRecClasses(undeclared, {1, 40, 11}, 11);
+}
+
+} // namespace
+
+int main() {
+    recHeightComesFromTheModel();
+    recClassesMustMatchTheDictionary();
+    return TEST_RESULT();
+}
@@ -0,0 +1,258 @@
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+#include "pixel_convert.h"
+#include "test_util.h"
+
+namespace {
+
+// 2x2 RGBA image in a buffer with one pixel of row padding
+std::vector<uint8_t> rgbaWithPadding() {
+    return {
+        10, 20, 30, 255, 40, 50, 60, 255, 0xEE, 0xEE, 0xEE, 0xEE,
+        70, 80, 90, 255, 100, 110, 120, 255, 0xEE, 0xEE, 0xEE, 0xEE,
+    };
+}
+
+void readsRgbaInMemoryOrder() {
+    std::vector<uint8_t> pixels = rgbaWithPadding();
+    ocr::ImageView view = ocr::ImageView::packed(ocr::PixelFormat::Rgba8888, pixels.data(), 2, 2, 12);
+    ocr::TensorSpec spec;
+    spec.planeWidth = 3;
+    spec.planeHeight = 2;
+    std::vector<float> chw(3 * 3 * 2, -1.0f);
+    ocr::writeTensor(view, spec, chw.data());
+    // Channel 0 is red, taken from the first byte of each pixel
+    EXPECT_NEAR(chw[0], 10 / 255.0, 1e-6);
+    EXPECT_NEAR(chw[6], 20 / 255.0, 1e-6);
+    EXPECT_NEAR(chw[12], 30 / 255.0, 1e-6);
+    EXPECT_NEAR(chw[3 + 1], 100 / 255.0, 1e-6);
+    // Padding beyond the image is left alone, and the row padding never read
+    EXPECT_EQ(chw[2], -1.0f);
+    EXPECT_EQ(chw[5], -1.0f);
+
+    spec.bgr = true;
+    ocr::writeTensor(view, spec, chw.data());
+    EXPECT_NEAR(chw[0], 30 / 255.0, 1e-6);
+    EXPECT_NEAR(chw[12], 10 / 255.0, 1e-6);
+}
+
+void writesHwcBytesAndHalves() {
+    std::vector<uint8_t> pixels = rgbaWithPadding();
+    ocr::ImageView view = ocr::ImageView::packed(ocr::PixelFormat::Rgba8888, pixels.data(), 2, 2, 12);
+    ocr::TensorSpec spec;
+    spec.layout = ocr::TensorLayout::Hwc;
+    spec.type = ocr::TensorType::U8;
+    spec.planeWidth = 2;
+    spec.planeHeight = 2;
+    uint8_t hwc[12];
+    ocr::writeTensor(view, spec, hwc);
+    const uint8_t expected[12] = {10, 20, 30, 40, 50, 60, 70, 80, 90, 100, 110, 120};
+    EXPECT_TRUE(std::memcmp(hwc, expected, sizeof(hwc)) == 0);
+
+    // Mean/std normalization folded into scale and bias
+    spec.type = ocr::TensorType::F16;
+    for (int c = 0; c < 3; ++c) {
+        spec.scale[c] = 1.0f / (255.0f * 0.5f);
+        spec.bias[c] = -1.0f;
+    }
+    uint16_t halves[12];
+    ocr::writeTensor(view, spec, halves);
+    EXPECT_NEAR(ocr::halfToFloat(halves[0]), 10 / 127.5 - 1, 1e-3);
+    EXPECT_NEAR(ocr::halfToFloat(halves[11]), 120 / 127.5 - 1, 1e-3);
+}
+
+void convertsHalfFloats() {
+    EXPECT_EQ(ocr::floatToHalf(1.0f), 0x3C00);
+    EXPECT_EQ(ocr::floatToHalf(-2.0f), 0xC000);
+    EXPECT_EQ(ocr::floatToHalf(0.5f), 0x3800);
+    EXPECT_EQ(ocr::floatToHalf(65504.0f), 0x7BFF);
+    EXPECT_EQ(ocr::floatToHalf(1e6f), 0x7C00);
+    EXPECT_EQ(ocr::floatToHalf(0.0f), 0x0000);
+    // Smallest subnormal
+    EXPECT_EQ(ocr::floatToHalf(5.9604645e-8f), 0x0001);
+    for (uint16_t bits : {0x0001, 0x03FF, 0x3555, 0x3C00, 0x7BFF, 0xBC00}) {
+        EXPECT_EQ(ocr::floatToHalf(ocr::halfToFloat(bits)), bits);
+    }
+}
+
+void readsBitmapFormats() {
+    ocr::TensorSpec spec;
+    spec.layout = ocr::TensorLayout::Hwc;
+    spec.type = ocr::TensorType::U8;
+    spec.planeWidth = 2;
+    spec.planeHeight = 1;
+    uint8_t out[6];
+
+    // RGB_565: pure red, pure blue
+    const uint16_t rgb565[2] = {0xF800, 0x001F};
+    ocr::writeTensor(ocr::ImageView::packed(ocr::PixelFormat::Rgb565, rgb565, 2, 1), spec, out);
+    const uint8_t red565[6] = {255, 0, 0, 0, 0, 255};
+    EXPECT_TRUE(std::memcmp(out, red565, sizeof(out)) == 0);
+
+    // A_8 as grey
+    const uint8_t alpha[2] = {7, 200};
+    ocr::writeTensor(ocr::ImageView::packed(ocr::PixelFormat::A8, alpha, 2, 1), spec, out);
+    EXPECT_EQ(out[0], 7);
+    EXPECT_EQ(out[2], 7);
+    EXPECT_EQ(out[4], 200);
+
+    // RGBA_F16, clamped to [0, 1]
+    const uint16_t f16[8] = {ocr::floatToHalf(1.0f), ocr::floatToHalf(0.5f), ocr::floatToHalf(-1.0f), 0x3C00,
+                             ocr::floatToHalf(2.0f), 0, 0, 0x3C00};
+    ocr::writeTensor(ocr::ImageView::packed(ocr::PixelFormat::RgbaF16, f16, 2, 1), spec, out);
+    EXPECT_EQ(out[0], 255);
+    EXPECT_EQ(out[1], 128);
+    EXPECT_EQ(out[2], 0);
+    EXPECT_EQ(out[3], 255);
+}
+
+void readsYuvWithChromaAlignedToTheImage() {
+    // 4x2 frame: left half grey, right half red (Y 76, U 85, V 255)
+    const uint8_t y[8] = {128, 128, 76, 76, 128, 128, 76, 76};
+    const uint8_t vu[4] = {128, 128, 255, 85};
+    const uint8_t u[2] = {128, 85};
+    const uint8_t v[2] = {128, 255};
+    const uint8_t uv[4] = {128, 128, 85, 255};
+    const ocr::ImageView nv21 = ocr::ImageView::nv21(y, 4, vu, 4, 4, 2);
+    const ocr::ImageView i420 = ocr::ImageView::i420(y, 4, u, 2, v, 2, 4, 2);
+    const ocr::ImageView nv12 = ocr::ImageView::nv12(y, 4, uv, 4, 4, 2);
+
+    for (const ocr::ImageView& view : {nv21, i420, nv12}) {
+        ocr::RgbaImage rgba;
+        ocr::convertToRgba(view, rgba);
+        EXPECT_EQ(rgba.width, 4);
+        const uint8_t* grey = reinterpret_cast<const uint8_t*>(&rgba.pixels[4]);
+        EXPECT_EQ(grey[0], 128);
+        EXPECT_EQ(grey[1], 128);
+        EXPECT_EQ(grey[2], 128);
+        EXPECT_EQ(grey[3], 255);
+        const uint8_t* red = reinterpret_cast<const uint8_t*>(&rgba.pixels[7]);
+        EXPECT_NEAR(red[0], 254, 1);
+        EXPECT_NEAR(red[1], 1, 1);
+        EXPECT_NEAR(red[2], 0, 1);
+
+        // An ROI starting on an odd column still takes its chroma from the
+        // pair that column belongs to
+        ocr::RgbaImage right;
+        ocr::convertToRgba(view.cropped({1, 0, 3, 2}), right);
+        EXPECT_EQ(right.width, 2);
+        EXPECT_EQ(reinterpret_cast<const uint8_t*>(&right.pixels[0])[0], 128);
+        EXPECT_NEAR(reinterpret_cast<const uint8_t*>(&right.pixels[1])[0], 254, 1);
+    }
+}
+
+void viewsRgbaInPlace() {
+    std::vector<uint32_t> pixels(6 * 4);
+    for (size_t i = 0; i < pixels.size(); ++i) pixels[i] = static_cast<uint32_t>(i);
+    // 5x4 image in rows of six pixels
+    ocr::ImageView view = ocr::ImageView::rgba(pixels.data(), 5, 4, 6).cropped({1, 2, 9, 3});
+    EXPECT_EQ(view.roi.right, 5);
+    EXPECT_EQ(view.roi.height(), 1);
+    int stride = 0;
+    const uint32_t* roi = view.rgbaPixels(stride);
+    EXPECT_EQ(stride, 6);
+    EXPECT_TRUE(roi == pixels.data() + 2 * 6 + 1);
+
+    ocr::RgbaImage copy;
+    ocr::convertToRgba(view, copy);
+    EXPECT_EQ(copy.width, 4);
+    EXPECT_EQ(copy.pixels[0], 13u);
+    EXPECT_EQ(copy.pixels[3], 16u);
+
+    EXPECT_TRUE(ocr::ImageView::packed(ocr::PixelFormat::A8, pixels.data(), 5, 4).rgbaPixels(stride) == nullptr);
+    EXPECT_TRUE(view.cropped({7, 0, 9, 4}).empty());
+}
+
+void validatesRawPlanes() {
+    const uint8_t y[6 * 3] = {};
+    const uint8_t vu[6 * 2] = {};
+    const void* planes[3] = {y, vu, nullptr};
+    const int strides[3] = {6, 6, 0};
+    // 5x3 NV21: chroma rows hold three V/U pairs
+    ocr::ImageView view = ocr::ImageView::fromPlanes(ocr::PixelFormat::Nv21, planes, strides, 5, 3);
+    EXPECT_TRUE(view.valid());
+    EXPECT_EQ(view.planeSize(0), 2u * 6 + 5);
+    EXPECT_EQ(view.planeSize(1), 6u + 6);
+    EXPECT_EQ(view.planeSize(2), 0u);
+
+    const int shortStrides[3] = {6, 4, 0};
+    EXPECT_TRUE(!ocr::ImageView::fromPlanes(ocr::PixelFormat::Nv21, planes, shortStrides, 5, 3).valid());
+    EXPECT_TRUE(!ocr::ImageView::fromPlanes(ocr::PixelFormat::I420, planes, strides, 5, 3).valid());
+    EXPECT_TRUE(ocr::ImageView::fromPlanes(ocr::PixelFormat::Nv12, planes, strides, 5, 3).valid());
+    EXPECT_EQ(ocr::ImageView::fromPlanes(ocr::PixelFormat::Nv12, planes, strides, 5, 3).planeSize(1), 6u + 6);
+    EXPECT_TRUE(!ocr::ImageView::fromPlanes(ocr::PixelFormat::Rgba8888, planes, strides, 2, 3).valid());
+    EXPECT_TRUE(ocr::ImageView::fromPlanes(ocr::PixelFormat::A8, planes, strides, 6, 3).valid());
+    EXPECT_TRUE(!ocr::ImageView::fromPlanes(ocr::PixelFormat::A8, planes, strides, 0, 3).valid());
+}
+
+// Pixel whose red is its column and green its row
+uint32_t coordinatePixel(int x, int y) {
+    return 0xFF000000u | static_cast<uint32_t>(y * 16) << 8 | static_cast<uint32_t>(x * 16);
+}
+
+void samplesQuadsFromTheView() {
+    std::vector<uint32_t> pixels(5 * 4);
+    for (int y = 0; y < 4; ++y) {
+        for (int x = 0; x < 5; ++x) pixels[y * 5 + x] = coordinatePixel(x, y);
+    }
+    const ocr::ImageView view = ocr::ImageView::rgba(pixels.data(), 5, 4);
+
+    // An axis-aligned quad is the plain crop
+    const float rect[8] = {1, 1, 4, 1, 4, 3, 1, 3};
+    ocr::RgbaImage crop;
+    EXPECT_TRUE(ocr::sampleQuad(view, rect, 2, 100, crop));
+    EXPECT_EQ(crop.width, 3);
+    EXPECT_EQ(crop.height, 2);
+    EXPECT_EQ(crop.pixels[0], coordinatePixel(1, 1));
+    EXPECT_EQ(crop.pixels[5], coordinatePixel(3, 2));
+
+    // Text running bottom to top comes out level: the quad's top-left is the
+    // image's bottom-left
+    const float rotated[8] = {0, 4, 0, 0, 4, 0, 4, 4};
+    ocr::RgbaImage level;
+    EXPECT_TRUE(ocr::sampleQuad(view, rotated, 4, 100, level));
+    EXPECT_EQ(level.width, 4);
+    EXPECT_EQ(level.pixels[0], coordinatePixel(0, 3));
+    EXPECT_EQ(level.pixels[3], coordinatePixel(0, 0));
+    EXPECT_EQ(level.pixels[3 * 4], coordinatePixel(3, 3));
+
+    // Width is capped, and taps never leave the ROI
+    const ocr::ImageView roi = view.cropped({1, 1, 3, 3});
+    EXPECT_TRUE(ocr::sampleQuad(roi, rect, 2, 2, crop));
+    EXPECT_EQ(crop.width, 2);
+    EXPECT_EQ(crop.pixels[3], coordinatePixel(2, 2));
+
+    const float point[8] = {2, 2, 2, 2, 2, 2, 2, 2};
+    EXPECT_TRUE(!ocr::sampleQuad(view, point, 2, 100, crop));
+}
+
+void samplesQuadsFromYuv() {
+    // The grey/red frame of readsYuvWithChromaAlignedToTheImage
+    const uint8_t y[8] = {128, 128, 76, 76, 128, 128, 76, 76};
+    const uint8_t vu[4] = {128, 128, 255, 85};
+    const float right[8] = {2, 0, 4, 0, 4, 2, 2, 2};
+    ocr::RgbaImage crop;
+    EXPECT_TRUE(ocr::sampleQuad(ocr::ImageView::nv21(y, 4, vu, 4, 4, 2), right, 2, 100, crop));
+    EXPECT_EQ(crop.width, 2);
+    const uint8_t* red = reinterpret_cast<const uint8_t*>(&crop.pixels[3]);
+    EXPECT_NEAR(red[0], 254, 1);
+    EXPECT_NEAR(red[1], 1, 1);
+    EXPECT_EQ(red[3], 255);
+}
+
+} // namespace
+
+int main() {
+    readsRgbaInMemoryOrder();
+    writesHwcBytesAndHalves();
+    convertsHalfFloats();
+    readsBitmapFormats();
+    readsYuvWithChromaAlignedToTheImage();
+    viewsRgbaInPlace();
+    validatesRawPlanes();
+    samplesQuadsFromTheView();
+    samplesQuadsFromYuv();
+    return TEST_RESULT();
+}
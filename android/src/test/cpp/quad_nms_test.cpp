@@ -0,0 +1,117 @@
+#include <cmath>
+
+#include "frame_arena.h"
+#include "quad_nms.h"
+#include "test_util.h"
+
+namespace {
+
+// Square of side 2 * half centred on (cx, cy), rotated by `angle` radians
+void pushSquare(ocr::QuadSet& quads, float cx, float cy, float half, float angle, float score) {
+    const float c = std::cos(angle), s = std::sin(angle);
+    const float corners[4][2] = {{-half, -half}, {half, -half}, {half, half}, {-half, half}};
+    float quad[8];
+    for (int i = 0; i < 4; ++i) {
+        quad[2 * i] = cx + corners[i][0] * c - corners[i][1] * s;
+        quad[2 * i + 1] = cy + corners[i][0] * s + corners[i][1] * c;
+    }
+    quads.push(quad, score);
+}
+
+void computesQuadIou() {
+    ocr::QuadSet quads;
+    quads.pushRect(0, 0, 10, 10, 1.0f);
+    quads.pushRect(5, 0, 15, 10, 1.0f);
+    quads.pushRect(20, 20, 30, 30, 1.0f);
+    EXPECT_NEAR(ocr::quadIou(quads, 0, 1), 50.0 / 150.0, 1e-5);
+    EXPECT_NEAR(ocr::quadIou(quads, 0, 2), 0, 1e-6);
+
+    // A square and itself rotated by 45 degrees: the overlap is a regular
+    // octagon of area 8 * (sqrt(2) - 1) * half^2
+    pushSquare(quads, 0, 0, 1, 0, 1.0f);
+    pushSquare(quads, 0, 0, 1, static_cast<float>(M_PI / 4), 1.0f);
+    const double octagon = 8 * (std::sqrt(2.0) - 1);
+    EXPECT_NEAR(ocr::quadIou(quads, 3, 4), octagon / (8 - octagon), 1e-4);
+    EXPECT_NEAR(ocr::quadIou(quads, 4, 3), octagon / (8 - octagon), 1e-4);
+}
+
+void suppressesAxisAlignedOverlaps() {
+    ocr::QuadSet quads;
+    quads.pushRect(0, 0, 100, 20, 0.7f);
+    quads.pushRect(2, 1, 101, 21, 0.9f);  // duplicate of the first
+    quads.pushRect(0, 40, 100, 60, 0.8f); // separate line
+    quads.pushRect(50, 0, 150, 20, 0.6f); // IoU 1/3 with the first
+    ocr::FrameArena arena;
+    ocr::suppressOverlaps(quads, 0.5f, &arena);
+    EXPECT_EQ(quads.size(), 3u);
+    EXPECT_NEAR(quads.score(0), 0.9, 1e-6);
+    EXPECT_NEAR(quads.score(1), 0.8, 1e-6);
+    EXPECT_NEAR(quads.score(2), 0.6, 1e-6);
+
+    // A suppressed quad does not suppress others in turn
+    ocr::QuadSet chain;
+    chain.pushRect(0, 0, 10, 10, 0.9f);
+    chain.pushRect(3, 0, 13, 10, 0.8f);
+    chain.pushRect(6, 0, 16, 10, 0.7f);
+    ocr::suppressOverlaps(chain, 0.4f);
+    EXPECT_EQ(chain.size(), 2u);
+    EXPECT_NEAR(chain.x(0, 1), 6, 1e-6);
+}
+
+void suppressesRotatedOverlaps() {
+    ocr::QuadSet quads;
+    pushSquare(quads, 50, 50, 20, 0.3f, 0.9f);
+    pushSquare(quads, 51, 50, 20, 0.32f, 0.8f);
+    pushSquare(quads, 200, 50, 20, 0.3f, 0.7f);
+    ocr::suppressOverlaps(quads, 0.5f);
+    EXPECT_EQ(quads.size(), 2u);
+    EXPECT_NEAR(quads.score(1), 0.7, 1e-6);
+}
+
+void handlesMoreThanOneMaskWord() {
+    ocr::QuadSet quads;
+    for (int i = 0; i < 150; ++i) {
+        // Pairs of duplicates spread along a row
+        quads.pushRect(i / 2 * 20.0f, 0, i / 2 * 20.0f + 10, 10, 1.0f - i * 0.001f);
+    }
+    ocr::suppressOverlaps(quads, 0.5f);
+    EXPECT_EQ(quads.size(), 75u);
+}
+
+void mergesDigitsOnOneBaseline() {
+    ocr::QuadSet quads;
+    // Five digits of a reading, a label above and a digit on another line
+    for (int i = 0; i < 5; ++i) quads.pushRect(100 + i * 22.0f, 50 + (i % 2), 120 + i * 22.0f, 80, 0.8f);
+    quads.pushRect(100, 0, 220, 15, 0.95f);
+    quads.pushRect(100, 150, 120, 180, 0.7f);
+    ocr::LineMergeParams params;
+    ocr::FrameArena arena;
+    ocr::mergeLines(quads, params, &arena);
+    EXPECT_EQ(quads.size(), 3u);
+    EXPECT_NEAR(quads.score(0), 0.95, 1e-6);
+    EXPECT_NEAR(quads.score(1), 0.8, 1e-6);
+    float left, top, right, bottom;
+    quads.bounds(1, left, top, right, bottom);
+    EXPECT_NEAR(left, 100, 1e-6);
+    EXPECT_NEAR(right, 208, 1e-6);
+    EXPECT_NEAR(top, 50, 1e-6);
+    EXPECT_NEAR(bottom, 80, 1e-6);
+
+    // A gap wider than maxGap keeps boxes apart
+    ocr::QuadSet apart;
+    apart.pushRect(0, 0, 20, 30, 0.5f);
+    apart.pushRect(60, 0, 80, 30, 0.5f);
+    ocr::mergeLines(apart, params);
+    EXPECT_EQ(apart.size(), 2u);
+}
+
+} // namespace
+
+int main() {
+    computesQuadIou();
+    suppressesAxisAlignedOverlaps();
+    suppressesRotatedOverlaps();
+    handlesMoreThanOneMaskWord();
+    mergesDigitsOnOneBaseline();
+    return TEST_RESULT();
+}
@@ -0,0 +1,95 @@
+#include <cmath>
+#include <cstdint>
+
+#include "quad_set.h"
+#include "test_util.h"
+
+namespace {
+
+void storesCornersScoreAndAngle() {
+    ocr::QuadSet quads;
+    quads.pushRect(1, 2, 11, 7, 0.8f);
+    // Square rotated by 45 degrees around (0, 0)
+    const float diamond[8] = {0, -1, 1, 0, 0, 1, -1, 0};
+    quads.push(diamond, 0.6f);
+    EXPECT_EQ(quads.size(), 2u);
+    EXPECT_EQ(quads.capacity() % ocr::QuadSet::kLanes, 0u);
+
+    float corners[8];
+    quads.corners(0, corners);
+    EXPECT_NEAR(corners[2], 11, 1e-6);
+    EXPECT_NEAR(corners[3], 2, 1e-6);
+    EXPECT_NEAR(corners[7], 7, 1e-6);
+    EXPECT_NEAR(quads.score(0), 0.8, 1e-6);
+    EXPECT_NEAR(quads.angle(0), 0, 1e-6);
+    EXPECT_NEAR(quads.angle(1), std::atan2(1.0, 1.0), 1e-6);
+
+    float left, top, right, bottom;
+    quads.bounds(1, left, top, right, bottom);
+    EXPECT_NEAR(left, -1, 1e-6);
+    EXPECT_NEAR(top, -1, 1e-6);
+    EXPECT_NEAR(right, 1, 1e-6);
+    EXPECT_NEAR(bottom, 1, 1e-6);
+}
+
+void growsWithoutLosingPlanes() {
+    ocr::QuadSet quads;
+    for (int i = 0; i < 100; ++i) quads.pushRect(i, i, i + 1, i + 2, i / 100.0f);
+    EXPECT_EQ(quads.size(), 100u);
+    EXPECT_NEAR(quads.x(1, 57), 58, 1e-6);
+    EXPECT_NEAR(quads.y(3, 99), 101, 1e-6);
+    EXPECT_NEAR(quads.score(42), 0.42, 1e-6);
+
+    ocr::QuadSet more;
+    more.pushRect(0, 0, 1, 1, 1.0f);
+    more.append(quads);
+    EXPECT_EQ(more.size(), 101u);
+    EXPECT_NEAR(more.x(0, 58), 57, 1e-6);
+
+    size_t capacity = more.capacity();
+    more.clear();
+    EXPECT_TRUE(more.empty());
+    EXPECT_EQ(more.capacity(), capacity);
+}
+
+void sortsFiltersAndTransforms() {
+    ocr::QuadSet quads;
+    const float scores[5] = {0.3f, 0.9f, 0.5f, 0.9f, 0.1f};
+    for (int i = 0; i < 5; ++i) quads.pushRect(i * 10, 0, i * 10 + 5, 5, scores[i]);
+
+    quads.sortByScore();
+    // Equal scores keep their input order
+    EXPECT_NEAR(quads.x(0, 0), 10, 1e-6);
+    EXPECT_NEAR(quads.x(0, 1), 30, 1e-6);
+    EXPECT_NEAR(quads.x(0, 2), 20, 1e-6);
+    EXPECT_NEAR(quads.score(4), 0.1, 1e-6);
+
+    quads.filterByScore(0.4f);
+    EXPECT_EQ(quads.size(), 3u);
+    EXPECT_NEAR(quads.x(2, 2), 25, 1e-6);
+
+    const uint8_t keep[3] = {0, 1, 1};
+    quads.compact(keep);
+    EXPECT_EQ(quads.size(), 2u);
+    EXPECT_NEAR(quads.x(0, 0), 30, 1e-6);
+
+    const uint32_t order[1] = {1};
+    quads.permute(order, 1);
+    EXPECT_EQ(quads.size(), 1u);
+    EXPECT_NEAR(quads.x(0, 0), 20, 1e-6);
+
+    quads.translate(1, 2);
+    quads.scale(2, 4);
+    EXPECT_NEAR(quads.x(0, 0), 42, 1e-6);
+    EXPECT_NEAR(quads.y(2, 0), 28, 1e-6);
+    EXPECT_NEAR(quads.angle(0), 0, 1e-6);
+}
+
+} // namespace
+
+int main() {
+    storesCornersScoreAndAngle();
+    growsWithoutLosingPlanes();
+    sortsFiltersAndTransforms();
+    return TEST_RESULT();
+}
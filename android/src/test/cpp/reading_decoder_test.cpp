@@ -0,0 +1,193 @@
+#include <cstdio>
+#include <fstream>
+#include <utility>
+#include <vector>
+
+#include "frame_arena.h"
+#include "reading_decoder.h"
+#include "test_util.h"
+
+namespace {
+
+// Classes of the test dictionary: blank, '0'..'9', '.', 'O', 'S', ' '
+constexpr int kClasses = 15;
+constexpr int kDot = 11;
+constexpr int kLetterO = 12;
+
+int digit(int d) { return d + 1; }
+
+ocr::CharDict meterDict() {
+    const char* path = "reading_decoder_test_dict.txt";
+    {
+        std::ofstream out(path);
+        for (char c = '0'; c <= '9'; ++c) out << c << '\n';
+        out << ".\nO\nS\n";
+    }
+    ocr::CharDict dict;
+    dict.load(path);
+    std::remove(path);
+    return dict;
+}
+
+// One step per entry, each putting the given mass on its classes and
+// spreading the rest evenly
+using Step = std::vector<std::pair<int, float>>;
+
+std::vector<float> posteriors(const std::vector<Step>& steps) {
+    std::vector<float> probs;
+    for (const Step& step : steps) {
+        float mass = 0.0f;
+        for (const auto& entry : step) mass += entry.second;
+        const size_t offset = probs.size();
+        probs.resize(offset + kClasses, (1.0f - mass) / (kClasses - step.size()));
+        for (const auto& entry : step) probs[offset + entry.first] = entry.second;
+    }
+    return probs;
+}
+
+// A clear path of digits with blanks between them
+std::vector<Step> digits(const char* text) {
+    std::vector<Step> steps;
+    for (const char* c = text; *c; ++c) {
+        steps.push_back({{*c == '.' ? kDot : digit(*c - '0'), 0.9f}});
+        steps.push_back({{0, 0.9f}});
+    }
+    return steps;
+}
+
+ocr::Recognition decode(const std::vector<Step>& steps, const ocr::ReadingGrammar& grammar,
+                        const ocr::ReadingPrior& prior = ocr::ReadingPrior()) {
+    static const ocr::CharDict dict = meterDict();
+    ocr::ReadingDecoder decoder(dict);
+    std::vector<float> probs = posteriors(steps);
+    ocr::Recognition result;
+    decoder.decode(probs.data(), static_cast<int>(steps.size()), kClasses, grammar, prior, result);
+    return result;
+}
+
+void parsesGrammars() {
+    ocr::ReadingGrammar grammar;
+    EXPECT_TRUE(ocr::parseReadingGrammar("5+3", grammar));
+    EXPECT_EQ(grammar.minDigits, 5);
+    EXPECT_EQ(grammar.maxDigits, 5);
+    EXPECT_EQ(grammar.fractionDigits, 3);
+    EXPECT_TRUE(ocr::parseReadingGrammar("4-7", grammar));
+    EXPECT_EQ(grammar.minDigits, 4);
+    EXPECT_EQ(grammar.maxDigits, 7);
+    EXPECT_EQ(grammar.fractionDigits, 0);
+    EXPECT_TRUE(!ocr::parseReadingGrammar("", grammar));
+    EXPECT_TRUE(!ocr::parseReadingGrammar("7-4", grammar));
+    EXPECT_TRUE(!ocr::parseReadingGrammar("5+", grammar));
+    EXPECT_TRUE(!ocr::parseReadingGrammar("5x", grammar));
+    EXPECT_TRUE(!ocr::parseReadingGrammar("12+8", grammar));
+}
+
+void findsDigitClasses() {
+    EXPECT_TRUE(ocr::ReadingDecoder(ocr::CharDict()).valid());
+    EXPECT_TRUE(ocr::ReadingDecoder(meterDict()).valid());
+}
+
+void readsLettersAsDigits() {
+    // Greedy decoding would read the first character as 'O'
+    std::vector<Step> steps = digits("04521");
+    steps[0] = {{kLetterO, 0.6f}, {digit(0), 0.3f}};
+    ocr::ReadingGrammar grammar;
+    ocr::Recognition result = decode(steps, grammar);
+    EXPECT_EQ(result.text, "04521");
+    EXPECT_EQ(result.charConfidences.size(), 5u);
+    EXPECT_NEAR(result.charConfidences[0], 0.3, 1e-6);
+    EXPECT_EQ(result.fractionDigits, 0);
+}
+
+void keepsRepeatedDigitsApart() {
+    // "00" needs a blank between the zeros; without one it is a single zero
+    ocr::ReadingGrammar grammar;
+    EXPECT_EQ(decode(digits("10025"), grammar).text, "10025");
+    std::vector<Step> steps = {{{digit(1), 0.9f}}, {{digit(0), 0.9f}}, {{digit(0), 0.9f}}, {{0, 0.9f}},
+                               {{digit(2), 0.9f}}, {{digit(5), 0.9f}}, {{digit(7), 0.9f}}};
+    EXPECT_EQ(decode(steps, grammar).text, "10257");
+}
+
+void enforcesLength() {
+    ocr::ReadingGrammar grammar;
+    ocr::parseReadingGrammar("4-6", grammar);
+    ocr::Recognition result = decode(digits("452"), grammar);
+    EXPECT_TRUE(result.text.empty());
+    EXPECT_EQ(result.confidence, 0.0f);
+    EXPECT_EQ(decode(digits("1234567"), grammar).text.size(), 6u);
+}
+
+void readsDecimals() {
+    ocr::ReadingGrammar grammar;
+    ocr::parseReadingGrammar("5+3", grammar);
+    // Red drum digits read as a plain run
+    ocr::Recognition red = decode(digits("04521123"), grammar);
+    EXPECT_EQ(red.text, "04521123");
+    EXPECT_EQ(red.fractionDigits, 3);
+    // A separator the model saw is dropped from the text
+    ocr::Recognition dotted = decode(digits("04521.12"), grammar);
+    EXPECT_EQ(dotted.text, "0452112");
+    EXPECT_EQ(dotted.fractionDigits, 2);
+    // The integer part alone is also a reading
+    EXPECT_EQ(decode(digits("04521"), grammar).fractionDigits, 0);
+
+    // Without decimals in the grammar the separator is not a symbol
+    ocr::ReadingGrammar plain;
+    EXPECT_EQ(decode(digits("04521.12"), plain).text, "0452112");
+}
+
+void priorPrefersIncreasingReadings() {
+    // The last digit is a close call between 3 and 8
+    std::vector<Step> steps = digits("04523");
+    steps[8] = {{digit(3), 0.5f}, {digit(8), 0.45f}};
+    ocr::ReadingGrammar grammar;
+    EXPECT_EQ(decode(steps, grammar).text, "04523");
+
+    ocr::ReadingPrior prior;
+    prior.lastValue = 4525.0;
+    EXPECT_EQ(decode(steps, grammar, prior).text, "04528");
+
+    // A reading far ahead of the last one costs the jump penalty
+    prior.lastValue = 4500.0;
+    prior.maxIncrease = 25.0;
+    EXPECT_EQ(decode(steps, grammar, prior).text, "04523");
+
+    // The prior never overrides a clear reading
+    prior.lastValue = 9000.0;
+    prior.maxIncrease = 0.0;
+    EXPECT_EQ(decode(digits("04521"), grammar, prior).text, "04521");
+}
+
+void arenaMatchesHeap() {
+    const ocr::CharDict dict = meterDict();
+    ocr::ReadingDecoder decoder(dict);
+    ocr::ReadingGrammar grammar;
+    ocr::parseReadingGrammar("5+3", grammar);
+    std::vector<Step> steps = digits("04521.12");
+    steps[0] = {{kLetterO, 0.5f}, {digit(0), 0.4f}};
+    std::vector<float> probs = posteriors(steps);
+    const int timeSteps = static_cast<int>(steps.size());
+
+    ocr::Recognition heap, pooled;
+    decoder.decode(probs.data(), timeSteps, kClasses, grammar, ocr::ReadingPrior(), heap);
+    ocr::FrameArena arena;
+    decoder.decode(probs.data(), timeSteps, kClasses, grammar, ocr::ReadingPrior(), pooled, &arena);
+    EXPECT_EQ(pooled.text, heap.text);
+    EXPECT_EQ(pooled.fractionDigits, heap.fractionDigits);
+    EXPECT_NEAR(pooled.confidence, heap.confidence, 1e-6);
+    EXPECT_TRUE(arena.used() > 0);
+}
+
+} // namespace
+
+int main() {
+    parsesGrammars();
+    findsDigitClasses();
+    readsLettersAsDigits();
+    keepsRepeatedDigitsApart();
+    enforcesLength();
+    readsDecimals();
+    priorPrefersIncreasingReadings();
+    arenaMatchesHeap();
+    return TEST_RESULT();
+}
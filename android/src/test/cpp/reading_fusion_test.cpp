@@ -0,0 +1,100 @@
+#include <string>
+#include <vector>
+
+#include "reading_fusion.h"
+#include "test_util.h"
+
+namespace {
+
+ocr::Recognition reading(const std::string& text, std::vector<float> confidences, int fractionDigits = 0) {
+    ocr::Recognition result;
+    result.text = text;
+    result.charConfidences = std::move(confidences);
+    float sum = 0.0f;
+    for (float confidence : result.charConfidences) sum += confidence;
+    result.confidence = sum / result.charConfidences.size();
+    result.fractionDigits = fractionDigits;
+    return result;
+}
+
+void fixesEachDigitFromTheSurestFrames() {
+    // Every frame misreads a different digit, and is unsure of it
+    const ocr::Recognition a = reading("04821", {0.95f, 0.9f, 0.45f, 0.9f, 0.95f});
+    const ocr::Recognition b = reading("04521", {0.9f, 0.95f, 0.9f, 0.9f, 0.4f});
+    const ocr::Recognition c = reading("09521", {0.95f, 0.5f, 0.85f, 0.9f, 0.9f});
+    const ocr::Recognition* reads[] = {&a, &b, &c};
+    ocr::Recognition fused;
+    EXPECT_TRUE(ocr::fuseRecognitions(reads, 3, 10, fused));
+    EXPECT_EQ(fused.text, std::string("04521"));
+    EXPECT_EQ(fused.charConfidences.size(), 5u);
+    // Agreement makes a digit surer than any one frame was
+    EXPECT_TRUE(fused.charConfidences[0] > 0.99f);
+    EXPECT_TRUE(fused.confidence > a.confidence && fused.confidence > b.confidence);
+    EXPECT_TRUE(fused.confidence <= 1.0f);
+}
+
+void oneConfidentFrameOutvotesUnsureOnes() {
+    const ocr::Recognition sure = reading("1", {0.99f});
+    const ocr::Recognition unsure1 = reading("7", {0.4f});
+    const ocr::Recognition unsure2 = reading("7", {0.4f});
+    const ocr::Recognition* reads[] = {&unsure1, &sure, &unsure2};
+    ocr::Recognition fused;
+    EXPECT_TRUE(ocr::fuseRecognitions(reads, 3, 10, fused));
+    EXPECT_EQ(fused.text, std::string("1"));
+}
+
+void keepsTheLayoutMostFramesAgreeOn() {
+    const ocr::Recognition a = reading("04521", {0.9f, 0.9f, 0.9f, 0.9f, 0.9f}, 2);
+    const ocr::Recognition b = reading("0452", {0.95f, 0.95f, 0.95f, 0.95f});
+    const ocr::Recognition c = reading("04521", {0.8f, 0.8f, 0.8f, 0.8f, 0.8f}, 2);
+    const ocr::Recognition d = reading("04521", {0.9f, 0.9f, 0.9f, 0.9f, 0.9f});
+    const ocr::Recognition* reads[] = {&b, &a, &d, &c};
+    ocr::Recognition fused;
+    EXPECT_TRUE(ocr::fuseRecognitions(reads, 4, 10, fused));
+    EXPECT_EQ(fused.text, std::string("04521"));
+    EXPECT_EQ(fused.fractionDigits, 2);
+}
+
+void skipsWhatCannotBeFused() {
+    ocr::Recognition empty;
+    ocr::Recognition multiByte = reading("\xc2\xb3", {0.9f}); // one character, two bytes
+    const ocr::Recognition* reads[] = {&empty, nullptr, &multiByte};
+    ocr::Recognition fused;
+    fused.text = "kept";
+    EXPECT_TRUE(!ocr::fuseRecognitions(reads, 3, 10, fused));
+    EXPECT_EQ(fused.text, std::string("kept"));
+
+    // A single reading comes back as it was
+    const ocr::Recognition single = reading("123", {0.9f, 0.8f, 0.7f});
+    const ocr::Recognition* one[] = {&single};
+    EXPECT_TRUE(ocr::fuseRecognitions(one, 1, 10, fused));
+    EXPECT_EQ(fused.text, std::string("123"));
+    EXPECT_NEAR(fused.charConfidences[1], 0.8f, 1e-4f);
+}
+
+void averagesVariantPosteriors() {
+    // Two time steps of three classes from each of three variants
+    const float outputs[] = {
+        0.7f, 0.2f, 0.1f, 0.1f, 0.5f, 0.4f,  // crop
+        0.6f, 0.3f, 0.1f, 0.1f, 0.3f, 0.6f,  // stretched
+        0.5f, 0.1f, 0.4f, 0.2f, 0.3f, 0.5f,  // binarized
+    };
+    float mean[6];
+    ocr::averagePosteriors(outputs, 3, 6, mean);
+    EXPECT_NEAR(mean[0], 0.6f, 1e-6f);
+    EXPECT_NEAR(mean[2], 0.2f, 1e-6f);
+    // The second step goes to class 2, which only the crop missed
+    EXPECT_TRUE(mean[5] > mean[4]);
+    EXPECT_NEAR(mean[3] + mean[4] + mean[5], 1.0f, 1e-6f);
+}
+
+} // namespace
+
+int main() {
+    fixesEachDigitFromTheSurestFrames();
+    oneConfidentFrameOutvotesUnsureOnes();
+    keepsTheLayoutMostFramesAgreeOn();
+    skipsWhatCannotBeFused();
+    averagesVariantPosteriors();
+    return TEST_RESULT();
+}
@@ -0,0 +1,114 @@
+#include <cstdint>
+#include <vector>
+
+#include "region_ranker.h"
+#include "test_util.h"
+
+namespace {
+
+void prefersReadingShapedCentredRegions() {
+    ocr::QuadSet quads;
+    quads.pushRect(200, 220, 400, 260, 0.8f); // 5:1 reading in the centre
+    quads.pushRect(20, 20, 380, 40, 0.9f);    // long serial number at the top
+    quads.pushRect(500, 400, 530, 430, 0.9f); // square logo in a corner
+    quads.pushRect(300, 300, 320, 305, 0.9f); // too small
+    ocr::RankParams params;
+    params.minWidth = 30;
+    params.minHeight = 10;
+    std::vector<float> scores(quads.size());
+    ocr::scoreRegions(quads, 640, 480, params, scores.data());
+    EXPECT_EQ(scores[3], -1.0f);
+    EXPECT_TRUE(scores[0] > scores[1]);
+    EXPECT_TRUE(scores[0] > scores[2]);
+
+    std::vector<uint32_t> order;
+    ocr::topRegions(scores.data(), scores.size(), 2, order);
+    EXPECT_EQ(order.size(), 2u);
+    EXPECT_EQ(order[0], 0u);
+    ocr::topRegions(scores.data(), scores.size(), 0, order);
+    EXPECT_EQ(order.size(), 3u);
+}
+
+void roiMovesThePreferredPosition() {
+    ocr::QuadSet quads;
+    quads.pushRect(40, 40, 140, 60, 0.8f);
+    quads.pushRect(270, 230, 370, 250, 0.8f);
+    ocr::RankParams params;
+    params.roiRight = 0.4f;
+    params.roiBottom = 0.4f;
+    float scores[2];
+    ocr::scoreRegions(quads, 640, 480, params, scores);
+    EXPECT_TRUE(scores[0] > scores[1]);
+}
+
+void recognitionDecidesBetweenSimilarRegions() {
+    ocr::RankParams params;
+    ocr::Recognition reading;
+    reading.text = "04521";
+    reading.confidence = 0.9f;
+    ocr::Recognition label;
+    label.text = "m3/h";
+    label.confidence = 0.95f;
+    ocr::Recognition shortDigits;
+    shortDigits.text = "12";
+    shortDigits.confidence = 0.95f;
+    float a = ocr::readingScore(0.7f, reading, params);
+    EXPECT_TRUE(a > ocr::readingScore(0.75f, label, params));
+    EXPECT_TRUE(a > ocr::readingScore(0.75f, shortDigits, params));
+    EXPECT_TRUE(a <= 1.0f);
+}
+
+ocr::Recognition text(const char* value, float confidence) {
+    ocr::Recognition result;
+    result.text = value;
+    result.charConfidences.assign(result.text.size(), confidence);
+    result.confidence = confidence;
+    return result;
+}
+
+void matchesTheReadingGrammar() {
+    ocr::RankParams params;
+    EXPECT_TRUE(ocr::matchesReading(text("04521", 0.95f), params));
+    EXPECT_TRUE(ocr::matchesReading(text("12345678", 0.95f), params));
+    EXPECT_TRUE(!ocr::matchesReading(text("452", 0.95f), params));
+    EXPECT_TRUE(!ocr::matchesReading(text("123456789", 0.95f), params));
+    EXPECT_TRUE(!ocr::matchesReading(text("04S21", 0.95f), params));
+    EXPECT_TRUE(!ocr::matchesReading(text("04521", 0.7f), params));
+
+    // One unsure digit is enough to keep looking
+    ocr::Recognition unsure = text("04521", 0.95f);
+    unsure.charConfidences[2] = 0.5f;
+    EXPECT_TRUE(!ocr::matchesReading(unsure, params));
+    params.minCharConfidence = 0.4f;
+    EXPECT_TRUE(ocr::matchesReading(unsure, params));
+}
+
+void grammarReadingsMatchAtTheirOwnLength() {
+    ocr::RankParams params;
+    ocr::ReadingGrammar grammar;
+    EXPECT_TRUE(ocr::parseReadingGrammar("8+3", grammar));
+    // Eight integer and three decimal digits: longer than the rank bounds
+    ocr::Recognition reading = text("12345678901", 0.95f);
+    reading.fractionDigits = 3;
+    EXPECT_TRUE(!ocr::matchesReading(reading, params));
+    EXPECT_TRUE(ocr::matchesReading(reading, params, grammar));
+    EXPECT_TRUE(!ocr::matchesReading(text("1234567890", 0.95f), params, grammar));
+    EXPECT_TRUE(!ocr::matchesReading(text("123456789012", 0.95f), params, grammar));
+
+    EXPECT_TRUE(ocr::parseReadingGrammar("5-9", grammar));
+    EXPECT_TRUE(ocr::matchesReading(text("123456789", 0.95f), params, grammar));
+    EXPECT_TRUE(!ocr::matchesReading(text("1234", 0.95f), params, grammar));
+    // Confidence still comes from the rank params
+    EXPECT_TRUE(!ocr::matchesReading(text("123456789", 0.7f), params, grammar));
+}
+
+} // namespace
+
+int main() {
+    prefersReadingShapedCentredRegions();
+    roiMovesThePreferredPosition();
+    recognitionDecidesBetweenSimilarRegions();
+    matchesTheReadingGrammar();
+    grammarReadingsMatchAtTheirOwnLength();
+    return TEST_RESULT();
+}
@@ -0,0 +1,62 @@
+#include <atomic>
+#include <stdexcept>
+#include <vector>
+
+#include "task_scheduler.h"
+#include "test_util.h"
+
+namespace {
+
+void runsEveryIndexOnce() {
+    ocr::TaskScheduler scheduler(3);
+    EXPECT_EQ(scheduler.concurrency(), 4);
+    std::vector<std::atomic<int>> hits(1000);
+    scheduler.parallelFor(1000, [&](int i) { hits[i]++; });
+    int wrong = 0;
+    for (std::atomic<int>& h : hits) wrong += h.load() != 1;
+    EXPECT_EQ(wrong, 0);
+}
+
+void nestedCallsDoNotDeadlock() {
+    ocr::TaskScheduler scheduler(2);
+    std::atomic<int> total{0};
+    scheduler.parallelFor(8, [&](int) {
+        scheduler.parallelFor(16, [&](int j) { total += j; });
+    });
+    EXPECT_EQ(total.load(), 8 * 120);
+}
+
+void rethrowsAfterAllTasksFinish() {
+    ocr::TaskScheduler scheduler(2);
+    std::atomic<int> ran{0};
+    bool caught = false;
+    try {
+        scheduler.parallelFor(64, [&](int i) {
+            ran++;
+            if (i == 5) throw std::runtime_error("boom");
+        });
+    } catch (const std::runtime_error&) {
+        caught = true;
+    }
+    EXPECT_TRUE(caught);
+    EXPECT_EQ(ran.load(), 64);
+}
+
+void zeroWorkersRunsOnCaller() {
+    ocr::TaskScheduler scheduler(0);
+    EXPECT_EQ(scheduler.concurrency(), 1);
+    int sum = 0;
+    scheduler.parallelFor(10, [&](int i) { sum += i; });
+    EXPECT_EQ(sum, 45);
+    EXPECT_TRUE(ocr::TaskScheduler::recommendedWorkers(1000) == 0);
+}
+
+} // namespace
+
+int main() {
+    runsEveryIndexOnce();
+    nestedCallsDoNotDeadlock();
+    rethrowsAfterAllTasksFinish();
+    zeroWorkersRunsOnCaller();
+    return TEST_RESULT();
+}
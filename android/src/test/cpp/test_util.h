@@ -0,0 +1,28 @@
+#pragma once
+
+// Minimal assertion helpers for the native unit tests. Each test binary calls
+// its cases from main() and returns TEST_RESULT().
+
+#include <cmath>
+#include <cstdio>
+
+namespace test {
+inline int& failures() {
+    static int count = 0;
+    return count;
+}
+} // namespace test
+
+#define EXPECT_TRUE(cond) \
+    do { \
+        if (!(cond)) { \
+            std::fprintf(stderr, "%s:%d: expected %s\n", __FILE__, __LINE__, #cond); \
+            ++test::failures(); \
+        } \
+    } while (0)
+
+#define EXPECT_EQ(a, b) EXPECT_TRUE((a) == (b))
+
+#define EXPECT_NEAR(a, b, eps) EXPECT_TRUE(std::fabs(static_cast<double>(a) - static_cast<double>(b)) <= (eps))
+
+#define TEST_RESULT() (test::failures() == 0 ? 0 : 1)
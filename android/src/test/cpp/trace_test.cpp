@@ -0,0 +1,67 @@
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+#include <string>
+
+#include "ocr_trace.h"
+#include "test_util.h"
+
+namespace {
+
+std::string readFile(const std::string& path) {
+    std::ifstream in(path);
+    std::stringstream buffer;
+    buffer << in.rdbuf();
+    return buffer.str();
+}
+
+void scopesAreIgnoredWhenDisabled() {
+    EXPECT_TRUE(!ocr::trace::enabled());
+    { OCR_TRACE_SCOPE("ignored", "test"); }
+    EXPECT_TRUE(!ocr::trace::finish());
+}
+
+void mergesOrtProfileOntoTraceClock() {
+    const std::string tracePath = "trace_test_out.json";
+    const std::string ortPath = "trace_test_ort.json";
+    {
+        // Layout as written by ORT's profiler, including its spacing
+        std::ofstream ort(ortPath);
+        ort << "[\n"
+            << "{\"cat\" : \"Session\",\"pid\" :4242,\"tid\" :7,\"dur\" :120,\"ts\" :5,\"ph\" : \"X\","
+               "\"name\" :\"model_run\",\"args\" : {\"ts\" : \"not-a-field\"}},\n"
+            << "{\"cat\" : \"Node\",\"pid\" :4242,\"tid\" :7,\"dur\" :40,\"ts\" :30,\"ph\" : \"X\","
+               "\"name\" :\"conv_kernel_time\",\"args\" : {\"op_name\" : \"Conv\"}}\n"
+            << "]\n";
+    }
+
+    EXPECT_TRUE(ocr::trace::start(tracePath));
+    EXPECT_TRUE(ocr::trace::enabled());
+    EXPECT_EQ(ocr::trace::outputPath(), tracePath);
+    { OCR_TRACE_SCOPE("Engine::detect", "pipeline"); }
+    EXPECT_TRUE(ocr::trace::mergeOrtProfile(ortPath, "onnxruntime det", 1000));
+    EXPECT_TRUE(ocr::trace::finish());
+    EXPECT_TRUE(!ocr::trace::enabled());
+
+    std::string trace = readFile(tracePath);
+    EXPECT_TRUE(trace.find("\"traceEvents\"") != std::string::npos);
+    EXPECT_TRUE(trace.find("\"name\":\"Engine::detect\",\"cat\":\"pipeline\",\"ph\":\"X\"") != std::string::npos);
+    EXPECT_TRUE(trace.find("\"name\":\"onnxruntime det\"") != std::string::npos);
+    // ORT timestamps shifted by the session start, pid remapped
+    EXPECT_TRUE(trace.find("\"ts\" :1005") != std::string::npos);
+    EXPECT_TRUE(trace.find("\"ts\" :1030") != std::string::npos);
+    EXPECT_TRUE(trace.find("4242") == std::string::npos);
+    // Nested args keep their values
+    EXPECT_TRUE(trace.find("\"ts\" : \"not-a-field\"") != std::string::npos);
+
+    std::remove(tracePath.c_str());
+    std::remove(ortPath.c_str());
+}
+
+} // namespace
+
+int main() {
+    scopesAreIgnoredWhenDisabled();
+    mergesOrtProfileOntoTraceClock();
+    return TEST_RESULT();
+}
@@ -0,0 +1,101 @@
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include "test_util.h"
+#include "water_ocr.h"
+
+namespace {
+
+void reportsFailedCreation() {
+    const char* options[] = {"intra_op_threads=1", "no_such_option=1"};
+    WaterOcrEngine* engine = water_ocr_create("missing_det.onnx", "missing_cls.onnx", "missing_rec.onnx", options, 2);
+    EXPECT_TRUE(engine == nullptr);
+    EXPECT_TRUE(std::strlen(water_ocr_last_error()) > 0);
+    water_ocr_destroy(engine);
+}
+
+void rejectsMissingArguments() {
+    WaterOcrReading readings[2];
+    float quads[9];
+    const uint8_t pixels[4] = {};
+    EXPECT_EQ(water_ocr_read_meter(nullptr, WATER_OCR_FORMAT_RGBA_8888, 1, 1, pixels, 4, nullptr, 0, nullptr, 0, -1.0,
+                                   0.0, readings, 2),
+              WATER_OCR_ERROR_ARGUMENT);
+    EXPECT_TRUE(std::string(water_ocr_last_error()).find("engine") != std::string::npos);
+    EXPECT_EQ(water_ocr_detect(nullptr, WATER_OCR_FORMAT_A_8, 4, 1, pixels, 4, nullptr, 0, nullptr, 0, quads, 1),
+              WATER_OCR_ERROR_ARGUMENT);
+    EXPECT_TRUE(water_ocr_warm_up(nullptr) < 0.0);
+    const WaterOcrFrame frame = {WATER_OCR_FORMAT_A_8, 4, 1, {pixels, nullptr, nullptr}, {4, 0, 0}};
+    EXPECT_EQ(water_ocr_read_burst(nullptr, &frame, 1, -1.0, 0.0, readings, nullptr, 2), WATER_OCR_ERROR_ARGUMENT);
+}
+
+void checksFramesWithoutAnEngine() {
+    // Flat mid-grey: nothing to read
+    std::vector<uint8_t> pixels(64 * 48, 128);
+    WaterOcrQuality quality;
+    EXPECT_EQ(water_ocr_check_frame(nullptr, WATER_OCR_FORMAT_A_8, 64, 48, pixels.data(), 64, nullptr, 0, nullptr, 0,
+                                    &quality),
+              WATER_OCR_QUALITY_LOW_CONTRAST);
+    EXPECT_NEAR(quality.mean, 128, 1e-3);
+    EXPECT_NEAR(quality.sharpness, 0, 1e-3);
+
+    // Dark and light columns
+    for (size_t i = 0; i < pixels.size(); ++i) pixels[i] = (i % 64) / 8 % 2 ? 30 : 200;
+    EXPECT_EQ(water_ocr_check_frame(nullptr, WATER_OCR_FORMAT_A_8, 64, 48, pixels.data(), 64, nullptr, 0, nullptr, 0,
+                                    nullptr),
+              WATER_OCR_QUALITY_OK);
+    EXPECT_EQ(water_ocr_check_frame(nullptr, WATER_OCR_FORMAT_NV21, 64, 48, pixels.data(), 64, nullptr, 0, nullptr,
+                                    0, nullptr),
+              WATER_OCR_ERROR_IMAGE);
+}
+
+void enhancesFramesWithoutAnEngine() {
+    const int width = 48;
+    const int height = 32;
+    // A dark bar on a light face, as RGBA and as grey
+    std::vector<uint8_t> rgba(static_cast<size_t>(width) * height * 4);
+    std::vector<uint8_t> grey(static_cast<size_t>(width) * height);
+    for (int i = 0; i < width * height; ++i) {
+        const uint8_t value = (i % width) / 6 == 3 ? 40 : 210;
+        grey[i] = value;
+        std::memset(&rgba[static_cast<size_t>(i) * 4], value, 4);
+    }
+    std::vector<uint8_t> fromRgba(grey.size());
+    std::vector<uint8_t> fromGrey(grey.size());
+    EXPECT_EQ(water_ocr_sauvola(WATER_OCR_FORMAT_RGBA_8888, width, height, rgba.data(), width * 4, nullptr, 0, nullptr,
+                                0, 7, 0.2f, fromRgba.data(), width),
+              0);
+    EXPECT_EQ(water_ocr_sauvola(WATER_OCR_FORMAT_A_8, width, height, grey.data(), width, nullptr, 0, nullptr, 0, 7,
+                                0.2f, fromGrey.data(), width),
+              0);
+    EXPECT_TRUE(fromRgba == fromGrey);
+    EXPECT_EQ(fromGrey[static_cast<size_t>(height / 2) * width + 20], 0);
+    EXPECT_EQ(fromGrey[static_cast<size_t>(height / 2) * width + 6], 255);
+
+    EXPECT_EQ(water_ocr_clahe(WATER_OCR_FORMAT_RGBA_8888, width, height, rgba.data(), width * 4, nullptr, 0, nullptr,
+                              0, 2, 2.0f, fromRgba.data(), width),
+              0);
+    // In place on the grey plane
+    EXPECT_EQ(water_ocr_clahe(WATER_OCR_FORMAT_A_8, width, height, grey.data(), width, nullptr, 0, nullptr, 0, 2, 2.0f,
+                              grey.data(), width),
+              0);
+    EXPECT_TRUE(fromRgba == grey);
+
+    EXPECT_EQ(water_ocr_sauvola(WATER_OCR_FORMAT_A_8, width, height, grey.data(), width, nullptr, 0, nullptr, 0, 0,
+                                0.2f, fromGrey.data(), width),
+              WATER_OCR_ERROR_ARGUMENT);
+    EXPECT_EQ(water_ocr_clahe(WATER_OCR_FORMAT_A_8, width, height, grey.data(), width, nullptr, 0, nullptr, 0, 2, 2.0f,
+                              fromGrey.data(), width - 1),
+              WATER_OCR_ERROR_ARGUMENT);
+}
+
+} // namespace
+
+int main() {
+    reportsFailedCreation();
+    rejectsMissingArguments();
+    checksFramesWithoutAnEngine();
+    enhancesFramesWithoutAnEngine();
+    return TEST_RESULT();
+}
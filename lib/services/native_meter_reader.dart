@@ -0,0 +1,514 @@
+import 'dart:ffi';
+import 'dart:io';
+import 'dart:typed_data';
+
+import 'package:ffi/ffi.dart';
+
+/// Pixel layouts [NativeMeterReader] accepts. The codes match `water_ocr.h`.
+enum NativePixelFormat {
+  rgba8888(0),
+  rgb565(1),
+  a8(2),
+  rgbaF16(3),
+  nv21(4),
+  i420(5),
+  nv12(6);
+
+  const NativePixelFormat(this.code);
+
+  final int code;
+}
+
+/// A meter reading candidate from the native engine.
+class NativeMeterReading {
+  NativeMeterReading({
+    required this.text,
+    required this.fractionDigits,
+    required this.confidence,
+    required this.score,
+    required this.quad,
+  });
+
+  /// Digits as read; the last [fractionDigits] are decimals.
+  final String text;
+  final int fractionDigits;
+  final double confidence;
+
+  /// Ranking score combining geometry, digit count and [confidence].
+  final double score;
+
+  /// x, y of four corners clockwise from the top-left, in image pixels.
+  final List<double> quad;
+
+  /// [text] with the decimal point in place.
+  String get value => fractionDigits > 0 && text.length > fractionDigits
+      ? '${text.substring(0, text.length - fractionDigits)}.${text.substring(text.length - fractionDigits)}'
+      : text;
+}
+
+/// One shot of a burst for [NativeMeterReader.readBurst], laid out as the
+/// arguments of [NativeMeterReader.readMeter].
+class NativeFrame {
+  NativeFrame(
+    this.pixels,
+    this.width,
+    this.height, {
+    this.format = NativePixelFormat.rgba8888,
+    this.rowStride = 0,
+    this.plane1,
+    this.stride1 = 0,
+    this.plane2,
+    this.stride2 = 0,
+  });
+
+  final Uint8List pixels;
+  final int width;
+  final int height;
+  final NativePixelFormat format;
+  final int rowStride;
+  final Uint8List? plane1;
+  final int stride1;
+  final Uint8List? plane2;
+  final int stride2;
+}
+
+/// Result of [NativeMeterReader.readBurst].
+class NativeBurstReading {
+  NativeBurstReading({required this.readings, required this.frames});
+
+  /// Candidates of the frames read, best first. With the `burst_fuse`
+  /// option the first fuses the readings of the best frames.
+  final List<NativeMeterReading> readings;
+
+  /// Index of the frame each of [readings] came from.
+  final List<int> frames;
+}
+
+/// Why [NativeMeterReader.checkFrame] turned a frame down. The codes match
+/// `water_ocr.h`.
+enum NativeFrameIssue {
+  none(0),
+  blur(1),
+  glare(2),
+  dark(3),
+  lowContrast(4);
+
+  const NativeFrameIssue(this.code);
+
+  final int code;
+}
+
+/// Blur and exposure of a frame, measured on a small luma thumbnail.
+class NativeFrameQuality {
+  NativeFrameQuality({
+    required this.issue,
+    required this.sharpness,
+    required this.clipped,
+    required this.mean,
+    required this.spread,
+  });
+
+  final NativeFrameIssue issue;
+
+  /// Variance of the Laplacian; low for blurred frames.
+  final double sharpness;
+
+  /// Fraction of clipped highlights, e.g. flash on the glass.
+  final double clipped;
+
+  /// Mean luma and its 5th to 95th percentile spread, 0..255.
+  final double mean;
+  final double spread;
+
+  bool get usable => issue == NativeFrameIssue.none;
+}
+
+final class _WaterOcrQuality extends Struct {
+  @Float()
+  external double sharpness;
+  @Float()
+  external double clipped;
+  @Float()
+  external double mean;
+  @Float()
+  external double spread;
+}
+
+final class _WaterOcrFrame extends Struct {
+  @Int32()
+  external int format;
+  @Int32()
+  external int width;
+  @Int32()
+  external int height;
+  @Array(3)
+  external Array<Pointer<Uint8>> planes;
+  @Array(3)
+  external Array<Int32> strides;
+}
+
+final class _WaterOcrReading extends Struct {
+  @Array(64)
+  external Array<Uint8> text;
+  @Int32()
+  external int fractionDigits;
+  @Float()
+  external double confidence;
+  @Float()
+  external double score;
+  @Array(8)
+  external Array<Float> quad;
+}
+
+typedef _CreateNative = Pointer<Void> Function(
+    Pointer<Utf8>, Pointer<Utf8>, Pointer<Utf8>, Pointer<Pointer<Utf8>>, Int32);
+typedef _Create = Pointer<Void> Function(
+    Pointer<Utf8>, Pointer<Utf8>, Pointer<Utf8>, Pointer<Pointer<Utf8>>, int);
+typedef _WarmUpNative = Double Function(Pointer<Void>);
+typedef _WarmUp = double Function(Pointer<Void>);
+typedef _ReadMeterNative = Int32 Function(Pointer<Void>, Int32, Int32, Int32, Pointer<Uint8>, Int32,
+    Pointer<Uint8>, Int32, Pointer<Uint8>, Int32, Double, Double, Pointer<_WaterOcrReading>, Int32);
+typedef _ReadMeter = int Function(Pointer<Void>, int, int, int, Pointer<Uint8>, int, Pointer<Uint8>, int,
+    Pointer<Uint8>, int, double, double, Pointer<_WaterOcrReading>, int);
+typedef _ReadBurstNative = Int32 Function(
+    Pointer<Void>, Pointer<_WaterOcrFrame>, Int32, Double, Double, Pointer<_WaterOcrReading>, Pointer<Int32>, Int32);
+typedef _ReadBurst = int Function(
+    Pointer<Void>, Pointer<_WaterOcrFrame>, int, double, double, Pointer<_WaterOcrReading>, Pointer<Int32>, int);
+typedef _CheckFrameNative = Int32 Function(Pointer<Void>, Int32, Int32, Int32, Pointer<Uint8>, Int32,
+    Pointer<Uint8>, Int32, Pointer<Uint8>, Int32, Pointer<_WaterOcrQuality>);
+typedef _CheckFrame = int Function(Pointer<Void>, int, int, int, Pointer<Uint8>, int, Pointer<Uint8>, int,
+    Pointer<Uint8>, int, Pointer<_WaterOcrQuality>);
+typedef _SauvolaNative = Int32 Function(Int32, Int32, Int32, Pointer<Uint8>, Int32, Pointer<Uint8>, Int32,
+    Pointer<Uint8>, Int32, Int32, Float, Pointer<Uint8>, Int32);
+typedef _Sauvola = int Function(
+    int, int, int, Pointer<Uint8>, int, Pointer<Uint8>, int, Pointer<Uint8>, int, int, double, Pointer<Uint8>, int);
+typedef _ClaheNative = _SauvolaNative;
+typedef _Clahe = _Sauvola;
+typedef _LastErrorNative = Pointer<Utf8> Function();
+
+class _Bindings {
+  _Bindings(DynamicLibrary library)
+      : create = library.lookupFunction<_CreateNative, _Create>('water_ocr_create'),
+        destroy = library.lookupFunction<Void Function(Pointer<Void>), void Function(Pointer<Void>)>(
+            'water_ocr_destroy'),
+        warmUp = library.lookupFunction<_WarmUpNative, _WarmUp>('water_ocr_warm_up'),
+        readMeter = library.lookupFunction<_ReadMeterNative, _ReadMeter>('water_ocr_read_meter'),
+        readBurst = library.lookupFunction<_ReadBurstNative, _ReadBurst>('water_ocr_read_burst'),
+        checkFrame = library.lookupFunction<_CheckFrameNative, _CheckFrame>('water_ocr_check_frame', isLeaf: true),
+        sauvola = library.lookupFunction<_SauvolaNative, _Sauvola>('water_ocr_sauvola', isLeaf: true),
+        clahe = library.lookupFunction<_ClaheNative, _Clahe>('water_ocr_clahe', isLeaf: true),
+        lastError = library.lookupFunction<_LastErrorNative, _LastErrorNative>('water_ocr_last_error');
+
+  final _Create create;
+  final void Function(Pointer<Void>) destroy;
+  final _WarmUp warmUp;
+  final _ReadMeter readMeter;
+  final _ReadBurst readBurst;
+  final _CheckFrame checkFrame;
+  final _Sauvola sauvola;
+  final _Clahe clahe;
+  final _LastErrorNative lastError;
+
+  static final _Bindings instance = _Bindings(DynamicLibrary.open(
+      Platform.isAndroid ? 'libpaddle_ocr.so' : Platform.isMacOS ? 'libwater_ocr.dylib' : 'libwater_ocr.so'));
+}
+
+/// Reads meters through the engine's C ABI (`water_ocr.h`) over `dart:ffi`:
+/// pixels go from a Dart [Uint8List] to native code without the
+/// platform-channel codec, a Bitmap or a temporary file.
+///
+/// [readMeter] and [readBurst] block until the whole pipeline has run, so
+/// call them off the UI isolate. They are not leaf calls, which would hold
+/// up garbage collection in every isolate of the group for as long, so the
+/// planes are copied to native memory first; only the short [checkFrame] and
+/// [NativeImageFilters] calls read Dart lists in place. An engine can be
+/// shared between isolates by passing [address] and reopening it with
+/// [NativeMeterReader.fromAddress]; only the isolate that created it should
+/// [dispose] it.
+class NativeMeterReader {
+  NativeMeterReader._(this._engine) : _owner = true;
+
+  /// Loads the models (file paths) and applies `key=value` engine options.
+  /// Throws a [StateError] when the engine cannot be created.
+  factory NativeMeterReader.open({
+    required String detModel,
+    required String clsModel,
+    required String recModel,
+    Map<String, String> options = const {},
+  }) {
+    final bindings = _Bindings.instance;
+    return using((arena) {
+      final optionList = options.entries.map((e) => '${e.key}=${e.value}'.toNativeUtf8(allocator: arena)).toList();
+      final optionArray = arena<Pointer<Utf8>>(optionList.length);
+      for (var i = 0; i < optionList.length; i++) {
+        optionArray[i] = optionList[i];
+      }
+      final engine = bindings.create(detModel.toNativeUtf8(allocator: arena), clsModel.toNativeUtf8(allocator: arena),
+          recModel.toNativeUtf8(allocator: arena), optionArray, optionList.length);
+      if (engine == nullptr) {
+        throw StateError(bindings.lastError().toDartString());
+      }
+      return NativeMeterReader._(engine);
+    });
+  }
+
+  /// An engine opened by another isolate, see [address].
+  NativeMeterReader.fromAddress(int address)
+      : _engine = Pointer<Void>.fromAddress(address),
+        _owner = false;
+
+  static const int _maxReadings = 8;
+  static final Uint8List _noPlane = Uint8List(0);
+
+  Pointer<Void> _engine;
+  final bool _owner;
+  final Pointer<_WaterOcrReading> _readings = calloc<_WaterOcrReading>(_maxReadings);
+  final Pointer<_WaterOcrQuality> _quality = calloc<_WaterOcrQuality>();
+
+  int get address => _engine.address;
+
+  /// Runs every model once; returns the time it took in milliseconds.
+  double warmUp() {
+    final millis = _Bindings.instance.warmUp(_checkedEngine);
+    if (millis < 0) throw StateError(_Bindings.instance.lastError().toDartString());
+    return millis;
+  }
+
+  /// Reads the meter in a [width] x [height] frame of [format]. [pixels] is
+  /// plane 0 and [rowStride] its row stride in bytes (0 for tightly packed);
+  /// NV21, NV12 and I420 frames add their chroma planes. [lastReading] and
+  /// [maxIncrease] are the priors of the `rec_grammar` option. Candidates
+  /// come back best first.
+  List<NativeMeterReading> readMeter(
+    Uint8List pixels,
+    int width,
+    int height, {
+    NativePixelFormat format = NativePixelFormat.rgba8888,
+    int rowStride = 0,
+    Uint8List? plane1,
+    int stride1 = 0,
+    Uint8List? plane2,
+    int stride2 = 0,
+    double? lastReading,
+    double maxIncrease = 0,
+  }) {
+    final bindings = _Bindings.instance;
+    return using((arena) {
+      final count = bindings.readMeter(
+          _checkedEngine,
+          format.code,
+          width,
+          height,
+          _nativePlane(pixels, arena),
+          rowStride > 0 ? rowStride : width * _bytesPerPixel(format),
+          _nativePlane(plane1, arena),
+          stride1,
+          _nativePlane(plane2, arena),
+          stride2,
+          lastReading ?? -1.0,
+          maxIncrease,
+          _readings,
+          _maxReadings);
+      if (count < 0) throw StateError(bindings.lastError().toDartString());
+
+      return List.generate(count, (i) => _reading(_readings[i]));
+    });
+  }
+
+  /// Reads several shots of the same meter at close to the cost of one: the
+  /// engine scores every frame for sharpness and exposure in the meter ROI
+  /// and runs the models only on the `burst_top_k` best.
+  NativeBurstReading readBurst(List<NativeFrame> frames, {double? lastReading, double maxIncrease = 0}) {
+    final bindings = _Bindings.instance;
+    return using((arena) {
+      final descriptors = arena<_WaterOcrFrame>(frames.length);
+      for (var i = 0; i < frames.length; i++) {
+        final frame = frames[i];
+        final descriptor = descriptors[i];
+        descriptor.format = frame.format.code;
+        descriptor.width = frame.width;
+        descriptor.height = frame.height;
+        final planes = [frame.pixels, frame.plane1, frame.plane2];
+        final strides = [
+          frame.rowStride > 0 ? frame.rowStride : frame.width * _bytesPerPixel(frame.format),
+          frame.stride1,
+          frame.stride2
+        ];
+        for (var p = 0; p < 3; p++) {
+          descriptor.planes[p] = _nativePlane(planes[p], arena);
+          descriptor.strides[p] = strides[p];
+        }
+      }
+      final sources = arena<Int32>(_maxReadings);
+      final count = bindings.readBurst(_checkedEngine, descriptors, frames.length, lastReading ?? -1.0, maxIncrease,
+          _readings, sources, _maxReadings);
+      if (count < 0) throw StateError(bindings.lastError().toDartString());
+      return NativeBurstReading(
+        readings: List.generate(count, (i) => _reading(_readings[i])),
+        frames: List.generate(count, (i) => sources[i]),
+      );
+    });
+  }
+
+  /// Measures blur and exposure of a frame, laid out as for [readMeter], in
+  /// well under a millisecond, so a camera stream can skip frames not worth
+  /// reading. Thresholds are the engine's `quality_*` options.
+  NativeFrameQuality checkFrame(
+    Uint8List pixels,
+    int width,
+    int height, {
+    NativePixelFormat format = NativePixelFormat.rgba8888,
+    int rowStride = 0,
+    Uint8List? plane1,
+    int stride1 = 0,
+    Uint8List? plane2,
+    int stride2 = 0,
+  }) {
+    final bindings = _Bindings.instance;
+    final code = bindings.checkFrame(
+        _checkedEngine,
+        format.code,
+        width,
+        height,
+        pixels.address,
+        rowStride > 0 ? rowStride : width * _bytesPerPixel(format),
+        (plane1 ?? _noPlane).address,
+        stride1,
+        (plane2 ?? _noPlane).address,
+        stride2,
+        _quality);
+    if (code < 0) throw StateError(bindings.lastError().toDartString());
+    final quality = _quality.ref;
+    return NativeFrameQuality(
+      issue: NativeFrameIssue.values.firstWhere((issue) => issue.code == code),
+      sharpness: quality.sharpness,
+      clipped: quality.clipped,
+      mean: quality.mean,
+      spread: quality.spread,
+    );
+  }
+
+  /// Frees the engine if this reader opened it. The reader cannot be used
+  /// afterwards.
+  void dispose() {
+    if (_engine == nullptr) return;
+    if (_owner) {
+      _Bindings.instance.destroy(_engine);
+    }
+    _engine = nullptr;
+    calloc.free(_readings);
+    calloc.free(_quality);
+  }
+
+  static NativeMeterReading _reading(_WaterOcrReading reading) {
+    final bytes = <int>[];
+    for (var j = 0; j < 64 && reading.text[j] != 0; j++) {
+      bytes.add(reading.text[j]);
+    }
+    return NativeMeterReading(
+      text: String.fromCharCodes(bytes),
+      fractionDigits: reading.fractionDigits,
+      confidence: reading.confidence,
+      score: reading.score,
+      quad: List.generate(8, (j) => reading.quad[j]),
+    );
+  }
+
+  /// Copy of [plane] in memory from [arena], or null without one.
+  static Pointer<Uint8> _nativePlane(Uint8List? plane, Arena arena) {
+    if (plane == null) return nullptr;
+    final copy = arena<Uint8>(plane.length);
+    copy.asTypedList(plane.length).setAll(0, plane);
+    return copy;
+  }
+
+  static int _bytesPerPixel(NativePixelFormat format) => switch (format) {
+        NativePixelFormat.rgba8888 => 4,
+        NativePixelFormat.rgb565 => 2,
+        NativePixelFormat.rgbaF16 => 8,
+        _ => 1,
+      };
+
+  Pointer<Void> get _checkedEngine {
+    if (_engine == nullptr) throw StateError('NativeMeterReader was disposed');
+    return _engine;
+  }
+}
+
+/// The engine's grey-level filters, usable without loading any model.
+/// Frames are laid out as for [NativeMeterReader.readMeter]; the result is
+/// one byte per pixel, tightly packed.
+class NativeImageFilters {
+  NativeImageFilters._();
+
+  /// Local Sauvola binarization: 0 where a pixel is darker than its
+  /// (2 * [radius] + 1)^2 neighbourhood by the factor [k], 255 elsewhere.
+  /// Unlike a fixed cut-off it keeps digits under shadows and glare.
+  static Uint8List sauvola(
+    Uint8List pixels,
+    int width,
+    int height, {
+    NativePixelFormat format = NativePixelFormat.rgba8888,
+    int rowStride = 0,
+    Uint8List? plane1,
+    int stride1 = 0,
+    Uint8List? plane2,
+    int stride2 = 0,
+    int radius = 15,
+    double k = 0.2,
+  }) {
+    final bindings = _Bindings.instance;
+    final result = Uint8List(width * height);
+    final code = bindings.sauvola(
+        format.code,
+        width,
+        height,
+        pixels.address,
+        rowStride > 0 ? rowStride : width * NativeMeterReader._bytesPerPixel(format),
+        (plane1 ?? NativeMeterReader._noPlane).address,
+        stride1,
+        (plane2 ?? NativeMeterReader._noPlane).address,
+        stride2,
+        radius,
+        k,
+        result.address,
+        width);
+    if (code < 0) throw StateError(bindings.lastError().toDartString());
+    return result;
+  }
+
+  /// Contrast limited adaptive histogram equalization on [tiles] x [tiles]
+  /// tiles, histogram bins capped at [clipLimit] times their mean.
+  static Uint8List clahe(
+    Uint8List pixels,
+    int width,
+    int height, {
+    NativePixelFormat format = NativePixelFormat.rgba8888,
+    int rowStride = 0,
+    Uint8List? plane1,
+    int stride1 = 0,
+    Uint8List? plane2,
+    int stride2 = 0,
+    int tiles = 8,
+    double clipLimit = 2.0,
+  }) {
+    final bindings = _Bindings.instance;
+    final result = Uint8List(width * height);
+    final code = bindings.clahe(
+        format.code,
+        width,
+        height,
+        pixels.address,
+        rowStride > 0 ? rowStride : width * NativeMeterReader._bytesPerPixel(format),
+        (plane1 ?? NativeMeterReader._noPlane).address,
+        stride1,
+        (plane2 ?? NativeMeterReader._noPlane).address,
+        stride2,
+        tiles,
+        clipLimit,
+        result.address,
+        width);
+    if (code < 0) throw StateError(bindings.lastError().toDartString());
+    return result;
+  }
+}
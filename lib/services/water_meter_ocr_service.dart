@@ -1,14 +1,24 @@
 import 'dart:io';
+import 'dart:isolate';
 import 'dart:typed_data';
 import 'package:google_mlkit_text_recognition/google_mlkit_text_recognition.dart';
 import 'package:path_provider/path_provider.dart';
 import '../models/water_meter_result.dart';
+import 'native_meter_reader.dart';
 import 'package:image/image.dart' as img;
 
 class WaterMeterOCRService {
   final TextRecognizer _textRecognizer;
+  // Native engine over dart:ffi; ML Kit is the fallback without one. An
+  // engine opened with the `rec_tta` option fuses crop variants in one rec
+  // batch, in place of the four ML Kit passes below
+  final NativeMeterReader? _nativeReader;
+  // Background reads of _nativeReader's engine, which dispose waits for
+  final Set<Future<WaterMeterResult>> _inFlight = {};
   
-  WaterMeterOCRService() : _textRecognizer = TextRecognizer();
+  WaterMeterOCRService({NativeMeterReader? nativeReader})
+      : _textRecognizer = TextRecognizer(),
+        _nativeReader = nativeReader;
 
   Future<WaterMeterResult> processImage(Uint8List imageBytes,{String? imageFull} ) async {
     try {
@@ -23,6 +33,27 @@ class WaterMeterOCRService {
         );
       }
 
+      final reader = _nativeReader;
+      if (reader != null) {
+        // Decoded pixels go to the engine, no temp files. The pipeline runs
+        // on a helper isolate, so this one keeps drawing frames meanwhile
+        final rgba = image.convert(format: img.Format.uint8, numChannels: 4).getBytes(order: img.ChannelOrder.rgba);
+        final read = _readInBackground(reader.address, rgba, image.width, image.height);
+        _inFlight.add(read);
+        final WaterMeterResult result;
+        try {
+          result = await read;
+        } finally {
+          _inFlight.remove(read);
+        }
+        return WaterMeterResult(
+          reading: result.reading,
+          confidence: result.confidence,
+          imageBytes: imageBytes,
+          debugInfo: result.debugInfo,
+        );
+      }
+
       // Try multiple preprocessing approaches
       List<String> allResults = [];
       
@@ -38,22 +69,7 @@ class WaterMeterOCRService {
       allResults.add(result2);
       
       // Approach 3: Grayscale + threshold
-      var image3 = img.grayscale(image);
-      // Apply threshold to make text more distinct
-      for (int y = 0; y < image3.height; y++) {
-        for (int x = 0; x < image3.width; x++) {
-          var pixel = image3.getPixel(x, y);
-          var r = pixel.r.toInt();
-          var g = pixel.g.toInt(); 
-          var b = pixel.b.toInt();
-          var luminance = (0.299 * r + 0.587 * g + 0.114 * b).round();
-          if (luminance > 128) {
-            image3.setPixel(x, y, img.ColorRgb8(255, 255, 255)); // White
-          } else {
-            image3.setPixel(x, y, img.ColorRgb8(0, 0, 0)); // Black
-          }
-        }
-      }
+      var image3 = _threshold(image);
       var result3 = await _processWithSettings(image3, imageBytes, 'threshold');
       allResults.add(result3);
       
@@ -91,6 +107,119 @@ class WaterMeterOCRService {
     }
   }
   
+  /// Black digits on white. A local Sauvola threshold from the native
+  /// library keeps digits under shadows and glare; without the library a
+  /// fixed cut-off at mid-grey stands in.
+  img.Image _threshold(img.Image image) {
+    try {
+      final rgba = image.convert(format: img.Format.uint8, numChannels: 4).getBytes(order: img.ChannelOrder.rgba);
+      final binary = NativeImageFilters.sauvola(rgba, image.width, image.height);
+      return img.Image.fromBytes(width: image.width, height: image.height, bytes: binary.buffer, numChannels: 1);
+    } on Object {
+      // Native library not available
+    }
+    var image3 = img.grayscale(image);
+    // Apply threshold to make text more distinct
+    for (int y = 0; y < image3.height; y++) {
+      for (int x = 0; x < image3.width; x++) {
+        var pixel = image3.getPixel(x, y);
+        var r = pixel.r.toInt();
+        var g = pixel.g.toInt(); 
+        var b = pixel.b.toInt();
+        var luminance = (0.299 * r + 0.587 * g + 0.114 * b).round();
+        if (luminance > 128) {
+          image3.setPixel(x, y, img.ColorRgb8(255, 255, 255)); // White
+        } else {
+          image3.setPixel(x, y, img.ColorRgb8(0, 0, 0)); // Black
+        }
+      }
+    }
+    return image3;
+  }
+
+  /// Reads a frame that is already in memory, e.g. from a camera stream, on
+  /// the native engine. See [NativeMeterReader.readMeter] for the arguments;
+  /// like it, this blocks until the engine is done, so call it off the UI
+  /// isolate. [processImage] does that itself.
+  WaterMeterResult processFrame(
+    Uint8List pixels,
+    int width,
+    int height, {
+    NativePixelFormat format = NativePixelFormat.rgba8888,
+    int rowStride = 0,
+    Uint8List? plane1,
+    int stride1 = 0,
+    Uint8List? plane2,
+    int stride2 = 0,
+    double? lastReading,
+    double maxIncrease = 0,
+  }) {
+    final reader = _nativeReader;
+    if (reader == null) {
+      return const WaterMeterResult(reading: '', confidence: 0.0, debugInfo: ['Native engine not available']);
+    }
+    return _readFrame(reader, pixels, width, height,
+        format: format,
+        rowStride: rowStride,
+        plane1: plane1,
+        stride1: stride1,
+        plane2: plane2,
+        stride2: stride2,
+        lastReading: lastReading,
+        maxIncrease: maxIncrease);
+  }
+
+  /// [_readFrame] of an RGBA frame on a helper isolate, through the engine
+  /// at [engine] (see [NativeMeterReader.address]). Static, so the closure
+  /// sent to the isolate holds nothing but the frame.
+  static Future<WaterMeterResult> _readInBackground(int engine, Uint8List rgba, int width, int height) {
+    return Isolate.run(() {
+      final reader = NativeMeterReader.fromAddress(engine);
+      try {
+        return _readFrame(reader, rgba, width, height);
+      } finally {
+        reader.dispose();
+      }
+    });
+  }
+
+  static WaterMeterResult _readFrame(
+    NativeMeterReader reader,
+    Uint8List pixels,
+    int width,
+    int height, {
+    NativePixelFormat format = NativePixelFormat.rgba8888,
+    int rowStride = 0,
+    Uint8List? plane1,
+    int stride1 = 0,
+    Uint8List? plane2,
+    int stride2 = 0,
+    double? lastReading,
+    double maxIncrease = 0,
+  }) {
+    try {
+      final candidates = reader.readMeter(pixels, width, height,
+          format: format,
+          rowStride: rowStride,
+          plane1: plane1,
+          stride1: stride1,
+          plane2: plane2,
+          stride2: stride2,
+          lastReading: lastReading,
+          maxIncrease: maxIncrease);
+      if (candidates.isEmpty) {
+        return const WaterMeterResult(reading: '', confidence: 0.0, debugInfo: ['No reading found']);
+      }
+      return WaterMeterResult(
+        reading: candidates.first.value,
+        confidence: candidates.first.confidence,
+        debugInfo: candidates.map((c) => '${c.value} (score ${c.score.toStringAsFixed(2)})').toList(),
+      );
+    } catch (e) {
+      return WaterMeterResult(reading: '', confidence: 0.0, debugInfo: ['Error processing frame: $e']);
+    }
+  }
+
   Future<String> _processWithSettings(img.Image processedImage, Uint8List originalBytes, String suffix) async {
     try {
       // Save preprocessed image
@@ -309,6 +438,9 @@ class WaterMeterOCRService {
   }
 
   Future<void> dispose() async {
+    // The engine must outlive the reads on helper isolates
+    await Future.wait(_inFlight.toList()).catchError((Object _) => <WaterMeterResult>[]);
+    _nativeReader?.dispose();
     await _textRecognizer.close();
   }
 } 
\ No newline at end of file
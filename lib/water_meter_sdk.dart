@@ -1,12 +1,19 @@
 import 'dart:typed_data';
 
 import 'water_meter_sdk_platform_interface.dart';
+import 'services/native_meter_reader.dart';
 import 'services/water_meter_ocr_service.dart';
 import 'models/water_meter_result.dart';
 export 'models/water_meter_result.dart';
+export 'services/native_meter_reader.dart';
+export 'water_meter_sdk_platform_interface.dart' show OcrEngine;
 
 class WaterMeterSdk {
-  final WaterMeterOCRService _ocrService = WaterMeterOCRService();
+  /// With a [nativeReader] images are read by the native engine over
+  /// dart:ffi instead of ML Kit, and [processFrame] is available.
+  WaterMeterSdk({NativeMeterReader? nativeReader}) : _ocrService = WaterMeterOCRService(nativeReader: nativeReader);
+
+  final WaterMeterOCRService _ocrService;
 
   Future<String?> getPlatformVersion() {
     return WaterMeterSdkPlatform.instance.getPlatformVersion();
@@ -18,6 +25,46 @@ class WaterMeterSdk {
     return await _ocrService.processImage(imageBytes, imageFull: imageFull);
   }
 
+  /// Configure the platform-side native engine, see
+  /// [WaterMeterSdkPlatform.configureNative].
+  Future<void> configureNative({
+    int maxConcurrency = 1,
+    int queueDepth = 2,
+    Map<String, String> options = const {},
+    bool preload = true,
+  }) {
+    return WaterMeterSdkPlatform.instance.configureNative(
+        maxConcurrency: maxConcurrency, queueDepth: queueDepth, options: options, preload: preload);
+  }
+
+  /// Read the meter in the image file at [imagePath] with the platform-side
+  /// native engine. The image is decoded and read on a background executor,
+  /// and the engine stays loaded between calls.
+  Future<WaterMeterResult> readMeterFromFile(String imagePath) async {
+    final map = await WaterMeterSdkPlatform.instance.processImage(imagePath, engine: OcrEngine.native);
+    if (map.containsKey('error')) {
+      return WaterMeterResult(reading: '', confidence: 0.0, debugInfo: ['${map['error']}']);
+    }
+    final regions = (map['textRegions'] as List?) ?? const [];
+    return WaterMeterResult(
+      reading: map['reading'] as String? ?? '',
+      confidence: (map['confidence'] as num?)?.toDouble() ?? 0.0,
+      debugInfo: [
+        'processingTime: ${map['processingTime']} ms',
+        for (final region in regions) '${(region as Map)['text']}',
+      ],
+    );
+  }
+
+  /// Read a raw frame (RGBA by default, or NV21/I420 planes) already in
+  /// memory. Needs a native reader, and blocks until the engine is done, so
+  /// call it off the UI isolate; [processWaterMeterImage] does that itself.
+  WaterMeterResult processFrame(Uint8List pixels, int width, int height,
+      {NativePixelFormat format = NativePixelFormat.rgba8888, int rowStride = 0, double? lastReading}) {
+    return _ocrService.processFrame(pixels, width, height,
+        format: format, rowStride: rowStride, lastReading: lastReading);
+  }
+
   /// Dispose of resources
   Future<void> dispose() async {
     await _ocrService.dispose();
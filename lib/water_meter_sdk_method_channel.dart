@@ -16,11 +16,11 @@ class MethodChannelWaterMeterSdk extends WaterMeterSdkPlatform {
   }
 
   @override
-  Future<Map<String, dynamic>> processImage(String imagePath) async {
+  Future<Map<String, dynamic>> processImage(String imagePath, {OcrEngine engine = OcrEngine.mlKit}) async {
     try {
       final result = await methodChannel.invokeMethod<Map<Object?, Object?>>(
         'processImage',
-        {'imagePath': imagePath},
+        {'imagePath': imagePath, 'engine': engine.name},
       );
       
       // Convert the result to Map<String, dynamic>
@@ -32,4 +32,19 @@ class MethodChannelWaterMeterSdk extends WaterMeterSdkPlatform {
       };
     }
   }
+
+  @override
+  Future<void> configureNative({
+    int maxConcurrency = 1,
+    int queueDepth = 2,
+    Map<String, String> options = const {},
+    bool preload = true,
+  }) async {
+    await methodChannel.invokeMethod<void>('configureNative', {
+      'maxConcurrency': maxConcurrency,
+      'queueDepth': queueDepth,
+      'options': options,
+      'preload': preload,
+    });
+  }
 }
@@ -3,6 +3,16 @@ import 'package:plugin_platform_interface/plugin_platform_interface.dart';
 import 'water_meter_sdk_method_channel.dart';
 import 'models/water_meter_result.dart';
 
+/// Recognizer behind [WaterMeterSdkPlatform.processImage].
+enum OcrEngine {
+  /// ML Kit text recognition.
+  mlKit,
+
+  /// The plugin's own detection and recognition models, kept loaded between
+  /// calls. Configure it with [WaterMeterSdkPlatform.configureNative].
+  native,
+}
+
 abstract class WaterMeterSdkPlatform extends PlatformInterface {
   /// Constructs a WaterMeterSdkPlatform.
   WaterMeterSdkPlatform() : super(token: _token);
@@ -28,7 +38,23 @@ abstract class WaterMeterSdkPlatform extends PlatformInterface {
     throw UnimplementedError('platformVersion() has not been implemented.');
   }
 
-  Future<Map<String, dynamic>> processImage(String imagePath) async {
+  /// Reads the meter in the image at [imagePath] off the platform thread.
+  /// With [OcrEngine.native] it fails with a `BUSY` error when more images
+  /// are in flight than [configureNative] allows; ML Kit requests queue.
+  Future<Map<String, dynamic>> processImage(String imagePath, {OcrEngine engine = OcrEngine.mlKit}) async {
     throw UnimplementedError('processImage() has not been implemented.');
   }
+
+  /// Limits the background work to [maxConcurrency] images at a time with
+  /// [queueDepth] more waiting, and sets the native engine's `key=value`
+  /// [options]. With [preload] the models are loaded right away instead of
+  /// on the first native call.
+  Future<void> configureNative({
+    int maxConcurrency = 1,
+    int queueDepth = 2,
+    Map<String, String> options = const {},
+    bool preload = true,
+  }) {
+    throw UnimplementedError('configureNative() has not been implemented.');
+  }
 }
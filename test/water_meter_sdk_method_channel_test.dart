@@ -1,17 +1,27 @@
 import 'package:flutter/services.dart';
 import 'package:flutter_test/flutter_test.dart';
 import 'package:water_meter_sdk/water_meter_sdk_method_channel.dart';
+import 'package:water_meter_sdk/water_meter_sdk_platform_interface.dart';
 
 void main() {
   TestWidgetsFlutterBinding.ensureInitialized();
 
   MethodChannelWaterMeterSdk platform = MethodChannelWaterMeterSdk();
   const MethodChannel channel = MethodChannel('water_meter_sdk');
+  final List<MethodCall> calls = [];
 
   setUp(() {
+    calls.clear();
     TestDefaultBinaryMessengerBinding.instance.defaultBinaryMessenger.setMockMethodCallHandler(
       channel,
       (MethodCall methodCall) async {
+        calls.add(methodCall);
+        switch (methodCall.method) {
+          case 'processImage':
+            return {'reading': '01234', 'confidence': 0.9};
+          case 'configureNative':
+            return null;
+        }
         return '42';
       },
     );
@@ -24,4 +34,21 @@ void main() {
   test('getPlatformVersion', () async {
     expect(await platform.getPlatformVersion(), '42');
   });
+
+  test('processImage passes the engine', () async {
+    final result = await platform.processImage('/tmp/meter.jpg', engine: OcrEngine.native);
+    expect(result['reading'], '01234');
+    expect(calls.single.arguments, {'imagePath': '/tmp/meter.jpg', 'engine': 'native'});
+  });
+
+  test('configureNative sends the executor limits', () async {
+    await platform.configureNative(maxConcurrency: 2, queueDepth: 0, options: {'det_threshold': '0.3'});
+    expect(calls.single.method, 'configureNative');
+    expect(calls.single.arguments, {
+      'maxConcurrency': 2,
+      'queueDepth': 0,
+      'options': {'det_threshold': '0.3'},
+      'preload': true,
+    });
+  });
 }
@@ -10,6 +10,34 @@ class MockWaterMeterSdkPlatform
 
   @override
   Future<String?> getPlatformVersion() => Future.value('42');
+
+  OcrEngine? lastEngine;
+
+  @override
+  Future<Map<String, dynamic>> processImage(String imagePath, {OcrEngine engine = OcrEngine.mlKit}) {
+    lastEngine = engine;
+    return Future.value({
+      'isWaterMeter': true,
+      'reading': '01234',
+      'confidence': 0.9,
+      'processingTime': 35,
+      'textRegions': [
+        {'text': '01234', 'confidence': 0.8, 'bounds': [0, 0, 10, 5]},
+      ],
+    });
+  }
+
+  Map<String, Object>? nativeConfig;
+
+  @override
+  Future<void> configureNative({
+    int maxConcurrency = 1,
+    int queueDepth = 2,
+    Map<String, String> options = const {},
+    bool preload = true,
+  }) async {
+    nativeConfig = {'maxConcurrency': maxConcurrency, 'queueDepth': queueDepth, 'options': options};
+  }
 }
 
 void main() {
@@ -26,4 +54,19 @@ void main() {
 
     expect(await waterMeterSdkPlugin.getPlatformVersion(), '42');
   });
+
+  test('readMeterFromFile uses the native engine', () async {
+    WaterMeterSdk waterMeterSdkPlugin = WaterMeterSdk();
+    MockWaterMeterSdkPlatform fakePlatform = MockWaterMeterSdkPlatform();
+    WaterMeterSdkPlatform.instance = fakePlatform;
+
+    await waterMeterSdkPlugin.configureNative(maxConcurrency: 2, options: {'rec_grammar': '5'});
+    expect(fakePlatform.nativeConfig?['maxConcurrency'], 2);
+    expect(fakePlatform.nativeConfig?['options'], {'rec_grammar': '5'});
+
+    final result = await waterMeterSdkPlugin.readMeterFromFile('/tmp/meter.jpg');
+    expect(fakePlatform.lastEngine, OcrEngine.native);
+    expect(result.reading, '01234');
+    expect(result.confidence, 0.9);
+  });
 }